@@ -0,0 +1,70 @@
+#ifndef _AFFINE_H
+#define _AFFINE_H
+
+#include <cstddef>
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Transformações afins guardadas como matrizes 3x4: as três primeiras linhas
+// de uma matriz de modelagem, cuja última linha é sempre [0 0 0 1]. Cada
+// linha tem quatro floats, [r0 r1 r2 t], e é processada como um vetor SIMD:
+// SSE2 em x86, NEON em ARM, ou código escalar nos demais casos (ou com
+// -DAFFINE_SCALAR). Definidas em "affine.cpp".
+//
+// As matrizes de modelagem são construídas de uma vez, sem multiplicar
+// matrizes intermediárias, por Affine_MakeTRS() ou Affine_MakeTSR(); as
+// rotações são quatérnios da GLM, por exemplo
+//
+//     Affine m = Affine_MakeTSR(position, glm::angleAxis(angle, glm::vec3(0,1,0)), scale);
+//
+// Para enviar uma transformação para a GPU converta-a com Affine_ToMat4().
+// As funções "Batch" processam vetores inteiros de transformações ou pontos,
+// para os caminhos que tratam muitos objetos por quadro.
+
+#if !defined(AFFINE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define AFFINE_SSE 1
+#elif !defined(AFFINE_SCALAR) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define AFFINE_NEON 1
+#endif
+
+struct Affine
+{
+    float m[3][4];      // Linhas da matriz; m[i][3] é a translação
+};
+
+Affine Affine_Identity();
+
+// T * R * S: escala, depois rotação, depois translação.
+Affine Affine_MakeTRS(const glm::vec3& t, const glm::quat& r, const glm::vec3& s);
+
+// T * S * R: a ordem usada nas matrizes de modelagem de "main.cpp"
+// (Matrix_Translate(...) * Matrix_Scale(...) * Matrix_Rotate(...)).
+Affine Affine_MakeTSR(const glm::vec3& t, const glm::quat& r, const glm::vec3& s);
+
+// a * b: aplica "b" e depois "a".
+Affine Affine_Compose(const Affine& a, const Affine& b);
+
+// Inversa de uma transformação não singular.
+Affine Affine_Inverse(const Affine& a);
+
+glm::vec3 Affine_TransformPoint(const Affine& a, const glm::vec3& p);
+glm::vec3 Affine_TransformVector(const Affine& a, const glm::vec3& v);
+
+glm::mat4 Affine_ToMat4(const Affine& a);
+Affine    Affine_FromMat4(const glm::mat4& m);
+
+// out[i] = a[i] * b[i]. "out" pode ser o próprio "a" ou "b".
+void Affine_ComposeBatch(const Affine* a, const Affine* b, Affine* out, size_t count);
+
+// out[i] = parent * local[i].
+void Affine_ComposeBatch(const Affine& parent, const Affine* local, Affine* out, size_t count);
+
+// Transforma "count" pontos (w = 1) ou vetores (w = 0). "out" pode ser "in".
+void Affine_TransformPointsBatch(const Affine& a, const glm::vec3* in, glm::vec3* out, size_t count);
+void Affine_TransformVectorsBatch(const Affine& a, const glm::vec3* in, glm::vec3* out, size_t count);
+
+void Affine_ToMat4Batch(const Affine* in, glm::mat4* out, size_t count);
+
+#endif // _AFFINE_H
@@ -0,0 +1,151 @@
+#ifndef _ANIMATION_H
+#define _ANIMATION_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "transformgraph.h"
+#include "bezier.h"
+
+// Animações por quadros-chave. Definidas em "animation.cpp".
+//
+// Uma trilha ("track") é uma lista de chaves (tempo, valor) ligada a um canal
+// (translação ou escala em x, y ou z) de um alvo. Um alvo é um nó da
+// hierarquia de transformações (veja "transformgraph.h") com translação,
+// rotação e escala próprias; os canais animados sobrescrevem os componentes
+// correspondentes.
+//
+// As trilhas começam quando o evento ao qual pertencem é disparado por
+// Animation_Trigger() (por exemplo "gate_open" quando o cubo é colocado no
+// botão). Animation_Update() avalia, em uma única passada sobre vetores
+// contíguos (SoA), somente as trilhas em execução; trilhas que terminaram ou
+// que nunca foram disparadas não custam nada. Animation_Apply() então
+// recalcula a transformação local dos alvos que mudaram.
+//
+// Assim, novos objetos animados só precisam de alvos e trilhas criados na
+// inicialização, sem código no laço principal.
+
+#define ANIMATION_MAX_BEZIER_KEYS 16
+
+enum AnimationChannel
+{
+    ANIM_TRANSLATE_X,
+    ANIM_TRANSLATE_Y,
+    ANIM_TRANSLATE_Z,
+    ANIM_SCALE_X,
+    ANIM_SCALE_Y,
+    ANIM_SCALE_Z,
+    ANIM_CHANNEL_COUNT
+};
+
+enum AnimationInterp
+{
+    ANIM_STEP,      // Valor da última chave alcançada
+    ANIM_LINEAR,
+    ANIM_SMOOTH,    // Hermite (smoothstep) entre chaves vizinhas
+    ANIM_BEZIER     // Os valores são pontos de controle de uma curva de Bézier
+                    // percorrida entre o tempo da primeira e da última chave,
+                    // com velocidade constante (veja "curve_" abaixo)
+};
+
+enum AnimationLoop
+{
+    ANIM_ONCE,      // Para na última chave
+    ANIM_REPEAT,
+    ANIM_PINGPONG   // Ida e volta
+};
+
+struct AnimationSystem
+{
+    // Chaves de todas as trilhas, em sequência.
+    std::vector<float>          key_time;
+    std::vector<float>          key_value;
+
+    // Trilhas.
+    std::vector<int>            track_first_key;
+    std::vector<int>            track_key_count;
+    std::vector<unsigned char>  track_interp;
+    std::vector<unsigned char>  track_loop;
+    std::vector<int>            track_slot;     // alvo * ANIM_CHANNEL_COUNT + canal
+    std::vector<double>         track_start;
+    std::vector<unsigned char>  track_playing;
+    std::vector<int>            track_curve;    // Curva da trilha ANIM_BEZIER, ou -1
+
+    // Curvas das trilhas ANIM_BEZIER (veja "bezier.h"). As trilhas de
+    // translação (ou de escala) de um alvo disparadas pelo mesmo evento, com o
+    // mesmo número de chaves e o mesmo intervalo de tempo, formam uma única
+    // curva em 3D, e a tabela de comprimento de arco dessa curva faz o alvo
+    // andar com velocidade constante. Os eixos sem trilha ficam constantes.
+    std::vector<glm::vec3>       curve_points;
+    std::vector<int>             curve_first_point;
+    std::vector<int>             curve_point_count;
+    std::vector<unsigned char>   curve_axes;     // Bit i: eixo i tem trilha
+    std::vector<BezierArcLength> curve_arc;
+
+    // Trilhas em execução, e o tempo local de cada uma no quadro atual.
+    std::vector<int>            active;
+    std::vector<float>          active_time;
+    std::vector<float>          active_value;
+
+    // Alvos.
+    std::vector<int>            target_node;
+    std::vector<float>          target_channels;    // ANIM_CHANNEL_COUNT por alvo
+    std::vector<glm::quat>      target_rotation;
+    std::vector<unsigned char>  target_scale_first; // T * S * R em vez de T * R * S
+    std::vector<unsigned char>  target_dirty;
+    std::vector<int>            dirty_targets;
+
+    std::map<std::string, std::vector<int> > events;
+
+    size_t                      evaluated;      // Trilhas avaliadas no último Animation_Update()
+
+    AnimationSystem() : evaluated(0) {}
+};
+
+// Cria um alvo para o nó "node" de "graph". A transformação local do nó passa
+// a ser controlada por Animation_Apply().
+int  Animation_AddTarget(AnimationSystem* system, int node, const glm::vec3& translation,
+                         const glm::quat& rotation, const glm::vec3& scale, bool scale_first = false);
+
+// Mudam a pose de um alvo fora das animações (por exemplo um portal colocado
+// em outra parede). Canais animados sobrescrevem os valores dados aqui.
+void Animation_SetTranslation(AnimationSystem* system, int target, const glm::vec3& translation);
+void Animation_SetRotation(AnimationSystem* system, int target, const glm::quat& rotation);
+glm::vec3 Animation_GetTranslation(const AnimationSystem& system, int target);
+
+// Cria uma trilha com "count" chaves, em ordem crescente de tempo (em
+// segundos, a partir do disparo), disparada pelo evento "event".
+int  Animation_AddTrack(AnimationSystem* system, const char* event, int target, AnimationChannel channel,
+                        AnimationInterp interp, AnimationLoop loop,
+                        const float* times, const float* values, int count);
+
+// Inicia (ou reinicia) no instante "time" todas as trilhas do evento.
+void Animation_Trigger(AnimationSystem* system, const char* event, double time);
+
+void Animation_Update(AnimationSystem* system, double time);
+
+// Animation_Update() em três etapas, para avaliar as trilhas em paralelo
+// (veja "jobs.h"): Animation_BeginUpdate() retorna quantas trilhas estão em
+// execução, Animation_EvaluateRange() avalia as trilhas [begin, end) dessa
+// lista (partes diferentes podem rodar ao mesmo tempo) e Animation_EndUpdate()
+// escreve os valores nos alvos. Trilhas não podem ser disparadas entre a
+// primeira e a última.
+size_t Animation_BeginUpdate(AnimationSystem* system);
+void   Animation_EvaluateRange(AnimationSystem* system, double time, size_t begin, size_t end);
+void   Animation_EndUpdate(AnimationSystem* system);
+void Animation_Apply(AnimationSystem* system, TransformGraph* graph);
+
+inline bool Animation_IsPlaying(const AnimationSystem& system, int track)
+{
+    return system.track_playing[track] != 0;
+}
+
+// Se alguma trilha do evento está em execução.
+bool Animation_IsEventPlaying(const AnimationSystem& system, const char* event);
+
+#endif // _ANIMATION_H
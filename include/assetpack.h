@@ -0,0 +1,77 @@
+#ifndef _ASSETPACK_H
+#define _ASSETPACK_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Acesso aos arquivos do jogo (imagens, modelos e shaders).
+//
+// Os arquivos são identificados por nomes relativos à raiz do projeto, por
+// exemplo "data/floor.jpg" ou "src/shader_vertex.glsl". Se um pacote (veja
+// abaixo) estiver aberto e contiver o nome, os dados vêm do pacote; caso
+// contrário o arquivo é lido do disco, relativo à raiz do projeto, que é
+// encontrada a partir do caminho do executável ("bin/Linux/main" ->
+// "../../"). Assim o jogo não depende mais do diretório corrente.
+//
+// Formato do pacote ("assets.pak", gerado por "make pack"):
+//
+//   +------------------+
+//   | AssetPackHeader  |
+//   +------------------+
+//   | dados            |  cada arquivo começa em um deslocamento múltiplo de
+//   |   ...            |  "alignment" (256 bytes), podendo ser enviado
+//   +------------------+  diretamente para um buffer da GPU
+//   | AssetPackEntry[] |  índice ordenado por nome (busca binária)
+//   +------------------+
+//   | nomes            |  nomes concatenados, sem terminador
+//   +------------------+
+//
+// Arquivos que ficam ao menos 10% menores são comprimidos com um codec LZ77
+// simples (ASSETPACK_COMPRESSED); os demais (JPEG, PNG) são armazenados como
+// estão. O pacote é mapeado em memória com mmap(), então abrir um arquivo do
+// pacote não faz nenhuma chamada de sistema. Todos os inteiros são
+// little-endian.
+
+// Bytes de um arquivo. "data" aponta para dentro do pacote mapeado (arquivos
+// não comprimidos) ou para um buffer próprio (arquivos comprimidos ou lidos do
+// disco), liberado por AssetPack_Free().
+struct AssetBlob
+{
+    const unsigned char* data;
+    size_t               size;
+    unsigned char*       owned;
+};
+
+// Abre o pacote "filename" (caminho no disco, normalmente ao lado do
+// executável). Retorna false se o arquivo não existir ou for inválido; nesse
+// caso todos os arquivos são lidos do disco.
+bool AssetPack_Open(const char* filename);
+void AssetPack_Close();
+bool AssetPack_IsOpen();
+
+// Lê o arquivo "name" do pacote ou do disco. Nomes absolutos, ou não
+// encontrados na raiz do projeto, são lidos relativos ao diretório corrente
+// (por exemplo, modelos passados na linha de comando).
+bool AssetPack_Load(const char* name, AssetBlob* blob);
+void AssetPack_Free(AssetBlob* blob);
+
+// Total de bytes lidos por AssetPack_Load() na thread atual (do disco, ou do
+// pacote, antes da descompressão). Usado pela linha do tempo de "startup.h".
+size_t AssetPack_GetBytesRead();
+
+// Caminho no disco de "name" (relativo à raiz do projeto).
+std::string AssetPack_LoosePath(const char* name);
+
+// Diretório que contém o executável, sem "/" no final.
+std::string AssetPack_ExecutableDirectory();
+
+// Cria um pacote com os arquivos "names" (relativos à raiz do projeto) e os
+// gerados em memória "generated" (nome -> conteúdo, por exemplo fases
+// compiladas). Utilizada pela ferramenta "mkpack".
+typedef std::map<std::string, std::vector<unsigned char> > AssetPackGenerated;
+bool AssetPack_Write(const char* filename, const std::vector<std::string>& names,
+                     const AssetPackGenerated& generated = AssetPackGenerated());
+
+#endif // _ASSETPACK_H
@@ -0,0 +1,39 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <glm/vec4.hpp>
+
+// Modo de benchmark ("--bench"): a janela fica invisível, sem vsync e sem
+// captura do mouse, e a câmera segue um roteiro fixo pela sala: cria os dois
+// portais, atravessa-os, carrega o cubo até o botão e passa pelo portão.
+// O tempo da simulação avança em passos fixos de BENCH_TIMESTEP, então todos
+// os quadros mostram exatamente a mesma cena em qualquer máquina; só o tempo
+// gasto para desenhá-los muda.
+//
+// Ao final de Bench_GetFrames() quadros o programa imprime o resumo de
+// tempos (veja "framestats.h") e termina. Funciona também sem GPU, com o
+// renderizador em software do Mesa (llvmpipe), por exemplo sob Xvfb.
+
+#define BENCH_TIMESTEP (1.0 / 60.0)
+
+// Entrada do roteiro em um quadro.
+struct BenchInput
+{
+    glm::vec4 position;     // Posição da câmera, ou deslocamento em relação ao cubo móvel
+    glm::vec4 look_at;      // Ponto para onde a câmera olha, ou deslocamento em relação ao cubo
+    bool      follow_cube;  // "position" é relativa ao cubo móvel
+    bool      aim_at_cube;  // "look_at" é relativo ao cubo móvel
+    bool      left_click;   // Dispara o portal 1
+    bool      right_click;  // Dispara o portal 2
+    bool      use;          // Pega ou solta o cubo (tecla E)
+};
+
+void   Bench_Init(int frames);
+bool   Bench_IsActive();
+int    Bench_GetFrames();
+double Bench_GetTime(int frame);
+
+// O roteiro se repete se "frames" for maior que sua duração.
+void   Bench_GetInput(int frame, BenchInput* input);
+
+#endif // _BENCH_H
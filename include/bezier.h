@@ -0,0 +1,143 @@
+#ifndef _BEZIER_H
+#define _BEZIER_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+// Curvas de Bézier usadas nas trilhas ANIM_BEZIER das animações (o cubo
+// móvel, veja "animation.h") e nas plataformas da cena de estresse (veja
+// "stressscene.h"). Definidas em "bezier.cpp", exceto os templates abaixo.
+//
+// BezierCurve<N> é uma curva de grau N (N+1 pontos de controle) de tamanho
+// fixo, avaliada pelo esquema de Horner com os coeficientes binomiais
+// calculados em tempo de compilação. Para movimento com velocidade constante,
+// Bezier_BakeArcLength() tabela o comprimento da curva, e
+// BezierArcLength::ParameterAt() converte uma fração do comprimento em um
+// parâmetro t.
+
+// Coeficiente binomial C(n, k).
+constexpr float Bezier_Binomial(int n, int k)
+{
+    return k == 0 ? 1.0f : Bezier_Binomial(n, k - 1) * (n - k + 1) / k;
+}
+
+template <int N>
+struct BezierCurve
+{
+    glm::vec3 points[N + 1];
+
+    // Ponto da curva em t (entre 0 e 1).
+    glm::vec3 Evaluate(float t) const
+    {
+        // Horner em s = t/(1-t):  sum C(N,i) t^i (1-t)^(N-i) P_i
+        //   = (1-t)^N * (...((C(N,N) P_N s + C(N,N-1) P_{N-1}) s + ...) + P_0).
+        // Perto de t = 1 avaliamos a curva invertida, em 1-t.
+        if (t > 0.5f)
+        {
+            float u = 1.0f - t;
+            float s = u / t;
+            glm::vec3 p = points[0];
+            float scale = 1.0f;
+            for (int i = 1; i <= N; ++i)
+            {
+                p = p * s + Bezier_Binomial(N, i) * points[i];
+                scale *= t;
+            }
+            return p * scale;
+        }
+        else
+        {
+            float u = 1.0f - t;
+            float s = t / u;
+            glm::vec3 p = points[N];
+            float scale = 1.0f;
+            for (int i = N - 1; i >= 0; --i)
+            {
+                p = p * s + Bezier_Binomial(N, i) * points[i];
+                scale *= u;
+            }
+            return p * scale;
+        }
+    }
+
+    // Derivada dB/dt, que é uma curva de grau N-1 nas diferenças dos pontos.
+    glm::vec3 Derivative(float t) const
+    {
+        BezierCurve<N - 1> hodograph;
+        for (int i = 0; i < N; ++i)
+            hodograph.points[i] = float(N) * (points[i + 1] - points[i]);
+        return hodograph.Evaluate(t);
+    }
+};
+
+template <>
+struct BezierCurve<0>
+{
+    glm::vec3 points[1];
+
+    glm::vec3 Evaluate(float) const   { return points[0]; }
+    glm::vec3 Derivative(float) const { return glm::vec3(0.0f); }
+};
+
+// Número de trechos da tabela de comprimento de arco.
+#define BEZIER_ARC_SAMPLES 32
+
+struct BezierArcLength
+{
+    // lengths[i] é o comprimento da curva de t = 0 até t = i/BEZIER_ARC_SAMPLES.
+    float lengths[BEZIER_ARC_SAMPLES + 1];
+
+    float Length() const { return lengths[BEZIER_ARC_SAMPLES]; }
+
+    // Parâmetro t em que o comprimento percorrido é "fraction" (entre 0 e 1)
+    // do comprimento total.
+    float ParameterAt(float fraction) const;
+};
+
+template <int N>
+void Bezier_BakeArcLength(const BezierCurve<N>& curve, BezierArcLength* arc)
+{
+    glm::vec3 previous = curve.points[0];
+    arc->lengths[0] = 0.0f;
+    for (int i = 1; i <= BEZIER_ARC_SAMPLES; ++i)
+    {
+        glm::vec3 p = curve.Evaluate((float)i / BEZIER_ARC_SAMPLES);
+        glm::vec3 d = p - previous;
+        arc->lengths[i] = arc->lengths[i - 1] + std::sqrt(d.x*d.x + d.y*d.y + d.z*d.z);
+        previous = p;
+    }
+}
+
+// out[i] = curves[i].Evaluate(t[i]).
+template <int N>
+void Bezier_EvaluateBatch(const BezierCurve<N>* curves, const float* t, glm::vec3* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = curves[i].Evaluate(t[i]);
+}
+
+// Como Bezier_EvaluateBatch(), mas com velocidade constante: "fractions" são
+// frações do comprimento de cada curva, convertidas por "arcs".
+template <int N>
+void Bezier_EvaluateUniformBatch(const BezierCurve<N>* curves, const BezierArcLength* arcs,
+                                 const float* fractions, glm::vec3* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = curves[i].Evaluate(arcs[i].ParameterAt(fractions[i]));
+}
+
+// Ponto da curva de grau count-1 em "time" (entre 0 e 1), para curvas cujo
+// grau só é conhecido em tempo de execução; usa o algoritmo de de Casteljau.
+glm::vec3 bezierCurve(const glm::vec3* points, size_t count, float time);
+glm::vec3 bezierCurve(const std::vector<glm::vec3>& points, float time);
+
+// Como Bezier_BakeArcLength() acima, para as curvas de bezierCurve().
+void Bezier_BakeArcLength(const glm::vec3* points, size_t count, BezierArcLength* arc);
+
+// Polinômio de Bernstein de índice k e grau n.
+float Bernstein(int k, int n, float t);
+
+#endif // _BEZIER_H
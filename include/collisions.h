@@ -0,0 +1,34 @@
+#ifndef _COLLISIONS_H
+#define _COLLISIONS_H
+
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "memtrack.h"
+
+// Testes de colisão usados pelo laço principal, contra as caixas (bbox) das
+// paredes, do cubo e dos portais. Definidos em "collisions.cpp".
+
+struct bbox
+{
+    glm::vec4    bbox_min;
+    glm::vec4    bbox_max;
+    double       angle;
+};
+
+// Listas de caixas de colisão, contabilizadas como memória da física (veja
+// "memtrack.h").
+typedef std::vector<bbox, MemTrackAllocator<bbox, MEM_PHYSICS> > BBoxList;
+
+// Verifica se o ponto "position" está dentro da caixa [hitbox_min, hitbox_max].
+bool detectColision(glm::vec4 position, glm::vec4 hitbox_min, glm::vec4 hitbox_max);
+
+// Verifica se o raio que parte de L1 na direção "vector_view" intersecta a
+// caixa [B1, B2]; o ponto de interseção é retornado em "Hit".
+int CheckLineBox( glm::vec4 B1, glm::vec4 B2, glm::vec4 L1, glm::vec4 vector_view, glm::vec4 &Hit);
+
+// Ângulo da diagonal da caixa [B1, B2] no plano XY.
+double boxAngle(glm::vec4 B1, glm::vec4 B2);
+
+#endif // _COLLISIONS_H
@@ -0,0 +1,289 @@
+#ifndef _ECS_H
+#define _ECS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "animation.h"
+#include "collisions.h"
+#include "memtrack.h"
+#include "transformgraph.h"
+
+// Entidades do jogo (objetos desenhados, paredes, portais, o cubo que pode ser
+// carregado, o botão, a saída...) e os sistemas que as atualizam. Definidos em
+// "ecs.cpp"; nenhum deles faz chamadas OpenGL, o desenho fica em "main.cpp".
+//
+// Uma entidade é só um identificador. Os dados ficam nos componentes, e cada
+// tipo de componente tem o seu "pool" (sparse set): um vetor denso com os
+// componentes, outro com a entidade dona de cada um, na ordem em que foram
+// adicionados, e um vetor esparso, indexado pela entidade, com a posição no
+// denso. Os tipos ficam separados uns dos outros (estrutura de vetores, como
+// em "animation.h" e "transformgraph.h"), então um sistema percorre só os
+// vetores densos dos componentes que usa, sem buracos. Buscar outro
+// componente da mesma entidade custa duas leituras (esparso e denso).
+//
+// Remover um componente move o último do vetor denso para o lugar dele; a
+// ordem de adição só é mantida enquanto nada é removido. A ordem importa para
+// as superfícies de portal: o primeiro acerto do raio ganha.
+//
+// Com isso, mais objetos de um tipo (por exemplo 500 cubos que podem ser
+// carregados) são só mais registros no arquivo da fase (veja "level.h").
+
+typedef uint32_t Entity;
+
+#define ECS_NO_ENTITY   0xFFFFFFFFu
+#define ECS_INDEX_BITS  24
+#define ECS_INDEX_MASK  ((1u << ECS_INDEX_BITS) - 1)
+
+inline uint32_t Entity_Index(Entity entity)      { return entity & ECS_INDEX_MASK; }
+inline uint32_t Entity_Generation(Entity entity) { return entity >> ECS_INDEX_BITS; }
+
+template <typename T>
+struct ComponentPool
+{
+    std::vector<uint32_t, MemTrackAllocator<uint32_t, MEM_ENTITIES> > sparse;   // Posição em "data" + 1, ou 0
+    std::vector<Entity, MemTrackAllocator<Entity, MEM_ENTITIES> >     entities;
+    std::vector<T, MemTrackAllocator<T, MEM_ENTITIES> >               data;
+};
+
+// Posição da câmera e dos objetos que os sistemas movem, e o nó da hierarquia
+// (ou TRANSFORM_ROOT) que os desenha.
+struct TransformComponent
+{
+    glm::vec3 position;
+    int       node;
+};
+
+enum RenderPass
+{
+    RENDER_SCENE,
+    RENDER_PORTALS,     // Desenhados depois da cena, na etapa "portals"
+    RENDER_PASS_COUNT
+};
+
+struct RenderableComponent
+{
+    int         node;           // Matriz global usada no desenho
+    int         object_id;      // Material, como em "main.cpp"
+    const char* object_name;    // Malha em g_VirtualScene
+    uint8_t     pass;           // RenderPass
+    bool        visible;
+    glm::vec3   bounds_min;     // Caixa da malha, em coordenadas locais; com
+    glm::vec3   bounds_max;     // bounds_min.x > bounds_max.x nunca é descartado
+};
+
+// Caixa sólida: a câmera não entra nela (com folga de 1 em x e z).
+struct ColliderComponent
+{
+    bbox box;
+};
+
+// Superfície onde portais podem ser abertos. Se "follow" não for
+// ECS_NO_ENTITY, a caixa acompanha a posição dessa entidade, deslocada por
+// "offset_min" e "offset_max" (é o caso do cubo móvel).
+struct PortalSurfaceComponent
+{
+    bbox      box;
+    Entity    follow;
+    glm::vec3 offset_min;
+    glm::vec3 offset_max;
+};
+
+struct PortalComponent
+{
+    bbox        box;            // bbox_min: posição do portal aberto; "angle" em torno de y
+    Entity      linked;         // Portal de saída
+    Entity      attached;       // Entidade onde foi aberto, que ele acompanha
+    glm::vec3   attach_offset;  // Posição relativa a "attached"
+    int         button;         // Índice do botão do mouse que o abre
+    int         target;         // Alvo de animação (veja "animation.h")
+    const char* open_event;     // Disparado ao abrir (a animação do portal)
+    double      last_time;      // Quando foi aberto pela última vez
+    bool        created;
+};
+
+// Objeto que pode ser carregado. "model_offset" é somado à posição no nó
+// desenhado quando ele está no chão.
+struct PickupComponent
+{
+    glm::vec3 model_offset;
+    bool      held;
+    bool      dropped;          // Solto neste quadro, ainda não foi para o chão
+};
+
+enum TriggerActivator
+{
+    TRIGGER_CAMERA,             // A câmera dentro de [bbox_min, bbox_max]
+    TRIGGER_PICKUP              // Um objeto solto perto de "position"
+};
+
+struct TriggerComponent
+{
+    glm::vec4   bbox_min;
+    glm::vec4   bbox_max;
+    glm::vec4   position;
+    glm::vec3   snap;           // TRIGGER_PICKUP: onde o objeto fica ao ativar
+    const char* event;          // Disparado na primeira ativação, ou NULL
+    const char* after;          // Só fica ativo depois deste evento, ou NULL
+    uint8_t     activator;      // TriggerActivator
+    bool        armed;
+    bool        inside;         // TRIGGER_CAMERA: a câmera está dentro
+    bool        fired;
+};
+
+// A posição da entidade vem do alvo de animação "target".
+struct AnimationComponent
+{
+    int target;
+};
+
+struct World
+{
+    std::vector<uint8_t>  generation;   // Por índice de entidade
+    std::vector<uint32_t> free_indices;
+    size_t                alive;
+
+    ComponentPool<TransformComponent>     transforms;
+    ComponentPool<RenderableComponent>    renderables;
+    ComponentPool<ColliderComponent>      colliders;
+    ComponentPool<PortalSurfaceComponent> portal_surfaces;
+    ComponentPool<PortalComponent>        portals;
+    ComponentPool<PickupComponent>        pickups;
+    ComponentPool<TriggerComponent>       triggers;
+    ComponentPool<AnimationComponent>     animations;
+
+    // Eventos disparados pelos sistemas e ainda não tratados pelo jogo (veja
+    // Ecs_TakeEvents()).
+    std::vector<const char*> events;
+
+    int held_node;                      // Nó onde o objeto carregado é desenhado
+
+    World() : alive(0), held_node(TRANSFORM_ROOT) {}
+};
+
+// Objetos a desenhar em cada etapa: posições em World::renderables.data, na
+// ordem do vetor.
+struct RenderList
+{
+    std::vector<uint32_t> items[RENDER_PASS_COUNT];
+};
+
+Entity World_CreateEntity(World* world);
+void   World_DestroyEntity(World* world, Entity entity);   // Remove também os componentes
+bool   World_IsAlive(const World& world, Entity entity);
+
+// Acrescenta (ou substitui) o componente de "entity" e retorna o componente
+// guardado. O ponteiro vale até o próximo Component_Add() no mesmo pool.
+template <typename T>
+T* Component_Add(ComponentPool<T>* pool, Entity entity, const T& value)
+{
+    uint32_t index = Entity_Index(entity);
+    if (index >= pool->sparse.size())
+        pool->sparse.resize(index + 1, 0);
+    uint32_t slot = pool->sparse[index];
+    if (slot != 0)
+    {
+        pool->data[slot - 1] = value;
+        return &pool->data[slot - 1];
+    }
+    pool->entities.push_back(entity);
+    pool->data.push_back(value);
+    pool->sparse[index] = (uint32_t)pool->data.size();
+    return &pool->data.back();
+}
+
+// NULL se a entidade não tiver o componente.
+template <typename T>
+T* Component_Get(ComponentPool<T>& pool, Entity entity)
+{
+    uint32_t index = Entity_Index(entity);
+    if (entity == ECS_NO_ENTITY || index >= pool.sparse.size() || pool.sparse[index] == 0
+     || pool.entities[pool.sparse[index] - 1] != entity)
+        return NULL;
+    return &pool.data[pool.sparse[index] - 1];
+}
+
+template <typename T>
+const T* Component_Get(const ComponentPool<T>& pool, Entity entity)
+{
+    return Component_Get(const_cast<ComponentPool<T>&>(pool), entity);
+}
+
+template <typename T>
+void Component_Remove(ComponentPool<T>* pool, Entity entity)
+{
+    if (Component_Get(*pool, entity) == NULL)
+        return;
+    uint32_t slot = pool->sparse[Entity_Index(entity)] - 1;
+    uint32_t last = (uint32_t)pool->data.size() - 1;
+    if (slot != last)
+    {
+        pool->data[slot]     = pool->data[last];
+        pool->entities[slot] = pool->entities[last];
+        pool->sparse[Entity_Index(pool->entities[slot])] = slot + 1;
+    }
+    pool->data.pop_back();
+    pool->entities.pop_back();
+    pool->sparse[Entity_Index(entity)] = 0;
+}
+
+// Sistemas, na ordem em que "main.cpp" os chama a cada quadro. "camera" é a
+// posição da câmera; "wall_height" é a altura das paredes, onde os portais
+// são abertos.
+
+// Indica se a câmera entrou em alguma caixa sólida. A versão com [begin, end)
+// testa só essas posições de world.colliders.data, para dividir a busca
+// entre tarefas (veja "jobs.h").
+bool Ecs_CameraBlocked(const World& world, const glm::vec4& camera);
+bool Ecs_CameraBlockedRange(const World& world, const glm::vec4& camera, size_t begin, size_t end);
+
+// Abre os portais cujo botão (bit 1 << PortalComponent::button de "buttons")
+// está pressionado, na primeira superfície atingida pelo raio "view" que
+// parte da câmera. Cada portal só pode ser reaberto 0.5 s depois.
+void Ecs_ShootPortals(World* world, const glm::vec4& camera, const glm::vec4& view, unsigned buttons,
+                      double time, float wall_height);
+
+// Pega o objeto mais próximo da câmera, ou solta o que está sendo carregado.
+void Ecs_TogglePickup(World* world, const glm::vec4& camera);
+
+// Objeto no chão perto da câmera, que pode ser pego, ou ECS_NO_ENTITY.
+Entity Ecs_FindPickupNear(const World& world, const glm::vec4& camera);
+
+// Move os objetos carregados com a câmera e põe no chão ("floor_y") os que
+// foram soltos, encaixando-os nos gatilhos TRIGGER_PICKUP próximos.
+void Ecs_UpdatePickups(World* world, TransformGraph* graph, const glm::vec4& camera, float floor_y);
+
+// Atualiza os gatilhos TRIGGER_CAMERA.
+void Ecs_UpdateTriggers(World* world, const glm::vec4& camera);
+
+// Dispara um evento: arma os gatilhos que esperam por ele e o guarda para o
+// jogo.
+void Ecs_FireEvent(World* world, const char* event);
+
+// Retorna, e esvazia, os eventos disparados desde a última chamada.
+void Ecs_TakeEvents(World* world, std::vector<const char*>* events);
+
+// Copia as posições animadas, move as superfícies de portal que acompanham
+// uma entidade e os portais abertos nelas, e passa a pose dos portais para os
+// seus alvos de animação.
+void Ecs_UpdateMovers(World* world, AnimationSystem* animations);
+
+// Atravessa os portais: se a câmera estiver na frente de um portal aberto e o
+// de saída também estiver aberto, ela vai para a frente do de saída e "theta"
+// é corrigido. Retorna quantas vezes a câmera atravessou.
+int Ecs_TeleportThroughPortals(World* world, glm::vec4* camera, float* theta, float wall_height);
+
+// Monta em "list" os objetos visíveis de world.renderables.data[begin, end):
+// os que estão marcados como visíveis e cuja caixa, levada por
+// "view_projection" vezes a matriz global do nó, não está inteira fora de um
+// mesmo plano do volume de visão. Usa as matrizes do último
+// TransformGraph_Update().
+void Ecs_BuildRenderList(const World& world, const TransformGraph& graph, const glm::mat4& view_projection,
+                         size_t begin, size_t end, RenderList* list);
+
+#endif // _ECS_H
@@ -0,0 +1,50 @@
+#ifndef _FRAMESTATS_H
+#define _FRAMESTATS_H
+
+#include <cstddef>
+
+// Estatísticas de tempo de quadro. A média de FPS esconde engasgos, então
+// guardamos o tempo de CPU e de GPU de cada quadro em histogramas de faixa
+// dinâmica alta (estilo HdrHistogram: erro relativo abaixo de 2% de 1 us a
+// mais de uma hora), de onde saem os percentis p50/p90/p99/p99.9 e o máximo.
+//
+// Um quadro é um "engasgo" (hitch) se demorar mais que o limite dado a
+// FrameStats_Init() ou mais que o dobro da mediana. Cada engasgo é registrado
+// com os eventos anotados durante o quadro (FrameStats_Annotate()), como
+// teletransporte por portal, animação do portão ou envio de assets à GPU.
+//
+// Uso, a cada quadro:
+//
+//     FrameStats_Annotate("portal teleport");   // Quando algo acontece
+//     ...
+//     FrameStats_EndFrame(cpu_ms);
+//     if (Profiler_GetLastGpuFrameMs(&gpu_ms))
+//         FrameStats_AddGpuSample(PROFILER_GPU_FRAMES, gpu_ms);
+
+struct FrameStatsSummary
+{
+    size_t count;
+    double p50, p90, p99, p999, max;
+    double mean;
+};
+
+void FrameStats_Init(double hitch_ms);
+
+// "event" deve ser uma string constante (o ponteiro é guardado).
+void FrameStats_Annotate(const char* event);
+
+void FrameStats_EndFrame(double cpu_ms);
+
+// Tempo de GPU do quadro terminado "frames_ago" quadros antes do atual.
+void FrameStats_AddGpuSample(int frames_ago, double gpu_ms);
+
+void   FrameStats_GetSummary(bool gpu, FrameStatsSummary* summary);
+size_t FrameStats_GetHitchCount();
+
+void FrameStats_Print();
+
+// Escreve um quadro por linha em CSV, ou o resumo e os engasgos em JSON,
+// conforme a extensão de "filename" (".csv" ou ".json").
+bool FrameStats_Write(const char* filename);
+
+#endif // _FRAMESTATS_H
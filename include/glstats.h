@@ -0,0 +1,72 @@
+#ifndef _GLSTATS_H
+#define _GLSTATS_H
+
+#include <cstddef>
+
+// Contabilidade de chamadas OpenGL. GLStats_Install() troca os ponteiros de
+// função da GLAD (glad_glDrawElements, glad_glUseProgram, ...) por versões que
+// contam a chamada e então chamam a função original. Assim nenhum código que
+// usa OpenGL precisa ser alterado.
+//
+// Por quadro são contados: chamadas de desenho e triângulos, trocas de VAO,
+// programa, textura/sampler e buffer, envios de uniforms e bytes enviados por
+// glBufferData()/glBufferSubData(). Chamadas redundantes (que repetem o valor
+// já definido, como ligar o VAO que já está ligado ou enviar de novo o mesmo
+// valor para um uniform do mesmo programa) são contadas à parte.
+//
+// Os contadores aparecem no overlay do profiler (tecla F3) e no relatório do
+// modo de benchmark. Em builds de release (-DNDEBUG), ou com
+// -DGLSTATS_ENABLED=0, o módulo não é compilado: as funções abaixo são vazias
+// e as chamadas OpenGL vão direto para o driver.
+
+#ifndef GLSTATS_ENABLED
+#ifdef NDEBUG
+#define GLSTATS_ENABLED 0
+#else
+#define GLSTATS_ENABLED 1
+#endif
+#endif
+
+struct GLStats
+{
+    size_t draw_calls;
+    size_t triangles;
+    size_t vao_binds;
+    size_t program_binds;
+    size_t texture_binds;       // glBindTexture() e glBindSampler()
+    size_t buffer_binds;
+    size_t uniform_uploads;
+    size_t buffer_bytes;        // glBufferData() e glBufferSubData()
+
+    size_t redundant_vao_binds;
+    size_t redundant_program_binds;
+    size_t redundant_texture_binds;
+    size_t redundant_uniforms;
+};
+
+#if GLSTATS_ENABLED
+
+// Deve ser chamada logo após gladLoadGLLoader().
+void GLStats_Install();
+
+// Fecha os contadores do quadro atual. Chamada uma vez por quadro, após
+// glfwSwapBuffers().
+void GLStats_EndFrame();
+
+const GLStats& GLStats_GetLastFrame();
+
+// Média por quadro desde GLStats_Install(); retorna o número de quadros.
+size_t GLStats_GetAverage(GLStats* average);
+void   GLStats_Print();
+
+#else
+
+inline void GLStats_Install() {}
+inline void GLStats_EndFrame() {}
+inline const GLStats& GLStats_GetLastFrame() { static const GLStats zero = GLStats(); return zero; }
+inline size_t GLStats_GetAverage(GLStats* average) { *average = GLStats(); return 0; }
+inline void GLStats_Print() {}
+
+#endif // GLSTATS_ENABLED
+
+#endif // _GLSTATS_H
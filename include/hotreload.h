@@ -0,0 +1,27 @@
+#ifndef _HOTRELOAD_H
+#define _HOTRELOAD_H
+
+#include <string>
+#include <vector>
+
+// Observa diretórios em busca de arquivos alterados (inotify no Linux). Uma
+// thread auxiliar acumula os nomes dos arquivos escritos ou movidos para dentro
+// dos diretórios, e a thread principal os consome uma vez por quadro com
+// HotReload_PollChanges(), decidindo o que recarregar (veja
+// ReloadChangedFiles() em "main.cpp").
+//
+// Em outros sistemas operacionais HotReload_Init() retorna false e nenhuma
+// alteração é reportada; a tecla R continua recarregando os shaders.
+
+// Os diretórios são relativos à raiz do projeto (veja AssetPack_LoosePath()),
+// por exemplo "data". Somente arquivos terminados em uma das "extensions"
+// (por exemplo ".glsl") são reportados.
+bool HotReload_Init(const std::vector<std::string>& directories, const std::vector<std::string>& extensions);
+void HotReload_Shutdown();
+
+// Preenche "files" com os arquivos alterados desde a última chamada, no formato
+// "<diretório>/<nome>" (o mesmo nome usado por AssetPack_Load()), sem
+// repetições. Não bloqueia.
+void HotReload_PollChanges(std::vector<std::string>* files);
+
+#endif // _HOTRELOAD_H
@@ -0,0 +1,64 @@
+#ifndef _INPUTREPLAY_H
+#define _INPUTREPLAY_H
+
+#include <cstdint>
+
+// Gravação e reprodução de entrada. Toda a entrada do jogo chega pelas
+// funções de callback (KeyCallback(), MouseButtonCallback() e
+// CursorPosCallback() em "main.cpp"), que alteram variáveis globais na hora.
+// Com "--record=arquivo" cada evento é gravado, junto com o índice do quadro
+// em que passa a ter efeito; com "--replay=arquivo" os mesmos eventos são
+// entregues às callbacks no início dos mesmos quadros, e a entrada real da
+// GLFW é ignorada.
+//
+// Nos dois modos a simulação avança em passos fixos (gravados no arquivo), de
+// forma que a reprodução repete a sessão gravada exatamente, e pode ser
+// executada sob um profiler.
+//
+// Formato do arquivo (na ordem de bytes da máquina):
+//
+//     InputFileHeader
+//     InputEvent[]        // Em ordem de quadro; termina com INPUT_END
+
+#define INPUT_FILE_MAGIC   0x504E4950  // "PINP"
+#define INPUT_FILE_VERSION 1
+
+enum InputEventType
+{
+    INPUT_KEY          = 1,  // a = key, b = scancode, c = action, d = mods
+    INPUT_MOUSE_BUTTON = 2,  // a = button, c = action, d = mods, x/y = cursor
+    INPUT_CURSOR_POS   = 3,  // x/y = cursor
+    INPUT_END          = 4,  // "frame" = número de quadros gravados
+};
+
+struct InputFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    double   timestep;   // Passo fixo da simulação, em segundos
+};
+
+struct InputEvent
+{
+    uint32_t frame;      // Quadro em que o evento é visto pela simulação
+    uint32_t type;
+    double   time;       // Tempo real desde o início da gravação (informativo)
+    int32_t  a, b, c, d;
+    double   x, y;
+};
+
+bool InputRecord_Start(const char* filename, double timestep);
+void InputRecord_Stop(uint32_t frames);
+bool InputRecord_IsActive();
+void InputRecord_Event(const InputEvent& event);
+
+bool     InputReplay_Start(const char* filename);
+void     InputReplay_Stop();
+bool     InputReplay_IsActive();
+double   InputReplay_GetTimestep();
+uint32_t InputReplay_GetFrames();  // Número de quadros da sessão gravada
+
+// Próximo evento do quadro "frame", se houver.
+bool     InputReplay_Next(uint32_t frame, InputEvent* event);
+
+#endif // _INPUTREPLAY_H
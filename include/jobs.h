@@ -0,0 +1,61 @@
+#ifndef _JOBS_H
+#define _JOBS_H
+
+#include <cstddef>
+
+// Sistema de tarefas ("jobs") do quadro. Definido em "jobs.cpp".
+//
+// Cada thread auxiliar ("worker") tem a sua fila dupla (deque) de tarefas
+// prontas: a dona empilha e retira do fim, e uma thread sem trabalho rouba do
+// início da fila de outra ("work stealing"). A thread principal também tem
+// uma fila e executa tarefas enquanto espera em Jobs_Wait(), então com zero
+// workers tudo roda nela, na ordem das dependências.
+//
+// Uma tarefa pode depender de outras: ela guarda quantas dependências ainda
+// não terminaram, e a última a terminar a coloca na fila de quem a terminou.
+// O grafo do quadro é montado pela thread principal com Jobs_Add() (as
+// tarefas sem dependências pendentes começam na hora) e desfeito por
+// Jobs_EndFrame(), que espera todas terminarem.
+//
+// As tarefas não podem fazer chamadas OpenGL: o contexto é da thread
+// principal, que desenha depois de esperar pelas tarefas de que precisa.
+//
+// Cada tarefa é gravada na linha do tempo de "trace.h", na thread que a
+// executou, e Jobs_EndFrame() passa ao profiler (veja "profiler.h") o tempo
+// de cada nome, somado entre as partes de uma tarefa dividida.
+
+#define JOBS_MAX_THREADS 16     // Incluindo a thread principal
+#define JOBS_MAX         65536  // Tarefas por quadro; passar disso encerra o programa
+#define JOB_NONE         (-1)
+
+typedef int JobId;
+
+// Executa a parte [begin, end) da tarefa. Tarefas não divididas recebem
+// [0, 1).
+typedef void (*JobFunction)(void* data, size_t begin, size_t end);
+
+// Cria "workers" threads auxiliares; com um valor negativo, uma a menos que o
+// número de núcleos. Deve ser chamada pela thread principal.
+void Jobs_Init(int workers);
+void Jobs_Shutdown();
+int  Jobs_GetWorkerCount();
+
+// Acrescenta uma tarefa que começa depois de "dependencies" (entradas iguais
+// a JOB_NONE são ignoradas). "name" deve ser uma string constante. Com
+// "function" igual a NULL a tarefa só junta as dependências.
+JobId Jobs_Add(const char* name, JobFunction function, void* data,
+               const JobId* dependencies = NULL, int dependency_count = 0);
+
+// Divide [0, count) em partes de até "batch" elementos, cada uma uma tarefa,
+// e retorna uma tarefa que termina junto com a última parte.
+JobId Jobs_AddParallel(const char* name, JobFunction function, void* data, size_t count, size_t batch,
+                       const JobId* dependencies = NULL, int dependency_count = 0);
+
+// Executa tarefas na thread principal até "job" terminar.
+void Jobs_Wait(JobId job);
+
+// Espera todas as tarefas do quadro, envia os tempos para o profiler e
+// libera os identificadores. Deve ser chamada antes de Profiler_EndFrame().
+void Jobs_EndFrame();
+
+#endif // _JOBS_H
@@ -0,0 +1,201 @@
+#ifndef _LEVEL_H
+#define _LEVEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "affine.h"
+#include "collisions.h"
+
+// Fases descritas em arquivos de dados. Definidas em "level.cpp".
+//
+// Uma fase é escrita à mão em texto ("data/level1.level") e compilada por
+// Level_Compile() para um formato binário ("data/level1.lvl"), que é o que
+// vai para o pacote (veja "make pack"). Sem o pacote, o texto é compilado ao
+// carregar, então basta editar o arquivo e executar o jogo de novo.
+//
+// Formato do texto: um registro por linha, "#" inicia um comentário.
+//
+//   placement <material> <malha> [name <nome>] [dynamic] [trs]
+//             position x y z [rotate <x|y|z> <graus>]... scale x y z
+//       Objeto desenhado: material como em "main.cpp" (FLOOR, WALL, ...) e
+//       nome da malha em g_VirtualScene. As rotações são compostas da
+//       esquerda para a direita; a matriz é T * S * R, ou T * R * S com "trs".
+//       Objetos "dynamic" (animados ou movidos pelo jogo) ficam depois dos
+//       estáticos na hierarquia de transformações (veja "transformgraph.h").
+//
+//   collider <nome> min x y z max x y z [solid] [portal] [portal_after <evento>]
+//       Caixa de colisão ("solid") e/ou superfície onde portais podem ser
+//       abertos, desde o início ou depois do evento.
+//
+//   trigger <nome> min x y z max x y z [after <evento>]
+//       Volume nomeado, ativado pela câmera (por exemplo a saída); com "after",
+//       só depois do evento.
+//
+//   marker <nome> x y z [event <evento>]
+//       Ponto nomeado; "event" é disparado quando o jogo o ativa (por exemplo
+//       o botão, quando o cubo é colocado sobre ele).
+//
+//   pickup <material> <malha> x y z
+//       Objeto que pode ser carregado (tecla E) e colocado sobre um marcador.
+//
+//   track <evento> <objeto> <canal> <interpolação> <repetição> t:v t:v ...
+//       Trilha de animação (veja "animation.h") do objeto com nome <objeto>:
+//       canal translate_x ... scale_z, interpolação step, linear, smooth ou
+//       bezier, repetição once, repeat ou pingpong.
+//
+// Formato binário: um LevelHeader seguido das seções que ele indica, cada
+// uma começando em um deslocamento múltiplo de 8. Os registros já estão no
+// formato usado pelo jogo: matrizes de modelagem prontas, caixas de colisão
+// como "bbox" (com o ângulo calculado) e superfícies de portal agrupadas por
+// evento. Carregar uma fase é validar o cabeçalho e copiar o arquivo; as
+// listas de colisão e de portais são montadas copiando vetores inteiros.
+// Todos os inteiros são little-endian, e as caixas têm o tamanho de "bbox" da
+// plataforma que compilou a fase (o pacote é gerado na mesma máquina).
+
+#define LEVEL_VERSION 2
+#define LEVEL_NONE    0xFFFFFFFFu   // Deslocamento de texto ausente
+
+enum LevelPlacementFlags
+{
+    LEVEL_DYNAMIC = 1,
+    LEVEL_TSR     = 2   // T * S * R (padrão do texto); sem ela, T * R * S
+};
+
+struct LevelSection
+{
+    uint32_t offset;    // Em bytes, a partir do início do arquivo
+    uint32_t count;     // Em registros
+};
+
+struct LevelHeader
+{
+    char         magic[4];      // "LEVL"
+    uint32_t     version;
+    uint32_t     static_placement_count;
+    uint32_t     bbox_size;     // sizeof(bbox) de quem compilou a fase
+    LevelSection placements;    // LevelPlacement, estáticos primeiro
+    LevelSection colliders;     // bbox
+    LevelSection portal_surfaces; // bbox, agrupadas por evento
+    LevelSection portal_groups; // LevelPortalGroup
+    LevelSection triggers;      // LevelTrigger
+    LevelSection markers;       // LevelMarker
+    LevelSection pickups;       // LevelPickup
+    LevelSection tracks;        // LevelTrack
+    LevelSection key_times;     // float
+    LevelSection key_values;    // float
+    LevelSection strings;       // char, textos terminados em zero
+};
+
+struct LevelPlacement
+{
+    Affine   local;             // Matriz de modelagem já calculada
+    float    translation[3];    // Pose decomposta, para os alvos de animação
+    float    rotation[4];       // Quatérnio (x, y, z, w)
+    float    scale[3];
+    int32_t  object_id;
+    uint32_t mesh;              // Deslocamentos em "strings"
+    uint32_t name;              // LEVEL_NONE se o objeto não tiver nome
+    uint32_t flags;             // LevelPlacementFlags
+};
+
+struct LevelPortalGroup
+{
+    uint32_t event;             // LEVEL_NONE: superfícies disponíveis desde o início
+    uint32_t first;
+    uint32_t count;
+};
+
+struct LevelTrigger
+{
+    uint32_t name;
+    uint32_t after;             // LEVEL_NONE: ativo desde o início
+    float    bbox_min[3];
+    float    bbox_max[3];
+};
+
+struct LevelMarker
+{
+    uint32_t name;
+    uint32_t event;             // LEVEL_NONE se não dispara evento
+    float    position[3];
+};
+
+struct LevelPickup
+{
+    int32_t  object_id;
+    uint32_t mesh;
+    float    position[3];
+};
+
+struct LevelTrack
+{
+    uint32_t event;
+    uint32_t placement;
+    uint8_t  channel;           // AnimationChannel
+    uint8_t  interp;            // AnimationInterp
+    uint8_t  loop;              // AnimationLoop
+    uint8_t  reserved;
+    uint32_t first_key;
+    uint32_t key_count;
+};
+
+// Fase carregada. Os ponteiros apontam para dentro de "data".
+struct Level
+{
+    std::vector<unsigned char> data;
+
+    const LevelPlacement*   placements;
+    size_t                  placement_count;
+    size_t                  static_placement_count;
+    const bbox*             colliders;
+    size_t                  collider_count;
+    const bbox*             portal_surfaces;
+    const LevelPortalGroup* portal_groups;
+    size_t                  portal_group_count;
+    const LevelTrigger*     triggers;
+    size_t                  trigger_count;
+    const LevelMarker*      markers;
+    size_t                  marker_count;
+    const LevelPickup*      pickups;
+    size_t                  pickup_count;
+    const LevelTrack*       tracks;
+    size_t                  track_count;
+    const float*            key_times;
+    const float*            key_values;
+    const char*             strings;
+
+    Level()
+        : placements(NULL), placement_count(0), static_placement_count(0), colliders(NULL), collider_count(0),
+          portal_surfaces(NULL), portal_groups(NULL), portal_group_count(0), triggers(NULL), trigger_count(0),
+          markers(NULL), marker_count(0), pickups(NULL), pickup_count(0), tracks(NULL), track_count(0), key_times(NULL), key_values(NULL),
+          strings(NULL) {}
+};
+
+// Compila o texto de uma fase para o formato binário. Erros são impressos
+// com o nome "source_name" e o número da linha; retorna false se houver algum.
+bool Level_Compile(const char* text, size_t size, const char* source_name, std::vector<unsigned char>* binary);
+
+// Valida e copia uma fase no formato binário.
+bool Level_LoadMemory(const unsigned char* binary, size_t size, Level* level);
+
+// Carrega "<name>.lvl" (por exemplo do pacote) ou, se não existir, compila
+// "<name>.level". Com "name" igual a "data/level1": "data/level1.lvl".
+bool Level_Load(const char* name, Level* level);
+
+inline const char* Level_String(const Level& level, uint32_t offset)
+{
+    return offset == LEVEL_NONE ? NULL : level.strings + offset;
+}
+
+// Retornam -1 (ou NULL) se não houver registro com o nome.
+int                 Level_FindPlacement(const Level& level, const char* name);
+const LevelTrigger* Level_FindTrigger(const Level& level, const char* name);
+const LevelMarker*  Level_FindMarker(const Level& level, const char* name);
+
+// Acrescenta a "list" as superfícies de portal liberadas pelo evento, ou as
+// disponíveis desde o início se "event" for NULL.
+void Level_AppendPortalSurfaces(const Level& level, const char* event, BBoxList* list);
+
+#endif // _LEVEL_H
@@ -0,0 +1,87 @@
+#ifndef _MEMTRACK_H
+#define _MEMTRACK_H
+
+#include <cstddef>
+#include <new>
+
+// Contabilidade de memória por subsistema. Cada alocação de memória de vídeo
+// (buffers e texturas OpenGL) e as principais alocações de memória da CPU são
+// atribuídas a uma categoria. Para cada categoria guardamos o total atual e o
+// máximo atingido (high-water mark), tanto de CPU quanto de GPU.
+//
+// O tamanho real de uma textura na GPU não é visível em OpenGL; estimamos com
+// MemTrack_TextureBytes(), que soma toda a cadeia de mipmaps.
+//
+// As funções podem ser chamadas de qualquer thread. Contêineres da STL podem
+// ser contabilizados com MemTrackAllocator:
+//
+//     std::vector<bbox, MemTrackAllocator<bbox, MEM_PHYSICS> > boxes;
+//
+// Em "main.cpp": tecla F5 mostra o overlay, F6 imprime o relatório no
+// terminal, e o relatório com os máximos é impresso ao sair.
+
+enum MemCategory
+{
+    MEM_MESHES,     // Buffers de vértices; MeshData aguardando envio
+    MEM_TEXTURES,   // Texturas e PBOs; imagens decodificadas aguardando envio
+    MEM_TEXT,       // Atlas da fonte e buffer de texto
+    MEM_PHYSICS,    // Caixas de colisão
+    MEM_ASSETS,     // Pacote de assets e arquivos lidos por AssetPack_Load()
+    MEM_ENTITIES,   // Componentes das entidades do jogo (veja "ecs.h")
+    MEM_CATEGORY_COUNT
+};
+
+struct MemTrackUsage
+{
+    size_t cpu_bytes;
+    size_t cpu_peak_bytes;
+    size_t gpu_bytes;
+    size_t gpu_peak_bytes;
+};
+
+void MemTrack_CpuAlloc(MemCategory category, size_t bytes);
+void MemTrack_CpuFree(MemCategory category, size_t bytes);
+void MemTrack_GpuAlloc(MemCategory category, size_t bytes);
+void MemTrack_GpuFree(MemCategory category, size_t bytes);
+
+// Bytes de uma textura de width x height texels, com ou sem mipmaps.
+size_t MemTrack_TextureBytes(int width, int height, int bytes_per_texel, bool mipmaps);
+
+const char* MemTrack_CategoryName(MemCategory category);
+
+// Uso de uma categoria, ou o total de todas (MEM_CATEGORY_COUNT). O máximo do
+// total é o máximo da soma, e não a soma dos máximos.
+void MemTrack_GetUsage(MemCategory category, MemTrackUsage* usage);
+
+void MemTrack_Print();
+
+// Alocador para contêineres da STL que contabiliza em "C".
+template <typename T, MemCategory C>
+struct MemTrackAllocator
+{
+    typedef T value_type;
+
+    template <typename U> struct rebind { typedef MemTrackAllocator<U, C> other; };
+
+    MemTrackAllocator() {}
+    template <typename U> MemTrackAllocator(const MemTrackAllocator<U, C>&) {}
+
+    T* allocate(size_t n)
+    {
+        MemTrack_CpuAlloc(C, n * sizeof(T));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        MemTrack_CpuFree(C, n * sizeof(T));
+        ::operator delete(p);
+    }
+};
+
+template <typename T, typename U, MemCategory C>
+bool operator==(const MemTrackAllocator<T, C>&, const MemTrackAllocator<U, C>&) { return true; }
+template <typename T, typename U, MemCategory C>
+bool operator!=(const MemTrackAllocator<T, C>&, const MemTrackAllocator<U, C>&) { return false; }
+
+#endif // _MEMTRACK_H
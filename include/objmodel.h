@@ -0,0 +1,149 @@
+#ifndef _OBJMODEL_H
+#define _OBJMODEL_H
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+#include <glm/vec3.hpp>
+
+// Headers da biblioteca para carregar modelos obj
+#include <tiny_obj_loader.h>
+
+#include "assetpack.h"
+
+// Lê arquivos ".mtl" através de AssetPack_Load(), do pacote ou do disco.
+class AssetMaterialReader : public tinyobj::MaterialReader
+{
+public:
+    explicit AssetMaterialReader(const std::string& basedir) : m_basedir(basedir) {}
+    virtual bool operator()(const std::string& matId,
+                            std::vector<tinyobj::material_t>* materials,
+                            std::map<std::string, int>* matMap, std::string* warn,
+                            std::string* err);
+private:
+    std::string m_basedir;
+};
+
+// Estrutura que representa um modelo geométrico carregado a partir de um
+// arquivo ".obj". Veja https://en.wikipedia.org/wiki/Wavefront_.obj_file .
+struct ObjModel
+{
+    tinyobj::attrib_t                 attrib;
+    std::vector<tinyobj::shape_t>     shapes;
+    std::vector<tinyobj::material_t>  materials;
+
+    // Modelo vazio, preenchido diretamente (veja "microbench.cpp").
+    ObjModel() {}
+
+    // Este construtor lê o modelo de um arquivo (do pacote ou do disco, veja
+    // "assetpack.h") utilizando a biblioteca tinyobjloader.
+    // Veja: https://github.com/syoyo/tinyobjloader
+    ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true)
+    {
+        printf("Carregando objetos do arquivo \"%s\"...\n", filename);
+
+        // Se basepath == NULL, então setamos basepath como o dirname do
+        // filename, para que os arquivos MTL sejam corretamente carregados caso
+        // estejam no mesmo diretório dos arquivos OBJ.
+        std::string fullpath(filename);
+        std::string dirname;
+        if (basepath == NULL)
+        {
+            auto i = fullpath.find_last_of("/");
+            if (i != std::string::npos)
+            {
+                dirname = fullpath.substr(0, i+1);
+                basepath = dirname.c_str();
+            }
+        }
+
+        AssetBlob blob;
+        if (!AssetPack_Load(filename, &blob))
+        {
+            fprintf(stderr, "ERROR: Cannot open file \"%s\".\n", filename);
+            throw std::runtime_error("Erro ao carregar modelo.");
+        }
+        std::istringstream stream(std::string((const char*)blob.data, blob.size));
+        AssetPack_Free(&blob);
+
+        std::string warn;
+        std::string err;
+        AssetMaterialReader material_reader(basepath ? basepath : "");
+        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream, &material_reader, triangulate);
+
+        if (!err.empty())
+            fprintf(stderr, "\n%s\n", err.c_str());
+
+        if (!ret)
+            throw std::runtime_error("Erro ao carregar modelo.");
+
+        for (size_t shape = 0; shape < shapes.size(); ++shape)
+        {
+            if (shapes[shape].name.empty())
+            {
+                fprintf(stderr,
+                        "*********************************************\n"
+                        "Erro: Objeto sem nome dentro do arquivo '%s'.\n"
+                        "Veja https://www.inf.ufrgs.br/~eslgastal/fcg-faq-etc.html#Modelos-3D-no-formato-OBJ .\n"
+                        "*********************************************\n",
+                    filename);
+                throw std::runtime_error("Objeto sem nome.");
+            }
+            printf("- Objeto '%s'\n", shapes[shape].name.c_str());
+        }
+
+        printf("OK.\n");
+    }
+};
+
+// Definimos uma estrutura que armazenará dados necessários para renderizar
+// cada objeto da cena virtual.
+struct SceneObject
+{
+    std::string  name;        // Nome do objeto
+    size_t       first_index; // Índice do primeiro vértice dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
+    size_t       num_indices; // Número de índices do objeto dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
+    GLenum       rendering_mode; // Modo de rasterização (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
+    GLuint       vertex_array_object_id; // ID do VAO onde estão armazenados os atributos do modelo
+    glm::vec3    bbox_min; // Axis-Aligned Bounding Box do objeto
+    glm::vec3    bbox_max;
+};
+
+// Atributos de vértices de um ObjModel já organizados para envio à GPU, mas
+// ainda em memória da CPU. Pode ser construído fora da thread do contexto
+// OpenGL (veja BuildMeshData()), e enviado depois com UploadMeshData().
+struct MeshData
+{
+    std::vector<GLuint>       indices;
+    std::vector<float>        model_coefficients;
+    std::vector<float>        normal_coefficients;
+    std::vector<float>        texture_coefficients;
+    std::vector<SceneObject>  objects; // vertex_array_object_id ainda não definido
+
+    size_t SizeInBytes() const
+    {
+        return indices.size() * sizeof(GLuint)
+             + (model_coefficients.size() + normal_coefficients.size() + texture_coefficients.size()) * sizeof(float);
+    }
+};
+
+// Objetos OpenGL criados para uma MeshData, necessários para liberar a malha.
+struct GpuMesh
+{
+    GLuint vertex_array_object_id;
+    GLuint buffers[4];
+    int    num_buffers;
+    size_t bytes;
+};
+
+// Definidas em "objmodel.cpp". Não fazem chamadas OpenGL.
+void ComputeNormals(ObjModel* model); // Computa normais de um ObjModel, caso não existam.
+void BuildMeshData(ObjModel* model, MeshData* mesh); // Constrói os atributos de vértices de um ObjModel
+
+#endif // _OBJMODEL_H
@@ -0,0 +1,91 @@
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// Profiler de quadros: mede o tempo de CPU de trechos do laço principal
+// ("escopos", que podem ser aninhados) e o tempo de GPU de passes de
+// renderização, através de pares de consultas GL_TIME_ELAPSED.
+//
+// As consultas de GPU ficam em um buffer circular de PROFILER_GPU_FRAMES
+// quadros: o resultado de um quadro só é lido PROFILER_GPU_FRAMES quadros
+// depois, quando a GPU certamente já terminou, e se ainda não estiver
+// disponível é descartado. Assim o profiler nunca bloqueia esperando pela GPU.
+//
+// Uso:
+//
+//     Profiler_BeginFrame();
+//     {
+//         PROFILE_SCOPE("sim");            // Termina no fim do bloco
+//         ...
+//     }
+//     Profiler_BeginScope("render");       // Ou explicitamente
+//     Profiler_BeginGpuScope("scene");
+//     ...
+//     Profiler_EndGpuScope();
+//     Profiler_EndScope();
+//     Profiler_EndFrame();
+//
+// Os escopos de CPU também são gravados na linha do tempo de "trace.h".
+//
+// O tempo das tarefas executadas fora da thread principal (veja "jobs.h")
+// chega por Profiler_AddJobTime() e aparece com o nome da tarefa, somado entre
+// as threads; pode passar do tempo do quadro.
+//
+// Escopos de CPU devem ser usados somente na thread principal. Escopos de GPU
+// não podem ser aninhados (limitação de GL_TIME_ELAPSED).
+
+#define PROFILER_GPU_FRAMES     4
+#define PROFILER_MAX_GPU_SCOPES 16
+
+// Tempo médio (média móvel exponencial) de um escopo.
+struct ProfilerResult
+{
+    const char* name;
+    int         depth;   // Nível de aninhamento (0 = escopo mais externo)
+    bool        gpu;
+    bool        job;     // Tempo de uma tarefa de "jobs.h"
+    double      ms;
+};
+
+void Profiler_Init();     // Requer o contexto OpenGL
+void Profiler_Shutdown();
+
+void Profiler_BeginFrame();
+void Profiler_EndFrame();
+
+// "name" deve ser uma string constante (o ponteiro é guardado).
+void Profiler_BeginScope(const char* name);
+void Profiler_EndScope();
+void Profiler_BeginGpuScope(const char* name);
+void Profiler_EndGpuScope();
+
+// Tempo de CPU de uma tarefa no quadro atual, somado ao de outras com o mesmo
+// nome. Somente na thread principal (Jobs_EndFrame() a chama).
+void Profiler_AddJobTime(const char* name, double ms);
+
+// Resultados na ordem em que os escopos foram abertos no quadro, primeiro os de
+// CPU, depois as tarefas e por fim os de GPU.
+size_t Profiler_GetResults(const ProfilerResult** results);
+double Profiler_GetCpuFrameMs();  // Tempo entre Profiler_BeginFrame() e Profiler_EndFrame()
+double Profiler_GetGpuFrameMs();  // Soma dos escopos de GPU
+
+// Valores do último quadro, sem média (veja "framestats.h"). O tempo de GPU é o
+// do quadro PROFILER_GPU_FRAMES antes do atual, e só existe se as consultas
+// dele foram lidas no último Profiler_BeginFrame().
+double Profiler_GetLastCpuFrameMs();
+bool   Profiler_GetLastGpuFrameMs(double* ms);
+
+struct ProfilerScope
+{
+    ProfilerScope(const char* name) { Profiler_BeginScope(name); }
+    ~ProfilerScope() { Profiler_EndScope(); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfilerScope PROFILE_CONCAT(profiler_scope_, __LINE__)(name)
+
+#endif // _PROFILER_H
@@ -0,0 +1,41 @@
+#ifndef _PROGRAMCACHE_H
+#define _PROGRAMCACHE_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Cache em disco de programas de GPU já linkados (glGetProgramBinary() /
+// glProgramBinary()), evitando compilar GLSL a cada execução.
+//
+// A chave de um programa é um hash de todos os códigos-fonte (incluindo
+// quaisquer "#define" adicionados a eles) e do fabricante, renderizador e
+// versão do driver; qualquer alteração em um deles gera uma nova entrada. Se a
+// extensão GL_ARB_get_program_binary (ou OpenGL 4.1) não estiver disponível,
+// ou se o driver rejeitar o binário, ProgramCache_Load() retorna 0 e o
+// programa deve ser compilado a partir do código-fonte, como antes.
+//
+// Uso:
+//
+//     GLuint program_id = ProgramCache_Load(sources);
+//     if (program_id == 0)
+//     {
+//         ... compila os shaders e chama CreateGpuProgram() ...
+//         ProgramCache_Store(program_id, sources);
+//     }
+
+// Deve ser chamada após gladLoadGLLoader(). "directory" é criado se necessário.
+void ProgramCache_Init(const char* directory);
+
+// Retorna um programa linkado a partir do cache, ou 0.
+GLuint ProgramCache_Load(const std::vector<std::string>& sources);
+
+// Grava o binário de um programa linkado com sucesso.
+void ProgramCache_Store(GLuint program_id, const std::vector<std::string>& sources);
+
+// Chamada por CreateGpuProgram() antes de glLinkProgram(), pedindo ao driver
+// que mantenha o binário disponível para ProgramCache_Store().
+void ProgramCache_PrepareForLink(GLuint program_id);
+
+#endif // _PROGRAMCACHE_H
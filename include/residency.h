@@ -0,0 +1,70 @@
+#ifndef _RESIDENCY_H
+#define _RESIDENCY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Gerenciador de residência de assets (texturas e malhas).
+//
+// Nenhum asset é carregado na inicialização: os arquivos são apenas
+// registrados, e o carregamento começa na primeira vez em que o asset é
+// utilizado (DrawVirtualObject() / SetObjectId() em "main.cpp"). Até lá, as
+// texturas mostram a textura provisória do envio assíncrono (veja
+// "texturestreaming.h") e as malhas são desenhadas com o cubo unitário.
+//
+// Malhas ".obj" são lidas e convertidas em atributos de vértices por uma
+// thread auxiliar; após o envio para a GPU as cópias em memória da CPU
+// (ObjModel e MeshData) são liberadas.
+//
+// Quando a memória de vídeo estimada ultrapassa o orçamento, os assets usados
+// há mais tempo (LRU) e que não foram usados no último quadro são liberados,
+// e voltam a ser carregados se forem usados novamente.
+
+struct ResidencyStats
+{
+    size_t vram_bytes;       // Estimativa de memória de vídeo ocupada pelos assets residentes
+    size_t vram_peak_bytes;
+    size_t ram_bytes;        // Cópias em memória da CPU aguardando envio para a GPU
+    size_t ram_peak_bytes;
+    size_t loads;
+    size_t evictions;
+    size_t reloads;
+};
+
+void Residency_Init(size_t vram_budget_bytes, size_t ram_budget_bytes);
+void Residency_Shutdown();
+
+// Registra uma imagem de textura que será ligada à unidade "textureunit" e
+// utilizada pelos objetos desenhados com "object_id".
+void Residency_RegisterTexture(const char* filename, GLuint textureunit, int object_id);
+
+// Registra um arquivo ".obj" que contém os objetos "object_names".
+void Residency_RegisterMesh(const char* filename, const std::vector<std::string>& object_names);
+
+// Marcam o asset como usado neste quadro, disparando o carregamento caso ele
+// não esteja residente. Residency_UseObject() retorna true se o objeto já pode
+// ser desenhado. Objetos não registrados (construídos em código) são sempre
+// considerados residentes.
+bool Residency_UseObject(const std::string& object_name);
+void Residency_UseMaterial(int object_id);
+
+// Recarrega um arquivo alterado no disco, caso ele esteja registrado e
+// residente (ou carregando). A nova versão é lida em segundo plano e só
+// substitui a atual dentro de Residency_Update(); se a leitura falhar, a versão
+// atual é mantida. Assets que falharam voltam a ser carregados no próximo uso.
+void Residency_Reload(const std::string& filename);
+
+// Finaliza carregamentos e aplica o orçamento de memória. Deve ser chamada uma
+// vez por quadro, na thread do contexto OpenGL.
+void Residency_Update();
+
+// Retorna true se nenhum asset estiver sendo carregado ou aguardando envio.
+bool Residency_IsIdle();
+
+const ResidencyStats& Residency_GetStats();
+void Residency_PrintStats();
+
+#endif // _RESIDENCY_H
@@ -0,0 +1,78 @@
+#ifndef _SDFATLAS_H
+#define _SDFATLAS_H
+
+// Conversão de um atlas de glifos em mapa de cobertura (um byte por texel,
+// como o de "dejavufont.h") para um campo de distâncias com sinal (signed
+// distance field, SDF) do mesmo tamanho. Definida em "sdfatlas.cpp"; não faz
+// chamadas OpenGL, para poder ser medida em "microbench.cpp".
+//
+// Cada texel da saída guarda a distância até a borda do glifo, em texels do
+// atlas: 128 na borda, valores maiores dentro e menores fora, saturando em
+// "spread" texels. Amostrado com filtro linear, o SDF dá bordas nítidas em
+// qualquer escala (veja o shader de texto em "textrendering.cpp"), enquanto o
+// mapa de cobertura fica borrado quando ampliado.
+//
+// A borda é encontrada em uma grade "supersample" vezes mais fina, obtida por
+// interpolação bilinear da cobertura; as distâncias são calculadas nessa grade
+// (8SSEDT) e a média de cada bloco vai para o texel correspondente.
+#include <cstdint>
+#include <vector>
+
+#include "texturefont.h"
+
+#define SDFATLAS_DEFAULT_SPREAD      2.0f
+#define SDFATLAS_DEFAULT_SUPERSAMPLE 2
+
+void SdfAtlas_Generate(const unsigned char* coverage, int width, int height, unsigned char* sdf,
+                       float spread = SDFATLAS_DEFAULT_SPREAD, int supersample = SDFATLAS_DEFAULT_SUPERSAMPLE);
+
+// Fonte com o atlas já convertido. A conversão leva mais de 10 ms, então é
+// feita por "mkpack", que grava SDFFONT_FILE a partir de "dejavufont.h"; o
+// jogo só carrega o arquivo (pelo pacote, veja "assetpack.h") e não embute o
+// bitmap original. Formato (inteiros e floats de 4 bytes, little-endian):
+//
+//   SdfFontHeader
+//   SdfFontGlyph[glyph_count]
+//   tex_width * tex_height bytes do SDF
+#define SDFFONT_FILE    "data/dejavufont.sdf"
+#define SDFFONT_VERSION 1
+
+struct SdfFontHeader
+{
+    char     magic[4];   // "SDFF"
+    uint32_t version;
+    uint32_t tex_width;
+    uint32_t tex_height;
+    float    height;     // Distância entre linhas, em pixels
+    uint32_t glyph_count;
+};
+
+struct SdfFontGlyph
+{
+    uint32_t codepoint;
+    int32_t  width, height;
+    int32_t  offset_x, offset_y;
+    float    advance_x, advance_y;
+    float    s0, t0, s1, t1;
+    uint32_t kerning_count;  // 0 ou 1: só o primeiro par de "texture_glyph_t"
+    uint32_t kerning_codepoint;
+    float    kerning;
+};
+
+struct SdfFont
+{
+    int                          tex_width;
+    int                          tex_height;
+    float                        height;
+    std::vector<texture_glyph_t> glyphs;
+    std::vector<unsigned char>   sdf;
+};
+
+// Gera o arquivo de "font" em "binary". Utilizada por "mkpack".
+void SdfFont_Bake(const texture_font_t* font, std::vector<unsigned char>* binary);
+
+// Retornam false se o arquivo não existir ou for inválido.
+bool SdfFont_LoadMemory(const unsigned char* binary, size_t size, SdfFont* font);
+bool SdfFont_Load(const char* name, SdfFont* font);
+
+#endif // _SDFATLAS_H
@@ -0,0 +1,53 @@
+#ifndef _STARTUP_H
+#define _STARTUP_H
+
+#include <string>
+
+// Linha do tempo da inicialização. Cada etapa do carregamento (criação da
+// janela e do contexto, compilação de shaders, leitura e decodificação de
+// imagens, leitura de ".obj", envio para a GPU, ...) é medida com tempo real,
+// tempo de CPU da thread que a executou e bytes lidos de arquivos ou do pacote
+// por essa mesma thread durante a etapa (AssetPack_GetBytesRead() conta por
+// thread, então leituras simultâneas de outras threads não entram na conta).
+// Etapas executadas pelas threads auxiliares de "texturestreaming.h" e
+// "residency.h" também são registradas.
+//
+// A medição começa em Startup_Init() (início de main()). O número principal é
+// o tempo até o primeiro quadro (Startup_FirstFrame(), após o primeiro
+// glfwSwapBuffers()); como os assets são carregados em segundo plano, a
+// medição continua até Startup_Finish(), quando todos os assets usados estão
+// residentes. Nesse momento o relatório é impresso, ordenado pelo tempo real
+// de cada etapa, com totais por categoria ("init", "compile", "decode",
+// "parse", "upload", ...), e escrito em JSON. Etapas podem ser aninhadas; o
+// tempo de uma etapa inclui o das aninhadas, mas nos totais por categoria
+// cada uma conta só o tempo fora delas.
+//
+// Uso:
+//
+//     {
+//         StartupScope step("decode", filename);
+//         ...
+//     }
+//
+// Após Startup_Finish() as etapas não são mais registradas (recargas de
+// assets, por exemplo).
+
+void Startup_Init();
+
+// "category" deve ser uma string constante (o ponteiro é guardado).
+void Startup_BeginStep(const char* category, const std::string& name);
+void Startup_EndStep();
+
+void Startup_FirstFrame();
+bool Startup_IsActive();
+
+// Imprime o relatório e o escreve em "json_filename" (se não for NULL).
+void Startup_Finish(const char* json_filename);
+
+struct StartupScope
+{
+    StartupScope(const char* category, const std::string& name) { Startup_BeginStep(category, name); }
+    ~StartupScope() { Startup_EndStep(); }
+};
+
+#endif // _STARTUP_H
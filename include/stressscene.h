@@ -0,0 +1,92 @@
+#ifndef _STRESSSCENE_H
+#define _STRESSSCENE_H
+
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "collisions.h"
+#include "bezier.h"
+
+// Gerador de cenas de estresse ("--stress=N" em "main.cpp"). Constrói N salas
+// com as malhas já existentes ("the_floor", "the_wall", "cube" e "pCube2"):
+// cada sala tem um piso, quatro paredes com uma porta no meio, paredes
+// internas, objetos no chão e plataformas que se movem com velocidade
+// constante ao longo de curvas de Bézier cúbicas. As salas ficam em uma grade
+// fora da sala principal e são percorridas pelos mesmos caminhos da fase real:
+// as caixas de colisão são adicionadas à lista de colisões e todas as paredes
+// à lista de superfícies que aceitam portais. Assim é possível medir o tempo
+// de quadro em função do número de objetos.
+//
+// A geração é determinística: a mesma "seed" produz sempre a mesma cena.
+
+struct StressSceneParams
+{
+    int       rooms;
+    int       walls_per_room;       // Paredes internas (além das 8 do contorno)
+    int       props_per_room;
+    int       platforms_per_room;
+    unsigned  seed;
+    float     room_size;            // Lado de cada sala
+    float     wall_height;
+    glm::vec3 origin;               // Canto da grade de salas, na altura do piso
+
+    StressSceneParams()
+        : rooms(0), walls_per_room(8), props_per_room(6), platforms_per_room(2),
+          seed(1), room_size(40.0f), wall_height(5.0f), origin(0.0f) {}
+};
+
+enum StressKind
+{
+    STRESS_FLOOR,           // "the_floor"
+    STRESS_WALL,            // "the_wall"
+    STRESS_PROP_CUBE,       // "cube"
+    STRESS_PROP_COMPANION,  // "pCube2"
+    STRESS_PLATFORM         // "cube", em movimento
+};
+
+// A matriz de modelagem de cada objeto é Translate(position) *
+// Rotate_Y(yaw) * Scale(scale); as paredes são antes giradas para a vertical,
+// como as paredes da fase, e são visíveis somente pelo lado +Z (antes de
+// Rotate_Y).
+struct StressObject
+{
+    StressKind kind;
+    glm::vec3  position;
+    glm::vec3  scale;
+    float      yaw;
+};
+
+struct StressPlatform
+{
+    int   object;       // Índice em StressScene::objects
+    int   collider;     // Índice em StressScene::colliders
+    float period;       // Segundos para percorrer a curva
+    float phase;        // Entre 0 e 2 (ida e volta)
+};
+
+struct StressScene
+{
+    std::vector<StressObject>   objects;
+    std::vector<StressPlatform> platforms;
+
+    // Curvas das plataformas (em coordenadas globais), na mesma ordem de
+    // "platforms" e contíguas, para serem avaliadas em lote.
+    std::vector<BezierCurve<3> >  platform_curves;
+    std::vector<BezierArcLength>  platform_arcs;
+    std::vector<float>            platform_fractions;
+    std::vector<glm::vec3>        platform_positions;
+
+    BBoxList                    colliders;
+    BBoxList                    portal_surfaces;
+    int                         walls;
+    int                         props;
+};
+
+void StressScene_Generate(const StressSceneParams& params, StressScene* scene);
+
+// Move as plataformas para o instante "time" (em segundos), atualizando a
+// posição dos objetos e as suas caixas de colisão.
+void StressScene_Update(StressScene* scene, double time);
+
+#endif // _STRESSSCENE_H
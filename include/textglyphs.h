@@ -0,0 +1,102 @@
+#ifndef _TEXTGLYPHS_H
+#define _TEXTGLYPHS_H
+
+#include <vector>
+
+#include "texturefont.h"
+
+// Busca do glifo de um caractere entre os glifos de uma fonte (os de
+// "dejavufont.h", ou os carregados do atlas pré-gerado, veja "sdfatlas.h").
+// Fica separada de "textrendering.cpp" para poder ser medida sem OpenGL
+// (veja "microbench.cpp").
+
+// Retorna NULL se a fonte não tiver o caractere. Percorre todos os glifos;
+// para texto use TextGlyphs_Lookup() abaixo.
+inline const texture_glyph_t* TextGlyphs_Find(const texture_glyph_t* glyphs, size_t count, uint32_t codepoint)
+{
+    for (size_t j = 0; j < count; ++j)
+    {
+        if (glyphs[j].codepoint == codepoint)
+            return &glyphs[j];
+    }
+    return NULL;
+}
+
+// Tabela de busca em tempo constante: os caracteres ASCII são indexados
+// diretamente, e os demais ficam em uma tabela hash com endereçamento aberto
+// (sondagem linear) de tamanho potência de 2.
+#define TEXTGLYPHS_ASCII 128
+
+struct TextGlyphTable
+{
+    const texture_glyph_t*              ascii[TEXTGLYPHS_ASCII];
+    std::vector<uint32_t>               hash_codepoints;
+    std::vector<const texture_glyph_t*> hash_glyphs;   // NULL nas posições vazias
+    uint32_t                            hash_mask;
+};
+
+inline uint32_t TextGlyphsHash(uint32_t codepoint)
+{
+    return codepoint * 2654435761u;
+}
+
+inline void TextGlyphs_BuildTable(TextGlyphTable* table, const texture_glyph_t* glyphs, size_t count)
+{
+    for (int c = 0; c < TEXTGLYPHS_ASCII; ++c)
+        table->ascii[c] = NULL;
+
+    size_t others = 0;
+    for (size_t j = 0; j < count; ++j)
+        if (glyphs[j].codepoint >= TEXTGLYPHS_ASCII)
+            ++others;
+
+    // No máximo metade das posições ocupadas.
+    size_t size = 1;
+    while (size < 2 * others)
+        size *= 2;
+    table->hash_codepoints.assign(others > 0 ? size : 0, 0);
+    table->hash_glyphs.assign(others > 0 ? size : 0, (const texture_glyph_t*)NULL);
+    table->hash_mask = (uint32_t)size - 1;
+
+    // Se houver glifos repetidos, vale o primeiro, como em TextGlyphs_Find().
+    for (size_t j = 0; j < count; ++j)
+    {
+        const texture_glyph_t* glyph = &glyphs[j];
+        uint32_t codepoint = glyph->codepoint;
+        if (codepoint < TEXTGLYPHS_ASCII)
+        {
+            if (!table->ascii[codepoint])
+                table->ascii[codepoint] = glyph;
+            continue;
+        }
+
+        uint32_t i = TextGlyphsHash(codepoint) & table->hash_mask;
+        while (table->hash_glyphs[i] && table->hash_codepoints[i] != codepoint)
+            i = (i + 1) & table->hash_mask;
+        if (!table->hash_glyphs[i])
+        {
+            table->hash_codepoints[i] = codepoint;
+            table->hash_glyphs[i] = glyph;
+        }
+    }
+}
+
+// Retorna NULL se a fonte não tiver o caractere.
+inline const texture_glyph_t* TextGlyphs_Lookup(const TextGlyphTable& table, uint32_t codepoint)
+{
+    if (codepoint < TEXTGLYPHS_ASCII)
+        return table.ascii[codepoint];
+    if (table.hash_glyphs.empty())
+        return NULL;
+
+    uint32_t i = TextGlyphsHash(codepoint) & table.hash_mask;
+    while (table.hash_glyphs[i])
+    {
+        if (table.hash_codepoints[i] == codepoint)
+            return table.hash_glyphs[i];
+        i = (i + 1) & table.hash_mask;
+    }
+    return NULL;
+}
+
+#endif // _TEXTGLYPHS_H
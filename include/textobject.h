@@ -0,0 +1,44 @@
+#ifndef _TEXTOBJECT_H
+#define _TEXTOBJECT_H
+
+#include <cstddef>
+#include <string>
+
+#include <glad/glad.h>
+
+// Texto "retido": os quadriláteros dos glifos ficam em um buffer próprio na
+// GPU, montado só quando o texto, a posição, a escala ou o tamanho da janela
+// mudam. Serve para linhas que raramente mudam (instruções, fps), que com
+// TextRendering_PrintString() seriam montadas de novo a cada quadro.
+// Definido em "textrendering.cpp".
+//
+// Como em TextRendering_PrintString(), (x, y) é a posição da primeira linha em
+// NDC; "\n" passa para a linha seguinte.
+
+struct TextObject
+{
+    std::string text;
+    float       x, y, scale;
+    GLuint      vertex_array_object_id;
+    GLuint      vertex_buffer_id;
+    size_t      buffer_bytes;
+    GLsizei     vertex_count;
+    int         window_width;   // Tamanho da janela na última montagem
+    int         window_height;
+    bool        dirty;
+
+    TextObject()
+        : x(0.0f), y(0.0f), scale(1.0f), vertex_array_object_id(0), vertex_buffer_id(0),
+          buffer_bytes(0), vertex_count(0), window_width(0), window_height(0), dirty(true) {}
+};
+
+// Pode ser chamada a cada quadro: só marca o objeto para ser montado de novo
+// se algo mudou.
+void TextObject_Set(TextObject* object, const std::string& text, float x, float y, float scale = 1.0f);
+
+// Monta o buffer se necessário e desenha o objeto com uma única chamada.
+void TextObject_Draw(TextObject* object);
+
+void TextObject_Destroy(TextObject* object);
+
+#endif // _TEXTOBJECT_H
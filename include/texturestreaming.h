@@ -0,0 +1,85 @@
+#ifndef _TEXTURESTREAMING_H
+#define _TEXTURESTREAMING_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// Envio assíncrono de texturas para a GPU através de um conjunto (pool) de
+// Pixel Buffer Objects (PBOs). A decodificação da imagem (stb_image) e a cópia
+// dos pixels para o PBO mapeado são feitas em uma thread auxiliar; a thread do
+// contexto OpenGL apenas mapeia/desmapeia os PBOs, dispara o glTexImage2D a
+// partir do PBO (DMA feito pelo driver) e cria um "fence" com glFenceSync().
+// O PBO só volta para o pool quando o fence é sinalizado, de forma que a
+// thread principal nunca espera pela GPU.
+//
+// Estados de uma requisição:
+//
+//   DECODING -> DECODED -> COPYING -> COPIED -> UPLOADING -> READY
+//   (thread auxiliar)      (thread auxiliar)    (fence)
+//
+// Enquanto a textura não está pronta, a unidade de textura aponta para uma
+// textura cinza de 1x1 pixel.
+
+enum TextureStreamState
+{
+    TEXSTREAM_DECODING,
+    TEXSTREAM_DECODED,
+    TEXSTREAM_COPYING,
+    TEXSTREAM_COPIED,
+    TEXSTREAM_UPLOADING,
+    TEXSTREAM_READY,
+    TEXSTREAM_FAILED,
+    TEXSTREAM_RELEASED
+};
+
+struct TextureStreamingStats
+{
+    size_t bytes_this_frame;      // Bytes enviados no último quadro
+    size_t bytes_peak_frame;      // Maior quantidade de bytes enviada em um único quadro
+    size_t bytes_total;           // Total de bytes enviados desde TextureStreaming_Init()
+    double stall_ms_this_frame;   // Tempo gasto pela thread do contexto em chamadas que podem bloquear (map/unmap/upload/fence)
+    double stall_ms_peak_frame;
+    double stall_ms_total;
+    size_t textures_completed;
+    size_t frames;                // Número de chamadas a TextureStreaming_Update()
+};
+
+// Cria os PBOs e a thread auxiliar. "max_bytes_per_frame" limita quantos bytes
+// começam a ser enviados por quadro (sempre ao menos uma textura por quadro).
+void TextureStreaming_Init(size_t num_pbos = 4, size_t max_bytes_per_frame = 8*1024*1024);
+void TextureStreaming_Shutdown();
+
+// Requisita o carregamento de "filename" para a unidade de textura
+// "textureunit". Retorna imediatamente um identificador da requisição; o
+// "texture_id" OpenGL já existe (com a textura provisória) no retorno.
+int TextureStreaming_Request(const char* filename, GLuint textureunit, GLuint* texture_id = NULL);
+
+// Recarrega do disco a imagem de uma requisição READY. A textura atual continua
+// ligada até a nova versão chegar na GPU, quando então é apagada (e a
+// requisição antiga passa para TEXSTREAM_RELEASED). Se a decodificação falhar,
+// a nova requisição termina em TEXSTREAM_FAILED e a textura atual é mantida.
+int TextureStreaming_Reload(int request);
+
+// Avança as requisições pendentes. Deve ser chamada uma vez por quadro, na
+// thread que possui o contexto OpenGL.
+void TextureStreaming_Update();
+
+// Bloqueia (chamando TextureStreaming_Update()) até todas requisições terminarem.
+void TextureStreaming_Finish();
+
+TextureStreamState TextureStreaming_GetState(int request);
+bool TextureStreaming_GetSize(int request, int* width, int* height); // Válido somente a partir de TEXSTREAM_DECODED
+
+// Apaga a textura e o sampler de uma requisição já terminada (READY ou
+// FAILED), religando a textura provisória na unidade de textura.
+void TextureStreaming_Release(int request);
+
+// Liga a textura provisória em uma unidade de textura ainda sem requisição.
+void TextureStreaming_BindPlaceholder(GLuint textureunit);
+
+bool TextureStreaming_IsIdle();
+const TextureStreamingStats& TextureStreaming_GetStats();
+void TextureStreaming_PrintStats();
+
+#endif // _TEXTURESTREAMING_H
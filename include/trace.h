@@ -0,0 +1,40 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+// Gravação de linha do tempo no formato "Chrome Trace Event" (JSON), que pode
+// ser aberto em chrome://tracing ou https://ui.perfetto.dev .
+//
+// Cada thread grava eventos de início/fim ("B"/"E") em um buffer próprio, sem
+// locks: somente a thread dona escreve no buffer, e o arquivo é gerado depois
+// que a gravação termina. Quando não há gravação em andamento, Trace_Begin() e
+// Trace_End() apenas testam uma variável atômica.
+//
+// A gravação é iniciada com Trace_StartCapture() (tecla F4 ou opção
+// "--trace=N" em "main.cpp"), começa no próximo quadro e termina sozinha após
+// N quadros, escrevendo o arquivo JSON. Os escopos do profiler (veja
+// "profiler.h") também aparecem na linha do tempo.
+
+void Trace_Begin(const char* name); // "name" deve ser uma string constante
+void Trace_End();
+
+// Nome da thread atual na linha do tempo.
+void Trace_SetThreadName(const char* name);
+
+// Grava os próximos "frames" quadros em "filename".
+void Trace_StartCapture(int frames, const char* filename);
+bool Trace_IsCapturing();
+
+// Deve ser chamada pela thread principal no início de cada quadro.
+void Trace_BeginFrame();
+
+struct TraceScope
+{
+    TraceScope(const char* name) { Trace_Begin(name); }
+    ~TraceScope() { Trace_End(); }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#endif // _TRACE_H
@@ -0,0 +1,56 @@
+#ifndef _TRANSFORMGRAPH_H
+#define _TRANSFORMGRAPH_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+#include "affine.h"
+
+// Hierarquia de transformações com cache das matrizes globais. Definida em
+// "transformgraph.cpp".
+//
+// Cada nó tem uma transformação local (relativa ao pai) e uma global, que é
+// a global do pai vezes a local. Os nós ficam em vetores contíguos, em ordem
+// topológica: todo nó é criado depois do seu pai, então uma única passada em
+// ordem crescente de índice atualiza a hierarquia inteira.
+//
+// Alterar a transformação local de um nó o marca como "sujo"; somente os nós
+// sujos e os seus descendentes são recalculados por TransformGraph_Update().
+// A passada começa no primeiro nó sujo, então nós estáticos criados antes dos
+// dinâmicos não custam nada nos quadros em que não mudam. Em "main.cpp" a
+// geometria da fase e da cena de estresse é criada primeiro, e os objetos que
+// se movem (portão, cubo móvel, plataformas, câmera e os objetos presos a
+// ela) por último.
+
+#define TRANSFORM_ROOT (-1)
+
+struct TransformGraph
+{
+    std::vector<int>            parent;         // TRANSFORM_ROOT ou índice menor que o do nó
+    std::vector<Affine>         local;
+    std::vector<Affine>         world;
+    std::vector<glm::mat4>      world_matrix;   // "world" no formato enviado para a GPU
+    std::vector<unsigned char>  dirty;
+    size_t                      first_dirty;    // Igual a parent.size() se nenhum nó mudou
+    size_t                      updated;        // Nós recalculados no último TransformGraph_Update()
+
+    TransformGraph() : first_dirty(0), updated(0) {}
+};
+
+// Cria um nó filho de "parent" (ou TRANSFORM_ROOT) e retorna o seu índice.
+int  TransformGraph_AddNode(TransformGraph* graph, int parent, const Affine& local);
+
+// Só marca o nó como sujo se a transformação for diferente da atual; pode ser
+// chamada a cada quadro para objetos que raramente se movem.
+void TransformGraph_SetLocal(TransformGraph* graph, int node, const Affine& local);
+
+void TransformGraph_Update(TransformGraph* graph);
+
+inline const glm::mat4& TransformGraph_GetWorld(const TransformGraph& graph, int node)
+{
+    return graph.world_matrix[node];
+}
+
+#endif // _TRANSFORMGRAPH_H
@@ -0,0 +1,345 @@
+// Transformações afins 3x4. Veja "include/affine.h".
+#include "affine.h"
+
+// Operações sobre vetores de quatro floats. Cada núcleo abaixo é escrito uma
+// única vez em termos destas funções, que têm uma versão para cada conjunto
+// de instruções.
+#if defined(AFFINE_SSE)
+
+#include <emmintrin.h>
+
+typedef __m128 AffineVec;
+
+static inline AffineVec AffineLoad(const float* p)                 { return _mm_loadu_ps(p); }
+static inline void      AffineStore(float* p, AffineVec v)         { _mm_storeu_ps(p, v); }
+static inline AffineVec AffineSplat(float x)                       { return _mm_set1_ps(x); }
+static inline AffineVec AffineSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+static inline AffineVec AffineAdd(AffineVec a, AffineVec b)        { return _mm_add_ps(a, b); }
+static inline AffineVec AffineSub(AffineVec a, AffineVec b)        { return _mm_sub_ps(a, b); }
+static inline AffineVec AffineMul(AffineVec a, AffineVec b)        { return _mm_mul_ps(a, b); }
+// a * b + c
+static inline AffineVec AffineMulAdd(AffineVec a, AffineVec b, AffineVec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+// [x y z w] -> [y z x w] e [z x y w]
+static inline AffineVec AffineYZX(AffineVec v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1)); }
+static inline AffineVec AffineZXY(AffineVec v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 0, 2)); }
+
+static inline void AffineTranspose(AffineVec& r0, AffineVec& r1, AffineVec& r2, AffineVec& r3)
+{
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+#elif defined(AFFINE_NEON)
+
+#include <arm_neon.h>
+
+typedef float32x4_t AffineVec;
+
+static inline AffineVec AffineLoad(const float* p)                 { return vld1q_f32(p); }
+static inline void      AffineStore(float* p, AffineVec v)         { vst1q_f32(p, v); }
+static inline AffineVec AffineSplat(float x)                       { return vdupq_n_f32(x); }
+static inline AffineVec AffineSet(float x, float y, float z, float w)
+{
+    float v[4] = { x, y, z, w };
+    return vld1q_f32(v);
+}
+static inline AffineVec AffineAdd(AffineVec a, AffineVec b)        { return vaddq_f32(a, b); }
+static inline AffineVec AffineSub(AffineVec a, AffineVec b)        { return vsubq_f32(a, b); }
+static inline AffineVec AffineMul(AffineVec a, AffineVec b)        { return vmulq_f32(a, b); }
+// a * b + c
+static inline AffineVec AffineMulAdd(AffineVec a, AffineVec b, AffineVec c) { return vmlaq_f32(c, a, b); }
+// [x y z w] -> [y z x w] e [z x y w]
+static inline AffineVec AffineYZX(AffineVec v)
+{
+    float32x2_t xy = vget_low_f32(v);
+    float32x2_t zw = vget_high_f32(v);
+    return vcombine_f32(vext_f32(xy, zw, 1), vset_lane_f32(vget_lane_f32(xy, 0), zw, 0));
+}
+static inline AffineVec AffineZXY(AffineVec v)
+{
+    float32x2_t xy = vget_low_f32(v);
+    float32x2_t zw = vget_high_f32(v);
+    return vcombine_f32(vzip_f32(zw, xy).val[0], vtrn_f32(xy, zw).val[1]);
+}
+
+static inline void AffineTranspose(AffineVec& r0, AffineVec& r1, AffineVec& r2, AffineVec& r3)
+{
+    float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]),  vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]),  vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#else
+
+struct AffineVec
+{
+    float v[4];
+};
+
+static inline AffineVec AffineSet(float x, float y, float z, float w)
+{
+    AffineVec r = {{ x, y, z, w }};
+    return r;
+}
+static inline AffineVec AffineLoad(const float* p)                 { return AffineSet(p[0], p[1], p[2], p[3]); }
+static inline void      AffineStore(float* p, AffineVec v)         { for (int i = 0; i < 4; ++i) p[i] = v.v[i]; }
+static inline AffineVec AffineSplat(float x)                       { return AffineSet(x, x, x, x); }
+static inline AffineVec AffineAdd(AffineVec a, AffineVec b)        { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+static inline AffineVec AffineSub(AffineVec a, AffineVec b)        { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+static inline AffineVec AffineMul(AffineVec a, AffineVec b)        { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+// a * b + c
+static inline AffineVec AffineMulAdd(AffineVec a, AffineVec b, AffineVec c) { return AffineAdd(AffineMul(a, b), c); }
+// [x y z w] -> [y z x w] e [z x y w]
+static inline AffineVec AffineYZX(AffineVec a) { return AffineSet(a.v[1], a.v[2], a.v[0], a.v[3]); }
+static inline AffineVec AffineZXY(AffineVec a) { return AffineSet(a.v[2], a.v[0], a.v[1], a.v[3]); }
+
+static inline void AffineTranspose(AffineVec& r0, AffineVec& r1, AffineVec& r2, AffineVec& r3)
+{
+    AffineVec r[4] = { r0, r1, r2, r3 };
+    r0 = AffineSet(r[0].v[0], r[1].v[0], r[2].v[0], r[3].v[0]);
+    r1 = AffineSet(r[0].v[1], r[1].v[1], r[2].v[1], r[3].v[1]);
+    r2 = AffineSet(r[0].v[2], r[1].v[2], r[2].v[2], r[3].v[2]);
+    r3 = AffineSet(r[0].v[3], r[1].v[3], r[2].v[3], r[3].v[3]);
+}
+
+#endif
+
+// Produto vetorial das três primeiras coordenadas; a quarta resulta em zero.
+static inline AffineVec AffineCross(AffineVec a, AffineVec b)
+{
+    return AffineSub(AffineMul(AffineYZX(a), AffineZXY(b)), AffineMul(AffineZXY(a), AffineYZX(b)));
+}
+
+// Linha i de a * b = a[i][0]*b[0] + a[i][1]*b[1] + a[i][2]*b[2] + a[i][3]*[0 0 0 1],
+// recebendo os coeficientes a[i][j] já replicados e at = [0 0 0 a[i][3]].
+static inline AffineVec AffineRow(AffineVec a0, AffineVec a1, AffineVec a2, AffineVec at,
+                                  AffineVec b0, AffineVec b1, AffineVec b2)
+{
+    return AffineMulAdd(a2, b2, AffineMulAdd(a1, b1, AffineMulAdd(a0, b0, at)));
+}
+
+static inline void AffineComposeRows(const Affine& a, AffineVec b0, AffineVec b1, AffineVec b2, Affine* out)
+{
+    // Os coeficientes de "a" são lidos antes de escrever "out", que pode ser
+    // o próprio "a".
+    AffineVec r0 = AffineRow(AffineSplat(a.m[0][0]), AffineSplat(a.m[0][1]), AffineSplat(a.m[0][2]),
+                             AffineSet(0.0f, 0.0f, 0.0f, a.m[0][3]), b0, b1, b2);
+    AffineVec r1 = AffineRow(AffineSplat(a.m[1][0]), AffineSplat(a.m[1][1]), AffineSplat(a.m[1][2]),
+                             AffineSet(0.0f, 0.0f, 0.0f, a.m[1][3]), b0, b1, b2);
+    AffineVec r2 = AffineRow(AffineSplat(a.m[2][0]), AffineSplat(a.m[2][1]), AffineSplat(a.m[2][2]),
+                             AffineSet(0.0f, 0.0f, 0.0f, a.m[2][3]), b0, b1, b2);
+    AffineStore(out->m[0], r0);
+    AffineStore(out->m[1], r1);
+    AffineStore(out->m[2], r2);
+}
+
+// Linhas da matriz de rotação do quatérnio (unitário) "q".
+static void AffineRotation(const glm::quat& q, float r[3][3])
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    r[0][0] = 1.0f - 2.0f * (yy + zz); r[0][1] = 2.0f * (xy - wz);        r[0][2] = 2.0f * (xz + wy);
+    r[1][0] = 2.0f * (xy + wz);        r[1][1] = 1.0f - 2.0f * (xx + zz); r[1][2] = 2.0f * (yz - wx);
+    r[2][0] = 2.0f * (xz - wy);        r[2][1] = 2.0f * (yz + wx);        r[2][2] = 1.0f - 2.0f * (xx + yy);
+}
+
+Affine Affine_Identity()
+{
+    Affine a = {{
+        { 1.0f, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f, 0.0f }
+    }};
+    return a;
+}
+
+Affine Affine_MakeTRS(const glm::vec3& t, const glm::quat& r, const glm::vec3& s)
+{
+    // R * S escala as colunas de R.
+    float rot[3][3];
+    AffineRotation(r, rot);
+
+    Affine a;
+    for (int i = 0; i < 3; ++i)
+    {
+        a.m[i][0] = rot[i][0] * s.x;
+        a.m[i][1] = rot[i][1] * s.y;
+        a.m[i][2] = rot[i][2] * s.z;
+        a.m[i][3] = t[i];
+    }
+    return a;
+}
+
+Affine Affine_MakeTSR(const glm::vec3& t, const glm::quat& r, const glm::vec3& s)
+{
+    // S * R escala as linhas de R.
+    float rot[3][3];
+    AffineRotation(r, rot);
+
+    Affine a;
+    for (int i = 0; i < 3; ++i)
+    {
+        a.m[i][0] = rot[i][0] * s[i];
+        a.m[i][1] = rot[i][1] * s[i];
+        a.m[i][2] = rot[i][2] * s[i];
+        a.m[i][3] = t[i];
+    }
+    return a;
+}
+
+Affine Affine_Compose(const Affine& a, const Affine& b)
+{
+    Affine out;
+    AffineComposeRows(a, AffineLoad(b.m[0]), AffineLoad(b.m[1]), AffineLoad(b.m[2]), &out);
+    return out;
+}
+
+Affine Affine_Inverse(const Affine& a)
+{
+    // Sendo r0, r1 e r2 as linhas da parte linear A, as colunas de A^-1 são
+    // r1 x r2, r2 x r0 e r0 x r1 divididos pelo determinante r0 . (r1 x r2).
+    // A translação da inversa é -A^-1 * t.
+    AffineVec r0 = AffineLoad(a.m[0]);
+    AffineVec r1 = AffineLoad(a.m[1]);
+    AffineVec r2 = AffineLoad(a.m[2]);
+
+    AffineVec c0 = AffineCross(r1, r2);
+    AffineVec c1 = AffineCross(r2, r0);
+    AffineVec c2 = AffineCross(r0, r1);
+
+    float c[4];
+    AffineStore(c, c0);
+    float det = a.m[0][0] * c[0] + a.m[0][1] * c[1] + a.m[0][2] * c[2];
+    AffineVec inv_det = AffineSplat(1.0f / det);
+    c0 = AffineMul(c0, inv_det);
+    c1 = AffineMul(c1, inv_det);
+    c2 = AffineMul(c2, inv_det);
+
+    AffineVec t = AffineMul(c0, AffineSplat(-a.m[0][3]));
+    t = AffineMulAdd(c1, AffineSplat(-a.m[1][3]), t);
+    t = AffineMulAdd(c2, AffineSplat(-a.m[2][3]), t);
+
+    // Colunas (c0, c1, c2, t) -> linhas da inversa.
+    AffineTranspose(c0, c1, c2, t);
+
+    Affine out;
+    AffineStore(out.m[0], c0);
+    AffineStore(out.m[1], c1);
+    AffineStore(out.m[2], c2);
+    return out;
+}
+
+glm::vec3 Affine_TransformPoint(const Affine& a, const glm::vec3& p)
+{
+    return glm::vec3(a.m[0][0] * p.x + a.m[0][1] * p.y + a.m[0][2] * p.z + a.m[0][3],
+                     a.m[1][0] * p.x + a.m[1][1] * p.y + a.m[1][2] * p.z + a.m[1][3],
+                     a.m[2][0] * p.x + a.m[2][1] * p.y + a.m[2][2] * p.z + a.m[2][3]);
+}
+
+glm::vec3 Affine_TransformVector(const Affine& a, const glm::vec3& v)
+{
+    return glm::vec3(a.m[0][0] * v.x + a.m[0][1] * v.y + a.m[0][2] * v.z,
+                     a.m[1][0] * v.x + a.m[1][1] * v.y + a.m[1][2] * v.z,
+                     a.m[2][0] * v.x + a.m[2][1] * v.y + a.m[2][2] * v.z);
+}
+
+glm::mat4 Affine_ToMat4(const Affine& a)
+{
+    glm::mat4 m;
+    Affine_ToMat4Batch(&a, &m, 1);
+    return m;
+}
+
+Affine Affine_FromMat4(const glm::mat4& m)
+{
+    // Em GLM, m[coluna][linha].
+    Affine a;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 4; ++j)
+            a.m[i][j] = m[j][i];
+    return a;
+}
+
+void Affine_ComposeBatch(const Affine* a, const Affine* b, Affine* out, size_t count)
+{
+    for (size_t k = 0; k < count; ++k)
+        AffineComposeRows(a[k], AffineLoad(b[k].m[0]), AffineLoad(b[k].m[1]), AffineLoad(b[k].m[2]), &out[k]);
+}
+
+void Affine_ComposeBatch(const Affine& parent, const Affine* local, Affine* out, size_t count)
+{
+    // Os coeficientes de "parent" são replicados uma única vez e ficam em
+    // registradores durante todo o laço.
+    AffineVec p00 = AffineSplat(parent.m[0][0]), p01 = AffineSplat(parent.m[0][1]), p02 = AffineSplat(parent.m[0][2]);
+    AffineVec p10 = AffineSplat(parent.m[1][0]), p11 = AffineSplat(parent.m[1][1]), p12 = AffineSplat(parent.m[1][2]);
+    AffineVec p20 = AffineSplat(parent.m[2][0]), p21 = AffineSplat(parent.m[2][1]), p22 = AffineSplat(parent.m[2][2]);
+    AffineVec pt0 = AffineSet(0.0f, 0.0f, 0.0f, parent.m[0][3]);
+    AffineVec pt1 = AffineSet(0.0f, 0.0f, 0.0f, parent.m[1][3]);
+    AffineVec pt2 = AffineSet(0.0f, 0.0f, 0.0f, parent.m[2][3]);
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        AffineVec b0 = AffineLoad(local[k].m[0]);
+        AffineVec b1 = AffineLoad(local[k].m[1]);
+        AffineVec b2 = AffineLoad(local[k].m[2]);
+        AffineStore(out[k].m[0], AffineRow(p00, p01, p02, pt0, b0, b1, b2));
+        AffineStore(out[k].m[1], AffineRow(p10, p11, p12, pt1, b0, b1, b2));
+        AffineStore(out[k].m[2], AffineRow(p20, p21, p22, pt2, b0, b1, b2));
+    }
+}
+
+static void AffineTransformBatch(const Affine& a, const glm::vec3* in, glm::vec3* out, size_t count, float w)
+{
+    // Com as colunas da matriz em registradores, cada ponto é
+    // x*c0 + y*c1 + z*c2 + w*c3.
+    AffineVec c0 = AffineLoad(a.m[0]);
+    AffineVec c1 = AffineLoad(a.m[1]);
+    AffineVec c2 = AffineLoad(a.m[2]);
+    AffineVec c3 = AffineSet(0.0f, 0.0f, 0.0f, 1.0f);
+    AffineTranspose(c0, c1, c2, c3);
+    c3 = AffineMul(c3, AffineSplat(w));
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        AffineVec r = AffineMulAdd(c0, AffineSplat(in[k].x), c3);
+        r = AffineMulAdd(c1, AffineSplat(in[k].y), r);
+        r = AffineMulAdd(c2, AffineSplat(in[k].z), r);
+
+        float v[4];
+        AffineStore(v, r);
+        out[k] = glm::vec3(v[0], v[1], v[2]);
+    }
+}
+
+void Affine_TransformPointsBatch(const Affine& a, const glm::vec3* in, glm::vec3* out, size_t count)
+{
+    AffineTransformBatch(a, in, out, count, 1.0f);
+}
+
+void Affine_TransformVectorsBatch(const Affine& a, const glm::vec3* in, glm::vec3* out, size_t count)
+{
+    AffineTransformBatch(a, in, out, count, 0.0f);
+}
+
+void Affine_ToMat4Batch(const Affine* in, glm::mat4* out, size_t count)
+{
+    AffineVec r3 = AffineSet(0.0f, 0.0f, 0.0f, 1.0f);
+    for (size_t k = 0; k < count; ++k)
+    {
+        AffineVec r0 = AffineLoad(in[k].m[0]);
+        AffineVec r1 = AffineLoad(in[k].m[1]);
+        AffineVec r2 = AffineLoad(in[k].m[2]);
+        AffineVec c3 = r3;
+        AffineTranspose(r0, r1, r2, c3);
+
+        // glm::mat4 guarda as colunas em sequência.
+        AffineStore(&out[k][0][0], r0);
+        AffineStore(&out[k][1][0], r1);
+        AffineStore(&out[k][2][0], r2);
+        AffineStore(&out[k][3][0], c3);
+    }
+}
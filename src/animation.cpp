@@ -0,0 +1,301 @@
+// Animações por quadros-chave. Veja "include/animation.h".
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include "animation.h"
+
+static void AnimationMarkTarget(AnimationSystem* system, int target)
+{
+    if (!system->target_dirty[target])
+    {
+        system->target_dirty[target] = 1;
+        system->dirty_targets.push_back(target);
+    }
+}
+
+int Animation_AddTarget(AnimationSystem* system, int node, const glm::vec3& translation,
+                        const glm::quat& rotation, const glm::vec3& scale, bool scale_first)
+{
+    int target = (int)system->target_node.size();
+    system->target_node.push_back(node);
+    system->target_channels.push_back(translation.x);
+    system->target_channels.push_back(translation.y);
+    system->target_channels.push_back(translation.z);
+    system->target_channels.push_back(scale.x);
+    system->target_channels.push_back(scale.y);
+    system->target_channels.push_back(scale.z);
+    system->target_rotation.push_back(rotation);
+    system->target_scale_first.push_back(scale_first ? 1 : 0);
+    system->target_dirty.push_back(0);
+    AnimationMarkTarget(system, target);
+    return target;
+}
+
+void Animation_SetTranslation(AnimationSystem* system, int target, const glm::vec3& translation)
+{
+    float* channels = &system->target_channels[target * ANIM_CHANNEL_COUNT];
+    if (channels[ANIM_TRANSLATE_X] == translation.x &&
+        channels[ANIM_TRANSLATE_Y] == translation.y &&
+        channels[ANIM_TRANSLATE_Z] == translation.z)
+        return;
+
+    channels[ANIM_TRANSLATE_X] = translation.x;
+    channels[ANIM_TRANSLATE_Y] = translation.y;
+    channels[ANIM_TRANSLATE_Z] = translation.z;
+    AnimationMarkTarget(system, target);
+}
+
+void Animation_SetRotation(AnimationSystem* system, int target, const glm::quat& rotation)
+{
+    if (system->target_rotation[target] == rotation)
+        return;
+
+    system->target_rotation[target] = rotation;
+    AnimationMarkTarget(system, target);
+}
+
+glm::vec3 Animation_GetTranslation(const AnimationSystem& system, int target)
+{
+    const float* channels = &system.target_channels[target * ANIM_CHANNEL_COUNT];
+    return glm::vec3(channels[ANIM_TRANSLATE_X], channels[ANIM_TRANSLATE_Y], channels[ANIM_TRANSLATE_Z]);
+}
+
+// Primeiro canal do grupo (translação ou escala) de "channel".
+static int AnimationChannelGroup(int channel)
+{
+    return channel < ANIM_SCALE_X ? ANIM_TRANSLATE_X : ANIM_SCALE_X;
+}
+
+// Curva (veja "curve_" em "animation.h") da trilha ANIM_BEZIER "track", que
+// acaba de ser criada com as chaves "times" e "values". Deve ser chamada antes
+// de a trilha entrar na lista do evento.
+static int AnimationAddCurve(AnimationSystem* system, const std::vector<int>& event_tracks, int track,
+                             const float* times, const float* values, int count)
+{
+    int slot   = system->track_slot[track];
+    int target = slot / ANIM_CHANNEL_COUNT;
+    int group  = AnimationChannelGroup(slot % ANIM_CHANNEL_COUNT);
+    int axis   = slot % ANIM_CHANNEL_COUNT - group;
+
+    int curve = -1;
+    for (size_t i = 0; i < event_tracks.size() && curve < 0; ++i)
+    {
+        int other = event_tracks[i];
+        int other_slot = system->track_slot[other];
+        int c = system->track_curve[other];
+        int first = system->track_first_key[other];
+        if (c >= 0 && other_slot / ANIM_CHANNEL_COUNT == target
+         && AnimationChannelGroup(other_slot % ANIM_CHANNEL_COUNT) == group
+         && !(system->curve_axes[c] & (1 << axis))
+         && system->track_key_count[other] == count && system->track_loop[other] == system->track_loop[track]
+         && system->key_time[first] == times[0] && system->key_time[first + count - 1] == times[count - 1])
+            curve = c;
+    }
+
+    if (curve < 0)
+    {
+        curve = (int)system->curve_first_point.size();
+        const float* channels = &system->target_channels[target * ANIM_CHANNEL_COUNT + group];
+        system->curve_first_point.push_back((int)system->curve_points.size());
+        system->curve_point_count.push_back(count);
+        system->curve_axes.push_back(0);
+        system->curve_arc.push_back(BezierArcLength());
+        system->curve_points.insert(system->curve_points.end(), count, glm::vec3(channels[0], channels[1], channels[2]));
+    }
+
+    glm::vec3* points = &system->curve_points[system->curve_first_point[curve]];
+    for (int i = 0; i < count; ++i)
+        points[i][axis] = values[i];
+    system->curve_axes[curve] |= (unsigned char)(1 << axis);
+    Bezier_BakeArcLength(points, count, &system->curve_arc[curve]);
+    return curve;
+}
+
+int Animation_AddTrack(AnimationSystem* system, const char* event, int target, AnimationChannel channel,
+                       AnimationInterp interp, AnimationLoop loop,
+                       const float* times, const float* values, int count)
+{
+    assert(count > 0);
+    assert(interp != ANIM_BEZIER || count <= ANIMATION_MAX_BEZIER_KEYS);
+    assert(target >= 0 && target < (int)system->target_node.size());
+
+    int track = (int)system->track_first_key.size();
+    system->track_first_key.push_back((int)system->key_time.size());
+    system->track_key_count.push_back(count);
+    system->track_interp.push_back((unsigned char)interp);
+    system->track_loop.push_back((unsigned char)loop);
+    system->track_slot.push_back(target * ANIM_CHANNEL_COUNT + channel);
+    system->track_start.push_back(0.0);
+    system->track_playing.push_back(0);
+    system->track_curve.push_back(-1);
+
+    system->key_time.insert(system->key_time.end(), times, times + count);
+    system->key_value.insert(system->key_value.end(), values, values + count);
+
+    std::vector<int>& event_tracks = system->events[event];
+    if (interp == ANIM_BEZIER)
+        system->track_curve[track] = AnimationAddCurve(system, event_tracks, track, times, values, count);
+    event_tracks.push_back(track);
+    return track;
+}
+
+void Animation_Trigger(AnimationSystem* system, const char* event, double time)
+{
+    std::map<std::string, std::vector<int> >::iterator it = system->events.find(event);
+    if (it == system->events.end())
+        return;
+
+    for (size_t i = 0; i < it->second.size(); ++i)
+    {
+        int track = it->second[i];
+        system->track_start[track] = time;
+        if (!system->track_playing[track])
+        {
+            system->track_playing[track] = 1;
+            system->active.push_back(track);
+        }
+    }
+}
+
+bool Animation_IsEventPlaying(const AnimationSystem& system, const char* event)
+{
+    std::map<std::string, std::vector<int> >::const_iterator it = system.events.find(event);
+    if (it == system.events.end())
+        return false;
+
+    for (size_t i = 0; i < it->second.size(); ++i)
+        if (system.track_playing[it->second[i]])
+            return true;
+    return false;
+}
+
+// Valor de uma trilha no tempo local "t" (já limitado às chaves).
+static float AnimationEvaluate(const AnimationSystem& system, int track, float t)
+{
+    const float* times  = &system.key_time[system.track_first_key[track]];
+    const float* values = &system.key_value[system.track_first_key[track]];
+    int count = system.track_key_count[track];
+    int interp = system.track_interp[track];
+
+    if (interp == ANIM_BEZIER)
+    {
+        // "u" é a fração do comprimento da curva já percorrida. As trilhas de
+        // uma mesma curva avaliam o ponto inteiro e ficam com o seu eixo.
+        float span = times[count - 1] - times[0];
+        float u = span > 0.0f ? (t - times[0]) / span : 1.0f;
+        int curve   = system.track_curve[track];
+        int channel = system.track_slot[track] % ANIM_CHANNEL_COUNT;
+        glm::vec3 p = bezierCurve(&system.curve_points[system.curve_first_point[curve]], count,
+                                  system.curve_arc[curve].ParameterAt(u));
+        return p[channel - AnimationChannelGroup(channel)];
+    }
+
+    // Última chave com tempo <= t. As trilhas têm poucas chaves, então uma
+    // busca linear é mais rápida que uma binária.
+    int i = 0;
+    while (i + 1 < count && times[i + 1] <= t)
+        ++i;
+    if (interp == ANIM_STEP || i + 1 == count)
+        return values[i];
+
+    float u = (t - times[i]) / (times[i + 1] - times[i]);
+    if (interp == ANIM_SMOOTH)
+        u = u * u * (3.0f - 2.0f * u);
+    return values[i] + (values[i + 1] - values[i]) * u;
+}
+
+void Animation_Update(AnimationSystem* system, double time)
+{
+    size_t count = Animation_BeginUpdate(system);
+    Animation_EvaluateRange(system, time, 0, count);
+    Animation_EndUpdate(system);
+}
+
+size_t Animation_BeginUpdate(AnimationSystem* system)
+{
+    size_t count = system->active.size();
+    system->evaluated = count;
+    system->active_time.resize(count);
+    system->active_value.resize(count);
+    return count;
+}
+
+void Animation_EvaluateRange(AnimationSystem* system, double time, size_t begin, size_t end)
+{
+    end = std::min(end, system->active.size());
+
+    // Tempo local de cada trilha, conforme o modo de repetição.
+    for (size_t i = begin; i < end; ++i)
+    {
+        int track = system->active[i];
+        int first = system->track_first_key[track];
+        float start    = system->key_time[first];
+        float duration = system->key_time[first + system->track_key_count[track] - 1] - start;
+        double elapsed = std::max(time - system->track_start[track], 0.0);
+
+        float t;
+        if (duration <= 0.0f)
+            t = 0.0f;
+        else if (system->track_loop[track] == ANIM_REPEAT)
+            t = (float)std::fmod(elapsed, (double)duration);
+        else if (system->track_loop[track] == ANIM_PINGPONG)
+        {
+            t = (float)std::fmod(elapsed, 2.0 * duration);
+            if (t > duration)
+                t = 2.0f * duration - t;
+        }
+        else
+        {
+            t = (float)std::min(elapsed, (double)duration);
+            if (elapsed >= duration)
+                system->track_playing[track] = 0;
+        }
+        system->active_time[i] = start + t;
+    }
+
+    for (size_t i = begin; i < end; ++i)
+        system->active_value[i] = AnimationEvaluate(*system, system->active[i], system->active_time[i]);
+}
+
+void Animation_EndUpdate(AnimationSystem* system)
+{
+    size_t count = system->active.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        int slot = system->track_slot[system->active[i]];
+        if (system->target_channels[slot] != system->active_value[i])
+        {
+            system->target_channels[slot] = system->active_value[i];
+            AnimationMarkTarget(system, slot / ANIM_CHANNEL_COUNT);
+        }
+    }
+
+    // Trilhas que chegaram à última chave saem da lista; o seu valor final
+    // permanece no alvo.
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (system->track_playing[system->active[i]])
+            system->active[kept++] = system->active[i];
+    system->active.resize(kept);
+}
+
+void Animation_Apply(AnimationSystem* system, TransformGraph* graph)
+{
+    for (size_t i = 0; i < system->dirty_targets.size(); ++i)
+    {
+        int target = system->dirty_targets[i];
+        const float* c = &system->target_channels[target * ANIM_CHANNEL_COUNT];
+        glm::vec3 translation(c[ANIM_TRANSLATE_X], c[ANIM_TRANSLATE_Y], c[ANIM_TRANSLATE_Z]);
+        glm::vec3 scale(c[ANIM_SCALE_X], c[ANIM_SCALE_Y], c[ANIM_SCALE_Z]);
+
+        if (system->target_scale_first[target])
+            TransformGraph_SetLocal(graph, system->target_node[target],
+                                    Affine_MakeTSR(translation, system->target_rotation[target], scale));
+        else
+            TransformGraph_SetLocal(graph, system->target_node[target],
+                                    Affine_MakeTRS(translation, system->target_rotation[target], scale));
+        system->target_dirty[target] = 0;
+    }
+    system->dirty_targets.clear();
+}
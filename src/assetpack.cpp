@@ -0,0 +1,533 @@
+// Pacote de arquivos do jogo. Veja os comentários em "include/assetpack.h".
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
+#include "assetpack.h"
+#include "memtrack.h"
+
+static const uint32_t ASSETPACK_VERSION    = 1;
+static const uint32_t ASSETPACK_ALIGNMENT  = 256;
+static const uint32_t ASSETPACK_COMPRESSED = 1;
+
+struct AssetPackHeader
+{
+    char     magic[4];        // "APAK"
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t alignment;
+    uint64_t index_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+};
+
+struct AssetPackEntry
+{
+    uint32_t name_offset;     // Deslocamento dentro da tabela de nomes
+    uint32_t name_length;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t offset;          // Deslocamento dos dados, múltiplo de "alignment"
+    uint64_t stored_size;     // Tamanho no pacote
+    uint64_t size;            // Tamanho original
+};
+
+static const unsigned char*  g_AssetPackData = NULL;
+static size_t                g_AssetPackSize = 0;
+static const AssetPackEntry* g_AssetPackEntries = NULL;
+static const char*           g_AssetPackNames = NULL;
+static uint32_t              g_AssetPackEntryCount = 0;
+
+// ---------------------------------------------------------------------------
+// Codec LZ77. Cada sequência é formada por um byte "token" (4 bits para o
+// número de literais e 4 bits para o comprimento da cópia menos 4), os
+// literais, e o deslocamento da cópia (2 bytes). Valores 15 continuam em bytes
+// seguintes (255 = continua). A última sequência contém apenas literais.
+
+static void AssetPackWriteLength(std::vector<unsigned char>* out, size_t length)
+{
+    while (length >= 255)
+    {
+        out->push_back(255);
+        length -= 255;
+    }
+    out->push_back((unsigned char)length);
+}
+
+static void AssetPackEmit(std::vector<unsigned char>* out, const unsigned char* literals, size_t num_literals, size_t match_length, size_t offset)
+{
+    size_t match_code = match_length >= 4 ? match_length - 4 : 0;
+    unsigned char token = (unsigned char)((std::min(num_literals, (size_t)15) << 4) | std::min(match_code, (size_t)15));
+    out->push_back(token);
+    if (num_literals >= 15)
+        AssetPackWriteLength(out, num_literals - 15);
+    out->insert(out->end(), literals, literals + num_literals);
+
+    if (match_length == 0)
+        return;
+    out->push_back((unsigned char)(offset & 0xFF));
+    out->push_back((unsigned char)(offset >> 8));
+    if (match_code >= 15)
+        AssetPackWriteLength(out, match_code - 15);
+}
+
+static void AssetPackCompress(const unsigned char* src, size_t size, std::vector<unsigned char>* out)
+{
+    const int HASH_BITS = 16;
+    std::vector<size_t> table((size_t)1 << HASH_BITS, (size_t)-1);
+
+    out->clear();
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + 4 <= size)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, src + i, 4);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = i;
+
+        if (candidate != (size_t)-1 && i - candidate <= 0xFFFF && memcmp(src + candidate, src + i, 4) == 0)
+        {
+            size_t length = 4;
+            while (i + length < size && src[candidate + length] == src[i + length])
+                ++length;
+
+            AssetPackEmit(out, src + anchor, i - anchor, length, i - candidate);
+            i += length;
+            anchor = i;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    AssetPackEmit(out, src + anchor, size - anchor, 0, 0);
+}
+
+static bool AssetPackReadLength(const unsigned char* src, size_t size, size_t* ip, size_t* length)
+{
+    unsigned char b;
+    do
+    {
+        if (*ip >= size)
+            return false;
+        b = src[(*ip)++];
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+static bool AssetPackDecompress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size)
+{
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < src_size)
+    {
+        unsigned char token = src[ip++];
+
+        size_t num_literals = token >> 4;
+        if (num_literals == 15 && !AssetPackReadLength(src, src_size, &ip, &num_literals))
+            return false;
+        if (num_literals > src_size - ip || num_literals > dst_size - op)
+            return false;
+        memcpy(dst + op, src + ip, num_literals);
+        ip += num_literals;
+        op += num_literals;
+
+        if (ip == src_size)
+            break; // Última sequência
+
+        if (src_size - ip < 2)
+            return false;
+        size_t offset = src[ip] | ((size_t)src[ip+1] << 8);
+        ip += 2;
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !AssetPackReadLength(src, src_size, &ip, &match_length))
+            return false;
+        match_length += 4;
+
+        if (offset == 0 || offset > op || match_length > dst_size - op)
+            return false;
+
+        // Cópia byte a byte: origem e destino podem se sobrepor.
+        for (size_t k = 0; k < match_length; ++k)
+            dst[op + k] = dst[op - offset + k];
+        op += match_length;
+    }
+    return op == dst_size;
+}
+
+// ---------------------------------------------------------------------------
+
+std::string AssetPack_ExecutableDirectory()
+{
+    char path[4096];
+    size_t length = 0;
+
+#if defined(_WIN32)
+    DWORD n = GetModuleFileNameA(NULL, path, sizeof(path));
+    if (n > 0 && n < sizeof(path))
+        length = n;
+#elif defined(__APPLE__)
+    uint32_t n = sizeof(path);
+    if (_NSGetExecutablePath(path, &n) == 0)
+        length = strlen(path);
+#else
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n > 0)
+        length = (size_t)n;
+#endif
+
+    std::string executable(path, length);
+    size_t slash = executable.find_last_of("/\\");
+    if (slash == std::string::npos)
+        return ".";
+    return executable.substr(0, slash);
+}
+
+std::string AssetPack_LoosePath(const char* name)
+{
+    // O executável fica em "bin/<plataforma>/", dois níveis abaixo da raiz.
+    static const std::string root = AssetPack_ExecutableDirectory() + "/../../";
+    return root + name;
+}
+
+// Contador por thread: as threads auxiliares de carregamento medem as próprias
+// leituras sem sincronização.
+static thread_local size_t t_AssetPackBytesRead = 0;
+
+size_t AssetPack_GetBytesRead()
+{
+    return t_AssetPackBytesRead;
+}
+
+static bool AssetPackReadFile(const char* filename, AssetBlob* blob)
+{
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0)
+    {
+        fclose(file);
+        return false;
+    }
+
+    // Um byte extra com zero, para que textos possam ser usados como string C.
+    unsigned char* data = new unsigned char[size + 1];
+    bool ok = fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!ok)
+    {
+        delete [] data;
+        return false;
+    }
+    data[size] = 0;
+
+    blob->data  = data;
+    blob->size  = (size_t)size;
+    blob->owned = data;
+    t_AssetPackBytesRead += blob->size;
+    MemTrack_CpuAlloc(MEM_ASSETS, blob->size);
+    return true;
+}
+
+static const AssetPackEntry* AssetPackFind(const char* name)
+{
+    size_t length = strlen(name);
+    size_t lo = 0;
+    size_t hi = g_AssetPackEntryCount;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        const AssetPackEntry& entry = g_AssetPackEntries[mid];
+        int cmp = memcmp(g_AssetPackNames + entry.name_offset, name, std::min((size_t)entry.name_length, length));
+        if (cmp == 0)
+            cmp = entry.name_length < length ? -1 : (entry.name_length > length ? 1 : 0);
+        if (cmp == 0)
+            return &entry;
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+bool AssetPack_Open(const char* filename)
+{
+    AssetPack_Close();
+
+    std::string path = filename;
+
+#if defined(_WIN32)
+    // Sem mmap(): lemos o pacote inteiro de uma vez.
+    AssetBlob blob;
+    if (!AssetPackReadFile(path.c_str(), &blob))
+        return false;
+    g_AssetPackData = blob.data;
+    g_AssetPackSize = blob.size;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(AssetPackHeader))
+    {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    g_AssetPackData = (const unsigned char*)data;
+    g_AssetPackSize = (size_t)st.st_size;
+
+    // As páginas mapeadas só são lidas quando usadas, mas contamos o pacote
+    // inteiro, como na leitura completa acima.
+    MemTrack_CpuAlloc(MEM_ASSETS, g_AssetPackSize);
+#endif
+
+    // Validamos o cabeçalho e o índice antes de aceitar o pacote.
+    const AssetPackHeader* header = (const AssetPackHeader*)g_AssetPackData;
+    bool ok = g_AssetPackSize >= sizeof(AssetPackHeader)
+           && memcmp(header->magic, "APAK", 4) == 0
+           && header->version == ASSETPACK_VERSION
+           && header->index_offset <= g_AssetPackSize
+           && header->entry_count <= (g_AssetPackSize - header->index_offset) / sizeof(AssetPackEntry)
+           && header->names_offset <= g_AssetPackSize
+           && header->names_size <= g_AssetPackSize - header->names_offset;
+
+    if (ok)
+    {
+        g_AssetPackEntries    = (const AssetPackEntry*)(g_AssetPackData + header->index_offset);
+        g_AssetPackNames      = (const char*)(g_AssetPackData + header->names_offset);
+        g_AssetPackEntryCount = header->entry_count;
+
+        for (uint32_t i = 0; ok && i < g_AssetPackEntryCount; ++i)
+        {
+            const AssetPackEntry& entry = g_AssetPackEntries[i];
+            ok = (uint64_t)entry.name_offset + entry.name_length <= header->names_size
+              && entry.offset <= g_AssetPackSize
+              && entry.stored_size <= g_AssetPackSize - entry.offset;
+        }
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Invalid asset pack \"%s\".\n", path.c_str());
+        AssetPack_Close();
+        return false;
+    }
+
+    printf("Pacote \"%s\" aberto (%u arquivos).\n", path.c_str(), g_AssetPackEntryCount);
+    return true;
+}
+
+void AssetPack_Close()
+{
+    if (g_AssetPackData == NULL)
+        return;
+
+    MemTrack_CpuFree(MEM_ASSETS, g_AssetPackSize);
+#if defined(_WIN32)
+    delete [] (unsigned char*)g_AssetPackData;
+#else
+    munmap((void*)g_AssetPackData, g_AssetPackSize);
+#endif
+    g_AssetPackData       = NULL;
+    g_AssetPackSize       = 0;
+    g_AssetPackEntries    = NULL;
+    g_AssetPackNames      = NULL;
+    g_AssetPackEntryCount = 0;
+}
+
+bool AssetPack_IsOpen()
+{
+    return g_AssetPackData != NULL;
+}
+
+bool AssetPack_Load(const char* name, AssetBlob* blob)
+{
+    blob->data  = NULL;
+    blob->size  = 0;
+    blob->owned = NULL;
+
+    const AssetPackEntry* entry = g_AssetPackData ? AssetPackFind(name) : NULL;
+    if (entry)
+    {
+        const unsigned char* stored = g_AssetPackData + entry->offset;
+        t_AssetPackBytesRead += (size_t)entry->stored_size;
+        if (!(entry->flags & ASSETPACK_COMPRESSED))
+        {
+            blob->data = stored;
+            blob->size = entry->size;
+            return true;
+        }
+
+        unsigned char* data = new unsigned char[entry->size + 1];
+        if (!AssetPackDecompress(stored, entry->stored_size, data, entry->size))
+        {
+            fprintf(stderr, "ERROR: Corrupted entry \"%s\" in asset pack.\n", name);
+            delete [] data;
+            return false;
+        }
+        data[entry->size] = 0;
+        blob->data  = data;
+        blob->size  = entry->size;
+        blob->owned = data;
+        MemTrack_CpuAlloc(MEM_ASSETS, blob->size);
+        return true;
+    }
+
+    if (name[0] != '/' && AssetPackReadFile(AssetPack_LoosePath(name).c_str(), blob))
+        return true;
+    return AssetPackReadFile(name, blob);
+}
+
+void AssetPack_Free(AssetBlob* blob)
+{
+    if (blob->owned)
+        MemTrack_CpuFree(MEM_ASSETS, blob->size);
+    delete [] blob->owned;
+    blob->data  = NULL;
+    blob->size  = 0;
+    blob->owned = NULL;
+}
+
+static bool AssetPackWritePadding(FILE* file, uint64_t* offset)
+{
+    static const char zeros[ASSETPACK_ALIGNMENT] = { 0 };
+    uint64_t padding = (ASSETPACK_ALIGNMENT - *offset % ASSETPACK_ALIGNMENT) % ASSETPACK_ALIGNMENT;
+    *offset += padding;
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+bool AssetPack_Write(const char* filename, const std::vector<std::string>& names,
+                     const AssetPackGenerated& generated)
+{
+    std::vector<std::string> sorted(names);
+    for (AssetPackGenerated::const_iterator it = generated.begin(); it != generated.end(); ++it)
+        sorted.push_back(it->first);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot create \"%s\".\n", filename);
+        return false;
+    }
+
+    AssetPackHeader header;
+    memset(&header, 0, sizeof(header));
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t offset = sizeof(header);
+
+    std::vector<AssetPackEntry> entries;
+    std::string names_table;
+    std::vector<unsigned char> compressed;
+    uint64_t total_size = 0;
+    uint64_t total_stored = 0;
+
+    for (size_t i = 0; ok && i < sorted.size(); ++i)
+    {
+        AssetBlob blob;
+        AssetPackGenerated::const_iterator it = generated.find(sorted[i]);
+        if (it != generated.end())
+        {
+            blob.data  = it->second.data();
+            blob.size  = it->second.size();
+            blob.owned = NULL;
+        }
+        else if (!AssetPackReadFile(AssetPack_LoosePath(sorted[i].c_str()).c_str(), &blob))
+        {
+            fprintf(stderr, "ERROR: Cannot read \"%s\".\n", sorted[i].c_str());
+            ok = false;
+            break;
+        }
+
+        AssetPackEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.name_offset = (uint32_t)names_table.size();
+        entry.name_length = (uint32_t)sorted[i].size();
+        entry.size        = blob.size;
+        names_table += sorted[i];
+
+        // Só vale a pena descomprimir se o arquivo ficar ao menos 10% menor.
+        AssetPackCompress(blob.data, blob.size, &compressed);
+        const unsigned char* stored = blob.data;
+        size_t stored_size = blob.size;
+        if (compressed.size() < blob.size - blob.size / 10)
+        {
+            entry.flags |= ASSETPACK_COMPRESSED;
+            stored = compressed.data();
+            stored_size = compressed.size();
+        }
+
+        ok = AssetPackWritePadding(file, &offset)
+          && fwrite(stored, 1, stored_size, file) == stored_size;
+        entry.offset      = offset;
+        entry.stored_size = stored_size;
+        offset += stored_size;
+        entries.push_back(entry);
+
+        total_size   += blob.size;
+        total_stored += stored_size;
+        printf("  %-48s %10lu -> %10lu%s\n", sorted[i].c_str(),
+               (unsigned long)blob.size, (unsigned long)stored_size,
+               (entry.flags & ASSETPACK_COMPRESSED) ? " (lz)" : "");
+        AssetPack_Free(&blob);
+    }
+
+    if (ok)
+    {
+        ok = AssetPackWritePadding(file, &offset);
+        header.index_offset = offset;
+        ok = ok && (entries.empty() || fwrite(entries.data(), sizeof(AssetPackEntry), entries.size(), file) == entries.size());
+        offset += entries.size() * sizeof(AssetPackEntry);
+
+        header.names_offset = offset;
+        header.names_size   = names_table.size();
+        ok = ok && fwrite(names_table.data(), 1, names_table.size(), file) == names_table.size();
+
+        memcpy(header.magic, "APAK", 4);
+        header.version     = ASSETPACK_VERSION;
+        header.entry_count = (uint32_t)entries.size();
+        header.alignment   = ASSETPACK_ALIGNMENT;
+        ok = ok && fseek(file, 0, SEEK_SET) == 0
+                && fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        remove(filename);
+        return false;
+    }
+
+    printf("%s: %lu arquivos, %lu -> %lu bytes.\n", filename, (unsigned long)entries.size(),
+           (unsigned long)total_size, (unsigned long)total_stored);
+    return true;
+}
@@ -0,0 +1,115 @@
+// Modo de benchmark. Veja os comentários em "include/bench.h".
+#include <cmath>
+
+#include "bench.h"
+
+#define BENCH_JUMP        (1 << 0)  // Não interpola a partir do ponto anterior
+#define BENCH_FOLLOW_CUBE (1 << 1)
+#define BENCH_AIM_CUBE    (1 << 2)
+#define BENCH_LEFT        (1 << 3)
+#define BENCH_RIGHT       (1 << 4)
+#define BENCH_USE         (1 << 5)
+
+// Ponto do roteiro: a câmera chega em (x, 0, z) olhando para "look" no
+// instante "t", e as ações de "flags" acontecem nesse instante.
+struct BenchWaypoint
+{
+    double   t;
+    float    x, z;
+    float    look_x, look_y, look_z;
+    unsigned flags;
+};
+
+// Coordenadas da fase "data/level1.level" (carregada por Level_Load()): a
+// sala inicial ocupa z entre 10 e 50, o fosso de lava z entre -10 e 10, e a
+// sala do portão z entre -50 e -10. As paredes laterais ficam em x = -50 e
+// x = +50, o cubo a ser carregado em (40, -30), o botão em (40, 30) e o
+// portão em (0, -50). O cubo móvel (onde fica o portal 1) oscila em x entre
+// -50 e 0, com z = -25.
+static const BenchWaypoint g_BenchScript[] =
+{
+    {  0.0,    0.0f,  25.0f,  -50.0f,  0.0f,  30.0f, 0 },
+    {  1.0,    0.0f,  25.0f,  -50.0f,  0.0f,  30.0f, BENCH_RIGHT },     // Portal 2 na parede lateral
+    {  1.5,    0.0f,  25.0f,    0.0f,  0.0f,   0.0f, BENCH_AIM_CUBE },
+    {  2.5,    0.0f,  25.0f,    0.0f,  0.0f,   0.0f, BENCH_AIM_CUBE | BENCH_LEFT },  // Portal 1 no cubo móvel
+    {  3.0,    0.0f,  25.0f,  -50.0f,  0.0f,  30.0f, 0 },
+    {  5.0,  -49.5f,  30.0f,  -60.0f,  0.0f,  30.0f, 0 },               // Entra no portal 2
+    {  5.1,  -10.0f, -18.0f,   40.0f,  0.0f, -30.0f, BENCH_JUMP },
+    {  8.0,   34.0f, -28.0f,   40.0f, -2.5f, -30.0f, 0 },
+    {  8.5,   34.0f, -28.0f,   40.0f, -2.5f, -30.0f, BENCH_USE },       // Pega o cubo
+    {  9.0,    0.0f,   6.0f,    0.0f,  0.0f,   0.0f, BENCH_JUMP | BENCH_FOLLOW_CUBE | BENCH_AIM_CUBE },
+    { 11.0,    0.0f,   2.0f,    0.0f,  0.0f,   0.0f, BENCH_FOLLOW_CUBE | BENCH_AIM_CUBE },  // Entra no portal 1
+    { 11.1,  -40.0f,  30.0f,   40.0f,  0.0f,  30.0f, BENCH_JUMP },
+    { 15.0,   36.0f,  30.0f,   40.0f, -2.5f,  30.0f, 0 },
+    { 15.5,   36.0f,  30.0f,   40.0f, -2.5f,  30.0f, BENCH_USE },       // Solta o cubo no botão
+    { 16.0,   36.0f,  30.0f,  -50.0f,  0.0f,  30.0f, 0 },
+    { 19.0,  -49.5f,  30.0f,  -60.0f,  0.0f,  30.0f, 0 },               // Entra no portal 2
+    { 19.1,  -10.0f, -18.0f,    0.0f,  0.0f, -50.0f, BENCH_JUMP },
+    { 23.0,    0.0f, -45.0f,    0.0f,  0.0f, -60.0f, 0 },
+    { 25.0,    0.0f, -55.0f,    0.0f,  0.0f, -60.0f, 0 },               // Passa pelo portão aberto
+    { 26.0,    0.0f, -55.0f,    0.0f,  0.0f, -60.0f, 0 },
+};
+static const int g_BenchScriptLength = sizeof(g_BenchScript) / sizeof(g_BenchScript[0]);
+
+static int g_BenchFrames = 0;
+
+void Bench_Init(int frames)
+{
+    g_BenchFrames = frames;
+}
+
+bool Bench_IsActive()
+{
+    return g_BenchFrames > 0;
+}
+
+int Bench_GetFrames()
+{
+    return g_BenchFrames;
+}
+
+double Bench_GetTime(int frame)
+{
+    return frame * BENCH_TIMESTEP;
+}
+
+// Instante de "frame" dentro do roteiro.
+static double BenchScriptTime(int frame)
+{
+    return fmod(Bench_GetTime(frame), g_BenchScript[g_BenchScriptLength - 1].t);
+}
+
+void Bench_GetInput(int frame, BenchInput* input)
+{
+    double t = BenchScriptTime(frame);
+    double t_prev = frame > 0 ? BenchScriptTime(frame - 1) : -1.0;
+    if (t_prev > t)
+        t_prev = -1.0;  // O roteiro recomeçou
+
+    int i = 0;
+    while (i + 1 < g_BenchScriptLength && g_BenchScript[i + 1].t <= t)
+        ++i;
+
+    const BenchWaypoint& a = g_BenchScript[i];
+    const BenchWaypoint& b = g_BenchScript[i + 1 < g_BenchScriptLength ? i + 1 : i];
+
+    // Interpolamos somente entre pontos do mesmo tipo (absolutos ou relativos
+    // ao cubo); nos demais casos a câmera fica parada até o salto.
+    float s = 0.0f;
+    unsigned relative = BENCH_FOLLOW_CUBE | BENCH_AIM_CUBE;
+    if (&a != &b && !(b.flags & BENCH_JUMP) && (a.flags & relative) == (b.flags & relative))
+        s = (float)((t - a.t) / (b.t - a.t));
+
+    input->position    = glm::vec4(a.x + (b.x - a.x) * s, 0.0f, a.z + (b.z - a.z) * s, 1.0f);
+    input->look_at     = glm::vec4(a.look_x + (b.look_x - a.look_x) * s,
+                                   a.look_y + (b.look_y - a.look_y) * s,
+                                   a.look_z + (b.look_z - a.look_z) * s, 1.0f);
+    input->follow_cube = (a.flags & BENCH_FOLLOW_CUBE) != 0;
+    input->aim_at_cube = (a.flags & BENCH_AIM_CUBE) != 0;
+
+    // As ações acontecem uma única vez, no primeiro quadro que alcança o ponto.
+    bool reached = t_prev < a.t && a.t <= t;
+    input->left_click  = reached && (a.flags & BENCH_LEFT);
+    input->right_click = reached && (a.flags & BENCH_RIGHT);
+    input->use         = reached && (a.flags & BENCH_USE);
+}
@@ -0,0 +1,74 @@
+// Curvas de Bézier. Veja "include/bezier.h".
+#include <cmath>
+#include <algorithm>
+
+#include "bezier.h"
+
+float Bernstein(int k, int n, float t)
+{
+    float b = Bezier_Binomial(n, k);
+    for (int i = 0; i < k; ++i)
+        b *= t;
+    for (int i = k; i < n; ++i)
+        b *= 1.0f - t;
+    return b;
+}
+
+glm::vec3 bezierCurve(const glm::vec3* points, size_t count, float time)
+{
+    if (count == 0)
+        return glm::vec3(0.0f, 0.0f, 0.0f);
+
+    // de Casteljau: interpolamos pontos vizinhos até restar um só. Curvas com
+    // até 16 pontos de controle não alocam memória.
+    glm::vec3 local[16];
+    std::vector<glm::vec3> heap;
+    glm::vec3* p = local;
+    if (count > 16)
+    {
+        heap.resize(count);
+        p = heap.data();
+    }
+    std::copy(points, points + count, p);
+
+    for (size_t n = count - 1; n > 0; --n)
+        for (size_t i = 0; i < n; ++i)
+            p[i] = p[i] + (p[i + 1] - p[i]) * time;
+
+    return p[0];
+}
+
+glm::vec3 bezierCurve(const std::vector<glm::vec3>& points, float time)
+{
+    return bezierCurve(points.data(), points.size(), time);
+}
+
+void Bezier_BakeArcLength(const glm::vec3* points, size_t count, BezierArcLength* arc)
+{
+    glm::vec3 previous = bezierCurve(points, count, 0.0f);
+    arc->lengths[0] = 0.0f;
+    for (int i = 1; i <= BEZIER_ARC_SAMPLES; ++i)
+    {
+        glm::vec3 p = bezierCurve(points, count, (float)i / BEZIER_ARC_SAMPLES);
+        glm::vec3 d = p - previous;
+        arc->lengths[i] = arc->lengths[i - 1] + std::sqrt(d.x*d.x + d.y*d.y + d.z*d.z);
+        previous = p;
+    }
+}
+
+float BezierArcLength::ParameterAt(float fraction) const
+{
+    float target = std::min(std::max(fraction, 0.0f), 1.0f) * Length();
+
+    // Primeiro trecho cujo comprimento acumulado alcança "target".
+    const float* end = lengths + BEZIER_ARC_SAMPLES + 1;
+    const float* it = std::lower_bound(lengths + 1, end, target);
+    if (it == end)
+        return 1.0f;
+
+    int   i  = (int)(it - lengths);
+    float l0 = lengths[i - 1];
+    float l1 = lengths[i];
+    float f  = l1 > l0 ? (target - l0) / (l1 - l0) : 0.0f;
+    return (i - 1 + f) / BEZIER_ARC_SAMPLES;
+}
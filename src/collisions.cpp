@@ -0,0 +1,74 @@
+// Testes de colisão entre pontos, raios e caixas alinhadas aos eixos. Veja
+// "include/collisions.h".
+#include <cmath>
+
+#include "collisions.h"
+
+int GetIntersection( float fDst1, float fDst2, glm::vec4 P1, glm::vec4 P2, glm::vec4 &Hit) {
+if ( (fDst1 * fDst2) >= 0.0f) return 0;
+if ( fDst1 == fDst2) return 0;
+Hit = P1 + (P2-P1) * ( -fDst1/(fDst2-fDst1) );
+return 1;
+}
+
+int InBox( glm::vec4 Hit, glm::vec4 B1, glm::vec4 B2, const int Axis) {
+if ( Axis==1 && Hit.z > B1.z && Hit.z < B2.z && Hit.y > B1.y && Hit.y < B2.y) return 1;
+if ( Axis==2 && Hit.z > B1.z && Hit.z < B2.z && Hit.x > B1.x && Hit.x < B2.x) return 1;
+if ( Axis==3 && Hit.x > B1.x && Hit.x < B2.x && Hit.y > B1.y && Hit.y < B2.y) return 1;
+return 0;
+}
+
+// returns true if line (L1, L2) intersects with the box (B1, B2)
+// returns intersection point in Hit
+int CheckLineBox( glm::vec4 B1, glm::vec4 B2, glm::vec4 L1, glm::vec4 vector_view, glm::vec4 &Hit)
+{
+    glm::vec4 L2 = 500.0f * vector_view + L1;
+
+if (L2.x < B1.x && L1.x < B1.x) return false;
+if (L2.x > B2.x && L1.x > B2.x) return false;
+if (L2.y < B1.y && L1.y < B1.y) return false;
+if (L2.y > B2.y && L1.y > B2.y) return false;
+if (L2.z < B1.z && L1.z < B1.z) return false;
+if (L2.z > B2.z && L1.z > B2.z) return false;
+if (L1.x > B1.x && L1.x < B2.x &&
+    L1.y > B1.y && L1.y < B2.y &&
+    L1.z > B1.z && L1.z < B2.z)
+    {Hit = L1;
+    return true;}
+if ( (GetIntersection( L1.x-B1.x, L2.x-B1.x, L1, L2, Hit) && InBox( Hit, B1, B2, 1 ))
+  || (GetIntersection( L1.y-B1.y, L2.y-B1.y, L1, L2, Hit) && InBox( Hit, B1, B2, 2 ))
+  || (GetIntersection( L1.z-B1.z, L2.z-B1.z, L1, L2, Hit) && InBox( Hit, B1, B2, 3 ))
+  || (GetIntersection( L1.x-B2.x, L2.x-B2.x, L1, L2, Hit) && InBox( Hit, B1, B2, 1 ))
+  || (GetIntersection( L1.y-B2.y, L2.y-B2.y, L1, L2, Hit) && InBox( Hit, B1, B2, 2 ))
+  || (GetIntersection( L1.z-B2.z, L2.z-B2.z, L1, L2, Hit) && InBox( Hit, B1, B2, 3 )))
+	return true;
+
+return false;
+}
+
+bool detectColision(glm::vec4 position, glm::vec4 hitbox_min, glm::vec4 hitbox_max)
+{
+    if (position.x < hitbox_min.x || position.x > hitbox_max.x)
+        return false; // No collision along X-axis
+
+    if (position.y < hitbox_min.y || position.y > hitbox_max.y)
+        return false; // No collision along Y-axis
+
+    if (position.z < hitbox_min.z || position.z > hitbox_max.z)
+        return false; // No collision along Z-axis
+
+    return true;
+
+    /*for (std::map<std::string, SceneObject>::iterator it = g_VirtualScene.begin(); it != g_VirtualScene.end(); it++)
+    {
+        SceneObject obj = it->second;
+        printf("\n%s: ", ((std::string)it->first).c_str());
+        printf("bboxmin x:%f y:%f z:%f ", obj.bbox_min.x, obj.bbox_min.y, obj.bbox_min.z);
+        printf("bboxmax x:%f y:%f z:%f ", obj.bbox_max.x, obj.bbox_max.y, obj.bbox_max.z);
+    }*/
+}
+
+double boxAngle(glm::vec4 B1, glm::vec4 B2)
+{
+    return atan2(B2.y - B1.y, B2.x - B1.x);
+}
@@ -0,0 +1,408 @@
+// Entidades do jogo e sistemas. Veja "include/ecs.h".
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "ecs.h"
+#include "matrices.h"
+
+#define ECS_PORTAL_COOLDOWN 0.5     // Segundos entre duas aberturas do mesmo portal
+
+Entity World_CreateEntity(World* world)
+{
+    uint32_t index;
+    if (!world->free_indices.empty())
+    {
+        index = world->free_indices.back();
+        world->free_indices.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)world->generation.size();
+        world->generation.push_back(0);
+    }
+    ++world->alive;
+    return ((uint32_t)world->generation[index] << ECS_INDEX_BITS) | index;
+}
+
+void World_DestroyEntity(World* world, Entity entity)
+{
+    if (!World_IsAlive(*world, entity))
+        return;
+    Component_Remove(&world->transforms, entity);
+    Component_Remove(&world->renderables, entity);
+    Component_Remove(&world->colliders, entity);
+    Component_Remove(&world->portal_surfaces, entity);
+    Component_Remove(&world->portals, entity);
+    Component_Remove(&world->pickups, entity);
+    Component_Remove(&world->triggers, entity);
+    Component_Remove(&world->animations, entity);
+
+    uint32_t index = Entity_Index(entity);
+    ++world->generation[index];
+    world->free_indices.push_back(index);
+    --world->alive;
+}
+
+bool World_IsAlive(const World& world, Entity entity)
+{
+    uint32_t index = Entity_Index(entity);
+    return entity != ECS_NO_ENTITY && index < world.generation.size()
+        && world.generation[index] == Entity_Generation(entity);
+}
+
+bool Ecs_CameraBlocked(const World& world, const glm::vec4& camera)
+{
+    return Ecs_CameraBlockedRange(world, camera, 0, world.colliders.data.size());
+}
+
+bool Ecs_CameraBlockedRange(const World& world, const glm::vec4& camera, size_t begin, size_t end)
+{
+    const std::vector<ColliderComponent, MemTrackAllocator<ColliderComponent, MEM_ENTITIES> >& colliders = world.colliders.data;
+    end = std::min(end, colliders.size());
+    for (size_t i = begin; i < end; ++i)
+    {
+        glm::vec4 hitbox_min = colliders[i].box.bbox_min;
+        glm::vec4 hitbox_max = colliders[i].box.bbox_max;
+        hitbox_min.x -= 1;
+        hitbox_max.x += 1;
+        hitbox_min.z -= 1;
+        hitbox_max.z += 1;
+        if (detectColision(camera, hitbox_min, hitbox_max))
+            return true;
+    }
+    return false;
+}
+
+// Caixa do portal aberto no ponto "point" da superfície: um pouco à frente
+// dela e virado para fora da sala.
+static bbox EcsPortalOnSurface(const bbox& surface, const glm::vec4& point, float wall_height)
+{
+    float deslX;
+    float deslZ;
+    float angle = surface.angle;
+
+    if (angle < 0.1) angle = 0;
+
+    if (std::cos(angle) > 0.01)
+    {
+        deslX = 0;
+        deslZ = 0.01;
+
+        if (surface.bbox_min.z > 0)
+            deslZ = deslZ * -1;
+        else
+            angle = angle + M_PI;
+    }
+    else
+    {
+        deslX = 0.01;
+        deslZ = 0;
+
+        if (surface.bbox_min.x > 0)
+            deslX = deslX * -1;
+        else
+            angle = angle + M_PI;
+    }
+
+    bbox portal;
+    portal.bbox_min = glm::vec4(point.x + deslX, wall_height/2, point.z + deslZ, 0.0);
+    portal.bbox_max = glm::vec4(point.x - deslX, wall_height/2, point.z - deslZ, 0.0);
+    portal.angle = angle;
+    return portal;
+}
+
+void Ecs_ShootPortals(World* world, const glm::vec4& camera, const glm::vec4& view, unsigned buttons,
+                      double time, float wall_height)
+{
+    for (size_t p = 0; p < world->portals.data.size(); ++p)
+    {
+        PortalComponent& portal = world->portals.data[p];
+        if (time - portal.last_time <= ECS_PORTAL_COOLDOWN || !(buttons & (1u << portal.button)))
+            continue;
+
+        for (size_t s = 0; s < world->portal_surfaces.data.size(); ++s)
+        {
+            const PortalSurfaceComponent& surface = world->portal_surfaces.data[s];
+            glm::vec4 point;
+            if (!CheckLineBox(surface.box.bbox_min, surface.box.bbox_max, camera, view, point))
+                continue;
+
+            portal.box = EcsPortalOnSurface(surface.box, point, wall_height);
+            portal.attached = surface.follow;
+            const TransformComponent* follow = Component_Get(world->transforms, surface.follow);
+            if (follow)
+                portal.attach_offset = glm::vec3(0.0f, 0.0f, portal.box.bbox_min.z - follow->position.z);
+            portal.last_time = time;
+            portal.created = true;
+            RenderableComponent* renderable = Component_Get(world->renderables, world->portals.entities[p]);
+            if (renderable)
+                renderable->visible = true;
+            if (portal.open_event)
+                Ecs_FireEvent(world, portal.open_event);
+            break;
+        }
+    }
+}
+
+Entity Ecs_FindPickupNear(const World& world, const glm::vec4& camera)
+{
+    Entity nearest = ECS_NO_ENTITY;
+    float nearest_distance = 0.0f;
+    for (size_t i = 0; i < world.pickups.data.size(); ++i)
+    {
+        Entity entity = world.pickups.entities[i];
+        if (world.pickups.data[i].held)
+            return ECS_NO_ENTITY;
+        const TransformComponent* transform = Component_Get(world.transforms, entity);
+        if (!transform)
+            continue;
+        glm::vec4 position(transform->position, 1.0f);
+        if (!isNear(camera, position))
+            continue;
+        float dx = camera.x - position.x;
+        float dz = camera.z - position.z;
+        float distance = dx*dx + dz*dz;
+        if (nearest == ECS_NO_ENTITY || distance < nearest_distance)
+        {
+            nearest = entity;
+            nearest_distance = distance;
+        }
+    }
+    return nearest;
+}
+
+void Ecs_TogglePickup(World* world, const glm::vec4& camera)
+{
+    for (size_t i = 0; i < world->pickups.data.size(); ++i)
+    {
+        PickupComponent& pickup = world->pickups.data[i];
+        if (pickup.held)
+        {
+            pickup.held = false;
+            pickup.dropped = true;
+            return;
+        }
+    }
+
+    PickupComponent* pickup = Component_Get(world->pickups, Ecs_FindPickupNear(*world, camera));
+    if (pickup)
+        pickup->held = true;
+}
+
+void Ecs_UpdatePickups(World* world, TransformGraph* graph, const glm::vec4& camera, float floor_y)
+{
+    const glm::quat no_rotation(1.0f, 0.0f, 0.0f, 0.0f);
+    for (size_t i = 0; i < world->pickups.data.size(); ++i)
+    {
+        PickupComponent& pickup = world->pickups.data[i];
+        Entity entity = world->pickups.entities[i];
+        TransformComponent* transform = Component_Get(world->transforms, entity);
+        if (!transform)
+            continue;
+
+        if (pickup.held)
+            transform->position = glm::vec3(camera);
+        if (pickup.dropped)
+        {
+            pickup.dropped = false;
+            transform->position.y = floor_y;
+            for (size_t t = 0; t < world->triggers.data.size(); ++t)
+            {
+                TriggerComponent& trigger = world->triggers.data[t];
+                if (trigger.activator != TRIGGER_PICKUP || !trigger.armed
+                 || !isNear(glm::vec4(transform->position, 1.0f), trigger.position))
+                    continue;
+                transform->position = trigger.snap;
+                if (!trigger.fired && trigger.event)
+                    Ecs_FireEvent(world, trigger.event);
+                trigger.fired = true;
+                break;
+            }
+        }
+
+        if (!pickup.held && transform->node != TRANSFORM_ROOT)
+            TransformGraph_SetLocal(graph, transform->node,
+                                    Affine_MakeTSR(transform->position + pickup.model_offset, no_rotation, glm::vec3(1.0f)));
+
+        RenderableComponent* renderable = Component_Get(world->renderables, entity);
+        if (renderable)
+            renderable->node = pickup.held ? world->held_node : transform->node;
+    }
+}
+
+void Ecs_UpdateTriggers(World* world, const glm::vec4& camera)
+{
+    for (size_t i = 0; i < world->triggers.data.size(); ++i)
+    {
+        TriggerComponent& trigger = world->triggers.data[i];
+        if (trigger.activator != TRIGGER_CAMERA)
+            continue;
+        trigger.inside = trigger.armed && detectColision(camera, trigger.bbox_min, trigger.bbox_max);
+        if (trigger.inside && !trigger.fired && trigger.event)
+            Ecs_FireEvent(world, trigger.event);
+        trigger.fired = trigger.fired || trigger.inside;
+    }
+}
+
+void Ecs_FireEvent(World* world, const char* event)
+{
+    for (size_t i = 0; i < world->triggers.data.size(); ++i)
+    {
+        TriggerComponent& trigger = world->triggers.data[i];
+        if (trigger.after && strcmp(trigger.after, event) == 0)
+            trigger.armed = true;
+    }
+    world->events.push_back(event);
+}
+
+void Ecs_TakeEvents(World* world, std::vector<const char*>* events)
+{
+    events->clear();
+    events->swap(world->events);
+}
+
+void Ecs_UpdateMovers(World* world, AnimationSystem* animations)
+{
+    for (size_t i = 0; i < world->animations.data.size(); ++i)
+    {
+        TransformComponent* transform = Component_Get(world->transforms, world->animations.entities[i]);
+        if (transform)
+            transform->position = Animation_GetTranslation(*animations, world->animations.data[i].target);
+    }
+
+    for (size_t i = 0; i < world->portal_surfaces.data.size(); ++i)
+    {
+        PortalSurfaceComponent& surface = world->portal_surfaces.data[i];
+        const TransformComponent* follow = Component_Get(world->transforms, surface.follow);
+        if (!follow)
+            continue;
+        surface.box.bbox_min = glm::vec4(follow->position + surface.offset_min, 0.0f);
+        surface.box.bbox_max = glm::vec4(follow->position + surface.offset_max, 0.0f);
+    }
+
+    // Portais abertos em uma superfície que se move ficam centrados na
+    // entidade, na frente da face atingida.
+    for (size_t i = 0; i < world->portals.data.size(); ++i)
+    {
+        PortalComponent& portal = world->portals.data[i];
+        const TransformComponent* follow = Component_Get(world->transforms, portal.attached);
+        if (portal.created && follow)
+        {
+            glm::vec4 position(follow->position + portal.attach_offset, 0.0f);
+            portal.box.bbox_min = position;
+            portal.box.bbox_max = position;
+        }
+        Animation_SetTranslation(animations, portal.target, glm::vec3(portal.box.bbox_min));
+        Animation_SetRotation(animations, portal.target, glm::angleAxis((float)portal.box.angle, glm::vec3(0.0f,1.0f,0.0f)));
+    }
+}
+
+int Ecs_TeleportThroughPortals(World* world, glm::vec4* camera, float* theta, float wall_height)
+{
+    int teleports = 0;
+    for (size_t i = 0; i < world->portals.data.size(); ++i)
+    {
+        const PortalComponent& portal = world->portals.data[i];
+        if (!portal.created)
+            continue;
+
+        // Região na frente do portal: 5 para cada lado ao longo da parede e
+        // 1 para cada lado através dela.
+        int deslX;
+        int deslZ;
+        if (std::fabs(std::cos(portal.box.angle)) > 0.01)
+        {
+            deslX = 5;
+            deslZ = 1;
+        }
+        else
+        {
+            deslX = 1;
+            deslZ = 5;
+        }
+        glm::vec4 hitbox_min = portal.box.bbox_min;
+        glm::vec4 hitbox_max = portal.box.bbox_max;
+        hitbox_min.x -= deslX;
+        hitbox_max.x += deslX;
+        hitbox_min.z -= deslZ;
+        hitbox_max.z += deslZ;
+        hitbox_min.y = 0;
+        hitbox_max.y = wall_height;
+
+        const PortalComponent* exit = Component_Get(world->portals, portal.linked);
+        if (!exit || !exit->created || !detectColision(*camera, hitbox_min, hitbox_max))
+            continue;
+
+        float angleCorrection = (portal.box.angle - exit->box.angle) + M_PI * std::cos(portal.box.angle - exit->box.angle);
+
+        // A câmera sai 5 unidades à frente do portal de saída.
+        if (std::fabs(std::cos(exit->box.angle)) > 0.01)
+        {
+            deslX = 0;
+            deslZ = 5;
+
+            if (exit->box.bbox_min.z > 0)
+                deslZ = deslZ * -1;
+        }
+        else
+        {
+            deslX = 5;
+            deslZ = 0;
+
+            if (exit->box.bbox_min.x > 0)
+                deslX = deslX * -1;
+        }
+
+        camera->x = exit->box.bbox_min.x + deslX;
+        camera->z = exit->box.bbox_min.z + deslZ;
+        *theta = *theta + angleCorrection;
+        ++teleports;
+    }
+    return teleports;
+}
+
+// Bits dos planos do volume de visão (-w <= x, y, z <= w) que o ponto, em
+// coordenadas de recorte, está do lado de fora.
+static unsigned EcsOutcode(const glm::vec4& p)
+{
+    return (p.x < -p.w ? 1u : 0u) | (p.x > p.w ? 2u : 0u)
+         | (p.y < -p.w ? 4u : 0u) | (p.y > p.w ? 8u : 0u)
+         | (p.z < -p.w ? 16u : 0u) | (p.z > p.w ? 32u : 0u);
+}
+
+void Ecs_BuildRenderList(const World& world, const TransformGraph& graph, const glm::mat4& view_projection,
+                         size_t begin, size_t end, RenderList* list)
+{
+    for (int pass = 0; pass < RENDER_PASS_COUNT; ++pass)
+        list->items[pass].clear();
+
+    end = std::min(end, world.renderables.data.size());
+    for (size_t i = begin; i < end; ++i)
+    {
+        const RenderableComponent& renderable = world.renderables.data[i];
+        if (!renderable.visible)
+            continue;
+
+        if (renderable.bounds_min.x <= renderable.bounds_max.x)
+        {
+            // A caixa está fora se os oito vértices estiverem do lado de
+            // fora de um mesmo plano.
+            glm::mat4 mvp = view_projection * TransformGraph_GetWorld(graph, renderable.node);
+            unsigned outside = ~0u;
+            for (int c = 0; c < 8 && outside != 0; ++c)
+            {
+                glm::vec4 corner((c & 1) ? renderable.bounds_max.x : renderable.bounds_min.x,
+                                 (c & 2) ? renderable.bounds_max.y : renderable.bounds_min.y,
+                                 (c & 4) ? renderable.bounds_max.z : renderable.bounds_min.z, 1.0f);
+                outside &= EcsOutcode(mvp * corner);
+            }
+            if (outside != 0)
+                continue;
+        }
+
+        list->items[renderable.pass].push_back((uint32_t)i);
+    }
+}
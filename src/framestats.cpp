@@ -0,0 +1,291 @@
+// Estatísticas de tempo de quadro. Veja os comentários em
+// "include/framestats.h".
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "framestats.h"
+
+// Histograma log-linear de valores inteiros em microssegundos. Valores abaixo
+// de 128 têm um balde cada; acima disso, cada potência de 2 é dividida em 64
+// baldes, o que mantém o erro relativo abaixo de 1/64.
+#define FRAMESTATS_SUB_BITS    6
+#define FRAMESTATS_SUB_COUNT   (1 << FRAMESTATS_SUB_BITS)
+#define FRAMESTATS_MAX_EXP     25
+#define FRAMESTATS_NUM_BUCKETS ((FRAMESTATS_MAX_EXP + 2) * FRAMESTATS_SUB_COUNT)
+
+// Mediana recalculada a cada tantos quadros (percorrer o histograma é barato,
+// mas não precisa ser feito todo quadro), e só depois de alguns quadros.
+#define FRAMESTATS_MEDIAN_INTERVAL 30
+#define FRAMESTATS_MEDIAN_WARMUP   60
+
+// Número máximo de engasgos guardados com seus eventos (todos são contados).
+#define FRAMESTATS_MAX_HITCHES 1024
+
+struct FrameHistogram
+{
+    unsigned counts[FRAMESTATS_NUM_BUCKETS];
+    size_t   total;
+    double   sum_ms;
+    double   max_ms;
+};
+
+struct FrameSample
+{
+    float cpu_ms;
+    float gpu_ms;   // Negativo se o tempo de GPU do quadro não foi medido
+    bool  hitch;    // Marcado mesmo depois de FRAMESTATS_MAX_HITCHES engasgos
+};
+
+struct FrameHitch
+{
+    size_t      frame;
+    double      cpu_ms;
+    std::string events;
+};
+
+static FrameHistogram            g_FrameStatsCpu;
+static FrameHistogram            g_FrameStatsGpu;
+static std::vector<FrameSample>  g_FrameStatsSamples;
+static std::vector<FrameHitch>   g_FrameStatsHitches;
+static size_t                    g_FrameStatsHitchCount = 0;
+static double                    g_FrameStatsHitchMs = 33.3;
+static double                    g_FrameStatsMedianMs = 0.0;
+
+// Eventos anotados no quadro atual.
+static std::vector<const char*>  g_FrameStatsEvents;
+
+static int FrameHistogramIndex(unsigned long us)
+{
+    if (us < 2 * FRAMESTATS_SUB_COUNT)
+        return (int)us;
+
+    int msb = 0;
+    while ((us >> (msb + 1)) != 0)
+        ++msb;
+    int exp = msb - FRAMESTATS_SUB_BITS;
+    if (exp > FRAMESTATS_MAX_EXP)
+        return FRAMESTATS_NUM_BUCKETS - 1;
+
+    return exp * FRAMESTATS_SUB_COUNT + (int)(us >> exp);
+}
+
+// Valor central (em ms) dos valores que caem no balde "index".
+static double FrameHistogramValueMs(int index)
+{
+    if (index < 2 * FRAMESTATS_SUB_COUNT)
+        return index / 1000.0;
+
+    int exp = index / FRAMESTATS_SUB_COUNT - 1;
+    unsigned long sub = index - exp * FRAMESTATS_SUB_COUNT;
+    unsigned long low = sub << exp;
+    unsigned long high = ((sub + 1) << exp) - 1;
+    return (low + high) / 2.0 / 1000.0;
+}
+
+static void FrameHistogramRecord(FrameHistogram* histogram, double ms)
+{
+    if (ms < 0.0)
+        ms = 0.0;
+
+    histogram->counts[FrameHistogramIndex((unsigned long)(ms * 1000.0 + 0.5))] += 1;
+    histogram->total  += 1;
+    histogram->sum_ms += ms;
+    histogram->max_ms  = std::max(histogram->max_ms, ms);
+}
+
+static double FrameHistogramPercentile(const FrameHistogram& histogram, double percentile)
+{
+    if (histogram.total == 0)
+        return 0.0;
+
+    // Menor valor tal que "percentile"% das amostras são menores ou iguais.
+    size_t target = (size_t)(histogram.total * percentile / 100.0 + 0.5);
+    if (target < 1)
+        target = 1;
+
+    size_t seen = 0;
+    for (int i = 0; i < FRAMESTATS_NUM_BUCKETS; ++i)
+    {
+        seen += histogram.counts[i];
+        if (seen >= target)
+            return std::min(FrameHistogramValueMs(i), histogram.max_ms);
+    }
+    return histogram.max_ms;
+}
+
+static void FrameHistogramSummary(const FrameHistogram& histogram, FrameStatsSummary* summary)
+{
+    summary->count = histogram.total;
+    summary->p50   = FrameHistogramPercentile(histogram, 50.0);
+    summary->p90   = FrameHistogramPercentile(histogram, 90.0);
+    summary->p99   = FrameHistogramPercentile(histogram, 99.0);
+    summary->p999  = FrameHistogramPercentile(histogram, 99.9);
+    summary->max   = histogram.max_ms;
+    summary->mean  = histogram.total ? histogram.sum_ms / histogram.total : 0.0;
+}
+
+void FrameStats_Init(double hitch_ms)
+{
+    memset(&g_FrameStatsCpu, 0, sizeof(g_FrameStatsCpu));
+    memset(&g_FrameStatsGpu, 0, sizeof(g_FrameStatsGpu));
+    g_FrameStatsSamples.clear();
+    g_FrameStatsHitches.clear();
+    g_FrameStatsEvents.clear();
+    g_FrameStatsHitchCount = 0;
+    g_FrameStatsHitchMs = hitch_ms;
+    g_FrameStatsMedianMs = 0.0;
+}
+
+void FrameStats_Annotate(const char* event)
+{
+    for (size_t i = 0; i < g_FrameStatsEvents.size(); ++i)
+        if (strcmp(g_FrameStatsEvents[i], event) == 0)
+            return;
+    g_FrameStatsEvents.push_back(event);
+}
+
+void FrameStats_EndFrame(double cpu_ms)
+{
+    size_t frame = g_FrameStatsSamples.size();
+
+    FrameSample sample;
+    sample.cpu_ms = (float)cpu_ms;
+    sample.gpu_ms = -1.0f;
+    FrameHistogramRecord(&g_FrameStatsCpu, cpu_ms);
+
+    if (frame >= FRAMESTATS_MEDIAN_WARMUP && frame % FRAMESTATS_MEDIAN_INTERVAL == 0)
+        g_FrameStatsMedianMs = FrameHistogramPercentile(g_FrameStatsCpu, 50.0);
+
+    bool hitch = cpu_ms > g_FrameStatsHitchMs || (g_FrameStatsMedianMs > 0.0 && cpu_ms > 2.0 * g_FrameStatsMedianMs);
+    sample.hitch = hitch;
+    g_FrameStatsSamples.push_back(sample);
+    if (hitch)
+    {
+        g_FrameStatsHitchCount += 1;
+        if (g_FrameStatsHitches.size() < FRAMESTATS_MAX_HITCHES)
+        {
+            FrameHitch record;
+            record.frame  = frame;
+            record.cpu_ms = cpu_ms;
+            for (size_t i = 0; i < g_FrameStatsEvents.size(); ++i)
+            {
+                if (i > 0)
+                    record.events += ", ";
+                record.events += g_FrameStatsEvents[i];
+            }
+            g_FrameStatsHitches.push_back(record);
+        }
+    }
+
+    g_FrameStatsEvents.clear();
+}
+
+void FrameStats_AddGpuSample(int frames_ago, double gpu_ms)
+{
+    FrameHistogramRecord(&g_FrameStatsGpu, gpu_ms);
+
+    size_t count = g_FrameStatsSamples.size();
+    if (frames_ago >= 1 && (size_t)frames_ago <= count)
+        g_FrameStatsSamples[count - frames_ago].gpu_ms = (float)gpu_ms;
+}
+
+void FrameStats_GetSummary(bool gpu, FrameStatsSummary* summary)
+{
+    FrameHistogramSummary(gpu ? g_FrameStatsGpu : g_FrameStatsCpu, summary);
+}
+
+size_t FrameStats_GetHitchCount()
+{
+    return g_FrameStatsHitchCount;
+}
+
+void FrameStats_Print()
+{
+    if (g_FrameStatsCpu.total == 0)
+        return;
+
+    printf("Frame times (%lu frames, ms):\n", (unsigned long)g_FrameStatsCpu.total);
+    printf("          p50      p90      p99    p99.9      max     mean\n");
+    for (int g = 0; g < 2; ++g)
+    {
+        FrameStatsSummary s;
+        FrameStats_GetSummary(g == 1, &s);
+        if (s.count == 0)
+            continue;
+        printf("%s %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+               g == 1 ? "GPU" : "CPU", s.p50, s.p90, s.p99, s.p999, s.max, s.mean);
+    }
+
+    printf("Hitches: %lu (> %.1f ms or > 2x median)\n", (unsigned long)g_FrameStatsHitchCount, g_FrameStatsHitchMs);
+
+    // Mostramos os piores engasgos; a lista completa vai para o arquivo JSON.
+    std::vector<const FrameHitch*> worst;
+    for (size_t i = 0; i < g_FrameStatsHitches.size(); ++i)
+        worst.push_back(&g_FrameStatsHitches[i]);
+    std::stable_sort(worst.begin(), worst.end(), [](const FrameHitch* a, const FrameHitch* b) { return a->cpu_ms > b->cpu_ms; });
+    for (size_t i = 0; i < worst.size() && i < 10; ++i)
+        printf("  frame %6lu: %8.2f ms  %s\n", (unsigned long)worst[i]->frame, worst[i]->cpu_ms,
+               worst[i]->events.empty() ? "" : worst[i]->events.c_str());
+}
+
+static void FrameStatsWriteSummaryJson(FILE* file, const char* name, bool gpu)
+{
+    FrameStatsSummary s;
+    FrameStats_GetSummary(gpu, &s);
+    fprintf(file, "  \"%s\": {\"count\": %lu, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p99.9\": %.3f, \"max\": %.3f, \"mean\": %.3f},\n",
+            name, (unsigned long)s.count, s.p50, s.p90, s.p99, s.p999, s.max, s.mean);
+}
+
+bool FrameStats_Write(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot create frame statistics file \"%s\".\n", filename);
+        return false;
+    }
+
+    size_t length = strlen(filename);
+    if (length > 4 && strcmp(filename + length - 4, ".csv") == 0)
+    {
+        // Um quadro por linha; os eventos só são guardados para os
+        // primeiros FRAMESTATS_MAX_HITCHES engasgos.
+        fprintf(file, "frame,cpu_ms,gpu_ms,hitch,events\n");
+        size_t h = 0;
+        for (size_t i = 0; i < g_FrameStatsSamples.size(); ++i)
+        {
+            const FrameSample& sample = g_FrameStatsSamples[i];
+            bool events = h < g_FrameStatsHitches.size() && g_FrameStatsHitches[h].frame == i;
+
+            fprintf(file, "%lu,%.3f,", (unsigned long)i, sample.cpu_ms);
+            if (sample.gpu_ms >= 0.0f)
+                fprintf(file, "%.3f", sample.gpu_ms);
+            fprintf(file, ",%d,\"%s\"\n", sample.hitch ? 1 : 0, events ? g_FrameStatsHitches[h].events.c_str() : "");
+            if (events)
+                ++h;
+        }
+    }
+    else
+    {
+        fprintf(file, "{\n");
+        fprintf(file, "  \"frames\": %lu,\n", (unsigned long)g_FrameStatsSamples.size());
+        FrameStatsWriteSummaryJson(file, "cpu_ms", false);
+        FrameStatsWriteSummaryJson(file, "gpu_ms", true);
+        fprintf(file, "  \"hitch_threshold_ms\": %.3f,\n", g_FrameStatsHitchMs);
+        fprintf(file, "  \"hitch_count\": %lu,\n", (unsigned long)g_FrameStatsHitchCount);
+        fprintf(file, "  \"hitches\": [");
+        for (size_t i = 0; i < g_FrameStatsHitches.size(); ++i)
+        {
+            const FrameHitch& hitch = g_FrameStatsHitches[i];
+            fprintf(file, "%s\n    {\"frame\": %lu, \"cpu_ms\": %.3f, \"events\": \"%s\"}",
+                    i > 0 ? "," : "", (unsigned long)hitch.frame, hitch.cpu_ms, hitch.events.c_str());
+        }
+        fprintf(file, "\n  ]\n}\n");
+    }
+
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,344 @@
+// Contabilidade de chamadas OpenGL. Veja os comentários em "include/glstats.h".
+#include "glstats.h"
+
+#if GLSTATS_ENABLED
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+#define GLSTATS_MAX_UNITS 32
+
+// GLStats_EndFrame() e GLStats_GetAverage() percorrem os campos como um vetor.
+static_assert(sizeof(GLStats) % sizeof(size_t) == 0, "GLStats deve conter somente contadores size_t");
+
+static GLStats g_GLStatsFrame;
+static GLStats g_GLStatsLastFrame;
+static GLStats g_GLStatsTotal;
+static size_t  g_GLStatsFrames = 0;
+
+// Estado atual do contexto, como visto pelas chamadas interceptadas. Todas as
+// chamadas OpenGL são feitas na thread principal, então não há sincronização.
+static GLuint g_GLStatsVertexArray = 0;
+static GLuint g_GLStatsProgram = 0;
+static GLuint g_GLStatsActiveUnit = 0;
+static GLuint g_GLStatsTextures[GLSTATS_MAX_UNITS];  // GL_TEXTURE_2D de cada unidade
+static GLuint g_GLStatsSamplers[GLSTATS_MAX_UNITS];
+
+// Último valor enviado a cada uniform: chave (programa, location), valor hash
+// FNV-1a dos argumentos.
+static std::unordered_map<uint64_t, uint64_t> g_GLStatsUniforms;
+
+// Funções originais da GLAD.
+static PFNGLDRAWELEMENTSPROC        g_glDrawElements;
+static PFNGLDRAWARRAYSPROC          g_glDrawArrays;
+static PFNGLBINDVERTEXARRAYPROC     g_glBindVertexArray;
+static PFNGLDELETEVERTEXARRAYSPROC  g_glDeleteVertexArrays;
+static PFNGLUSEPROGRAMPROC          g_glUseProgram;
+static PFNGLCREATEPROGRAMPROC       g_glCreateProgram;
+static PFNGLLINKPROGRAMPROC         g_glLinkProgram;
+static PFNGLDELETEPROGRAMPROC       g_glDeleteProgram;
+static PFNGLACTIVETEXTUREPROC       g_glActiveTexture;
+static PFNGLBINDTEXTUREPROC         g_glBindTexture;
+static PFNGLDELETETEXTURESPROC      g_glDeleteTextures;
+static PFNGLBINDSAMPLERPROC         g_glBindSampler;
+static PFNGLBINDBUFFERPROC          g_glBindBuffer;
+static PFNGLBUFFERDATAPROC          g_glBufferData;
+static PFNGLBUFFERSUBDATAPROC       g_glBufferSubData;
+static PFNGLUNIFORM1IPROC           g_glUniform1i;
+static PFNGLUNIFORM1FPROC           g_glUniform1f;
+static PFNGLUNIFORM2FPROC           g_glUniform2f;
+static PFNGLUNIFORM3FPROC           g_glUniform3f;
+static PFNGLUNIFORM4FPROC           g_glUniform4f;
+static PFNGLUNIFORM3FVPROC          g_glUniform3fv;
+static PFNGLUNIFORM4FVPROC          g_glUniform4fv;
+static PFNGLUNIFORMMATRIX4FVPROC    g_glUniformMatrix4fv;
+
+static size_t GLStatsTriangles(GLenum mode, GLsizei count)
+{
+    if (mode == GL_TRIANGLES)
+        return (size_t)count / 3;
+    if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count >= 3)
+        return (size_t)count - 2;
+    return 0;
+}
+
+// Conta o envio de um uniform e verifica se o valor é igual ao anterior.
+static void GLStatsUniform(GLint location, const void* data, size_t size)
+{
+    g_GLStatsFrame.uniform_uploads += 1;
+    if (location < 0)
+        return;
+
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+    uint64_t key = ((uint64_t)g_GLStatsProgram << 32) | (uint32_t)location;
+    std::unordered_map<uint64_t, uint64_t>::iterator it = g_GLStatsUniforms.find(key);
+    if (it != g_GLStatsUniforms.end() && it->second == hash)
+        g_GLStatsFrame.redundant_uniforms += 1;
+    else
+        g_GLStatsUniforms[key] = hash;
+}
+
+static void APIENTRY GLStatsDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+    g_GLStatsFrame.draw_calls += 1;
+    g_GLStatsFrame.triangles += GLStatsTriangles(mode, count);
+    g_glDrawElements(mode, count, type, indices);
+}
+
+static void APIENTRY GLStatsDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    g_GLStatsFrame.draw_calls += 1;
+    g_GLStatsFrame.triangles += GLStatsTriangles(mode, count);
+    g_glDrawArrays(mode, first, count);
+}
+
+static void APIENTRY GLStatsBindVertexArray(GLuint array)
+{
+    g_GLStatsFrame.vao_binds += 1;
+    if (array == g_GLStatsVertexArray)
+        g_GLStatsFrame.redundant_vao_binds += 1;
+    g_GLStatsVertexArray = array;
+    g_glBindVertexArray(array);
+}
+
+static void APIENTRY GLStatsDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+    // Apagar o VAO ligado volta a ligação para zero.
+    for (GLsizei i = 0; i < n; ++i)
+        if (arrays[i] == g_GLStatsVertexArray)
+            g_GLStatsVertexArray = 0;
+    g_glDeleteVertexArrays(n, arrays);
+}
+
+static void APIENTRY GLStatsUseProgram(GLuint program)
+{
+    g_GLStatsFrame.program_binds += 1;
+    if (program == g_GLStatsProgram)
+        g_GLStatsFrame.redundant_program_binds += 1;
+    g_GLStatsProgram = program;
+    g_glUseProgram(program);
+}
+
+// Identificadores de programas podem ser reutilizados, e um programa
+// religado volta a ter todos os uniforms zerados; nesses casos esquecemos
+// os valores enviados.
+static GLuint APIENTRY GLStatsCreateProgram()
+{
+    g_GLStatsUniforms.clear();
+    return g_glCreateProgram();
+}
+
+static void APIENTRY GLStatsLinkProgram(GLuint program)
+{
+    g_GLStatsUniforms.clear();
+    g_glLinkProgram(program);
+}
+
+static void APIENTRY GLStatsDeleteProgram(GLuint program)
+{
+    g_GLStatsUniforms.clear();
+    g_glDeleteProgram(program);
+}
+
+static void APIENTRY GLStatsActiveTexture(GLenum texture)
+{
+    g_GLStatsActiveUnit = texture - GL_TEXTURE0;
+    g_glActiveTexture(texture);
+}
+
+static void APIENTRY GLStatsBindTexture(GLenum target, GLuint texture)
+{
+    g_GLStatsFrame.texture_binds += 1;
+    if (target == GL_TEXTURE_2D && g_GLStatsActiveUnit < GLSTATS_MAX_UNITS)
+    {
+        if (g_GLStatsTextures[g_GLStatsActiveUnit] == texture)
+            g_GLStatsFrame.redundant_texture_binds += 1;
+        g_GLStatsTextures[g_GLStatsActiveUnit] = texture;
+    }
+    g_glBindTexture(target, texture);
+}
+
+static void APIENTRY GLStatsDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    for (GLsizei i = 0; i < n; ++i)
+        for (int unit = 0; unit < GLSTATS_MAX_UNITS; ++unit)
+            if (g_GLStatsTextures[unit] == textures[i])
+                g_GLStatsTextures[unit] = 0;
+    g_glDeleteTextures(n, textures);
+}
+
+static void APIENTRY GLStatsBindSampler(GLuint unit, GLuint sampler)
+{
+    g_GLStatsFrame.texture_binds += 1;
+    if (unit < GLSTATS_MAX_UNITS)
+    {
+        if (g_GLStatsSamplers[unit] == sampler)
+            g_GLStatsFrame.redundant_texture_binds += 1;
+        g_GLStatsSamplers[unit] = sampler;
+    }
+    g_glBindSampler(unit, sampler);
+}
+
+static void APIENTRY GLStatsBindBuffer(GLenum target, GLuint buffer)
+{
+    // A ligação de GL_ELEMENT_ARRAY_BUFFER faz parte do VAO, então não
+    // tentamos detectar trocas redundantes de buffers.
+    g_GLStatsFrame.buffer_binds += 1;
+    g_glBindBuffer(target, buffer);
+}
+
+static void APIENTRY GLStatsBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    if (data != NULL)
+        g_GLStatsFrame.buffer_bytes += (size_t)size;
+    g_glBufferData(target, size, data, usage);
+}
+
+static void APIENTRY GLStatsBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    g_GLStatsFrame.buffer_bytes += (size_t)size;
+    g_glBufferSubData(target, offset, size, data);
+}
+
+static void APIENTRY GLStatsUniform1i(GLint location, GLint v0)
+{
+    GLStatsUniform(location, &v0, sizeof(v0));
+    g_glUniform1i(location, v0);
+}
+
+static void APIENTRY GLStatsUniform1f(GLint location, GLfloat v0)
+{
+    GLStatsUniform(location, &v0, sizeof(v0));
+    g_glUniform1f(location, v0);
+}
+
+static void APIENTRY GLStatsUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+    GLfloat v[2] = { v0, v1 };
+    GLStatsUniform(location, v, sizeof(v));
+    g_glUniform2f(location, v0, v1);
+}
+
+static void APIENTRY GLStatsUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+    GLfloat v[3] = { v0, v1, v2 };
+    GLStatsUniform(location, v, sizeof(v));
+    g_glUniform3f(location, v0, v1, v2);
+}
+
+static void APIENTRY GLStatsUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+    GLfloat v[4] = { v0, v1, v2, v3 };
+    GLStatsUniform(location, v, sizeof(v));
+    g_glUniform4f(location, v0, v1, v2, v3);
+}
+
+static void APIENTRY GLStatsUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    GLStatsUniform(location, value, count * 3 * sizeof(GLfloat));
+    g_glUniform3fv(location, count, value);
+}
+
+static void APIENTRY GLStatsUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    GLStatsUniform(location, value, count * 4 * sizeof(GLfloat));
+    g_glUniform4fv(location, count, value);
+}
+
+static void APIENTRY GLStatsUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+    GLStatsUniform(location, value, count * 16 * sizeof(GLfloat));
+    g_glUniformMatrix4fv(location, count, transpose, value);
+}
+
+#define GLSTATS_WRAP(name) \
+    g_gl##name = glad_gl##name; \
+    glad_gl##name = GLStats##name
+
+void GLStats_Install()
+{
+    if (g_glDrawElements != NULL)
+        return;
+
+    GLSTATS_WRAP(DrawElements);
+    GLSTATS_WRAP(DrawArrays);
+    GLSTATS_WRAP(BindVertexArray);
+    GLSTATS_WRAP(DeleteVertexArrays);
+    GLSTATS_WRAP(UseProgram);
+    GLSTATS_WRAP(CreateProgram);
+    GLSTATS_WRAP(LinkProgram);
+    GLSTATS_WRAP(DeleteProgram);
+    GLSTATS_WRAP(ActiveTexture);
+    GLSTATS_WRAP(BindTexture);
+    GLSTATS_WRAP(DeleteTextures);
+    GLSTATS_WRAP(BindSampler);
+    GLSTATS_WRAP(BindBuffer);
+    GLSTATS_WRAP(BufferData);
+    GLSTATS_WRAP(BufferSubData);
+    GLSTATS_WRAP(Uniform1i);
+    GLSTATS_WRAP(Uniform1f);
+    GLSTATS_WRAP(Uniform2f);
+    GLSTATS_WRAP(Uniform3f);
+    GLSTATS_WRAP(Uniform4f);
+    GLSTATS_WRAP(Uniform3fv);
+    GLSTATS_WRAP(Uniform4fv);
+    GLSTATS_WRAP(UniformMatrix4fv);
+}
+
+void GLStats_EndFrame()
+{
+    const size_t* frame = (const size_t*)&g_GLStatsFrame;
+    size_t* total = (size_t*)&g_GLStatsTotal;
+    for (size_t i = 0; i < sizeof(GLStats) / sizeof(size_t); ++i)
+        total[i] += frame[i];
+    g_GLStatsFrames += 1;
+
+    g_GLStatsLastFrame = g_GLStatsFrame;
+    g_GLStatsFrame = GLStats();
+}
+
+const GLStats& GLStats_GetLastFrame()
+{
+    return g_GLStatsLastFrame;
+}
+
+size_t GLStats_GetAverage(GLStats* average)
+{
+    *average = GLStats();
+    if (g_GLStatsFrames == 0)
+        return 0;
+
+    const size_t* total = (const size_t*)&g_GLStatsTotal;
+    size_t* result = (size_t*)average;
+    for (size_t i = 0; i < sizeof(GLStats) / sizeof(size_t); ++i)
+        result[i] = (total[i] + g_GLStatsFrames / 2) / g_GLStatsFrames;
+    return g_GLStatsFrames;
+}
+
+void GLStats_Print()
+{
+    GLStats s;
+    size_t frames = GLStats_GetAverage(&s);
+    if (frames == 0)
+        return;
+
+    printf("GL calls per frame (average of %lu frames):\n", (unsigned long)frames);
+    printf("  draws %lu, triangles %lu, buffer bytes %lu\n",
+           (unsigned long)s.draw_calls, (unsigned long)s.triangles, (unsigned long)s.buffer_bytes);
+    printf("  binds: VAO %lu (%lu redundant), program %lu (%lu redundant), texture %lu (%lu redundant), buffer %lu\n",
+           (unsigned long)s.vao_binds, (unsigned long)s.redundant_vao_binds,
+           (unsigned long)s.program_binds, (unsigned long)s.redundant_program_binds,
+           (unsigned long)s.texture_binds, (unsigned long)s.redundant_texture_binds,
+           (unsigned long)s.buffer_binds);
+    printf("  uniforms %lu (%lu redundant)\n", (unsigned long)s.uniform_uploads, (unsigned long)s.redundant_uniforms);
+}
+
+#endif // GLSTATS_ENABLED
@@ -0,0 +1,167 @@
+// Observação de arquivos alterados. Veja os comentários em
+// "include/hotreload.h".
+#include <cstdio>
+#include <set>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hotreload.h"
+#include "assetpack.h"
+
+#ifdef __linux__
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+static int                        g_HotReloadInotify = -1;
+static int                        g_HotReloadQuitPipe[2] = { -1, -1 };
+static std::map<int, std::string> g_HotReloadWatches; // Descritor inotify -> diretório
+static std::vector<std::string>   g_HotReloadExtensions;
+static std::thread                g_HotReloadWorker;
+
+// Arquivos alterados ainda não consumidos por HotReload_PollChanges().
+static std::mutex                 g_HotReloadMutex;
+static std::set<std::string>      g_HotReloadChanged;
+
+// Arquivos de outros tipos (código-fonte, temporários de editores, ...) são
+// ignorados já na thread auxiliar.
+static bool HotReloadWanted(const std::string& name)
+{
+    for (size_t i = 0; i < g_HotReloadExtensions.size(); ++i)
+    {
+        const std::string& extension = g_HotReloadExtensions[i];
+        if (name.size() > extension.size()
+         && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void HotReloadWorkerLoop()
+{
+    // Buffer alinhado como exigido por inotify(7).
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = g_HotReloadInotify;
+        fds[0].events = POLLIN;
+        fds[1].fd = g_HotReloadQuitPipe[0];
+        fds[1].events = POLLIN;
+
+        if (poll(fds, 2, -1) < 0)
+            continue;
+        if (fds[1].revents & POLLIN)
+            return;
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        ssize_t length = read(g_HotReloadInotify, buffer, sizeof(buffer));
+        if (length <= 0)
+            continue;
+
+        std::lock_guard<std::mutex> lock(g_HotReloadMutex);
+        for (char* ptr = buffer; ptr < buffer + length; )
+        {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->len == 0 || (event->mask & IN_ISDIR) || !HotReloadWanted(event->name))
+                continue;
+
+            std::map<int, std::string>::iterator it = g_HotReloadWatches.find(event->wd);
+            if (it != g_HotReloadWatches.end())
+                g_HotReloadChanged.insert(it->second + "/" + event->name);
+        }
+    }
+}
+
+bool HotReload_Init(const std::vector<std::string>& directories, const std::vector<std::string>& extensions)
+{
+    g_HotReloadExtensions = extensions;
+    g_HotReloadInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (g_HotReloadInotify < 0)
+    {
+        perror("inotify_init1");
+        return false;
+    }
+
+    // Editores costumam salvar escrevendo um arquivo temporário e renomeando,
+    // por isso observamos também IN_MOVED_TO.
+    for (size_t i = 0; i < directories.size(); ++i)
+    {
+        std::string path = AssetPack_LoosePath(directories[i].c_str());
+        int wd = inotify_add_watch(g_HotReloadInotify, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            fprintf(stderr, "WARNING: Cannot watch directory \"%s\" for changes.\n", path.c_str());
+            continue;
+        }
+        g_HotReloadWatches[wd] = directories[i];
+    }
+
+    if (pipe(g_HotReloadQuitPipe) != 0)
+    {
+        perror("pipe");
+        close(g_HotReloadInotify);
+        g_HotReloadInotify = -1;
+        g_HotReloadWatches.clear();
+        return false;
+    }
+
+    g_HotReloadWorker = std::thread(HotReloadWorkerLoop);
+    return true;
+}
+
+void HotReload_Shutdown()
+{
+    if (g_HotReloadInotify < 0)
+        return;
+
+    char quit = 0;
+    if (write(g_HotReloadQuitPipe[1], &quit, 1) == 1)
+        g_HotReloadWorker.join();
+    else
+        g_HotReloadWorker.detach();
+
+    close(g_HotReloadQuitPipe[0]);
+    close(g_HotReloadQuitPipe[1]);
+    close(g_HotReloadInotify);
+    g_HotReloadInotify = -1;
+    g_HotReloadWatches.clear();
+    g_HotReloadExtensions.clear();
+    g_HotReloadChanged.clear();
+}
+
+void HotReload_PollChanges(std::vector<std::string>* files)
+{
+    files->clear();
+
+    std::lock_guard<std::mutex> lock(g_HotReloadMutex);
+    files->assign(g_HotReloadChanged.begin(), g_HotReloadChanged.end());
+    g_HotReloadChanged.clear();
+}
+
+#else // __linux__
+
+bool HotReload_Init(const std::vector<std::string>& directories, const std::vector<std::string>& extensions)
+{
+    fprintf(stderr, "WARNING: Hot reload of assets is only available on Linux.\n");
+    return false;
+}
+
+void HotReload_Shutdown()
+{
+}
+
+void HotReload_PollChanges(std::vector<std::string>* files)
+{
+    files->clear();
+}
+
+#endif // __linux__
@@ -0,0 +1,153 @@
+// Gravação e reprodução de entrada. Veja os comentários em
+// "include/inputreplay.h".
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+#include "inputreplay.h"
+
+static_assert(sizeof(InputFileHeader) == 16, "InputFileHeader deve ter 16 bytes");
+static_assert(sizeof(InputEvent) == 48, "InputEvent deve ter 48 bytes");
+
+static FILE*                    g_InputRecordFile = NULL;
+static double                   g_InputRecordStart = 0.0;
+
+static std::vector<InputEvent>  g_InputReplayEvents;
+static size_t                   g_InputReplayNext = 0;
+static double                   g_InputReplayTimestep = 0.0;
+static uint32_t                 g_InputReplayFrames = 0;
+static bool                     g_InputReplayActive = false;
+
+static double InputNowSeconds()
+{
+    typedef std::chrono::steady_clock clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+bool InputRecord_Start(const char* filename, double timestep)
+{
+    g_InputRecordFile = fopen(filename, "wb");
+    if (g_InputRecordFile == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot create input recording \"%s\".\n", filename);
+        return false;
+    }
+
+    InputFileHeader header;
+    header.magic    = INPUT_FILE_MAGIC;
+    header.version  = INPUT_FILE_VERSION;
+    header.timestep = timestep;
+    fwrite(&header, sizeof(header), 1, g_InputRecordFile);
+
+    g_InputRecordStart = InputNowSeconds();
+    return true;
+}
+
+void InputRecord_Stop(uint32_t frames)
+{
+    if (g_InputRecordFile == NULL)
+        return;
+
+    InputEvent end = InputEvent();
+    end.frame = frames;
+    end.type  = INPUT_END;
+    InputRecord_Event(end);
+
+    fclose(g_InputRecordFile);
+    g_InputRecordFile = NULL;
+}
+
+bool InputRecord_IsActive()
+{
+    return g_InputRecordFile != NULL;
+}
+
+void InputRecord_Event(const InputEvent& event)
+{
+    if (g_InputRecordFile == NULL)
+        return;
+
+    InputEvent record = event;
+    record.time = InputNowSeconds() - g_InputRecordStart;
+    if (fwrite(&record, sizeof(record), 1, g_InputRecordFile) != 1)
+    {
+        fprintf(stderr, "ERROR: Cannot write input recording; recording stopped.\n");
+        fclose(g_InputRecordFile);
+        g_InputRecordFile = NULL;
+    }
+}
+
+bool InputReplay_Start(const char* filename)
+{
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot open input recording \"%s\".\n", filename);
+        return false;
+    }
+
+    InputFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != INPUT_FILE_MAGIC
+        || header.version != INPUT_FILE_VERSION || !(header.timestep > 0.0))
+    {
+        fprintf(stderr, "ERROR: \"%s\" is not a valid input recording.\n", filename);
+        fclose(file);
+        return false;
+    }
+
+    g_InputReplayEvents.clear();
+    g_InputReplayFrames = 0;
+    InputEvent event;
+    while (fread(&event, sizeof(event), 1, file) == 1)
+    {
+        if (event.type == INPUT_END)
+        {
+            g_InputReplayFrames = event.frame;
+            break;
+        }
+        g_InputReplayEvents.push_back(event);
+    }
+    fclose(file);
+
+    // Uma gravação interrompida (sem INPUT_END) vai até o último evento.
+    if (g_InputReplayFrames == 0 && !g_InputReplayEvents.empty())
+        g_InputReplayFrames = g_InputReplayEvents.back().frame + 1;
+
+    g_InputReplayNext = 0;
+    g_InputReplayTimestep = header.timestep;
+    g_InputReplayActive = true;
+
+    printf("Reproduzindo %lu eventos em %u quadros de \"%s\".\n",
+           (unsigned long)g_InputReplayEvents.size(), g_InputReplayFrames, filename);
+    return true;
+}
+
+void InputReplay_Stop()
+{
+    g_InputReplayEvents.clear();
+    g_InputReplayActive = false;
+}
+
+bool InputReplay_IsActive()
+{
+    return g_InputReplayActive;
+}
+
+double InputReplay_GetTimestep()
+{
+    return g_InputReplayTimestep;
+}
+
+uint32_t InputReplay_GetFrames()
+{
+    return g_InputReplayFrames;
+}
+
+bool InputReplay_Next(uint32_t frame, InputEvent* event)
+{
+    if (g_InputReplayNext >= g_InputReplayEvents.size() || g_InputReplayEvents[g_InputReplayNext].frame > frame)
+        return false;
+
+    *event = g_InputReplayEvents[g_InputReplayNext++];
+    return true;
+}
@@ -0,0 +1,300 @@
+// Sistema de tarefas do quadro. Veja os comentários em "include/jobs.h".
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "trace.h"
+#include "profiler.h"
+#include "jobs.h"
+
+struct Job
+{
+    const char*        name;
+    JobFunction        function;
+    void*              data;
+    size_t             begin;
+    size_t             end;
+
+    // Dependências que ainda não terminaram, mais uma enquanto Jobs_Add()
+    // monta a tarefa; quem levar a zero põe a tarefa na fila.
+    std::atomic<int>   waiting;
+    std::atomic<bool>  done;
+    std::vector<JobId> dependents;  // Protegido por g_JobsGraphMutex
+    double             ms;          // Escrito por quem executou, antes de "done"
+};
+
+// Fila de uma thread: a dona usa o fim, as outras roubam do início.
+struct JobQueue
+{
+    std::mutex        mutex;
+    std::deque<JobId> jobs;
+};
+
+// As tarefas ficam em blocos alocados conforme a necessidade e nunca movidos
+// (as threads guardam referências para elas); um quadro com muitas partes
+// apenas aloca mais blocos, que são reaproveitados nos quadros seguintes.
+#define JOBS_BLOCK_SIZE 1024
+
+static Job*                     g_JobBlocks[JOBS_MAX / JOBS_BLOCK_SIZE];
+static int                      g_JobCount = 0;     // Somente a thread principal cria tarefas
+static std::atomic<int>         g_JobsUnfinished(0);
+static std::atomic<int>         g_JobsQueued(0);
+static std::mutex               g_JobsGraphMutex;   // "done" e "dependents" de todas as tarefas
+
+static JobQueue                 g_JobQueues[JOBS_MAX_THREADS];
+static int                      g_JobThreadCount = 1;
+static std::vector<std::thread> g_JobWorkers;
+static char                     g_JobWorkerNames[JOBS_MAX_THREADS][16];
+static std::vector<JobId>       g_JobParts;
+
+// Workers sem trabalho dormem até alguma tarefa entrar em uma fila.
+static std::mutex               g_JobsWakeMutex;
+static std::condition_variable  g_JobsWake;
+static bool                     g_JobsQuit = false;
+
+static thread_local int         t_JobThread = 0;    // Índice da fila; 0 é a thread principal
+
+static Job& JobsGet(JobId id)
+{
+    return g_JobBlocks[id / JOBS_BLOCK_SIZE][id % JOBS_BLOCK_SIZE];
+}
+
+static double JobsNowMs()
+{
+    typedef std::chrono::steady_clock clock;
+    return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+}
+
+static void JobsPush(JobId id)
+{
+    JobQueue& queue = g_JobQueues[t_JobThread];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(id);
+    }
+    g_JobsQueued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(g_JobsWakeMutex);
+    }
+    g_JobsWake.notify_one();
+}
+
+// Retira a última tarefa da própria fila ou rouba a primeira de outra.
+static bool JobsPop(JobId* id)
+{
+    for (int i = 0; i < g_JobThreadCount; ++i)
+    {
+        JobQueue& queue = g_JobQueues[(t_JobThread + i) % g_JobThreadCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+        if (i == 0)
+        {
+            *id = queue.jobs.back();
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            *id = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+        g_JobsQueued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+static void JobsRun(JobId id)
+{
+    Job& job = JobsGet(id);
+    if (job.function)
+    {
+        Trace_Begin(job.name);
+        double start = JobsNowMs();
+        job.function(job.data, job.begin, job.end);
+        job.ms = JobsNowMs() - start;
+        Trace_End();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_JobsGraphMutex);
+        job.done.store(true);
+        for (size_t i = 0; i < job.dependents.size(); ++i)
+            if (JobsGet(job.dependents[i]).waiting.fetch_sub(1) == 1)
+                JobsPush(job.dependents[i]);
+    }
+    g_JobsUnfinished.fetch_sub(1);
+}
+
+static void JobsWorkerLoop(int index)
+{
+    t_JobThread = index;
+    Trace_SetThreadName(g_JobWorkerNames[index]);
+
+    for (;;)
+    {
+        JobId id;
+        if (JobsPop(&id))
+        {
+            JobsRun(id);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(g_JobsWakeMutex);
+        while (!g_JobsQuit && g_JobsQueued.load() == 0)
+            g_JobsWake.wait(lock);
+        if (g_JobsQuit)
+            return;
+    }
+}
+
+void Jobs_Init(int workers)
+{
+    if (workers < 0)
+    {
+        int cores = (int)std::thread::hardware_concurrency();
+        workers = cores > 1 ? cores - 1 : 0;
+    }
+    if (workers > JOBS_MAX_THREADS - 1)
+        workers = JOBS_MAX_THREADS - 1;
+
+    g_JobsQuit = false;
+    g_JobThreadCount = workers + 1;
+    for (int i = 1; i <= workers; ++i)
+    {
+        snprintf(g_JobWorkerNames[i], sizeof(g_JobWorkerNames[i]), "job worker %d", i);
+        g_JobWorkers.push_back(std::thread(JobsWorkerLoop, i));
+    }
+}
+
+void Jobs_Shutdown()
+{
+    Jobs_EndFrame();
+    {
+        std::lock_guard<std::mutex> lock(g_JobsWakeMutex);
+        g_JobsQuit = true;
+    }
+    g_JobsWake.notify_all();
+    for (size_t i = 0; i < g_JobWorkers.size(); ++i)
+        g_JobWorkers[i].join();
+    g_JobWorkers.clear();
+    g_JobThreadCount = 1;
+
+    for (int b = 0; b < JOBS_MAX / JOBS_BLOCK_SIZE; ++b)
+    {
+        delete[] g_JobBlocks[b];
+        g_JobBlocks[b] = NULL;
+    }
+}
+
+int Jobs_GetWorkerCount()
+{
+    return g_JobThreadCount - 1;
+}
+
+static JobId JobsAdd(const char* name, JobFunction function, void* data, size_t begin, size_t end,
+                     const JobId* dependencies, int dependency_count)
+{
+    // Executar a tarefa aqui mesmo e retornar JOB_NONE faria quem espera por
+    // ela (ou por uma tarefa que junta partes ainda em execução) seguir
+    // adiante antes da hora; melhor parar.
+    if (g_JobCount == JOBS_MAX)
+    {
+        fprintf(stderr, "ERROR: More than %d jobs in one frame (adding \"%s\"); increase the batch sizes or JOBS_MAX.\n", JOBS_MAX, name);
+        std::abort();
+    }
+
+    // O bloco é publicado para as outras threads junto com os identificadores
+    // das suas tarefas (pelos mutexes das filas e do grafo).
+    JobId id = g_JobCount++;
+    if (g_JobBlocks[id / JOBS_BLOCK_SIZE] == NULL)
+        g_JobBlocks[id / JOBS_BLOCK_SIZE] = new Job[JOBS_BLOCK_SIZE];
+    Job& job = JobsGet(id);
+    job.name = name;
+    job.function = function;
+    job.data = data;
+    job.begin = begin;
+    job.end = end;
+    job.ms = 0.0;
+    job.waiting.store(1);
+    job.done.store(false);
+    g_JobsUnfinished.fetch_add(1);
+
+    {
+        std::lock_guard<std::mutex> lock(g_JobsGraphMutex);
+        for (int i = 0; i < dependency_count; ++i)
+        {
+            if (dependencies[i] == JOB_NONE || JobsGet(dependencies[i]).done.load())
+                continue;
+            JobsGet(dependencies[i]).dependents.push_back(id);
+            job.waiting.fetch_add(1);
+        }
+    }
+
+    if (job.waiting.fetch_sub(1) == 1)
+        JobsPush(id);
+    return id;
+}
+
+JobId Jobs_Add(const char* name, JobFunction function, void* data, const JobId* dependencies, int dependency_count)
+{
+    return JobsAdd(name, function, data, 0, 1, dependencies, dependency_count);
+}
+
+JobId Jobs_AddParallel(const char* name, JobFunction function, void* data, size_t count, size_t batch,
+                       const JobId* dependencies, int dependency_count)
+{
+    if (batch == 0)
+        batch = 1;
+
+    g_JobParts.clear();
+    for (size_t begin = 0; begin < count; begin += batch)
+        g_JobParts.push_back(JobsAdd(name, function, data, begin, std::min(begin + batch, count),
+                                     dependencies, dependency_count));
+    if (g_JobParts.empty())
+        return JobsAdd(name, NULL, NULL, 0, 0, dependencies, dependency_count);
+    return JobsAdd(name, NULL, NULL, 0, 0, &g_JobParts[0], (int)g_JobParts.size());
+}
+
+void Jobs_Wait(JobId job)
+{
+    if (job == JOB_NONE)
+        return;
+
+    while (!JobsGet(job).done.load())
+    {
+        JobId id;
+        if (JobsPop(&id))
+            JobsRun(id);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void Jobs_EndFrame()
+{
+    while (g_JobsUnfinished.load() > 0)
+    {
+        JobId id;
+        if (JobsPop(&id))
+            JobsRun(id);
+        else
+            std::this_thread::yield();
+    }
+
+    for (int i = 0; i < g_JobCount; ++i)
+    {
+        Job& job = JobsGet(i);
+        if (job.function)
+            Profiler_AddJobTime(job.name, job.ms);
+        job.dependents.clear();
+    }
+    g_JobCount = 0;
+}
@@ -0,0 +1,676 @@
+// Fases em arquivos de dados. Veja "include/level.h".
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "level.h"
+#include "animation.h"
+#include "assetpack.h"
+
+static_assert(sizeof(LevelPlacement) % 4 == 0, "LevelPlacement deve ter tamanho múltiplo de 4");
+
+// Materiais: os mesmos valores dos "#define" de "main.cpp" e dos shaders.
+static const char* const g_LevelMaterials[] =
+{
+    "FLOOR", "WALL", "ROOF", "PORTALGUN", "PORTAL1", "PORTAL2",
+    "AIMLEFT", "AIMRIGHT", "COMPANION_CUBE", "BUTTON", "LAVA", "GATE"
+};
+
+// Na ordem de AnimationChannel, AnimationInterp e AnimationLoop.
+static const char* const g_LevelChannels[] =
+{
+    "translate_x", "translate_y", "translate_z", "scale_x", "scale_y", "scale_z"
+};
+static const char* const g_LevelInterps[] = { "step", "linear", "smooth", "bezier" };
+static const char* const g_LevelLoops[]   = { "once", "repeat", "pingpong" };
+
+static_assert(sizeof(g_LevelChannels) / sizeof(g_LevelChannels[0]) == ANIM_CHANNEL_COUNT,
+              "g_LevelChannels deve seguir AnimationChannel");
+
+#define LEVEL_COUNT(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+struct LevelPortalSource
+{
+    bbox        box;
+    std::string event;          // Vazio: disponível desde o início
+};
+
+struct LevelTrackSource
+{
+    LevelTrack  track;
+    std::string object;
+    int         line;
+};
+
+// Estado da compilação de um arquivo de texto.
+struct LevelCompiler
+{
+    const char*                     source_name;
+    int                             line;
+    bool                            ok;
+
+    std::vector<std::string>        tokens;     // Da linha atual
+    size_t                          next;
+
+    std::string                     strings;
+    std::map<std::string, uint32_t> string_offsets;
+
+    std::vector<LevelPlacement>     placements;
+    std::vector<std::string>        placement_names;
+    std::vector<bbox>               colliders;
+    std::vector<LevelPortalSource>  portals;
+    std::vector<LevelTrigger>       triggers;
+    std::vector<LevelMarker>        markers;
+    std::vector<LevelPickup>        pickups;
+    std::vector<LevelTrackSource>   tracks;
+    std::vector<float>              key_times;
+    std::vector<float>              key_values;
+};
+
+static void LevelError(LevelCompiler* c, int line, const char* message, const std::string& detail = "")
+{
+    fprintf(stderr, "ERROR: %s:%d: %s%s%s\n", c->source_name, line, message,
+            detail.empty() ? "" : " ", detail.c_str());
+    c->ok = false;
+}
+
+static uint32_t LevelAddString(LevelCompiler* c, const std::string& text)
+{
+    std::map<std::string, uint32_t>::const_iterator it = c->string_offsets.find(text);
+    if (it != c->string_offsets.end())
+        return it->second;
+
+    uint32_t offset = (uint32_t)c->strings.size();
+    c->strings += text;
+    c->strings += '\0';
+    c->string_offsets[text] = offset;
+    return offset;
+}
+
+static bool LevelNextToken(LevelCompiler* c, std::string* token, const char* what)
+{
+    if (c->next >= c->tokens.size())
+    {
+        LevelError(c, c->line, "expected", what);
+        return false;
+    }
+    *token = c->tokens[c->next++];
+    return true;
+}
+
+static bool LevelNextFloats(LevelCompiler* c, float* values, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        std::string token;
+        if (!LevelNextToken(c, &token, "number"))
+            return false;
+        char* end;
+        values[i] = strtof(token.c_str(), &end);
+        if (end == token.c_str() || *end != '\0')
+        {
+            LevelError(c, c->line, "expected number, found", token);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool LevelExpect(LevelCompiler* c, const char* keyword)
+{
+    std::string token;
+    if (!LevelNextToken(c, &token, keyword))
+        return false;
+    if (token != keyword)
+    {
+        LevelError(c, c->line, (std::string("expected ") + keyword + ", found").c_str(), token);
+        return false;
+    }
+    return true;
+}
+
+// Índice de "token" em "names", ou -1 (com erro) se não estiver lá.
+static int LevelNextEnum(LevelCompiler* c, const char* const* names, int count, const char* what)
+{
+    std::string token;
+    if (!LevelNextToken(c, &token, what))
+        return -1;
+    for (int i = 0; i < count; ++i)
+        if (token == names[i])
+            return i;
+    LevelError(c, c->line, (std::string("unknown ") + what).c_str(), token);
+    return -1;
+}
+
+static bool LevelNextBox(LevelCompiler* c, float* bbox_min, float* bbox_max)
+{
+    return LevelExpect(c, "min") && LevelNextFloats(c, bbox_min, 3)
+        && LevelExpect(c, "max") && LevelNextFloats(c, bbox_max, 3);
+}
+
+static void LevelParsePlacement(LevelCompiler* c)
+{
+    LevelPlacement placement;
+    memset(&placement, 0, sizeof(placement));
+    placement.name  = LEVEL_NONE;
+    placement.flags = LEVEL_TSR;
+
+    int material = LevelNextEnum(c, g_LevelMaterials, LEVEL_COUNT(g_LevelMaterials), "material");
+    std::string mesh, name;
+    if (material < 0 || !LevelNextToken(c, &mesh, "mesh name"))
+        return;
+    placement.object_id = material;
+    placement.mesh = LevelAddString(c, mesh);
+
+    glm::vec3 translation(0.0f);
+    glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale(1.0f);
+    while (c->next < c->tokens.size())
+    {
+        std::string keyword = c->tokens[c->next++];
+        if (keyword == "name")
+        {
+            if (!LevelNextToken(c, &name, "placement name"))
+                return;
+            for (size_t i = 0; i < c->placement_names.size(); ++i)
+                if (c->placement_names[i] == name)
+                {
+                    LevelError(c, c->line, "duplicate placement name", name);
+                    return;
+                }
+            placement.name = LevelAddString(c, name);
+        }
+        else if (keyword == "dynamic")
+            placement.flags |= LEVEL_DYNAMIC;
+        else if (keyword == "trs")
+            placement.flags &= ~LEVEL_TSR;
+        else if (keyword == "position")
+        {
+            if (!LevelNextFloats(c, &translation.x, 3))
+                return;
+        }
+        else if (keyword == "scale")
+        {
+            if (!LevelNextFloats(c, &scale.x, 3))
+                return;
+        }
+        else if (keyword == "rotate")
+        {
+            static const char* const axes[] = { "x", "y", "z" };
+            int axis = LevelNextEnum(c, axes, 3, "axis");
+            float degrees;
+            if (axis < 0 || !LevelNextFloats(c, &degrees, 1))
+                return;
+            glm::vec3 direction(0.0f);
+            direction[axis] = 1.0f;
+            rotation = rotation * glm::angleAxis(degrees * 3.14159265358979323846f / 180.0f, direction);
+        }
+        else
+        {
+            LevelError(c, c->line, "unknown placement option", keyword);
+            return;
+        }
+    }
+
+    placement.local = (placement.flags & LEVEL_TSR) ? Affine_MakeTSR(translation, rotation, scale)
+                                                    : Affine_MakeTRS(translation, rotation, scale);
+    for (int i = 0; i < 3; ++i)
+    {
+        placement.translation[i] = translation[i];
+        placement.scale[i]       = scale[i];
+    }
+    placement.rotation[0] = rotation.x;
+    placement.rotation[1] = rotation.y;
+    placement.rotation[2] = rotation.z;
+    placement.rotation[3] = rotation.w;
+
+    c->placements.push_back(placement);
+    c->placement_names.push_back(name);
+}
+
+static void LevelParseCollider(LevelCompiler* c)
+{
+    std::string name;
+    float bbox_min[3], bbox_max[3];
+    if (!LevelNextToken(c, &name, "collider name") || !LevelNextBox(c, bbox_min, bbox_max))
+        return;
+
+    bbox box;
+    box.bbox_min = glm::vec4(bbox_min[0], bbox_min[1], bbox_min[2], 0.0f);
+    box.bbox_max = glm::vec4(bbox_max[0], bbox_max[1], bbox_max[2], 0.0f);
+    box.angle = boxAngle(box.bbox_min, box.bbox_max);
+
+    bool used = false;
+    while (c->next < c->tokens.size())
+    {
+        std::string keyword = c->tokens[c->next++];
+        LevelPortalSource portal;
+        portal.box = box;
+        if (keyword == "solid")
+            c->colliders.push_back(box);
+        else if (keyword == "portal")
+            c->portals.push_back(portal);
+        else if (keyword == "portal_after")
+        {
+            if (!LevelNextToken(c, &portal.event, "event name"))
+                return;
+            c->portals.push_back(portal);
+        }
+        else
+        {
+            LevelError(c, c->line, "unknown collider option", keyword);
+            return;
+        }
+        used = true;
+    }
+    if (!used)
+        LevelError(c, c->line, "collider is neither solid nor a portal surface:", name);
+}
+
+static void LevelParseTrigger(LevelCompiler* c)
+{
+    LevelTrigger trigger;
+    std::string name, after;
+    if (!LevelNextToken(c, &name, "trigger name") || !LevelNextBox(c, trigger.bbox_min, trigger.bbox_max))
+        return;
+    trigger.name  = LevelAddString(c, name);
+    trigger.after = LEVEL_NONE;
+    if (c->next < c->tokens.size())
+    {
+        if (!LevelExpect(c, "after") || !LevelNextToken(c, &after, "event name"))
+            return;
+        trigger.after = LevelAddString(c, after);
+    }
+    c->triggers.push_back(trigger);
+}
+
+static void LevelParseMarker(LevelCompiler* c)
+{
+    LevelMarker marker;
+    std::string name, event;
+    if (!LevelNextToken(c, &name, "marker name") || !LevelNextFloats(c, marker.position, 3))
+        return;
+    marker.name  = LevelAddString(c, name);
+    marker.event = LEVEL_NONE;
+    if (c->next < c->tokens.size())
+    {
+        if (!LevelExpect(c, "event") || !LevelNextToken(c, &event, "event name"))
+            return;
+        marker.event = LevelAddString(c, event);
+    }
+    c->markers.push_back(marker);
+}
+
+static void LevelParsePickup(LevelCompiler* c)
+{
+    LevelPickup pickup;
+    int material = LevelNextEnum(c, g_LevelMaterials, LEVEL_COUNT(g_LevelMaterials), "material");
+    std::string mesh;
+    if (material < 0 || !LevelNextToken(c, &mesh, "mesh name") || !LevelNextFloats(c, pickup.position, 3))
+        return;
+    pickup.object_id = material;
+    pickup.mesh      = LevelAddString(c, mesh);
+    c->pickups.push_back(pickup);
+}
+
+static void LevelParseTrack(LevelCompiler* c)
+{
+    LevelTrackSource source;
+    std::string event;
+    if (!LevelNextToken(c, &event, "event name") || !LevelNextToken(c, &source.object, "placement name"))
+        return;
+    int channel = LevelNextEnum(c, g_LevelChannels, LEVEL_COUNT(g_LevelChannels), "channel");
+    int interp  = channel < 0 ? -1 : LevelNextEnum(c, g_LevelInterps, LEVEL_COUNT(g_LevelInterps), "interpolation");
+    int loop    = interp  < 0 ? -1 : LevelNextEnum(c, g_LevelLoops, LEVEL_COUNT(g_LevelLoops), "loop mode");
+    if (loop < 0)
+        return;
+
+    LevelTrack& track = source.track;
+    memset(&track, 0, sizeof(track));
+    track.event     = LevelAddString(c, event);
+    track.channel   = (uint8_t)channel;
+    track.interp    = (uint8_t)interp;
+    track.loop      = (uint8_t)loop;
+    track.first_key = (uint32_t)c->key_times.size();
+    for (; c->next < c->tokens.size(); ++c->next)
+    {
+        const std::string& key = c->tokens[c->next];
+        float time, value;
+        char end;
+        if (sscanf(key.c_str(), "%f:%f%c", &time, &value, &end) != 2)
+        {
+            LevelError(c, c->line, "expected key time:value, found", key);
+            return;
+        }
+        if (track.key_count > 0 && time < c->key_times.back())
+        {
+            LevelError(c, c->line, "keys out of order:", key);
+            return;
+        }
+        c->key_times.push_back(time);
+        c->key_values.push_back(value);
+        ++track.key_count;
+    }
+    if (track.key_count == 0)
+        LevelError(c, c->line, "track without keys");
+    else if (interp == ANIM_BEZIER && track.key_count > ANIMATION_MAX_BEZIER_KEYS)
+        LevelError(c, c->line, "too many keys for a bezier track");
+
+    source.line = c->line;
+    c->tracks.push_back(source);
+}
+
+template <typename T>
+static void LevelWriteSection(std::vector<unsigned char>* binary, LevelSection* section, const T* data, size_t count)
+{
+    while (binary->size() % 8 != 0)
+        binary->push_back(0);
+    section->offset = (uint32_t)binary->size();
+    section->count  = (uint32_t)count;
+    const unsigned char* bytes = (const unsigned char*)data;
+    binary->insert(binary->end(), bytes, bytes + count * sizeof(T));
+}
+
+bool Level_Compile(const char* text, size_t size, const char* source_name, std::vector<unsigned char>* binary)
+{
+    LevelCompiler c;
+    c.source_name = source_name;
+    c.line = 0;
+    c.ok = true;
+
+    const char* end = text + size;
+    for (const char* p = text; p < end; )
+    {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == NULL)
+            eol = end;
+        ++c.line;
+
+        // Separa a linha em palavras, ignorando o comentário.
+        c.tokens.clear();
+        c.next = 0;
+        const char* q = p;
+        while (q < eol && *q != '#')
+        {
+            while (q < eol && isspace((unsigned char)*q))
+                ++q;
+            const char* start = q;
+            while (q < eol && *q != '#' && !isspace((unsigned char)*q))
+                ++q;
+            if (q > start)
+                c.tokens.push_back(std::string(start, q));
+        }
+        p = eol + 1;
+        if (c.tokens.empty())
+            continue;
+
+        const std::string record = c.tokens[c.next++];
+        if (record == "placement")
+            LevelParsePlacement(&c);
+        else if (record == "collider")
+            LevelParseCollider(&c);
+        else if (record == "trigger")
+            LevelParseTrigger(&c);
+        else if (record == "marker")
+            LevelParseMarker(&c);
+        else if (record == "pickup")
+            LevelParsePickup(&c);
+        else if (record == "track")
+            LevelParseTrack(&c);
+        else
+            LevelError(&c, c.line, "unknown record", record);
+
+        if (c.ok && c.next < c.tokens.size())
+            LevelError(&c, c.line, "unexpected", c.tokens[c.next]);
+    }
+
+    // Objetos estáticos primeiro, mantendo a ordem do arquivo.
+    std::vector<uint32_t> remap(c.placements.size());
+    std::vector<LevelPlacement> placements;
+    size_t static_count = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (size_t i = 0; i < c.placements.size(); ++i)
+        {
+            bool dynamic = (c.placements[i].flags & LEVEL_DYNAMIC) != 0;
+            if (dynamic != (pass == 1))
+                continue;
+            remap[i] = (uint32_t)placements.size();
+            placements.push_back(c.placements[i]);
+        }
+        if (pass == 0)
+            static_count = placements.size();
+    }
+
+    std::vector<LevelTrack> tracks;
+    for (size_t i = 0; i < c.tracks.size(); ++i)
+    {
+        const LevelTrackSource& source = c.tracks[i];
+        size_t object = 0;
+        while (object < c.placement_names.size() && c.placement_names[object] != source.object)
+            ++object;
+        if (object == c.placement_names.size())
+        {
+            LevelError(&c, source.line, "unknown placement", source.object);
+            continue;
+        }
+        if (!(c.placements[object].flags & LEVEL_DYNAMIC))
+        {
+            LevelError(&c, source.line, "animated placement must be dynamic:", source.object);
+            continue;
+        }
+        tracks.push_back(source.track);
+        tracks.back().placement = remap[object];
+    }
+
+    // Superfícies de portal agrupadas por evento, as iniciais primeiro e as
+    // demais na ordem em que o evento aparece.
+    std::vector<std::string> events(1, std::string());
+    for (size_t i = 0; i < c.portals.size(); ++i)
+    {
+        size_t e = 0;
+        while (e < events.size() && events[e] != c.portals[i].event)
+            ++e;
+        if (e == events.size())
+            events.push_back(c.portals[i].event);
+    }
+    std::vector<bbox> portal_surfaces;
+    std::vector<LevelPortalGroup> portal_groups;
+    for (size_t e = 0; e < events.size(); ++e)
+    {
+        LevelPortalGroup group;
+        group.event = events[e].empty() ? LEVEL_NONE : LevelAddString(&c, events[e]);
+        group.first = (uint32_t)portal_surfaces.size();
+        for (size_t i = 0; i < c.portals.size(); ++i)
+            if (c.portals[i].event == events[e])
+                portal_surfaces.push_back(c.portals[i].box);
+        group.count = (uint32_t)portal_surfaces.size() - group.first;
+        if (group.count > 0)
+            portal_groups.push_back(group);
+    }
+
+    if (!c.ok)
+        return false;
+
+    LevelHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LEVL", 4);
+    header.version = LEVEL_VERSION;
+    header.static_placement_count = (uint32_t)static_count;
+    header.bbox_size = (uint32_t)sizeof(bbox);
+
+    binary->assign(sizeof(header), 0);
+    LevelWriteSection(binary, &header.placements,      placements.data(),      placements.size());
+    LevelWriteSection(binary, &header.colliders,       c.colliders.data(),     c.colliders.size());
+    LevelWriteSection(binary, &header.portal_surfaces, portal_surfaces.data(), portal_surfaces.size());
+    LevelWriteSection(binary, &header.portal_groups,   portal_groups.data(),   portal_groups.size());
+    LevelWriteSection(binary, &header.triggers,        c.triggers.data(),      c.triggers.size());
+    LevelWriteSection(binary, &header.markers,         c.markers.data(),       c.markers.size());
+    LevelWriteSection(binary, &header.pickups,         c.pickups.data(),       c.pickups.size());
+    LevelWriteSection(binary, &header.tracks,          tracks.data(),          tracks.size());
+    LevelWriteSection(binary, &header.key_times,       c.key_times.data(),     c.key_times.size());
+    LevelWriteSection(binary, &header.key_values,      c.key_values.data(),    c.key_values.size());
+    LevelWriteSection(binary, &header.strings,         c.strings.data(),       c.strings.size());
+    memcpy(binary->data(), &header, sizeof(header));
+    return true;
+}
+
+// Verifica se a seção cabe no arquivo e está alinhada.
+static bool LevelCheckSection(const LevelSection& section, size_t record_size, size_t size)
+{
+    return section.offset % 8 == 0 && section.offset <= size
+        && (uint64_t)section.count * record_size <= size - section.offset;
+}
+
+bool Level_LoadMemory(const unsigned char* binary, size_t size, Level* level)
+{
+    LevelHeader header;
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, binary, sizeof(header));
+    if (memcmp(header.magic, "LEVL", 4) != 0 || header.version != LEVEL_VERSION || header.bbox_size != sizeof(bbox))
+        return false;
+
+    if (!LevelCheckSection(header.placements, sizeof(LevelPlacement), size)
+     || !LevelCheckSection(header.colliders, sizeof(bbox), size)
+     || !LevelCheckSection(header.portal_surfaces, sizeof(bbox), size)
+     || !LevelCheckSection(header.portal_groups, sizeof(LevelPortalGroup), size)
+     || !LevelCheckSection(header.triggers, sizeof(LevelTrigger), size)
+     || !LevelCheckSection(header.markers, sizeof(LevelMarker), size)
+     || !LevelCheckSection(header.pickups, sizeof(LevelPickup), size)
+     || !LevelCheckSection(header.tracks, sizeof(LevelTrack), size)
+     || !LevelCheckSection(header.key_times, sizeof(float), size)
+     || !LevelCheckSection(header.key_values, sizeof(float), size)
+     || !LevelCheckSection(header.strings, 1, size)
+     || header.key_times.count != header.key_values.count
+     || header.static_placement_count > header.placements.count)
+        return false;
+
+    level->data.assign(binary, binary + size);
+    const unsigned char* data = level->data.data();
+    level->placements             = (const LevelPlacement*)(data + header.placements.offset);
+    level->placement_count        = header.placements.count;
+    level->static_placement_count = header.static_placement_count;
+    level->colliders              = (const bbox*)(data + header.colliders.offset);
+    level->collider_count         = header.colliders.count;
+    level->portal_surfaces        = (const bbox*)(data + header.portal_surfaces.offset);
+    level->portal_groups          = (const LevelPortalGroup*)(data + header.portal_groups.offset);
+    level->portal_group_count     = header.portal_groups.count;
+    level->triggers               = (const LevelTrigger*)(data + header.triggers.offset);
+    level->trigger_count          = header.triggers.count;
+    level->markers                = (const LevelMarker*)(data + header.markers.offset);
+    level->marker_count           = header.markers.count;
+    level->pickups                = (const LevelPickup*)(data + header.pickups.offset);
+    level->pickup_count           = header.pickups.count;
+    level->tracks                 = (const LevelTrack*)(data + header.tracks.offset);
+    level->track_count            = header.tracks.count;
+    level->key_times              = (const float*)(data + header.key_times.offset);
+    level->key_values             = (const float*)(data + header.key_values.offset);
+    level->strings                = (const char*)(data + header.strings.offset);
+
+    // Índices e textos dentro dos limites, para que o jogo não precise testar.
+    uint32_t strings_size = header.strings.count;
+    bool ok = strings_size == 0 || level->strings[strings_size - 1] == '\0';
+    #define LEVEL_STRING_OK(offset) ((offset) == LEVEL_NONE || (offset) < strings_size)
+    for (size_t i = 0; ok && i < level->placement_count; ++i)
+        ok = (level->placements[i].mesh < strings_size) && LEVEL_STRING_OK(level->placements[i].name);
+    for (size_t i = 0; ok && i < level->portal_group_count; ++i)
+        ok = LEVEL_STRING_OK(level->portal_groups[i].event)
+          && (uint64_t)level->portal_groups[i].first + level->portal_groups[i].count <= header.portal_surfaces.count;
+    for (size_t i = 0; ok && i < level->trigger_count; ++i)
+        ok = level->triggers[i].name < strings_size && LEVEL_STRING_OK(level->triggers[i].after);
+    for (size_t i = 0; ok && i < level->marker_count; ++i)
+        ok = level->markers[i].name < strings_size && LEVEL_STRING_OK(level->markers[i].event);
+    for (size_t i = 0; ok && i < level->pickup_count; ++i)
+        ok = level->pickups[i].mesh < strings_size;
+    for (size_t i = 0; ok && i < level->track_count; ++i)
+    {
+        const LevelTrack& track = level->tracks[i];
+        ok = track.event < strings_size && track.placement < level->placement_count
+          && track.channel < ANIM_CHANNEL_COUNT && track.interp <= ANIM_BEZIER && track.loop <= ANIM_PINGPONG
+          && track.key_count > 0 && (uint64_t)track.first_key + track.key_count <= header.key_times.count
+          && (track.interp != ANIM_BEZIER || track.key_count <= ANIMATION_MAX_BEZIER_KEYS);
+    }
+    #undef LEVEL_STRING_OK
+
+    if (!ok)
+    {
+        *level = Level();
+        return false;
+    }
+    return true;
+}
+
+bool Level_Load(const char* name, Level* level)
+{
+    AssetBlob blob;
+    std::string binary_name = std::string(name) + ".lvl";
+    if (AssetPack_Load(binary_name.c_str(), &blob))
+    {
+        bool ok = Level_LoadMemory(blob.data, blob.size, level);
+        if (!ok)
+            fprintf(stderr, "ERROR: Invalid level file \"%s\".\n", binary_name.c_str());
+        AssetPack_Free(&blob);
+        return ok;
+    }
+
+    std::string text_name = std::string(name) + ".level";
+    if (!AssetPack_Load(text_name.c_str(), &blob))
+    {
+        fprintf(stderr, "ERROR: Cannot read \"%s\".\n", text_name.c_str());
+        return false;
+    }
+    std::vector<unsigned char> binary;
+    bool ok = Level_Compile((const char*)blob.data, blob.size, text_name.c_str(), &binary)
+           && Level_LoadMemory(binary.data(), binary.size(), level);
+    AssetPack_Free(&blob);
+    return ok;
+}
+
+int Level_FindPlacement(const Level& level, const char* name)
+{
+    for (size_t i = 0; i < level.placement_count; ++i)
+    {
+        const char* placement_name = Level_String(level, level.placements[i].name);
+        if (placement_name && strcmp(placement_name, name) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+const LevelTrigger* Level_FindTrigger(const Level& level, const char* name)
+{
+    for (size_t i = 0; i < level.trigger_count; ++i)
+        if (strcmp(Level_String(level, level.triggers[i].name), name) == 0)
+            return &level.triggers[i];
+    return NULL;
+}
+
+const LevelMarker* Level_FindMarker(const Level& level, const char* name)
+{
+    for (size_t i = 0; i < level.marker_count; ++i)
+        if (strcmp(Level_String(level, level.markers[i].name), name) == 0)
+            return &level.markers[i];
+    return NULL;
+}
+
+void Level_AppendPortalSurfaces(const Level& level, const char* event, BBoxList* list)
+{
+    for (size_t i = 0; i < level.portal_group_count; ++i)
+    {
+        const LevelPortalGroup& group = level.portal_groups[i];
+        const char* group_event = Level_String(level, group.event);
+        bool match = event == NULL ? group_event == NULL : group_event != NULL && strcmp(group_event, event) == 0;
+        if (match)
+            list->insert(list->end(), level.portal_surfaces + group.first, level.portal_surfaces + group.first + group.count);
+    }
+}
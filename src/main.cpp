@@ -1,7 +1,10 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
+#include <atomic>
 
 // Headers abaixo são específicos de C++
 #include <map>
@@ -23,14 +26,34 @@
 #include <glm/vec4.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-// Headers da biblioteca para carregar modelos obj
-#include <tiny_obj_loader.h>
-
 #include <stb_image.h>
 
 // Headers locais, definidos na pasta "include/"
 #include "utils.h"
 #include "matrices.h"
+#include "objmodel.h"
+#include "collisions.h"
+#include "texturestreaming.h"
+#include "residency.h"
+#include "hotreload.h"
+#include "programcache.h"
+#include "assetpack.h"
+#include "profiler.h"
+#include "trace.h"
+#include "framestats.h"
+#include "bench.h"
+#include "inputreplay.h"
+#include "startup.h"
+#include "glstats.h"
+#include "memtrack.h"
+#include "stressscene.h"
+#include "affine.h"
+#include "transformgraph.h"
+#include "animation.h"
+#include "level.h"
+#include "ecs.h"
+#include "jobs.h"
+#include "textobject.h"
 
 
 // Define as dimensões do circulo
@@ -57,100 +80,89 @@
 #define LAVA 10
 #define GATE 11
 
-// Estrutura que representa um modelo geométrico carregado a partir de um
-// arquivo ".obj". Veja https://en.wikipedia.org/wiki/Wavefront_.obj_file .
-struct ObjModel
-{
-    tinyobj::attrib_t                 attrib;
-    std::vector<tinyobj::shape_t>     shapes;
-    std::vector<tinyobj::material_t>  materials;
-
-    // Este construtor lê o modelo de um arquivo utilizando a biblioteca tinyobjloader.
-    // Veja: https://github.com/syoyo/tinyobjloader
-    ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true)
-    {
-        printf("Carregando objetos do arquivo \"%s\"...\n", filename);
-
-        // Se basepath == NULL, então setamos basepath como o dirname do
-        // filename, para que os arquivos MTL sejam corretamente carregados caso
-        // estejam no mesmo diretório dos arquivos OBJ.
-        std::string fullpath(filename);
-        std::string dirname;
-        if (basepath == NULL)
-        {
-            auto i = fullpath.find_last_of("/");
-            if (i != std::string::npos)
-            {
-                dirname = fullpath.substr(0, i+1);
-                basepath = dirname.c_str();
-            }
-        }
-
-        std::string warn;
-        std::string err;
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath, triangulate);
-
-        if (!err.empty())
-            fprintf(stderr, "\n%s\n", err.c_str());
+// Tamanho das partes das tarefas divididas do quadro (veja AddFrameJobs()).
+#define COLLISION_JOB_BATCH 1024    // Caixas sólidas
+#define ANIMATION_JOB_BATCH 32      // Trilhas de animação
+#define CULL_JOB_BATCH      256     // Objetos desenhados
 
-        if (!ret)
-            throw std::runtime_error("Erro ao carregar modelo.");
-
-        for (size_t shape = 0; shape < shapes.size(); ++shape)
-        {
-            if (shapes[shape].name.empty())
-            {
-                fprintf(stderr,
-                        "*********************************************\n"
-                        "Erro: Objeto sem nome dentro do arquivo '%s'.\n"
-                        "Veja https://www.inf.ufrgs.br/~eslgastal/fcg-faq-etc.html#Modelos-3D-no-formato-OBJ .\n"
-                        "*********************************************\n",
-                    filename);
-                throw std::runtime_error("Objeto sem nome.");
-            }
-            printf("- Objeto '%s'\n", shapes[shape].name.c_str());
-        }
-
-        printf("OK.\n");
-    }
-};
-
-struct bbox
+// Dados do quadro usados pelas tarefas de "jobs.h" (veja AddFrameJobs()). A
+// thread principal preenche a entrada antes de criar as tarefas e só lê a
+// saída depois de esperar por elas.
+struct FrameJobs
 {
-    glm::vec4    bbox_min;
-    glm::vec4    bbox_max;
-    double       angle;
+    // Entrada
+    TransformGraph*            graph;
+    AnimationSystem*           animations;
+    StressScene*               stress;
+    const std::vector<Entity>* stress_colliders;    // Entidade de cada caixa da cena de estresse
+    const std::vector<Entity>* stress_platforms;    // Entidade de cada plataforma
+    const Level*               level;
+    int                        node_camera;
+    glm::vec4                  camera;
+    glm::vec4                  view_vector;
+    glm::mat4                  view;
+    glm::mat4                  view_projection;
+    unsigned                   buttons;             // Bit 0: botão esquerdo, bit 1: direito
+    double                     time;
+
+    // Saída
+    std::atomic<bool>          blocked;             // A câmera entrou em uma caixa sólida
+    bool                       pickup_near;         // Há um objeto perto que pode ser pego
+    std::vector<const char*>   events;              // Eventos disparados no quadro
+    std::vector<RenderList>    render_lists;        // Uma por parte da tarefa "cull", em ordem
+
+    // Tarefas pelas quais a thread principal espera
+    JobId                      collision;
+    JobId                      cull;
 };
 
-// Declaração de funções utilizadas para pilha de matrizes de modelagem.
-void PushMatrix(glm::mat4 M);
-void PopMatrix(glm::mat4& M);
-
 // Declaração de várias funções utilizadas em main().  Essas estão definidas
 // logo após a definição de main() neste arquivo.
 void BuildTrianglesAndAddToVirtualScene(ObjModel*); // Constrói representação de um ObjModel como malha de triângulos para renderização
-void ComputeNormals(ObjModel* model); // Computa normais de um ObjModel, caso não existam.
-void LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando um programa de GPU
+GpuMesh UploadMeshData(MeshData* mesh); // Envia para a GPU uma malha construída por BuildMeshData()
+void StartTraceCapture(); // Grava g_TraceFrames quadros em "trace_<data>.json" ao lado do executável
+void ToggleHoldBox(); // Pega ou solta o cubo mais próximo da câmera
+void ApplyBenchInput(int frame); // Posiciona a câmera e simula cliques segundo o roteiro de "bench.h"
+bool AcceptInputEvent(uint32_t type, int a, int b, int c, int d, double x, double y); // Grava ou filtra eventos de entrada
+void ReplayInput(GLFWwindow* window, uint32_t frame); // Entrega às callbacks os eventos gravados do quadro
+bool LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando um programa de GPU
+void ReloadChangedFiles(); // Recarrega shaders, texturas e modelos alterados no disco
 void LoadGouraudShadersFromFiles();
-void LoadTextureImage(const char* filename); // Função que carrega imagens de textura
+void RegisterTextureImage(const char* filename, int object_id); // Registra uma imagem de textura, carregada somente quando "object_id" for desenhado (veja "residency.h")
+void SetObjectId(int object_id); // Define o "object_id" dos próximos objetos desenhados
 void DrawVirtualObject(const char* object_name); // Desenha um objeto armazenado em g_VirtualScene
+Entity AddRenderable(TransformGraph* graph, int parent, const Affine& local, int object_id, const char* object_name, RenderPass pass = RENDER_SCENE); // Cria um nó e uma entidade que o desenha
+void DrawSceneNode(const TransformGraph& graph, int node, int object_id, const char* object_name); // Desenha um objeto com a matriz global do nó
+void UpdateRenderableBounds(); // Copia para os componentes as caixas das malhas residentes em g_VirtualScene
+void DrawRenderList(const TransformGraph& graph, const std::vector<RenderList>& lists, RenderPass pass); // Desenha os objetos de uma etapa que passaram pelo descarte
+void AddFrameJobs(FrameJobs* frame); // Cria as tarefas do quadro (veja "jobs.h") com as suas dependências
+void PlatformsJob(void* data, size_t begin, size_t end); // Move as plataformas da cena de estresse
+void CollisionJob(void* data, size_t begin, size_t end); // Testa a câmera contra uma faixa das caixas sólidas
+void GameplayJob(void* data, size_t begin, size_t end); // Portais, objetos carregados e eventos do quadro
+void AnimationJob(void* data, size_t begin, size_t end); // Avalia uma faixa das trilhas de animação em execução
+void TransformsJob(void* data, size_t begin, size_t end); // Atualiza as posições animadas e a hierarquia de transformações
+void CullJob(void* data, size_t begin, size_t end); // Monta a lista de desenho de uma faixa dos objetos
+void AddLevelPlacements(const Level& level, size_t first, size_t count, TransformGraph* graph, const std::vector<Entity>& entities); // Cria os nós e os componentes de uma faixa de objetos da fase
+void AddLevelAnimations(const Level& level, const std::vector<Entity>& entities, AnimationSystem* animations); // Cria os alvos e as trilhas de animação da fase
+void AddLevelGameplay(const Level& level, Entity* exit); // Cria as entidades das caixas de colisão, gatilhos e marcadores da fase
+void AddLevelPickups(const Level& level, TransformGraph* graph); // Cria os objetos da fase que podem ser carregados
+void AddLevelPortalSurfaces(const Level& level, const char* event); // Cria as superfícies de portal liberadas pelo evento (NULL: as iniciais)
 GLuint LoadShader_Vertex(const char* filename);   // Carrega um vertex shader
 GLuint LoadShader_Fragment(const char* filename); // Carrega um fragment shader
 void LoadShader(const char* filename, GLuint shader_id); // Função utilizada pelas duas acima
+std::string ReadShaderFile(const char* filename); // Lê o código GLSL de um arquivo
+void CompileShader(const char* filename, const std::string& source, GLuint shader_id); // Compila código GLSL já lido
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Cria um programa de GPU
 void PrintObjModelInfo(ObjModel*); // Função para debugging
 void BuildTrianglesAndAddToVirtualScene2(char* name, std::vector<GLuint>* indices, std::vector<float>* model_coefficients, std::vector<float>* normal_coefficients, GLenum rendering_mode);
 void BuildAim();
 void BuildPortal();
 void BuildCube();
-bool detectColision(glm::vec4 position, glm::vec4 hitbox_min, glm::vec4 hitbox_max);
-int CheckLineBox( glm::vec4 B1, glm::vec4 B2, glm::vec4 L1, glm::vec4 vector_view, glm::vec4 &Hit);
-double boxAngle(glm::vec4 B1, glm::vec4 B2);
-glm::vec3 bezierCurve(std::vector<glm::vec3> points, float time);
-float Bernstein(float k, float n, float t);
 // Declaração de funções auxiliares para renderizar texto dentro da janela
 // OpenGL. Estas funções estão definidas no arquivo "textrendering.cpp".
 void TextRendering_Init();
+void TextRendering_SetWindowSize(int width, int height);
+void TextRendering_Flush();
 float TextRendering_LineHeight(GLFWwindow* window);
 float TextRendering_CharWidth(GLFWwindow* window);
 void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float x, float y, float scale = 1.0f);
@@ -159,13 +171,21 @@ void TextRendering_PrintVector(GLFWwindow* window, glm::vec4 v, float x, float y
 void TextRendering_PrintMatrixVectorProduct(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f);
 void TextRendering_PrintMatrixVectorProductMoreDigits(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f);
 void TextRendering_PrintMatrixVectorProductDivW(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f);
+std::string TextRendering_FormatMatrixVectorProduct(glm::mat4 M, glm::vec4 v);
+std::string TextRendering_FormatMatrixVectorProductMoreDigits(glm::mat4 M, glm::vec4 v);
+std::string TextRendering_FormatMatrixVectorProductDivW(glm::mat4 M, glm::vec4 v);
 
 // Funções abaixo renderizam como texto na janela OpenGL algumas matrizes e
 // outras informações do programa. Definidas após main().
 void TextRendering_ShowModelViewProjection(GLFWwindow* window, glm::mat4 projection, glm::mat4 view, glm::mat4 model, glm::vec4 p_model);
+void TextRendering_ShowModelViewProjectionRetained(GLFWwindow* window, glm::mat4 projection, glm::mat4 view, glm::mat4 model, glm::vec4 p_model);
+glm::mat4 ViewportMappingMatrix(GLFWwindow* window);
 void TextRendering_ShowEulerAngles(GLFWwindow* window);
 void TextRendering_ShowProjection(GLFWwindow* window);
 void TextRendering_ShowFramesPerSecond(GLFWwindow* window);
+void TextRendering_ShowTextureStreaming(GLFWwindow* window);
+void TextRendering_ShowProfiler(GLFWwindow* window);
+void TextRendering_ShowMemory(GLFWwindow* window);
 
 // Funções callback para comunicação com o sistema operacional e interação do
 // usuário. Veja mais comentários nas definições das mesmas, abaixo.
@@ -178,19 +198,6 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 
 
 
-// Definimos uma estrutura que armazenará dados necessários para renderizar
-// cada objeto da cena virtual.
-struct SceneObject
-{
-    std::string  name;        // Nome do objeto
-    size_t       first_index; // Índice do primeiro vértice dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
-    size_t       num_indices; // Número de índices do objeto dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
-    GLenum       rendering_mode; // Modo de rasterização (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
-    GLuint       vertex_array_object_id; // ID do VAO onde estão armazenados os atributos do modelo
-    glm::vec3    bbox_min; // Axis-Aligned Bounding Box do objeto
-    glm::vec3    bbox_max;
-};
-
 // Abaixo definimos variáveis globais utilizadas em várias funções do código.
 
 // A cena virtual é uma lista de objetos nomeados, guardados em um dicionário
@@ -199,27 +206,16 @@ struct SceneObject
 // estes são acessados.
 std::map<std::string, SceneObject> g_VirtualScene;
 
-// Pilha que guardará as matrizes de modelagem.
-std::stack<glm::mat4>  g_MatrixStack;
-
 float width = 50.0f;
 float height = 5.0f;
 float spaceDistance = 10.0f;
 
-bool Portal1Created = false;
-bool Portal1OnCube = false;
-bbox Portal1Bbox;
-bool Portal2Created = false;
-bool Portal2OnCube = false;
-bbox Portal2Bbox;
-double lastPortal1Time = 0;
-double lastPortal2Time = 0;
-double openGateTime = 0;
-bool openDoor = false;
-
-glm::vec3 cubePositionOrigin = glm::vec3(0.0f, height/2, -25.0f);
-glm::vec3 cubePosition = cubePositionOrigin;
-float cubeWidth = 5.0f;
+// Entidades do jogo: objetos desenhados, paredes, portais, o cubo que pode
+// ser carregado, o botão e a saída (veja "ecs.h").
+World g_World;
+
+// Cubo móvel da fase, para onde a câmera olha no modo look-at.
+Entity g_MovingCube = ECS_NO_ENTITY;
 
 bool blockMove = false;
 
@@ -268,6 +264,24 @@ bool g_UsePerspectiveProjection = true;
 // Variável que controla se o texto informativo será mostrado na tela.
 bool g_ShowInfoText = true;
 
+// Variável que controla se o profiler de quadros é mostrado na tela (tecla F3).
+bool g_ShowProfiler = false;
+
+// Variável que controla se o uso de memória é mostrado na tela (tecla F5).
+bool g_ShowMemory = false;
+
+// Número de quadros gravados na linha do tempo ao apertar F4 (veja "trace.h").
+int g_TraceFrames = 300;
+
+// Passo fixo da simulação, em segundos, nos modos de benchmark, gravação e
+// reprodução de entrada; zero para usar o tempo real.
+double g_FixedTimestep = 0.0;
+
+// Quadro em que os eventos de entrada recebidos agora serão vistos pela
+// simulação, e evento sendo reproduzido (veja "inputreplay.h").
+uint32_t g_InputFrame = 0;
+const InputEvent* g_ReplayEvent = NULL;
+
 // Variáveis que definem um programa de GPU (shaders). Veja função LoadShadersFromFiles().
 GLuint g_GpuProgramID = 0;
 GLint g_model_uniform;
@@ -278,27 +292,127 @@ GLint g_bbox_min_uniform;
 GLint g_bbox_max_uniform;
 GLint g_light_position_uniform;
 
-// Número de texturas carregadas pela função LoadTextureImage()
+// Número de unidades de textura reservadas pela função RegisterTextureImage()
 GLuint g_NumLoadedTextures = 0;
 
 glm::vec4 camera_position_c;
 glm::vec4 last_camera_position_c;
 
-
-bool isHolding = false;
-bool dropped = false;
-glm::vec4 box_position;
-
 int main(int argc, char* argv[])
 {
+    // Argumentos de linha de comando: um modelo ".obj" adicional, os
+    // orçamentos de memória (em MB) do gerenciador de residência, o número de
+    // quadros a gravar na linha do tempo desde o início ("--trace=N"), o
+    // limite de engasgo em ms e o arquivo ".csv" ou ".json" onde as
+    // estatísticas de tempo de quadro são escritas ao sair. Com "--bench[=N]"
+    // o programa executa N quadros do roteiro de "bench.h" e termina com
+    // código 0, ou 1 se a janela for fechada antes, ou 2 se o p99 do tempo de
+    // quadro passar de "--bench-p99-ms". "--record=arquivo" grava a entrada e
+    // "--replay=arquivo" a reproduz (veja "inputreplay.h"). O relatório de
+    // inicialização (veja "startup.h") é escrito em "--startup-report=arquivo",
+    // ou em "startup.json" ao lado do executável. "--stress=N" adiciona N
+    // salas geradas proceduralmente (veja "stressscene.h"), com
+    // "--stress-walls=", "--stress-props=" e "--stress-platforms=" objetos
+    // por sala e "--stress-seed=" para o gerador. "--jobs=N" define o número
+    // de threads auxiliares do sistema de tarefas (veja "jobs.h"); com 0 as
+    // tarefas rodam na thread principal.
+    Startup_Init();
+    Trace_SetThreadName("main");
+
+    const char* model_filename = NULL;
+    size_t vram_budget_mb = 256;
+    size_t ram_budget_mb = 64;
+    bool use_pack = true;
+    double hitch_ms = 33.3;
+    const char* frame_stats_filename = NULL;
+    double bench_p99_ms = 0.0;
+    const char* record_filename = NULL;
+    const char* replay_filename = NULL;
+    std::string startup_report_filename = AssetPack_ExecutableDirectory() + "/startup.json";
+    StressSceneParams stress_params;
+    int job_workers = -1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--loose") == 0)
+            use_pack = false;
+        else if (strncmp(argv[i], "--vram-budget=", 14) == 0)
+            vram_budget_mb = strtoul(argv[i] + 14, NULL, 10);
+        else if (strncmp(argv[i], "--ram-budget=", 13) == 0)
+            ram_budget_mb = strtoul(argv[i] + 13, NULL, 10);
+        else if (strncmp(argv[i], "--hitch-ms=", 11) == 0)
+            hitch_ms = atof(argv[i] + 11);
+        else if (strncmp(argv[i], "--frame-stats=", 14) == 0)
+            frame_stats_filename = argv[i] + 14;
+        else if (strcmp(argv[i], "--bench") == 0)
+            Bench_Init(1800);
+        else if (strncmp(argv[i], "--bench=", 8) == 0)
+            Bench_Init(atoi(argv[i] + 8));
+        else if (strncmp(argv[i], "--bench-p99-ms=", 15) == 0)
+            bench_p99_ms = atof(argv[i] + 15);
+        else if (strncmp(argv[i], "--record=", 9) == 0)
+            record_filename = argv[i] + 9;
+        else if (strncmp(argv[i], "--replay=", 9) == 0)
+            replay_filename = argv[i] + 9;
+        else if (strncmp(argv[i], "--startup-report=", 17) == 0)
+            startup_report_filename = argv[i] + 17;
+        else if (strncmp(argv[i], "--stress=", 9) == 0)
+            stress_params.rooms = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--stress-walls=", 15) == 0)
+            stress_params.walls_per_room = atoi(argv[i] + 15);
+        else if (strncmp(argv[i], "--stress-props=", 15) == 0)
+            stress_params.props_per_room = atoi(argv[i] + 15);
+        else if (strncmp(argv[i], "--stress-platforms=", 19) == 0)
+            stress_params.platforms_per_room = atoi(argv[i] + 19);
+        else if (strncmp(argv[i], "--stress-seed=", 14) == 0)
+            stress_params.seed = strtoul(argv[i] + 14, NULL, 10);
+        else if (strncmp(argv[i], "--jobs=", 7) == 0)
+            job_workers = atoi(argv[i] + 7);
+        else if (strncmp(argv[i], "--trace=", 8) == 0)
+        {
+            g_TraceFrames = atoi(argv[i] + 8);
+            StartTraceCapture();
+        }
+        else if (argv[i][0] != '-')
+            model_filename = argv[i];
+        else
+            fprintf(stderr, "WARNING: unknown option \"%s\"\n", argv[i]);
+    }
+
+    // A simulação avança em passos fixos quando precisa ser reproduzível.
+    if ( Bench_IsActive() )
+        g_FixedTimestep = BENCH_TIMESTEP;
+    else if ( replay_filename != NULL )
+    {
+        if ( !InputReplay_Start(replay_filename) )
+            std::exit(EXIT_FAILURE);
+        g_FixedTimestep = InputReplay_GetTimestep();
+    }
+    else if ( record_filename != NULL )
+    {
+        g_FixedTimestep = 1.0 / 60.0;
+        if ( !InputRecord_Start(record_filename, g_FixedTimestep) )
+            std::exit(EXIT_FAILURE);
+    }
+
+    // Se existir um pacote ao lado do executável (veja "make pack"), todos os
+    // arquivos são lidos dele. Com "--loose", ou sem pacote, os arquivos são
+    // lidos diretamente de "data/" e "src/".
+    if ( use_pack )
+    {
+        StartupScope step("io", "AssetPack_Open");
+        AssetPack_Open((AssetPack_ExecutableDirectory() + "/assets.pak").c_str());
+    }
+
     // Inicializamos a biblioteca GLFW, utilizada para criar uma janela do
     // sistema operacional, onde poderemos renderizar com OpenGL.
+    Startup_BeginStep("init", "glfwInit");
     int success = glfwInit();
     if (!success)
     {
         fprintf(stderr, "ERROR: glfwInit() failed.\n");
         std::exit(EXIT_FAILURE);
     }
+    Startup_EndStep();
 
     // Definimos o callback para impressão de erros da GLFW no terminal
     glfwSetErrorCallback(ErrorCallback);
@@ -315,9 +429,15 @@ int main(int argc, char* argv[])
     // funções modernas de OpenGL.
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    // No modo de benchmark a janela não é mostrada; renderizamos no seu
+    // framebuffer normalmente.
+    if ( Bench_IsActive() )
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     // Criamos uma janela do sistema operacional, com 800 colunas e 600 linhas
     // de pixels, e com título "INF01047 ...".
     GLFWwindow* window;
+    Startup_BeginStep("init", "glfwCreateWindow");
     window = glfwCreateWindow(1600, 1200, "Portal", NULL, NULL);
     if (!window)
     {
@@ -325,6 +445,7 @@ int main(int argc, char* argv[])
         fprintf(stderr, "ERROR: glfwCreateWindow() failed.\n");
         std::exit(EXIT_FAILURE);
     }
+    Startup_EndStep();
 
     // Definimos a função de callback que será chamada sempre que o usuário
     // pressionar alguma tecla do teclado ...
@@ -337,11 +458,25 @@ int main(int argc, char* argv[])
     //glfwSetScrollCallback(window, ScrollCallback);
 
     // Indicamos que as chamadas OpenGL deverão renderizar nesta janela
+    Startup_BeginStep("init", "glfwMakeContextCurrent, gladLoadGLLoader");
     glfwMakeContextCurrent(window);
 
     // Carregamento de todas funções definidas por OpenGL 3.3, utilizando a
     // biblioteca GLAD.
     gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    Startup_EndStep();
+
+    // Contamos chamadas e trocas de estado OpenGL (veja "glstats.h").
+    GLStats_Install();
+
+    // Sem vsync no modo de benchmark, para medir o tempo real de cada quadro.
+    if ( Bench_IsActive() )
+        glfwSwapInterval(0);
+
+    // Programas de GPU já compilados em execuções anteriores ficam em disco.
+    Startup_BeginStep("init", "ProgramCache_Init");
+    ProgramCache_Init((AssetPack_ExecutableDirectory() + "/programcache").c_str());
+    Startup_EndStep();
 
     // Definimos a função de callback que será chamada sempre que a janela for
     // redimensionada, por consequência alterando o tamanho do "framebuffer"
@@ -360,61 +495,78 @@ int main(int argc, char* argv[])
     // Carregamos os shaders de vértices e de fragmentos que serão utilizados
     // para renderização. Veja slides 180-200 do documento Aula_03_Rendering_Pipeline_Grafico.pdf.
     //
+    Startup_BeginStep("compile", "LoadShadersFromFiles");
     LoadShadersFromFiles();
+    Startup_EndStep();
     //LoadGouraudShadersFromFiles();
-    // Carregamos duas imagens para serem utilizadas como textura
-    LoadTextureImage("../../data/floor.jpg");      // TextureImage0
-    LoadTextureImage("../../data/wall.jpg");      // TextureImage1
-    LoadTextureImage("../../data/hard_wall.jpg");      // TextureImage2
-    LoadTextureImage("../../data/portalgun_col.jpg");      // TextureImage2
-    LoadTextureImage("../../data/portal_blue.jpg");      // TextureImage2
-    LoadTextureImage("../../data/portal_orange.jpg");      // TextureImage2
-    LoadTextureImage("../../data/metal_box.png");
-    LoadTextureImage("../../data/Button.bmp");
-    LoadTextureImage("../../data/lava-texture.jpg");
-    LoadTextureImage("../../data/gate.jpg");
-
+    // Registramos as imagens que serão utilizadas como textura e os modelos
+    // geométricos. Nada é lido do disco aqui: cada asset é carregado em
+    // segundo plano na primeira vez em que é utilizado, e pode ser liberado
+    // caso o orçamento de memória seja ultrapassado (veja "residency.h").
+    Startup_BeginStep("init", "TextureStreaming_Init, Residency_Init");
+    TextureStreaming_Init();
+    Residency_Init(vram_budget_mb*1024*1024, ram_budget_mb*1024*1024);
+    Startup_EndStep();
+    RegisterTextureImage("data/floor.jpg", FLOOR);      // TextureImage0
+    RegisterTextureImage("data/wall.jpg", WALL);      // TextureImage1
+    RegisterTextureImage("data/hard_wall.jpg", ROOF);      // TextureImage2
+    RegisterTextureImage("data/portalgun_col.jpg", PORTALGUN);      // TextureImage3
+    RegisterTextureImage("data/portal_blue.jpg", PORTAL1);      // TextureImage4
+    RegisterTextureImage("data/portal_orange.jpg", PORTAL2);      // TextureImage5
+    RegisterTextureImage("data/metal_box.png", COMPANION_CUBE);
+    RegisterTextureImage("data/Button.bmp", BUTTON);
+    RegisterTextureImage("data/lava-texture.jpg", LAVA);
+    RegisterTextureImage("data/gate.jpg", GATE);
+
+    Residency_RegisterMesh("data/floor.obj", {"the_floor"});
+    Residency_RegisterMesh("data/wall.obj", {"the_wall"});
+    Residency_RegisterMesh("data/roof.obj", {"the_roof"});
+    Residency_RegisterMesh("data/Portal Gun.obj", {"PortalGun"});
+    Residency_RegisterMesh("data/Portal_Companion_Cube.obj", {"pCube2", "default"});
+    Residency_RegisterMesh("data/portalbutton.obj", {"Stm_button01", "Stm_button02"});
+
+    // Arquivos alterados nestes diretórios são recarregados automaticamente.
+    // Ao utilizar o pacote, os arquivos soltos não são lidos e não precisam ser
+    // observados.
+    if ( !AssetPack_IsOpen() )
+    {
+        StartupScope step("init", "HotReload_Init");
+        // Os shaders ficam junto do código em "src"; os demais arquivos de
+        // lá não são recarregáveis.
+        HotReload_Init({"data", "src"}, {".glsl", ".obj", ".jpg", ".png", ".bmp", ".gif"});
+    }
 
     // Construímos a representação de objetos geométricos através de malhas de triângulos
-    ObjModel floormodel("../../data/floor.obj");
-    ComputeNormals(&floormodel);
-    BuildTrianglesAndAddToVirtualScene(&floormodel);
-
-    ObjModel wallmodel("../../data/wall.obj");
-    ComputeNormals(&wallmodel);
-    BuildTrianglesAndAddToVirtualScene(&wallmodel);
-
-    ObjModel roofmodel("../../data/roof.obj");
-    ComputeNormals(&roofmodel);
-    BuildTrianglesAndAddToVirtualScene(&roofmodel);
-
-    //LoadGouraudShadersFromFiles();
-    ObjModel gunmodel("../../data/Portal Gun.obj");
-    ComputeNormals(&gunmodel);
-    BuildTrianglesAndAddToVirtualScene(&gunmodel);
-
-    ObjModel boxmodel("../../data/Portal_Companion_Cube.obj");
-    ComputeNormals(&boxmodel);
-    BuildTrianglesAndAddToVirtualScene(&boxmodel);
-
-    ObjModel buttonmodel("../../data/portalbutton.obj");
-    ComputeNormals(&buttonmodel);
-    BuildTrianglesAndAddToVirtualScene(&buttonmodel);
-
+    Startup_BeginStep("upload", "BuildAim, BuildPortal, BuildCube");
     BuildAim();
     BuildPortal();
     BuildCube();
+    Startup_EndStep();
 
     //LoadPhongShadersFromFiles();
 
-    if ( argc > 1 )
+    if ( model_filename != NULL )
     {
-        ObjModel model(argv[1]);
+        Startup_BeginStep("parse", model_filename);
+        ObjModel model(model_filename);
+        Startup_EndStep();
+        StartupScope step("upload", model_filename);
         BuildTrianglesAndAddToVirtualScene(&model);
     }
 
     // Inicializamos o código para renderização de texto.
+    Startup_BeginStep("compile", "TextRendering_Init");
     TextRendering_Init();
+    Startup_EndStep();
+
+    // Criamos as consultas de tempo de GPU do profiler de quadros.
+    Startup_BeginStep("init", "Profiler_Init");
+    Profiler_Init();
+    Startup_EndStep();
+    FrameStats_Init(hitch_ms);
+
+    // Threads auxiliares das tarefas de cada quadro.
+    Jobs_Init(job_workers);
 
     // Habilitamos o Z-buffer. Veja slides 104-116 do documento Aula_09_Projecoes.pdf.
     glEnable(GL_DEPTH_TEST);
@@ -432,98 +584,238 @@ int main(int argc, char* argv[])
     float t_prev = glfwGetTime();
     float t_step;
 
-    box_position = glm::vec4(+40.0f, -height/2 + 1.25, -30.0f, 1.0f);
-    glm::vec4 button_position = glm::vec4(+40.0f, -height/2 + 1, +30.0f, 1.0f);
-
-    std::vector<bbox> collisionList;
-    std::vector<bbox> portalList;
-
-    bbox wall1;
-    wall1.bbox_min = glm::vec4(-width, 0, -width, 0);
-    wall1.bbox_max = glm::vec4(width, height, -width, 0);
-    wall1.angle = boxAngle(wall1.bbox_min, wall1.bbox_max);
-
-    bbox wall2;
-    wall2.bbox_min = glm::vec4(-width, 0, spaceDistance, 0);
-    wall2.bbox_max = glm::vec4(-width, height, width, 0);
-    wall2.angle = boxAngle(wall2.bbox_min, wall2.bbox_max);
-
-    bbox wall3;
-    wall3.bbox_min = glm::vec4(-width, 0, width, 0);
-    wall3.bbox_max = glm::vec4(width, height, width, 0);
-    wall3.angle = boxAngle(wall3.bbox_min, wall3.bbox_max);
-
-    bbox wall4;
-    wall4.bbox_min = glm::vec4(width, 0, spaceDistance, 0);
-    wall4.bbox_max = glm::vec4(width, height, width, 0);
-    wall4.angle = boxAngle(wall4.bbox_min, wall4.bbox_max);
-
-    bbox wall5;
-    wall5.bbox_min = glm::vec4(-width, 0, -width, 0);
-    wall5.bbox_max = glm::vec4(-width, height, -spaceDistance, 0);
-    wall5.angle = boxAngle(wall5.bbox_min, wall5.bbox_max);
-
-    bbox wall6;
-    wall6.bbox_min = glm::vec4(width, 0, -width, 0);
-    wall6.bbox_max = glm::vec4(width, height, -spaceDistance, 0);
-    wall6.angle = boxAngle(wall6.bbox_min, wall6.bbox_max);
-
-    bbox holeIn;
-    holeIn.bbox_min = glm::vec4(-width-1, 0, -spaceDistance, 0);
-    holeIn.bbox_max = glm::vec4(width+1, height, -spaceDistance, 0);
-    holeIn.angle = boxAngle(holeIn.bbox_min, holeIn.bbox_max);
-
-    bbox holeOut;
-    holeOut.bbox_min = glm::vec4(-width-1, 0, spaceDistance, 0);
-    holeOut.bbox_max = glm::vec4(width+1, height, spaceDistance, 0);
-    holeOut.angle = boxAngle(holeOut.bbox_min, holeOut.bbox_max);
-
-    bbox cube;
-    cube.bbox_min = glm::vec4(box_position.x-1.2, 0, box_position.z-1.2, 0);
-    cube.bbox_max = glm::vec4(box_position.x+1.2, height, box_position.z+1.2, 0);
-    cube.angle = 0;
-
-    bbox button;
-    button.bbox_min = glm::vec4(button_position.x-2, 0, button_position.z-2, 0);
-    button.bbox_max = glm::vec4(button_position.x+2, height, button_position.z+2, 0);
-    button.angle = 0;
-
-    bbox gate;
-    gate.bbox_min = glm::vec4(-2.5, 0, -width-2, 0);
-    gate.bbox_max = glm::vec4(2.5, height, -width+2, 0);
-    gate.angle = boxAngle(wall1.bbox_min, wall1.bbox_max);
-
-    collisionList.push_back(wall1);
-    collisionList.push_back(wall2);
-    collisionList.push_back(wall3);
-    collisionList.push_back(wall4);
-    collisionList.push_back(wall5);
-    collisionList.push_back(wall6);
-    collisionList.push_back(holeIn);
-    collisionList.push_back(holeOut);
-    collisionList.push_back(cube);
-    collisionList.push_back(button);
-
-    portalList.push_back(wall2);
-    portalList.push_back(wall3);
-    portalList.push_back(wall4);
-
-    std::vector<glm::vec3> bezierCurvePoints;
-
-    bezierCurvePoints.push_back(glm::vec3(-1.0f, 0.0f, 0.0f));
-    bezierCurvePoints.push_back(glm::vec3(-0.8f, 0.5f, 0.0f));
-    bezierCurvePoints.push_back(glm::vec3(-0.6f, 0.0f, 0.0f));
-    bezierCurvePoints.push_back(glm::vec3(-0.4f, 0.5f, 0.0f));
-    bezierCurvePoints.push_back(glm::vec3(-0.2f, 0.0f, 0.0f));
-    bezierCurvePoints.push_back(glm::vec3(0.0f, 0.5f, 0.0f));
-
-    float t_bezier;
-    float t_bezier_last;
-    bool isBackwards = false;
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN); //deixa o cursor invisivel
+    // Fase descrita em "data/level1.level" (veja "level.h"): objetos,
+    // caixas de colisão, superfícies de portal, gatilhos, objetos que podem
+    // ser carregados e animações. Cada registro vira uma entidade (veja
+    // "ecs.h").
+    Level level;
+    Startup_BeginStep("parse", "Level_Load");
+    if ( !Level_Load("data/level1", &level) )
+    {
+        fprintf(stderr, "ERROR: Cannot load level \"data/level1\".\n");
+        std::exit(EXIT_FAILURE);
+    }
+    Startup_EndStep();
+
+    // O jogo só procura pelo nome a saída (para a mensagem final) e o cubo
+    // móvel (para a câmera look-at e o benchmark); o evento do botão é usado
+    // para anotar a animação do portão nas estatísticas de quadro.
+    const LevelTrigger* exitTrigger   = Level_FindTrigger(level, "exit");
+    int                 cubePlacement = Level_FindPlacement(level, "cube");
+    if ( !exitTrigger || cubePlacement < 0 )
+    {
+        fprintf(stderr, "ERROR: Level needs trigger \"exit\" and placement \"cube\".\n");
+        std::exit(EXIT_FAILURE);
+    }
+    const LevelMarker* buttonMarker = Level_FindMarker(level, "button");
+    const char* buttonEvent = buttonMarker ? Level_String(level, buttonMarker->event) : NULL;
+
+    // As entidades dos objetos da fase são criadas antes dos seus nós, para
+    // que a superfície de portal do cubo móvel seja a primeira testada.
+    std::vector<Entity> levelEntities(level.placement_count);
+    for (size_t i = 0; i < level.placement_count; ++i)
+        levelEntities[i] = World_CreateEntity(&g_World);
+    g_MovingCube = levelEntities[cubePlacement];
+
+    // A frente e o verso do cubo móvel, com a largura e a altura da sua
+    // escala, acompanham a sua posição (veja Ecs_UpdateMovers()).
+    const LevelPlacement& cubePlacementData = level.placements[cubePlacement];
+    PortalSurfaceComponent cubeSurface = PortalSurfaceComponent();
+    cubeSurface.follow = g_MovingCube;
+    cubeSurface.offset_min = glm::vec3(-cubePlacementData.scale[0]/2, -cubePlacementData.scale[1]/2, +cubePlacementData.scale[2]);
+    cubeSurface.offset_max = glm::vec3(+cubePlacementData.scale[0]/2, +cubePlacementData.scale[1]/2, -cubePlacementData.scale[2]);
+    Component_Add(&g_World.portal_surfaces, g_MovingCube, cubeSurface);
+
+    Entity exitEntity = ECS_NO_ENTITY;
+    AddLevelGameplay(level, &exitEntity);
+    AddLevelPortalSurfaces(level, NULL);
+
+    // Salas da cena de estresse, do lado de fora da parede da frente da sala
+    // principal ("front_wall", em z = width): a grade começa 20 unidades além
+    // dela e cresce em +x e +z.
+    // Cada caixa vira uma entidade com caixa de colisão ou superfície de
+    // portal; as das plataformas são atualizadas a cada quadro.
+    StressScene stressScene;
+    std::vector<Entity> stressColliders;
+    if ( stress_params.rooms > 0 )
+    {
+        StartupScope step("init", "StressScene_Generate");
+        stress_params.wall_height = height;
+        stress_params.origin = glm::vec3(-width, -height/2, width + 20.0f);
+        StressScene_Generate(stress_params, &stressScene);
+
+        for (size_t i = 0; i < stressScene.colliders.size(); ++i)
+        {
+            ColliderComponent collider = { stressScene.colliders[i] };
+            stressColliders.push_back(World_CreateEntity(&g_World));
+            Component_Add(&g_World.colliders, stressColliders.back(), collider);
+        }
+        for (size_t i = 0; i < stressScene.portal_surfaces.size(); ++i)
+        {
+            PortalSurfaceComponent surface = PortalSurfaceComponent();
+            surface.box = stressScene.portal_surfaces[i];
+            surface.follow = ECS_NO_ENTITY;
+            Component_Add(&g_World.portal_surfaces, World_CreateEntity(&g_World), surface);
+        }
+
+        printf("Stress scene: %d rooms, %lu objects (%d walls, %d props, %lu platforms), %lu colliders, %lu portal surfaces\n",
+               stress_params.rooms, (unsigned long)stressScene.objects.size(), stressScene.walls, stressScene.props,
+               (unsigned long)stressScene.platforms.size(), (unsigned long)g_World.colliders.data.size(),
+               (unsigned long)g_World.portal_surfaces.data.size());
+    }
+
+    // Hierarquia de transformações da cena. Os nós estáticos (fase e cena de
+    // estresse) são criados antes dos dinâmicos, para que a atualização de
+    // cada quadro comece depois deles; veja "transformgraph.h". Na fase os
+    // objetos estáticos já vêm primeiro.
+    const glm::quat noRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    const glm::quat rotateX90  = glm::angleAxis(3.141592f / 2.0f, glm::vec3(1.0f,0.0f,0.0f));
+    TransformGraph sceneGraph;
+
+    AddLevelPlacements(level, 0, level.static_placement_count, &sceneGraph, levelEntities);
+
+    // Objetos da cena de estresse: Translate * Rotate_Y * Scale, e as paredes
+    // ainda com Rotate_X(pi/2) à direita, que vira T * (Rotate_Y * Rotate_X) *
+    // Scale' com as escalas em y e z trocadas.
+    for (size_t i = 0; i < stressScene.objects.size(); ++i)
+    {
+        const StressObject& object = stressScene.objects[i];
+        if ( object.kind == STRESS_PLATFORM )
+            continue;
+
+        glm::quat rotation = glm::angleAxis(object.yaw, glm::vec3(0.0f,1.0f,0.0f));
+        glm::vec3 scale = object.scale;
+        int object_id = ROOF;
+        const char* object_name = "cube";
+        switch ( object.kind )
+        {
+        case STRESS_FLOOR:
+            object_id = FLOOR;
+            object_name = "the_floor";
+            break;
+        case STRESS_WALL:
+            rotation = rotation * rotateX90;
+            scale = glm::vec3(scale.x, scale.z, scale.y);
+            object_id = WALL;
+            object_name = "the_wall";
+            break;
+        case STRESS_PROP_COMPANION:
+            object_id = COMPANION_CUBE;
+            object_name = "pCube2";
+            break;
+        default:
+            break;
+        }
+        AddRenderable(&sceneGraph, TRANSFORM_ROOT, Affine_MakeTRS(object.position, rotation, scale), object_id, object_name);
+    }
+
+    // Objetos que se movem. A câmera é a inversa da matriz "view", e a arma,
+    // a mira e o cubo carregado são seus filhos.
+    AddLevelPlacements(level, level.static_placement_count, level.placement_count - level.static_placement_count,
+                       &sceneGraph, levelEntities);
+    AddLevelPickups(level, &sceneGraph);
+
+    // Os dois portais, abertos pelos botões esquerdo e direito do mouse;
+    // cada um leva ao outro. Só são desenhados depois de abertos.
+    const int   portalObjects[2] = { PORTAL1, PORTAL2 };
+    const char* portalMeshes[2]  = { "Portal1", "Portal2" };
+    const char* portalEvents[2]  = { "portal1_open", "portal2_open" };
+    Entity portals[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        portals[i] = AddRenderable(&sceneGraph, TRANSFORM_ROOT, Affine_Identity(), portalObjects[i], portalMeshes[i], RENDER_PORTALS);
+        Component_Get(g_World.renderables, portals[i])->visible = false;
+    }
+
+    std::vector<Entity> stressPlatforms;
+    for (size_t i = 0; i < stressScene.platforms.size(); ++i)
+    {
+        const StressObject& object = stressScene.objects[stressScene.platforms[i].object];
+        Entity platform = AddRenderable(&sceneGraph, TRANSFORM_ROOT, Affine_MakeTRS(object.position, noRotation, object.scale),
+                                        ROOF, "cube");
+        TransformComponent transform = { object.position, Component_Get(g_World.renderables, platform)->node };
+        Component_Add(&g_World.transforms, platform, transform);
+        stressPlatforms.push_back(platform);
+    }
+
+    int nodeCamera = TransformGraph_AddNode(&sceneGraph, TRANSFORM_ROOT, Affine_Identity());
+    AddRenderable(&sceneGraph, nodeCamera,
+                  Affine_MakeTSR(glm::vec3(0.2f,-0.15f,-0.5f), noRotation, glm::vec3(0.2f)),
+                  PORTALGUN, "PortalGun");
+    AddRenderable(&sceneGraph, nodeCamera,
+                  Affine_MakeTSR(glm::vec3(-0.05f,0.05f,-1.0f), noRotation, glm::vec3(0.05f, 0.1f, 0.05f)),
+                  AIMLEFT, "aimLeft");
+    AddRenderable(&sceneGraph, nodeCamera,
+                  Affine_MakeTSR(glm::vec3(0.05f,-0.05f,-1.0f), glm::angleAxis(3.141592f, glm::vec3(0.0f,0.0f,1.0f)), glm::vec3(0.05f, 0.1f, 0.05f)),
+                  AIMRIGHT, "aimRight");
+    g_World.held_node = TransformGraph_AddNode(&sceneGraph, nodeCamera,
+                                               Affine_MakeTSR(glm::vec3(0.0f,0.0f,-1.0f), noRotation, glm::vec3(0.7f)));
+
+    // Animações (veja "animation.h"). As da fase (o portão, que sobe quando o
+    // cubo é colocado no botão, e o cubo móvel) vêm do arquivo; os portais
+    // crescem quando são criados.
+    AnimationSystem animations;
+    AddLevelAnimations(level, levelEntities, &animations);
+    if ( Component_Get(g_World.animations, g_MovingCube) == NULL )
+    {
+        fprintf(stderr, "ERROR: Level placement \"cube\" has no animation.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    float portalTimes[]  = { 0.0f, (float)(5.0f/PortalAnimationSpeed) };
+    float portalValues[] = { 0.0f, 5.0f };
+    for (int i = 0; i < 2; ++i)
+    {
+        PortalComponent portal = PortalComponent();
+        portal.linked = portals[1 - i];
+        portal.attached = ECS_NO_ENTITY;
+        portal.button = i;
+        portal.target = Animation_AddTarget(&animations, Component_Get(g_World.renderables, portals[i])->node,
+                                            glm::vec3(0.0f), noRotation, glm::vec3(0.0f, 0.0f, 1.0f));
+        portal.open_event = portalEvents[i];
+        Component_Add(&g_World.portals, portals[i], portal);
+
+        Animation_AddTrack(&animations, portalEvents[i], portal.target, ANIM_SCALE_X, ANIM_LINEAR, ANIM_ONCE, portalTimes, portalValues, 2);
+        Animation_AddTrack(&animations, portalEvents[i], portal.target, ANIM_SCALE_Y, ANIM_LINEAR, ANIM_ONCE, portalTimes, portalValues, 2);
+    }
+
+    Animation_Trigger(&animations, "level_start", 0.0);
+    Ecs_UpdateMovers(&g_World, &animations);
+
+    // Dados das tarefas de cada quadro.
+    FrameJobs frameJobs;
+    frameJobs.graph = &sceneGraph;
+    frameJobs.animations = &animations;
+    frameJobs.stress = &stressScene;
+    frameJobs.stress_colliders = &stressColliders;
+    frameJobs.stress_platforms = &stressPlatforms;
+    frameJobs.level = &level;
+    frameJobs.node_camera = nodeCamera;
+
+    // Carregamentos vistos pela última UpdateRenderableBounds().
+    size_t renderableBoundsLoads = (size_t)-1;
+
+    TextObject instructionLines[2];
+
+    if ( !Bench_IsActive() )
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN); //deixa o cursor invisivel
+
+    int frame = 0;
+    double bench_start = glfwGetTime();
+    if ( g_FixedTimestep > 0.0 )
+        t_prev = 0.0f;
+
     while (!glfwWindowShouldClose(window))
     {
+        // O primeiro quadro termina a linha do tempo da inicialização.
+        if ( frame == 0 )
+            Startup_BeginStep("frame", "first frame");
+
+        // Medimos o tempo de cada etapa do quadro (veja "profiler.h" e
+        // "trace.h").
+        Trace_BeginFrame();
+        Profiler_BeginFrame();
+
         // Aqui executamos as operações de renderização
 
         // Definimos a cor do "fundo" do framebuffer como branco.  Tal cor é
@@ -534,10 +826,29 @@ int main(int argc, char* argv[])
         //           R     G     B     A
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
-        double time = glfwGetTime();
+        // Nos modos de benchmark, gravação e reprodução o tempo avança em
+        // passos fixos.
+        double time = g_FixedTimestep > 0.0 ? frame * g_FixedTimestep : glfwGetTime();
+
+        // Na reprodução, a entrada gravada para este quadro substitui a da GLFW.
+        if ( InputReplay_IsActive() )
+            ReplayInput(window, frame);
+
+        // Avançamos os envios de textura pendentes (PBOs) uma vez por quadro.
+        Profiler_BeginScope("streaming");
+        ReloadChangedFiles();
+        TextureStreaming_Update();
+        Residency_Update();
+        if ( Residency_GetStats().loads + Residency_GetStats().reloads != renderableBoundsLoads )
+        {
+            renderableBoundsLoads = Residency_GetStats().loads + Residency_GetStats().reloads;
+            UpdateRenderableBounds();
+        }
+        Profiler_EndScope();
 
         // "Pintamos" todos os pixels do framebuffer com a cor definida acima,
         // e também resetamos todos os pixels do Z-buffer (depth buffer).
+        Profiler_BeginGpuScope("scene");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Pedimos para a GPU utilizar o programa de GPU criado acima (contendo
@@ -548,6 +859,10 @@ int main(int argc, char* argv[])
         // variáveis g_CameraDistance, g_CameraPhi, e g_CameraTheta são
         // controladas pelo mouse do usuário. Veja as funções CursorPosCallback()
         // e ScrollCallback().
+        Profiler_BeginScope("sim");
+
+        if ( Bench_IsActive() )
+            ApplyBenchInput(frame);
 
         float y = r*sin(g_CameraPhi);
         float z = r*cos(g_CameraPhi)*cos(g_CameraTheta);
@@ -557,11 +872,11 @@ int main(int argc, char* argv[])
         //glm::vec4 camera_view_vector = camera_lookat_l - camera_position_c; // Vetor "view", sentido para onde a câmera está virada
         glm::vec4 camera_view_vector = glm::vec4(-x,-y,-z,0.0f);
         glm::vec4 camera_up_vector   = glm::vec4(0.0f,1.0f,0.0f,0.0f); // Vetor "up" fixado para apontar para o "céu" (eito Y global)
-        glm::vec4 camera_lookat_l    = glm::vec4(cubePosition.x, cubePosition.y, cubePosition.z, 1.0);
+        glm::vec4 camera_lookat_l    = glm::vec4(Component_Get(g_World.transforms, g_MovingCube)->position, 1.0);
 
         glm::mat4 view;
         glm::vec4 lastCameraPos;
-        t_now = glfwGetTime();
+        t_now = time;
         t_step = t_now - t_prev;
 
         t_prev = t_now;
@@ -582,208 +897,10 @@ int main(int argc, char* argv[])
             //std::cout << camera_position_c.x << " " << camera_position_c.y << " " << camera_position_c.z << std::endl;
 
         }
-        blockMove = false;
-
-        for (int i=0; i<collisionList.size(); i++)
-        {
-            bbox wallHitbox;
-            wallHitbox.bbox_min = collisionList[i].bbox_min;
-            wallHitbox.bbox_max = collisionList[i].bbox_max;
-
-            wallHitbox.bbox_max.x+=1;
-            wallHitbox.bbox_min.x-=1;
-            wallHitbox.bbox_max.z+=1;
-            wallHitbox.bbox_min.z-=1;
-
-            if(detectColision(camera_position_c, wallHitbox.bbox_min, wallHitbox.bbox_max))
-            {
-                blockMove = true;
-            }
-        }
-
-        bbox cubeIn;
-        cubeIn.bbox_min = glm::vec4(cubePosition.x - cubeWidth/2, cubePosition.y-height/2, cubePosition.z+1, 0);
-        cubeIn.bbox_max = glm::vec4(cubePosition.x + cubeWidth/2, cubePosition.y+height/2, cubePosition.z-1, 0);
-        cubeIn.angle = 0.0;
-        glm::vec4 point;
-
-        if(time - lastPortal1Time > 0.5 && g_LeftMouseButtonPressed)
-        {
-            if(CheckLineBox(cubeIn.bbox_min, cubeIn.bbox_max,
-                            camera_position_c, camera_view_vector, point))
-            {
-                lastPortal1Time = time;
-
-                float deslX;
-                float deslZ;
-                float angle = cubeIn.angle;
-
-                if(angle<0.1) angle = 0;
-
-                if(cos(angle)>0.01)
-                {
-                    deslX = 0;
-                    deslZ = 0.01;
-
-                    if(cubeIn.bbox_min.z>0)
-                        deslZ = deslZ * -1;
-                    else
-                        angle = angle + M_PI;
-                }
-                else
-                {
-                    deslX = 0.01;
-                    deslZ = 0;
-
-                    if(cubeIn.bbox_min.x>0)
-                        deslX = deslX * -1;
-                    else
-                        angle = angle + M_PI;
-                }
-
-                Portal1Created = true;
-                Portal1OnCube = true;
-                Portal1Bbox.bbox_min = glm::vec4(point.x+deslX, height/2, point.z+deslZ, 0.0);
-                Portal1Bbox.bbox_max = glm::vec4(point.x-deslX, height/2, point.z-deslZ, 0.0);
-                Portal1Bbox.angle = angle;
-            }
-        }
-
-        if(time - lastPortal2Time > 0.5 && g_RightMouseButtonPressed)
-        {
-
-            if(CheckLineBox(cubeIn.bbox_min, cubeIn.bbox_max,
-                            camera_position_c, camera_view_vector, point))
-            {
-                lastPortal2Time = time;
-
-                float deslX;
-                float deslZ;
-                float angle = cubeIn.angle;
-
-                if(angle<0.1) angle = 0;
-
-                if(cos(angle)>0.01)
-                {
-                    deslX = 0;
-                    deslZ = 0.01;
-
-                    if(cubeIn.bbox_min.z>0)
-                        deslZ = deslZ * -1;
-                    else
-                        angle = angle + M_PI;
-                }
-                else
-                {
-                    deslX = 0.01;
-                    deslZ = 0;
-
-                    if(cubeIn.bbox_min.x>0)
-                        deslX = deslX * -1;
-                    else
-                        angle = angle + M_PI;
-                }
-
-                Portal2Created = true;
-                Portal2OnCube = true;
-                Portal2Bbox.bbox_min = glm::vec4(point.x+deslX, height/2, point.z+deslZ, 0.0);
-                Portal2Bbox.bbox_max = glm::vec4(point.x-deslX, height/2, point.z-deslZ, 0.0);
-                Portal2Bbox.angle = angle;
-            }
-        }
-
-        for (int i=0; i<portalList.size(); i++)
-        {
-            glm::vec4 point;
-            if(time - lastPortal1Time > 0.5 && g_LeftMouseButtonPressed)
-            {
-                if(CheckLineBox(portalList[i].bbox_min, portalList[i].bbox_max,
-                                camera_position_c, camera_view_vector, point))
-                {
-                    lastPortal1Time = time;
-
-                    float deslX;
-                    float deslZ;
-                    float angle = portalList[i].angle;
-
-                    printf("angle %f\n", angle);
-
-                    if(angle<0.1) angle = 0;
-
-                    if(cos(angle)>0.01)
-                    {
-                        deslX = 0;
-                        deslZ = 0.01;
-
-                        if(portalList[i].bbox_min.z>0)
-                            deslZ = deslZ * -1;
-                        else
-                            angle = angle + M_PI;
-                    }
-                    else
-                    {
-                        deslX = 0.01;
-                        deslZ = 0;
-
-                        if(portalList[i].bbox_min.x>0)
-                            deslX = deslX * -1;
-                        else
-                            angle = angle + M_PI;
-                    }
-
-                    Portal1Created = true;
-                    Portal1OnCube = false;
-                    Portal1Bbox.bbox_min = glm::vec4(point.x+deslX, height/2, point.z+deslZ, 0.0);
-                    Portal1Bbox.bbox_max = glm::vec4(point.x-deslX, height/2, point.z-deslZ, 0.0);
-                    Portal1Bbox.angle = angle;
-                }
-            }
-
-            if(time - lastPortal2Time > 0.5 && g_RightMouseButtonPressed)
-            {
-
-                if(CheckLineBox(portalList[i].bbox_min, portalList[i].bbox_max,
-                                camera_position_c, camera_view_vector, point))
-                {
-                    lastPortal2Time = time;
-
-                    float deslX;
-                    float deslZ;
-                    float angle = boxAngle(portalList[i].bbox_min, portalList[i].bbox_max);
-
-                    if(angle<0.1) angle = 0;
-
-                    if(cos(angle)>0.01)
-                    {
-                        deslX = 0;
-                        deslZ = 0.01;
-
-                        if(portalList[i].bbox_min.z>0)
-                            deslZ = deslZ * -1;
-                        else
-                            angle = angle + M_PI;
-                    }
-                    else
-                    {
-                        deslX = 0.01;
-                        deslZ = 0;
-
-                        if(portalList[i].bbox_min.x>0)
-                            deslX = deslX * -1;
-                        else
-                            angle = angle + M_PI;
-                    }
-
-                    Portal2Created = true;
-                    Portal2OnCube = false;
-                    Portal2Bbox.bbox_min = glm::vec4(point.x+deslX, height/2, point.z+deslZ, 0.0);
-                    Portal2Bbox.bbox_max = glm::vec4(point.x-deslX, height/2, point.z-deslZ, 0.0);
-                    Portal2Bbox.angle = angle;
-                }
-            }
-        }
+        Profiler_EndScope();
 
         // Agora computamos a matriz de Projeção.
+        Profiler_BeginScope("render");
         glm::mat4 projection;
 
         // Note que, no sistema de coordenadas da câmera, os planos near e far
@@ -812,7 +929,18 @@ int main(int argc, char* argv[])
             projection = Matrix_Orthographic(l, r, b, t, nearplane, farplane);
         }
 
-        glm::mat4 model = Matrix_Identity(); // Transformação identidade de modelagem
+        // O que não faz chamadas OpenGL (plataformas, colisão, portais,
+        // objetos carregados, animações, hierarquia de transformações e
+        // descarte dos objetos fora da visão) vira um grafo de tarefas, que
+        // as threads auxiliares executam enquanto esta envia as matrizes;
+        // depois ela ajuda com o que faltar (veja "jobs.h").
+        frameJobs.camera = camera_position_c;
+        frameJobs.view_vector = camera_view_vector;
+        frameJobs.view = view;
+        frameJobs.view_projection = projection * view;
+        frameJobs.buttons = (g_LeftMouseButtonPressed ? 1u : 0u) | (g_RightMouseButtonPressed ? 2u : 0u);
+        frameJobs.time = time;
+        AddFrameJobs(&frameJobs);
 
         // Enviamos as matrizes "view" e "projection" para a placa de vídeo
         // (GPU). Veja o arquivo "shader_vertex.glsl", onde estas são
@@ -821,329 +949,46 @@ int main(int argc, char* argv[])
         glUniformMatrix4fv(g_projection_uniform , 1 , GL_FALSE , glm::value_ptr(projection));
         glUniform4f(g_light_position_uniform, 0.0f, 3.5f, 0.0f, 1.0f);
 
-        glm::mat4 identity = Matrix_Identity();
-        glUniformMatrix4fv(g_view_uniform, 1 , GL_FALSE , glm::value_ptr(identity));
-
-        //LoadGouraudShadersFromFiles();
-        model = Matrix_Translate(0.2,-0.15,-0.5) * Matrix_Scale(0.2f, 0.2f, 0.2f);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, PORTALGUN);
-        DrawVirtualObject("PortalGun");
-        //LoadPhongShadersFromFiles();
-        model = Matrix_Translate(-0.05,0.05,-1) * Matrix_Scale(0.05f, 0.1f, 0.05f);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, AIMLEFT);
-        DrawVirtualObject("aimLeft");
-
-        model = Matrix_Translate(0.05,-0.05,-1) * Matrix_Scale(0.05f, 0.1f, 0.05f) * Matrix_Rotate(3.141592f, glm::vec4(0.0f,0.0f,1.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, AIMRIGHT);
-        DrawVirtualObject("aimRight");
-
-        if(isHolding)
-        {
-            model = Matrix_Translate(0.0,0.0,-1) * Matrix_Scale(0.7f, 0.7f, 0.7f) * Matrix_Identity();
-            glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, COMPANION_CUBE);
-            DrawVirtualObject("pCube2");
-            box_position = camera_position_c;
-        }
-        if(dropped)
-        {
-            box_position.y = -height/2 +1;
-            dropped = false;
-            if(isNear(box_position, button_position))
-            {
-                box_position = button_position;
-                box_position.y +=1.25;
-                box_position.z +=0.8;
-
-                openDoor = true;
-                openGateTime = time;
-
-                portalList.push_back(wall1);
-                portalList.push_back(wall5);
-                portalList.push_back(wall6);
-            }
-        }
-
-
-        glUniformMatrix4fv(g_view_uniform, 1 , GL_FALSE , glm::value_ptr(view));
-
-        model = Matrix_Translate(0.0f,-height/2,width/2+spaceDistance/2)* Matrix_Scale(width, height/2, width/2-(spaceDistance/2));// * Matrix_Scale(20.0f, 20.0f, 20.0f);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, FLOOR);
-        DrawVirtualObject("the_floor");
-
-        model = Matrix_Translate(0.0f,-height/2,-width/2-spaceDistance/2) * Matrix_Scale(width, height/2, width/2-(spaceDistance/2));// * Matrix_Scale(20.0f, 20.0f, 20.0f);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, FLOOR);
-        DrawVirtualObject("the_floor");
-
-        model = Matrix_Translate(0.0f,-5*height/2,0.0f) * Matrix_Scale(width, height/2, spaceDistance);// * Matrix_Scale(20.0f, 20.0f, 20.0f);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, LAVA);
-        DrawVirtualObject("the_floor");
-
-        model = Matrix_Translate(-(width/2)-2.5,height/2,-width) * Matrix_Scale((width/2)-2.5, height, 0) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WALL);
-        DrawVirtualObject("the_wall");
-
-        model = Matrix_Translate((width/2)+2.5,height/2,-width) * Matrix_Scale((width/2)-2.5, height, 0) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WALL);
-        DrawVirtualObject("the_wall");
-
-        float gateYPos;
-
-        if(openDoor)
-            gateYPos = height/2 + std::min((time - openGateTime)*GateAnimationSpeed, (double)height*2.0);
-        else
-            gateYPos = height/2;
-
-
-        model = Matrix_Translate(0, gateYPos,-width) * Matrix_Scale(5, height, 0) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, GATE);
-        DrawVirtualObject("the_wall");
-
-        model = Matrix_Translate(0.0f,-3*height/2,-spaceDistance) * Matrix_Scale(width, height, 0) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WALL);
-        DrawVirtualObject("the_wall");
-
-        model = Matrix_Translate(0.0f,-3*height/2,spaceDistance) * Matrix_Scale(width, height, 0) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(-1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WALL);
-        DrawVirtualObject("the_wall");
-
-        model = Matrix_Translate(width,-height/2,0.0f) * Matrix_Scale(0, height*2, width) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(0.0f,-1.0f,0.0f,0.0f)) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WALL);
-        DrawVirtualObject("the_wall");
-
-        model = Matrix_Translate(-width,-height/2,0.0f) * Matrix_Scale(0, height*2, width) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(0.0f,1.0f,0.0f,0.0f)) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WALL);
-        DrawVirtualObject("the_wall");
-
-        model = Matrix_Translate(0.0f,height/2,width) * Matrix_Scale(width, height, 0) * Matrix_Rotate(3.141592f / 2.0f, glm::vec4(-1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WALL);
-        DrawVirtualObject("the_wall");
-
-        model = Matrix_Translate(0.0f,3*height/2,0.0f) * Matrix_Scale(width, height/2, width) * Matrix_Rotate(3.141592f, glm::vec4(1.0f,0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, ROOF);
-        DrawVirtualObject("the_roof");
-
-        model = Matrix_Translate(+40.0f, -height/2 + 0.01, +30.0f)* Matrix_Scale(0.07, 0.07, 0.07) * Matrix_Identity();
-        glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, BUTTON);
-        DrawVirtualObject("Stm_button01");
-        DrawVirtualObject("Stm_button02");
-
-        if(!isHolding)
-        {
-            model = Matrix_Translate(box_position.x, box_position.y, box_position.z + 3)* Matrix_Identity();
-            glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, COMPANION_CUBE);
-            DrawVirtualObject("pCube2");
-        }
-
+        Jobs_Wait(frameJobs.collision);
+        blockMove = frameJobs.blocked;
+        Jobs_Wait(frameJobs.cull);
 
-        //printf("%f\n", ((int)(time*1000)%5000)/5000.0);
+        if(buttonEvent != NULL && Animation_IsEventPlaying(animations, buttonEvent))
+            FrameStats_Annotate("gate animation");
 
-        t_bezier_last = t_bezier;
-        t_bezier = ((int)(time*1000)%5000)/5000.0;
-        glm::vec3 bezier_point;
-        if(t_bezier_last > t_bezier)
-        {
-            isBackwards = !isBackwards;
-        }
-        if(isBackwards)
-        {
-            bezier_point = bezierCurve(bezierCurvePoints, 1.0 - t_bezier);
-        }
-        else bezier_point = bezierCurve(bezierCurvePoints, t_bezier);
         //PrintVector(camera_position_c);
-        if(isNear(camera_position_c, box_position) && !isHolding)
+        if(frameJobs.pickup_near)
             TextRendering_PrintString(window, "Pressione E para pegar", -0.25, -0.25, 3.0f);
 
-        cubePosition.x=cubePositionOrigin.x+(bezier_point.x*width);
-        cubePosition.y=cubePositionOrigin.y+(bezier_point.y*height);
-        cubePosition.z=cubePositionOrigin.z+(bezier_point.z*width);
+        DrawRenderList(sceneGraph, frameJobs.render_lists, RENDER_SCENE);
+        Profiler_EndScope();
+        Profiler_EndGpuScope();
 
-        if(Portal1OnCube)
+        Profiler_BeginScope("portals");
+        Profiler_BeginGpuScope("portals");
+        if ( Ecs_TeleportThroughPortals(&g_World, &camera_position_c, &g_CameraTheta, height) > 0 )
         {
-            Portal1Bbox.bbox_min.x=cubePosition.x;
-            Portal1Bbox.bbox_min.y=cubePosition.y;
-            Portal1Bbox.bbox_min.z=cubePosition.z+1.01;
-            Portal1Bbox.bbox_max.x=cubePosition.x;
-            Portal1Bbox.bbox_max.y=cubePosition.y;
-            Portal1Bbox.bbox_max.z=cubePosition.z+1.01;
-        }
-
-        if(Portal2OnCube)
-        {
-            Portal2Bbox.bbox_min.x=cubePosition.x;
-            Portal2Bbox.bbox_min.y=cubePosition.y;
-            Portal2Bbox.bbox_min.z=cubePosition.z+1.01;
-            Portal2Bbox.bbox_max.x=cubePosition.x;
-            Portal2Bbox.bbox_max.y=cubePosition.y;
-            Portal2Bbox.bbox_max.z=cubePosition.z+1.01;
-        }
-
-        model = Matrix_Translate(cubePosition.x,cubePosition.y,cubePosition.z) * Matrix_Scale(cubeWidth, height, 1);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, ROOF);
-        DrawVirtualObject("cube");
-
-        if(Portal1Created)
-        {
-            bbox hitBoxPortal1;
-            hitBoxPortal1.bbox_min = Portal1Bbox.bbox_min;
-            hitBoxPortal1.bbox_max = Portal1Bbox.bbox_max;
-
-            int deslX;
-            int deslZ;
-
-            if(abs(cos(Portal1Bbox.angle))>0.01)
-            {
-                deslX = 5;
-                deslZ = 1;
-            }
-            else
-            {
-                deslX = 1;
-                deslZ = 5;
-            }
-
-            hitBoxPortal1.bbox_min.x -= deslX;
-            hitBoxPortal1.bbox_max.x += deslX;
-            hitBoxPortal1.bbox_min.z -= deslZ;
-            hitBoxPortal1.bbox_max.z += deslZ;
-            hitBoxPortal1.bbox_min.y = 0;
-            hitBoxPortal1.bbox_max.y = height;
-
-            if(detectColision(camera_position_c, hitBoxPortal1.bbox_min, hitBoxPortal1.bbox_max))
-            {
-                if(Portal2Created)
-                {
-                    blockMove = false;
-
-                    float angleCorrection = (Portal1Bbox.angle - Portal2Bbox.angle) + M_PI * cos(Portal1Bbox.angle - Portal2Bbox.angle);
-
-                    if(angleCorrection == -0.0) angleCorrection = 0.0;
-
-                    if(abs(cos(Portal2Bbox.angle))>0.01)
-                    {
-                        deslX = 0;
-                        deslZ = 5;
-
-                        if(Portal2Bbox.bbox_min.z>0)
-                            deslZ = deslZ * -1;
-                    }
-                    else
-                    {
-                        deslX = 5;
-                        deslZ = 0;
-
-                        if(Portal2Bbox.bbox_min.x>0)
-                            deslX = deslX * -1;
-                    }
-
-                    camera_position_c.x = Portal2Bbox.bbox_min.x + deslX;
-                    camera_position_c.z = Portal2Bbox.bbox_min.z + deslZ;
-
-                    g_CameraTheta = g_CameraTheta + angleCorrection;
-                }
-            }
-
-            model = Matrix_Translate(Portal1Bbox.bbox_min.x,Portal1Bbox.bbox_min.y,Portal1Bbox.bbox_min.z)
-             * Matrix_Rotate(Portal1Bbox.angle, glm::vec4(0.0f,1.0f,0.0f,0.0f))
-             * Matrix_Scale(std::min((time - lastPortal1Time)*PortalAnimationSpeed, 5.0), std::min((time - lastPortal1Time)*PortalAnimationSpeed, 5.0), 1);
-            glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, PORTAL1);
-            DrawVirtualObject("Portal1");
-        }
-
-        if(Portal2Created)
-        {
-            bbox hitBoxPortal2;
-            hitBoxPortal2.bbox_min = Portal2Bbox.bbox_min;
-            hitBoxPortal2.bbox_max = Portal2Bbox.bbox_max;
-
-            int deslX;
-            int deslZ;
-            if(abs(cos(Portal2Bbox.angle))>0.01)
-            {
-                deslX = 5;
-                deslZ = 1;
-            }
-            else
-            {
-                deslX = 1;
-                deslZ = 5;
-            }
-
-            hitBoxPortal2.bbox_min.x -= deslX;
-            hitBoxPortal2.bbox_max.x += deslX;
-            hitBoxPortal2.bbox_min.z -= deslZ;
-            hitBoxPortal2.bbox_max.z += deslZ;
-            hitBoxPortal2.bbox_min.y = 0;
-            hitBoxPortal2.bbox_max.y = height;
-
-            if(detectColision(camera_position_c, hitBoxPortal2.bbox_min, hitBoxPortal2.bbox_max))
-            {
-               if(Portal1Created)
-                {
-                    blockMove = false;
-
-                    float angleCorrection = (Portal2Bbox.angle - Portal1Bbox.angle) + M_PI * cos(Portal2Bbox.angle - Portal1Bbox.angle);
-
-                    if(angleCorrection == -0.0) angleCorrection = 0.0;
-
-                    if(abs(cos(Portal1Bbox.angle))>0.01)
-                    {
-                        deslX = 0;
-                        deslZ = 5;
-
-                        if(Portal1Bbox.bbox_min.z>0)
-                            deslZ = deslZ * -1;
-                    }
-                    else
-                    {
-                        deslX = 5;
-                        deslZ = 0;
-
-                        if(Portal1Bbox.bbox_min.x>0)
-                            deslX = deslX * -1;
-                    }
-
-                    camera_position_c.x = Portal1Bbox.bbox_min.x + deslX;
-                    camera_position_c.z = Portal1Bbox.bbox_min.z + deslZ;
-
-                    g_CameraTheta = g_CameraTheta + angleCorrection;
-                }
-            }
-
-            model = Matrix_Translate(Portal2Bbox.bbox_min.x,Portal2Bbox.bbox_min.y,Portal2Bbox.bbox_min.z)
-             * Matrix_Rotate(Portal2Bbox.angle, glm::vec4(0.0f,1.0f,0.0f,0.0f))
-             * Matrix_Scale(std::min((time - lastPortal2Time)*PortalAnimationSpeed, 5.0), std::min((time - lastPortal2Time)*PortalAnimationSpeed, 5.0), 1);
-            glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, PORTAL2);
-            DrawVirtualObject("Portal2");
+            blockMove = false;
+            FrameStats_Annotate("portal teleport");
         }
+        DrawRenderList(sceneGraph, frameJobs.render_lists, RENDER_PORTALS);
 
         if(blockMove) camera_position_c = lastCameraPos;
+        Ecs_UpdateTriggers(&g_World, camera_position_c);
+        Profiler_EndGpuScope();
+        Profiler_EndScope();
 
+        Profiler_BeginScope("text");
+        Profiler_BeginGpuScope("text");
         float lineheight = TextRendering_LineHeight(window);
         float charwidth = TextRendering_CharWidth(window);
 
-        TextRendering_PrintString(window, "Coloque o cubo no botao vermelho para avancar", -0.75, 0.75, 3.0f);
-        TextRendering_PrintString(window, "Use os cliques do mouse para abrir portais", -0.7, 0.70-lineheight, 3.0f);
+        // As instruções são montadas uma vez e só de novo se a janela mudar
+        // de tamanho (veja "textobject.h").
+        TextObject_Set(&instructionLines[0], "Coloque o cubo no botao vermelho para avancar", -0.75, 0.75, 3.0f);
+        TextObject_Set(&instructionLines[1], "Use os cliques do mouse para abrir portais", -0.7, 0.70-lineheight, 3.0f);
+        TextObject_Draw(&instructionLines[0]);
+        TextObject_Draw(&instructionLines[1]);
 
         // Imprimimos na tela os ângulos de Euler que controlam a rotação do
         // terceiro cubo.
@@ -1156,221 +1001,474 @@ int main(int argc, char* argv[])
         // por segundo (frames per second).
         TextRendering_ShowFramesPerSecond(window);
 
-        if(openDoor && detectColision(camera_position_c, gate.bbox_min, gate.bbox_max))
+        // Imprimimos na tela bytes enviados e tempo bloqueado pelo envio de
+        // texturas, enquanto houver texturas sendo carregadas.
+        TextRendering_ShowTextureStreaming(window);
+
+        if(Component_Get(g_World.triggers, exitEntity)->inside)
         {
             glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
             TextRendering_PrintString(window, "OBRIGADO POR JOGAR", -0.27, -0.02, 3.0f);
         }
 
+        // Imprimimos na tela o tempo de CPU e GPU de cada etapa (tecla F3).
+        TextRendering_ShowProfiler(window);
+
+        // Imprimimos na tela a memória usada por subsistema (tecla F5).
+        TextRendering_ShowMemory(window);
+
+        // Todo o texto do quadro é desenhado com uma única chamada.
+        TextRendering_Flush();
+        Profiler_EndGpuScope();
+        Profiler_EndScope();
+
         // O framebuffer onde OpenGL executa as operações de renderização não
         // é o mesmo que está sendo mostrado para o usuário, caso contrário
         // seria possível ver artefatos conhecidos como "screen tearing". A
         // chamada abaixo faz a troca dos buffers, mostrando para o usuário
         // tudo que foi renderizado pelas funções acima.
         // Veja o link: https://en.wikipedia.org/w/index.php?title=Multiple_buffering&oldid=793452829#Double_buffering_in_computer_graphics
+        Profiler_BeginScope("swap");
         glfwSwapBuffers(window);
+        Profiler_EndScope();
+
+        GLStats_EndFrame();
+
+        if ( frame == 0 )
+        {
+            Startup_EndStep();
+            Startup_FirstFrame();
+        }
 
         // Verificamos com o sistema operacional se houve alguma interação do
         // usuário (teclado, mouse, ...). Caso positivo, as funções de callback
         // definidas anteriormente usando glfwSet*Callback() serão chamadas
         // pela biblioteca GLFW.
+        Profiler_BeginScope("input");
+        g_InputFrame = frame + 1;
         glfwPollEvents();
+        Profiler_EndScope();
+
+        Jobs_EndFrame();
+        Profiler_EndFrame();
+
+        // Registramos os tempos do quadro para os percentis e engasgos (veja
+        // "framestats.h").
+        double gpu_frame_ms;
+        FrameStats_EndFrame(Profiler_GetLastCpuFrameMs());
+        if (Profiler_GetLastGpuFrameMs(&gpu_frame_ms))
+            FrameStats_AddGpuSample(PROFILER_GPU_FRAMES, gpu_frame_ms);
+
+        // Os assets usados no primeiro quadro são carregados em segundo plano;
+        // o relatório de inicialização sai quando todos estiverem prontos.
+        if ( Startup_IsActive() && Residency_IsIdle() && TextureStreaming_IsIdle() )
+            Startup_Finish(startup_report_filename.c_str());
+
+        frame += 1;
+        if ( Bench_IsActive() && frame >= Bench_GetFrames() )
+            glfwSetWindowShouldClose(window, GL_TRUE);
+        if ( InputReplay_IsActive() && (uint32_t)frame >= InputReplay_GetFrames() )
+            glfwSetWindowShouldClose(window, GL_TRUE);
     }
 
+    InputRecord_Stop(frame);
+    InputReplay_Stop();
+
+    int exit_code = 0;
+    if ( Bench_IsActive() )
+    {
+        double seconds = glfwGetTime() - bench_start;
+        printf("Bench: %d/%d quadros em %.2f s (%.1f quadros/s)\n", frame, Bench_GetFrames(), seconds, frame / seconds);
+        GLStats_Print();
+
+        FrameStatsSummary summary;
+        FrameStats_GetSummary(false, &summary);
+        if ( frame < Bench_GetFrames() )
+            exit_code = 1;
+        else if ( bench_p99_ms > 0.0 && summary.p99 > bench_p99_ms )
+        {
+            fprintf(stderr, "Bench: p99 %.2f ms acima do limite de %.2f ms.\n", summary.p99, bench_p99_ms);
+            exit_code = 2;
+        }
+    }
 
+    // Se a janela for fechada antes, o relatório fica incompleto.
+    Startup_Finish(startup_report_filename.c_str());
+    Residency_PrintStats();
+    TextureStreaming_PrintStats();
+    MemTrack_Print();
+    FrameStats_Print();
+    if ( frame_stats_filename != NULL )
+        FrameStats_Write(frame_stats_filename);
+    HotReload_Shutdown();
+    Jobs_Shutdown();
+    Profiler_Shutdown();
+    Residency_Shutdown();
+    TextureStreaming_Shutdown();
+    AssetPack_Close();
 
     // Finalizamos o uso dos recursos do sistema operacional
     glfwTerminate();
 
     // Fim do programa
-    return 0;
+    return exit_code;
 }
 
-// Função que carrega uma imagem para ser utilizada como textura
-void LoadTextureImage(const char* filename)
+// Função que registra uma imagem de textura sem carregá-la: a unidade de
+// textura é reservada imediatamente, e a imagem é decodificada e enviada para a
+// GPU em segundo plano na primeira vez em que um objeto com "object_id" for
+// desenhado. Veja "residency.h" e "texturestreaming.h".
+void RegisterTextureImage(const char* filename, int object_id)
 {
-    printf("Carregando imagem \"%s\"... ", filename);
+    GLuint textureunit = g_NumLoadedTextures;
+    Residency_RegisterTexture(filename, textureunit, object_id);
 
-    // Primeiro fazemos a leitura da imagem do disco
-    stbi_set_flip_vertically_on_load(true);
-    int width;
-    int height;
-    int channels;
-    unsigned char *data = stbi_load(filename, &width, &height, &channels, 3);
+    g_NumLoadedTextures += 1;
+}
 
-    if ( data == NULL )
-    {
-        fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", filename);
-        std::exit(EXIT_FAILURE);
-    }
+// Função que informa ao fragment shader qual objeto será desenhado, marcando a
+// textura correspondente como utilizada neste quadro.
+void SetObjectId(int object_id)
+{
+    glUniform1i(g_object_id_uniform, object_id);
+    Residency_UseMaterial(object_id);
+}
 
-    printf("OK (%dx%d).\n", width, height);
+// Função que desenha um objeto armazenado em g_VirtualScene. Veja definição
+// dos objetos na função BuildTrianglesAndAddToVirtualScene().
+void DrawVirtualObject(const char* object_name)
+{
+    // Enquanto o modelo não está residente, desenhamos o cubo unitário.
+    if (!Residency_UseObject(object_name))
+        object_name = "cube";
 
-    // Agora criamos objetos na GPU com OpenGL para armazenar a textura
-    GLuint texture_id;
-    GLuint sampler_id;
-    glGenTextures(1, &texture_id);
-    glGenSamplers(1, &sampler_id);
+    // "Ligamos" o VAO. Informamos que queremos utilizar os atributos de
+    // vértices apontados pelo VAO criado pela função BuildTrianglesAndAddToVirtualScene(). Veja
+    // comentários detalhados dentro da definição de BuildTrianglesAndAddToVirtualScene().
+    glBindVertexArray(g_VirtualScene[object_name].vertex_array_object_id);
 
-    // Veja slides 95-96 do documento Aula_20_Mapeamento_de_Texturas.pdf
-    glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // Setamos as variáveis "bbox_min" e "bbox_max" do fragment shader
+    // com os parâmetros da axis-aligned bounding box (AABB) do modelo.
+    glm::vec3 bbox_min = g_VirtualScene[object_name].bbox_min;
+    glm::vec3 bbox_max = g_VirtualScene[object_name].bbox_max;
+    glUniform4f(g_bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
+    glUniform4f(g_bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
+    glUniform4f(g_light_position_uniform, 0.0f, 3.5f, 0.0f, 1.0f);
 
-    // Parâmetros de amostragem da textura.
-    glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Agora enviamos a imagem lida do disco para a GPU
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    // Pedimos para a GPU rasterizar os vértices dos eixos XYZ
+    // apontados pelo VAO como linhas. Veja a definição de
+    // g_VirtualScene[""] dentro da função BuildTrianglesAndAddToVirtualScene(), e veja
+    // a documentação da função glDrawElements() em
+    // http://docs.gl/gl3/glDrawElements.
+    glDrawElements(
+        g_VirtualScene[object_name].rendering_mode,
+        g_VirtualScene[object_name].num_indices,
+        GL_UNSIGNED_INT,
+        (void*)(g_VirtualScene[object_name].first_index * sizeof(GLuint))
+    );
 
-    GLuint textureunit = g_NumLoadedTextures;
-    glActiveTexture(GL_TEXTURE0 + textureunit);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindSampler(textureunit, sampler_id);
+    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
+    // alterar o mesmo. Isso evita bugs.
+    glBindVertexArray(0);
+}
 
-    stbi_image_free(data);
+Entity AddRenderable(TransformGraph* graph, int parent, const Affine& local, int object_id, const char* object_name, RenderPass pass)
+{
+    RenderableComponent renderable;
+    renderable.node = TransformGraph_AddNode(graph, parent, local);
+    renderable.object_id = object_id;
+    renderable.object_name = object_name;
+    renderable.pass = (uint8_t)pass;
+    renderable.visible = true;
+    renderable.bounds_min = glm::vec3(1.0f);    // Até a malha ser carregada (veja UpdateRenderableBounds())
+    renderable.bounds_max = glm::vec3(-1.0f);
+    Entity entity = World_CreateEntity(&g_World);
+    Component_Add(&g_World.renderables, entity, renderable);
+    return entity;
+}
 
-    g_NumLoadedTextures += 1;
+void DrawSceneNode(const TransformGraph& graph, int node, int object_id, const char* object_name)
+{
+    glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(TransformGraph_GetWorld(graph, node)));
+    SetObjectId(object_id);
+    DrawVirtualObject(object_name);
 }
 
-int GetIntersection( float fDst1, float fDst2, glm::vec4 P1, glm::vec4 P2, glm::vec4 &Hit) {
-if ( (fDst1 * fDst2) >= 0.0f) return 0;
-if ( fDst1 == fDst2) return 0;
-Hit = P1 + (P2-P1) * ( -fDst1/(fDst2-fDst1) );
-return 1;
+// Objetos cuja malha ainda não foi carregada (veja "residency.h") não são
+// descartados: são desenhados com o cubo provisório, e é o desenho que pede a
+// malha. Malhas liberadas mantêm a última caixa conhecida.
+void UpdateRenderableBounds()
+{
+    for (size_t i = 0; i < g_World.renderables.data.size(); ++i)
+    {
+        RenderableComponent& renderable = g_World.renderables.data[i];
+        std::map<std::string, SceneObject>::const_iterator it = g_VirtualScene.find(renderable.object_name);
+        if (it == g_VirtualScene.end())
+            continue;
+        renderable.bounds_min = it->second.bbox_min;
+        renderable.bounds_max = it->second.bbox_max;
+    }
 }
 
-int InBox( glm::vec4 Hit, glm::vec4 B1, glm::vec4 B2, const int Axis) {
-if ( Axis==1 && Hit.z > B1.z && Hit.z < B2.z && Hit.y > B1.y && Hit.y < B2.y) return 1;
-if ( Axis==2 && Hit.z > B1.z && Hit.z < B2.z && Hit.x > B1.x && Hit.x < B2.x) return 1;
-if ( Axis==3 && Hit.x > B1.x && Hit.x < B2.x && Hit.y > B1.y && Hit.y < B2.y) return 1;
-return 0;
+void DrawRenderList(const TransformGraph& graph, const std::vector<RenderList>& lists, RenderPass pass)
+{
+    for (size_t l = 0; l < lists.size(); ++l)
+    {
+        const std::vector<uint32_t>& items = lists[l].items[pass];
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            const RenderableComponent& renderable = g_World.renderables.data[items[i]];
+            DrawSceneNode(graph, renderable.node, renderable.object_id, renderable.object_name);
+        }
+    }
 }
 
-// returns true if line (L1, L2) intersects with the box (B1, B2)
-// returns intersection point in Hit
-int CheckLineBox( glm::vec4 B1, glm::vec4 B2, glm::vec4 L1, glm::vec4 vector_view, glm::vec4 &Hit)
+// Grafo de tarefas do quadro. As setas são dependências:
+//
+//   platforms -> collision (em partes)
+//             -> gameplay -> animation (em partes) -> transforms -> cull (em partes)
+//
+// "platforms" escreve as caixas e os nós das plataformas; "gameplay" abre
+// portais, move os objetos carregados e dispara as animações dos eventos; as
+// partes de "animation" avaliam as trilhas; "transforms" escreve os valores
+// nos alvos, move as entidades animadas e atualiza a hierarquia; "cull" monta
+// as listas de desenho. A ordem é a do laço de um só thread que existia antes.
+void AddFrameJobs(FrameJobs* frame)
 {
-    glm::vec4 L2 = 500.0f * vector_view + L1;
-
-if (L2.x < B1.x && L1.x < B1.x) return false;
-if (L2.x > B2.x && L1.x > B2.x) return false;
-if (L2.y < B1.y && L1.y < B1.y) return false;
-if (L2.y > B2.y && L1.y > B2.y) return false;
-if (L2.z < B1.z && L1.z < B1.z) return false;
-if (L2.z > B2.z && L1.z > B2.z) return false;
-if (L1.x > B1.x && L1.x < B2.x &&
-    L1.y > B1.y && L1.y < B2.y &&
-    L1.z > B1.z && L1.z < B2.z)
-    {Hit = L1;
-    return true;}
-if ( (GetIntersection( L1.x-B1.x, L2.x-B1.x, L1, L2, Hit) && InBox( Hit, B1, B2, 1 ))
-  || (GetIntersection( L1.y-B1.y, L2.y-B1.y, L1, L2, Hit) && InBox( Hit, B1, B2, 2 ))
-  || (GetIntersection( L1.z-B1.z, L2.z-B1.z, L1, L2, Hit) && InBox( Hit, B1, B2, 3 ))
-  || (GetIntersection( L1.x-B2.x, L2.x-B2.x, L1, L2, Hit) && InBox( Hit, B1, B2, 1 ))
-  || (GetIntersection( L1.y-B2.y, L2.y-B2.y, L1, L2, Hit) && InBox( Hit, B1, B2, 2 ))
-  || (GetIntersection( L1.z-B2.z, L2.z-B2.z, L1, L2, Hit) && InBox( Hit, B1, B2, 3 )))
-	return true;
-
-return false;
+    // O nó da câmera (pai do cubo carregado) é atualizado aqui, antes de
+    // qualquer tarefa existir: assim todas, a começar por "gameplay", que
+    // prende o cubo carregado nele, já veem a câmera deste quadro. SetLocal()
+    // ignora transformações iguais às atuais.
+    TransformGraph_SetLocal(frame->graph, frame->node_camera, Affine_Inverse(Affine_FromMat4(frame->view)));
+
+    JobId platforms = JOB_NONE;
+    if ( !frame->stress->platforms.empty() )
+        platforms = Jobs_Add("platforms", PlatformsJob, frame);
+
+    frame->blocked = false;
+    frame->collision = Jobs_AddParallel("collision", CollisionJob, frame, g_World.colliders.data.size(), COLLISION_JOB_BATCH,
+                                        &platforms, 1);
+
+    JobId gameplay = Jobs_Add("gameplay", GameplayJob, frame, &platforms, 1);
+
+    // As trilhas em execução só são conhecidas depois de "gameplay"; as
+    // partes cobrem todas as trilhas e as que passam do fim não fazem nada.
+    JobId animation = Jobs_AddParallel("animation", AnimationJob, frame, frame->animations->track_slot.size(), ANIMATION_JOB_BATCH,
+                                       &gameplay, 1);
+    JobId transforms = Jobs_Add("transforms", TransformsJob, frame, &animation, 1);
+
+    size_t renderables = g_World.renderables.data.size();
+    frame->render_lists.resize((renderables + CULL_JOB_BATCH - 1) / CULL_JOB_BATCH);
+    frame->cull = Jobs_AddParallel("cull", CullJob, frame, renderables, CULL_JOB_BATCH, &transforms, 1);
 }
 
-bool detectColision(glm::vec4 position, glm::vec4 hitbox_min, glm::vec4 hitbox_max)
+void PlatformsJob(void* data, size_t begin, size_t end)
 {
-    if (position.x < hitbox_min.x || position.x > hitbox_max.x)
-        return false; // No collision along X-axis
+    FrameJobs* frame = (FrameJobs*)data;
+    StressScene* stress = frame->stress;
+    const glm::quat noRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 
-    if (position.y < hitbox_min.y || position.y > hitbox_max.y)
-        return false; // No collision along Y-axis
+    StressScene_Update(stress, frame->time);
+    for (size_t i = 0; i < stress->platforms.size(); ++i)
+    {
+        const StressPlatform& platform = stress->platforms[i];
+        Component_Get(g_World.colliders, (*frame->stress_colliders)[platform.collider])->box = stress->colliders[platform.collider];
 
-    if (position.z < hitbox_min.z || position.z > hitbox_max.z)
-        return false; // No collision along Z-axis
+        const StressObject& object = stress->objects[platform.object];
+        TransformComponent* transform = Component_Get(g_World.transforms, (*frame->stress_platforms)[i]);
+        transform->position = object.position;
+        TransformGraph_SetLocal(frame->graph, transform->node, Affine_MakeTRS(object.position, noRotation, object.scale));
+    }
+}
 
-    return true;
+void CollisionJob(void* data, size_t begin, size_t end)
+{
+    FrameJobs* frame = (FrameJobs*)data;
+    if ( Ecs_CameraBlockedRange(g_World, frame->camera, begin, end) )
+        frame->blocked = true;
+}
+
+void GameplayJob(void* data, size_t begin, size_t end)
+{
+    FrameJobs* frame = (FrameJobs*)data;
+    Ecs_ShootPortals(&g_World, frame->camera, frame->view_vector, frame->buttons, frame->time, height);
+
+    // O cubo carregado acompanha a câmera, e o que foi solto cai no chão
+    // (ou no botão).
+    Ecs_UpdatePickups(&g_World, frame->graph, frame->camera, -height/2 + 1);
 
-    /*for (std::map<std::string, SceneObject>::iterator it = g_VirtualScene.begin(); it != g_VirtualScene.end(); it++)
+    // Eventos disparados pelos sistemas (portais abertos, o cubo no
+    // botão): animações e as superfícies de portal que a fase libera.
+    Ecs_TakeEvents(&g_World, &frame->events);
+    for (size_t i = 0; i < frame->events.size(); ++i)
     {
-        SceneObject obj = it->second;
-        printf("\n%s: ", ((std::string)it->first).c_str());
-        printf("bboxmin x:%f y:%f z:%f ", obj.bbox_min.x, obj.bbox_min.y, obj.bbox_min.z);
-        printf("bboxmax x:%f y:%f z:%f ", obj.bbox_max.x, obj.bbox_max.y, obj.bbox_max.z);
-    }*/
+        Animation_Trigger(frame->animations, frame->events[i], frame->time);
+        AddLevelPortalSurfaces(*frame->level, frame->events[i]);
+    }
+
+    frame->pickup_near = Ecs_FindPickupNear(g_World, frame->camera) != ECS_NO_ENTITY;
+    Animation_BeginUpdate(frame->animations);
 }
 
-double boxAngle(glm::vec4 B1, glm::vec4 B2)
+void AnimationJob(void* data, size_t begin, size_t end)
 {
-    return atan2(B2.y - B1.y, B2.x - B1.x);
+    FrameJobs* frame = (FrameJobs*)data;
+    Animation_EvaluateRange(frame->animations, frame->time, begin, end);
 }
 
-int factorial(int n)
+void TransformsJob(void* data, size_t begin, size_t end)
 {
-    int f = 1;
-    for (int i=1; i<=n; ++i)
-        f *= i;
-    return f;
+    FrameJobs* frame = (FrameJobs*)data;
+    Animation_EndUpdate(frame->animations);
+
+    // Só os nós que mudaram neste quadro são recalculados.
+    Ecs_UpdateMovers(&g_World, frame->animations);
+    Animation_Apply(frame->animations, frame->graph);
+    TransformGraph_Update(frame->graph);
 }
 
-float Bernstein(float k, float n, float t)
+void CullJob(void* data, size_t begin, size_t end)
 {
-    return (factorial(n) / (factorial(k) * factorial(n-k)))*pow(t, k)*pow(1-t, n-k);
+    FrameJobs* frame = (FrameJobs*)data;
+    Ecs_BuildRenderList(g_World, *frame->graph, frame->view_projection, begin, end,
+                        &frame->render_lists[begin / CULL_JOB_BATCH]);
 }
 
-glm::vec3 bezierCurve(std::vector<glm::vec3> points, float time)
+// Cria um nó para cada objeto da fase em [first, first + count), com a matriz
+// de modelagem já calculada pelo compilador de fases, e dá à entidade do
+// objeto ("entities", pelo índice na fase) a posição e o desenho.
+void AddLevelPlacements(const Level& level, size_t first, size_t count, TransformGraph* graph, const std::vector<Entity>& entities)
 {
-    glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
-
-    for(int i=0; i<points.size(); i++)
+    for (size_t i = first; i < first + count; ++i)
     {
-        position+=Bernstein(i, points.size(), time) * points.at(i);
+        const LevelPlacement& placement = level.placements[i];
+        RenderableComponent renderable;
+        renderable.node = TransformGraph_AddNode(graph, TRANSFORM_ROOT, placement.local);
+        renderable.object_id = placement.object_id;
+        renderable.object_name = Level_String(level, placement.mesh);
+        renderable.pass = RENDER_SCENE;
+        renderable.visible = true;
+        renderable.bounds_min = glm::vec3(1.0f);
+        renderable.bounds_max = glm::vec3(-1.0f);
+        Component_Add(&g_World.renderables, entities[i], renderable);
+
+        TransformComponent transform;
+        transform.position = glm::vec3(placement.translation[0], placement.translation[1], placement.translation[2]);
+        transform.node = renderable.node;
+        Component_Add(&g_World.transforms, entities[i], transform);
     }
+}
 
-    return position;
+// Cria um alvo de animação para cada objeto da fase que tem trilhas, com a
+// pose do arquivo, e as trilhas. A posição da entidade passa a vir do alvo.
+void AddLevelAnimations(const Level& level, const std::vector<Entity>& entities, AnimationSystem* animations)
+{
+    for (size_t i = 0; i < level.track_count; ++i)
+    {
+        const LevelTrack& track = level.tracks[i];
+        const LevelPlacement& placement = level.placements[track.placement];
+        Entity entity = entities[track.placement];
+        AnimationComponent* animation = Component_Get(g_World.animations, entity);
+        if ( animation == NULL )
+        {
+            glm::quat rotation(placement.rotation[3], placement.rotation[0], placement.rotation[1], placement.rotation[2]);
+            AnimationComponent added;
+            added.target = Animation_AddTarget(animations, Component_Get(g_World.transforms, entity)->node,
+                                               glm::vec3(placement.translation[0], placement.translation[1], placement.translation[2]),
+                                               rotation,
+                                               glm::vec3(placement.scale[0], placement.scale[1], placement.scale[2]),
+                                               (placement.flags & LEVEL_TSR) != 0);
+            animation = Component_Add(&g_World.animations, entity, added);
+        }
+        Animation_AddTrack(animations, Level_String(level, track.event), animation->target, (AnimationChannel)track.channel,
+                           (AnimationInterp)track.interp, (AnimationLoop)track.loop,
+                           level.key_times + track.first_key, level.key_values + track.first_key, (int)track.key_count);
+    }
 }
 
-// Função que desenha um objeto armazenado em g_VirtualScene. Veja definição
-// dos objetos na função BuildTrianglesAndAddToVirtualScene().
-void DrawVirtualObject(const char* object_name)
+// Caixas de colisão, gatilhos ativados pela câmera e marcadores que disparam
+// eventos, que viram gatilhos ativados pelo cubo solto perto deles (o botão).
+// "exit" recebe a entidade do gatilho "exit".
+void AddLevelGameplay(const Level& level, Entity* exit)
 {
-    // "Ligamos" o VAO. Informamos que queremos utilizar os atributos de
-    // vértices apontados pelo VAO criado pela função BuildTrianglesAndAddToVirtualScene(). Veja
-    // comentários detalhados dentro da definição de BuildTrianglesAndAddToVirtualScene().
-    glBindVertexArray(g_VirtualScene[object_name].vertex_array_object_id);
+    for (size_t i = 0; i < level.collider_count; ++i)
+    {
+        ColliderComponent collider = { level.colliders[i] };
+        Component_Add(&g_World.colliders, World_CreateEntity(&g_World), collider);
+    }
 
-    // Setamos as variáveis "bbox_min" e "bbox_max" do fragment shader
-    // com os parâmetros da axis-aligned bounding box (AABB) do modelo.
-    glm::vec3 bbox_min = g_VirtualScene[object_name].bbox_min;
-    glm::vec3 bbox_max = g_VirtualScene[object_name].bbox_max;
-    glUniform4f(g_bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
-    glUniform4f(g_bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
-    glUniform4f(g_light_position_uniform, 0.0f, 3.5f, 0.0f, 1.0f);
+    for (size_t i = 0; i < level.trigger_count; ++i)
+    {
+        const LevelTrigger& source = level.triggers[i];
+        TriggerComponent trigger = TriggerComponent();
+        trigger.bbox_min = glm::vec4(source.bbox_min[0], source.bbox_min[1], source.bbox_min[2], 0.0f);
+        trigger.bbox_max = glm::vec4(source.bbox_max[0], source.bbox_max[1], source.bbox_max[2], 0.0f);
+        trigger.after = Level_String(level, source.after);
+        trigger.activator = TRIGGER_CAMERA;
+        trigger.armed = trigger.after == NULL;
+        Entity entity = World_CreateEntity(&g_World);
+        Component_Add(&g_World.triggers, entity, trigger);
+        if ( strcmp(Level_String(level, source.name), "exit") == 0 )
+            *exit = entity;
+    }
 
+    // O cubo fica em cima do botão, um pouco à frente do centro.
+    for (size_t i = 0; i < level.marker_count; ++i)
+    {
+        const LevelMarker& marker = level.markers[i];
+        if ( marker.event == LEVEL_NONE )
+            continue;
+        TriggerComponent trigger = TriggerComponent();
+        trigger.position = glm::vec4(marker.position[0], marker.position[1], marker.position[2], 1.0f);
+        trigger.snap = glm::vec3(trigger.position) + glm::vec3(0.0f, 1.25f, 0.8f);
+        trigger.event = Level_String(level, marker.event);
+        trigger.activator = TRIGGER_PICKUP;
+        trigger.armed = true;
+        Component_Add(&g_World.triggers, World_CreateEntity(&g_World), trigger);
+    }
+}
 
-    // Pedimos para a GPU rasterizar os vértices dos eixos XYZ
-    // apontados pelo VAO como linhas. Veja a definição de
-    // g_VirtualScene[""] dentro da função BuildTrianglesAndAddToVirtualScene(), e veja
-    // a documentação da função glDrawElements() em
-    // http://docs.gl/gl3/glDrawElements.
-    glDrawElements(
-        g_VirtualScene[object_name].rendering_mode,
-        g_VirtualScene[object_name].num_indices,
-        GL_UNSIGNED_INT,
-        (void*)(g_VirtualScene[object_name].first_index * sizeof(GLuint))
-    );
+// Cada objeto tem um nó próprio, usado quando está no chão; carregado, ele é
+// desenhado no nó preso à câmera (g_World.held_node). A origem do modelo do
+// cubo fica 3 unidades atrás do seu centro.
+void AddLevelPickups(const Level& level, TransformGraph* graph)
+{
+    for (size_t i = 0; i < level.pickup_count; ++i)
+    {
+        const LevelPickup& source = level.pickups[i];
+        Entity entity = AddRenderable(graph, TRANSFORM_ROOT, Affine_Identity(), source.object_id, Level_String(level, source.mesh));
+
+        TransformComponent transform;
+        transform.position = glm::vec3(source.position[0], source.position[1], source.position[2]);
+        transform.node = Component_Get(g_World.renderables, entity)->node;
+        Component_Add(&g_World.transforms, entity, transform);
+
+        PickupComponent pickup;
+        pickup.model_offset = glm::vec3(0.0f, 0.0f, 3.0f);
+        pickup.held = false;
+        pickup.dropped = false;
+        Component_Add(&g_World.pickups, entity, pickup);
+    }
+}
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
-    glBindVertexArray(0);
+void AddLevelPortalSurfaces(const Level& level, const char* event)
+{
+    BBoxList surfaces;
+    Level_AppendPortalSurfaces(level, event, &surfaces);
+    for (size_t i = 0; i < surfaces.size(); ++i)
+    {
+        PortalSurfaceComponent surface = PortalSurfaceComponent();
+        surface.box = surfaces[i];
+        surface.follow = ECS_NO_ENTITY;
+        Component_Add(&g_World.portal_surfaces, World_CreateEntity(&g_World), surface);
+    }
 }
 
 // Função que carrega os shaders de vértices e de fragmentos que serão
 // utilizados para renderização. Veja slides 180-200 do documento Aula_03_Rendering_Pipeline_Grafico.pdf.
 //
-void LoadShadersFromFiles()
+bool LoadShadersFromFiles()
 {
     // Note que o caminho para os arquivos "shader_vertex.glsl" e
     // "shader_fragment.glsl" estão fixados, sendo que assumimos a existência
@@ -1390,15 +1488,46 @@ void LoadShadersFromFiles()
     //       |
     //       o-- shader_fragment.glsl
     //
-    GLuint vertex_shader_id = LoadShader_Vertex("../../src/shader_vertex.glsl");
-    GLuint fragment_shader_id = LoadShader_Fragment("../../src/shader_fragment.glsl");
+    std::vector<std::string> sources;
+    sources.push_back(ReadShaderFile("src/shader_vertex.glsl"));
+    sources.push_back(ReadShaderFile("src/shader_fragment.glsl"));
+
+    // Se o mesmo código já foi compilado antes com este driver, carregamos o
+    // programa linkado do disco (veja "programcache.h").
+    GLint vertex_ok = GL_TRUE, fragment_ok = GL_TRUE, linked_ok;
+    GLuint program_id = ProgramCache_Load(sources);
+    if ( program_id == 0 )
+    {
+        GLuint vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
+        CompileShader("src/shader_vertex.glsl", sources[0], vertex_shader_id);
+        GLuint fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+        CompileShader("src/shader_fragment.glsl", sources[1], fragment_shader_id);
+
+        glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &vertex_ok);
+        glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &fragment_ok);
+
+        // Criamos um programa de GPU utilizando os shaders carregados acima.
+        program_id = CreateGpuProgram(vertex_shader_id, fragment_shader_id);
+
+        if ( vertex_ok && fragment_ok )
+            ProgramCache_Store(program_id, sources);
+    }
+    glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
+
+    // Ao recarregar (tecla R ou arquivo alterado), mantemos o programa
+    // anterior caso a nova versão não compile.
+    if ( (!vertex_ok || !fragment_ok || !linked_ok) && g_GpuProgramID != 0 )
+    {
+        fprintf(stderr, "ERROR: Keeping previous shaders.\n");
+        glDeleteProgram(program_id);
+        return false;
+    }
 
     // Deletamos o programa de GPU anterior, caso ele exista.
     if ( g_GpuProgramID != 0 )
         glDeleteProgram(g_GpuProgramID);
 
-    // Criamos um programa de GPU utilizando os shaders carregados acima.
-    g_GpuProgramID = CreateGpuProgram(vertex_shader_id, fragment_shader_id);
+    g_GpuProgramID = program_id;
 
     // Buscamos o endereço das variáveis definidas dentro do Vertex Shader.
     // Utilizaremos estas variáveis para enviar dados para a placa de vídeo
@@ -1425,11 +1554,136 @@ void LoadShadersFromFiles()
     glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureGate"), 9);
 
     glUseProgram(0);
+    return true;
 }
+
+// Função chamada no início de cada quadro, que recarrega os arquivos alterados
+// no disco (veja "hotreload.h"). Shaders são recompilados aqui mesmo, enquanto
+// texturas e modelos são lidos em segundo plano e substituídos dentro de
+// Residency_Update().
+void ReloadChangedFiles()
+{
+    std::vector<std::string> files;
+    HotReload_PollChanges(&files);
+
+    bool shaders_changed = false;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const std::string& file = files[i];
+        if (file.size() > 5 && file.compare(file.size() - 5, 5, ".glsl") == 0)
+            shaders_changed = true;
+        else
+            Residency_Reload(file);
+    }
+
+    if (shaders_changed && LoadShadersFromFiles())
+    {
+        FrameStats_Annotate("shader reload");
+        fprintf(stdout,"Shaders recarregados!\n");
+        fflush(stdout);
+    }
+}
+
+// Inicia a gravação dos próximos g_TraceFrames quadros (veja "trace.h"). O
+// arquivo recebe a data e hora no nome para não sobrescrever gravações antigas.
+void StartTraceCapture()
+{
+    if (Trace_IsCapturing())
+        return;
+
+    char name[64];
+    time_t now = time(NULL);
+    strftime(name, sizeof(name), "/trace_%Y%m%d_%H%M%S.json", localtime(&now));
+
+    std::string filename = AssetPack_ExecutableDirectory() + name;
+    Trace_StartCapture(g_TraceFrames, filename.c_str());
+    fprintf(stdout, "Gravando %d quadros em \"%s\".\n", g_TraceFrames, filename.c_str());
+    fflush(stdout);
+}
+
+// Pega o cubo mais próximo da câmera, ou solta o que está sendo carregado
+// (tecla E).
+void ToggleHoldBox()
+{
+    Ecs_TogglePickup(&g_World, camera_position_c);
+}
+
+// Aplica a entrada do roteiro de benchmark (veja "bench.h") no quadro
+// "frame": a posição e a direção da câmera são definidas diretamente, e os
+// cliques e a tecla E são simulados.
+void ApplyBenchInput(int frame)
+{
+    BenchInput input;
+    Bench_GetInput(frame, &input);
+
+    glm::vec4 cube = glm::vec4(Component_Get(g_World.transforms, g_MovingCube)->position, 0.0f);
+
+    camera_position_c = input.position;
+    if (input.follow_cube)
+        camera_position_c += glm::vec4(cube.x, 0.0f, cube.z, 0.0f);
+    isLookAt = false;
+
+    glm::vec4 target = input.look_at;
+    if (input.aim_at_cube)
+        target += cube;
+
+    // Inverso das coordenadas esféricas usadas para calcular
+    // camera_view_vector no laço principal.
+    glm::vec4 d = target - camera_position_c;
+    d.w = 0.0f;
+    d = d / norm(d);
+    g_CameraPhi   = asin(-d.y);
+    g_CameraTheta = atan2(-d.x, -d.z);
+
+    g_LeftMouseButtonPressed  = input.left_click;
+    g_RightMouseButtonPressed = input.right_click;
+    if (input.use)
+        ToggleHoldBox();
+}
+
+// Grava o evento de entrada, se houver gravação em andamento (veja
+// "inputreplay.h"), e indica se a callback deve processá-lo: durante a
+// reprodução somente os eventos vindos do arquivo são processados.
+bool AcceptInputEvent(uint32_t type, int a, int b, int c, int d, double x, double y)
+{
+    if (InputReplay_IsActive())
+        return g_ReplayEvent != NULL;
+
+    InputEvent event = InputEvent();
+    event.frame = g_InputFrame;
+    event.type  = type;
+    event.a = a;
+    event.b = b;
+    event.c = c;
+    event.d = d;
+    event.x = x;
+    event.y = y;
+    InputRecord_Event(event);
+    return true;
+}
+
+// Entrega às callbacks os eventos gravados para o quadro "frame", como se
+// tivessem vindo de glfwPollEvents() no fim do quadro anterior.
+void ReplayInput(GLFWwindow* window, uint32_t frame)
+{
+    InputEvent event;
+    while (InputReplay_Next(frame, &event))
+    {
+        g_ReplayEvent = &event;
+        if (event.type == INPUT_KEY)
+            KeyCallback(window, event.a, event.b, event.c, event.d);
+        else if (event.type == INPUT_MOUSE_BUTTON)
+            MouseButtonCallback(window, event.a, event.c, event.d);
+        else if (event.type == INPUT_CURSOR_POS)
+            CursorPosCallback(window, event.x, event.y);
+        g_ReplayEvent = NULL;
+    }
+}
+
 void LoadGouraudShadersFromFiles()
 {
-    GLuint vertex_shader_id = LoadShader_Vertex("../../src/gouraud_vertex.glsl");
-    GLuint fragment_shader_id = LoadShader_Fragment("../../src/gouraud_fragment.glsl");
+    GLuint vertex_shader_id = LoadShader_Vertex("src/gouraud_vertex.glsl");
+    GLuint fragment_shader_id = LoadShader_Fragment("src/gouraud_fragment.glsl");
 
     // Deletamos o programa de GPU anterior, caso ele exista.
     if ( g_GpuProgramID != 0 )
@@ -1460,182 +1714,47 @@ void LoadGouraudShadersFromFiles()
     glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureButton"), 7);
     glUseProgram(0);
 }
-// Função que pega a matriz M e guarda a mesma no topo da pilha
-void PushMatrix(glm::mat4 M)
+// Constrói triângulos para futura renderização a partir de um ObjModel.
+void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
 {
-    g_MatrixStack.push(M);
+    MeshData mesh;
+    BuildMeshData(model, &mesh);
+    UploadMeshData(&mesh);
 }
 
-// Função que remove a matriz atualmente no topo da pilha e armazena a mesma na variável M
-void PopMatrix(glm::mat4& M)
+// Envia para a GPU os atributos de vértices construídos por BuildMeshData() e
+// insere os objetos correspondentes em g_VirtualScene.
+GpuMesh UploadMeshData(MeshData* mesh)
 {
-    if ( g_MatrixStack.empty() )
-    {
-        M = Matrix_Identity();
-    }
-    else
-    {
-        M = g_MatrixStack.top();
-        g_MatrixStack.pop();
-    }
-}
-
-// Função que computa as normais de um ObjModel, caso elas não tenham sido
-// especificadas dentro do arquivo ".obj"
-void ComputeNormals(ObjModel* model)
-{
-    if ( !model->attrib.normals.empty() )
-        return;
+    TRACE_SCOPE("UploadMeshData");
+    FrameStats_Annotate("mesh upload");
 
-    // Primeiro computamos as normais para todos os TRIÂNGULOS.
-    // Segundo, computamos as normais dos VÉRTICES através do método proposto
-    // por Gouraud, onde a normal de cada vértice vai ser a média das normais de
-    // todas as faces que compartilham este vértice.
+    GpuMesh gpumesh;
+    gpumesh.num_buffers = 0;
+    gpumesh.bytes = mesh->SizeInBytes();
+    MemTrack_GpuAlloc(MEM_MESHES, gpumesh.bytes);
 
-    size_t num_vertices = model->attrib.vertices.size() / 3;
-
-    std::vector<int> num_triangles_per_vertex(num_vertices, 0);
-    std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f,0.0f,0.0f,0.0f));
-
-    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
-    {
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
-
-        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
-        {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
-
-            glm::vec4  vertices[3];
-            for (size_t vertex = 0; vertex < 3; ++vertex)
-            {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
-                vertices[vertex] = glm::vec4(vx,vy,vz,1.0);
-            }
-
-            const glm::vec4  a = vertices[0];
-            const glm::vec4  b = vertices[1];
-            const glm::vec4  c = vertices[2];
-
-            const glm::vec4  n = crossproduct(b-a,c-a);
-
-            for (size_t vertex = 0; vertex < 3; ++vertex)
-            {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                num_triangles_per_vertex[idx.vertex_index] += 1;
-                vertex_normals[idx.vertex_index] += n;
-                model->shapes[shape].mesh.indices[3*triangle + vertex].normal_index = idx.vertex_index;
-            }
-        }
-    }
-
-    model->attrib.normals.resize( 3*num_vertices );
-
-    for (size_t i = 0; i < vertex_normals.size(); ++i)
-    {
-        glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
-        n /= norm(n);
-        model->attrib.normals[3*i + 0] = n.x;
-        model->attrib.normals[3*i + 1] = n.y;
-        model->attrib.normals[3*i + 2] = n.z;
-    }
-}
-
-// Constrói triângulos para futura renderização a partir de um ObjModel.
-void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
-{
     GLuint vertex_array_object_id;
     glGenVertexArrays(1, &vertex_array_object_id);
     glBindVertexArray(vertex_array_object_id);
+    gpumesh.vertex_array_object_id = vertex_array_object_id;
 
-    std::vector<GLuint> indices;
-    std::vector<float>  model_coefficients;
-    std::vector<float>  normal_coefficients;
-    std::vector<float>  texture_coefficients;
+    const std::vector<GLuint>& indices              = mesh->indices;
+    const std::vector<float>&  model_coefficients   = mesh->model_coefficients;
+    const std::vector<float>&  normal_coefficients  = mesh->normal_coefficients;
+    const std::vector<float>&  texture_coefficients = mesh->texture_coefficients;
 
-    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    for (size_t i = 0; i < mesh->objects.size(); ++i)
     {
-        size_t first_index = indices.size();
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
-
-        const float minval = std::numeric_limits<float>::min();
-        const float maxval = std::numeric_limits<float>::max();
-
-        glm::vec3 bbox_min = glm::vec3(maxval,maxval,maxval);
-        glm::vec3 bbox_max = glm::vec3(minval,minval,minval);
-
-        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
-        {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
-
-            for (size_t vertex = 0; vertex < 3; ++vertex)
-            {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-
-                indices.push_back(first_index + 3*triangle + vertex);
-
-                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
-                //printf("tri %d vert %d = (%.2f, %.2f, %.2f)\n", (int)triangle, (int)vertex, vx, vy, vz);
-                model_coefficients.push_back( vx ); // X
-                model_coefficients.push_back( vy ); // Y
-                model_coefficients.push_back( vz ); // Z
-                model_coefficients.push_back( 1.0f ); // W
-
-                bbox_min.x = std::min(bbox_min.x, vx);
-                bbox_min.y = std::min(bbox_min.y, vy);
-                bbox_min.z = std::min(bbox_min.z, vz);
-                bbox_max.x = std::max(bbox_max.x, vx);
-                bbox_max.y = std::max(bbox_max.y, vy);
-                bbox_max.z = std::max(bbox_max.z, vz);
-
-                // Inspecionando o código da tinyobjloader, o aluno Bernardo
-                // Sulzbach (2017/1) apontou que a maneira correta de testar se
-                // existem normais e coordenadas de textura no ObjModel é
-                // comparando se o índice retornado é -1. Fazemos isso abaixo.
-
-                if ( idx.normal_index != -1 )
-                {
-                    const float nx = model->attrib.normals[3*idx.normal_index + 0];
-                    const float ny = model->attrib.normals[3*idx.normal_index + 1];
-                    const float nz = model->attrib.normals[3*idx.normal_index + 2];
-                    normal_coefficients.push_back( nx ); // X
-                    normal_coefficients.push_back( ny ); // Y
-                    normal_coefficients.push_back( nz ); // Z
-                    normal_coefficients.push_back( 0.0f ); // W
-                }
-
-                if ( idx.texcoord_index != -1 )
-                {
-                    const float u = model->attrib.texcoords[2*idx.texcoord_index + 0];
-                    const float v = model->attrib.texcoords[2*idx.texcoord_index + 1];
-                    texture_coefficients.push_back( u );
-                    texture_coefficients.push_back( v );
-                }
-            }
-        }
-
-        size_t last_index = indices.size() - 1;
-
-        SceneObject theobject;
-        theobject.name           = model->shapes[shape].name;
-        theobject.first_index    = first_index; // Primeiro índice
-        theobject.num_indices    = last_index - first_index + 1; // Número de indices
-        theobject.rendering_mode = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
+        SceneObject theobject = mesh->objects[i];
         theobject.vertex_array_object_id = vertex_array_object_id;
-
-        theobject.bbox_min = bbox_min;
-        theobject.bbox_max = bbox_max;
-
-        g_VirtualScene[model->shapes[shape].name] = theobject;
+        g_VirtualScene[theobject.name] = theobject;
     }
 
     GLuint VBO_model_coefficients_id;
     glGenBuffers(1, &VBO_model_coefficients_id);
     glBindBuffer(GL_ARRAY_BUFFER, VBO_model_coefficients_id);
+    gpumesh.buffers[gpumesh.num_buffers++] = VBO_model_coefficients_id;
     glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
     glBufferSubData(GL_ARRAY_BUFFER, 0, model_coefficients.size() * sizeof(float), model_coefficients.data());
     GLuint location = 0; // "(location = 0)" em "shader_vertex.glsl"
@@ -1649,6 +1768,7 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
         GLuint VBO_normal_coefficients_id;
         glGenBuffers(1, &VBO_normal_coefficients_id);
         glBindBuffer(GL_ARRAY_BUFFER, VBO_normal_coefficients_id);
+        gpumesh.buffers[gpumesh.num_buffers++] = VBO_normal_coefficients_id;
         glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
         glBufferSubData(GL_ARRAY_BUFFER, 0, normal_coefficients.size() * sizeof(float), normal_coefficients.data());
         location = 1; // "(location = 1)" em "shader_vertex.glsl"
@@ -1663,6 +1783,7 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
         GLuint VBO_texture_coefficients_id;
         glGenBuffers(1, &VBO_texture_coefficients_id);
         glBindBuffer(GL_ARRAY_BUFFER, VBO_texture_coefficients_id);
+        gpumesh.buffers[gpumesh.num_buffers++] = VBO_texture_coefficients_id;
         glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
         glBufferSubData(GL_ARRAY_BUFFER, 0, texture_coefficients.size() * sizeof(float), texture_coefficients.data());
         location = 2; // "(location = 1)" em "shader_vertex.glsl"
@@ -1674,6 +1795,7 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
 
     GLuint indices_id;
     glGenBuffers(1, &indices_id);
+    gpumesh.buffers[gpumesh.num_buffers++] = indices_id;
 
     // "Ligamos" o buffer. Note que o tipo agora é GL_ELEMENT_ARRAY_BUFFER.
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
@@ -1685,6 +1807,8 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
     // "Desligamos" o VAO, evitando assim que operações posteriores venham a
     // alterar o mesmo. Isso evita bugs.
     glBindVertexArray(0);
+
+    return gpumesh;
 }
 
 void BuildTrianglesAndAddToVirtualScene2(char* name, std::vector<GLuint>* indices, std::vector<float>* model_coefficients, std::vector<float>* normal_coefficients, GLenum rendering_mode)
@@ -1759,6 +1883,9 @@ void BuildTrianglesAndAddToVirtualScene2(char* name, std::vector<GLuint>* indice
     // "Desligamos" o VAO, evitando assim que operações posteriores venham a
     // alterar o mesmo. Isso evita bugs.
     glBindVertexArray(0);
+
+    MemTrack_GpuAlloc(MEM_MESHES, (model_coefficients->size() + normal_coefficients->size()) * sizeof(float)
+                                  + indices->size() * sizeof(GLuint));
 }
 
 void BuildAim()
@@ -2008,20 +2135,28 @@ GLuint LoadShader_Fragment(const char* filename)
 // um arquivo GLSL e faz sua compilação.
 void LoadShader(const char* filename, GLuint shader_id)
 {
-    // Lemos o arquivo de texto indicado pela variável "filename"
-    // e colocamos seu conteúdo em memória, apontado pela variável
-    // "shader_string".
-    std::ifstream file;
-    try {
-        file.exceptions(std::ifstream::failbit);
-        file.open(filename);
-    } catch ( std::exception& e ) {
+    CompileShader(filename, ReadShaderFile(filename), shader_id);
+}
+
+// Lê o arquivo de texto indicado pela variável "filename" (do pacote ou do
+// disco, veja "assetpack.h") e retorna seu conteúdo.
+std::string ReadShaderFile(const char* filename)
+{
+    AssetBlob blob;
+    if ( !AssetPack_Load(filename, &blob) )
+    {
         fprintf(stderr, "ERROR: Cannot open file \"%s\".\n", filename);
         std::exit(EXIT_FAILURE);
     }
-    std::stringstream shader;
-    shader << file.rdbuf();
-    std::string str = shader.str();
+    std::string shader((const char*)blob.data, blob.size);
+    AssetPack_Free(&blob);
+    return shader;
+}
+
+// Compila o código GLSL "str", lido do arquivo "filename" (utilizado somente
+// nas mensagens de erro).
+void CompileShader(const char* filename, const std::string& str, GLuint shader_id)
+{
     const GLchar* shader_string = str.c_str();
     const GLint   shader_string_length = static_cast<GLint>( str.length() );
 
@@ -2080,6 +2215,7 @@ GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id)
 {
     // Criamos um identificador (ID) para este programa de GPU
     GLuint program_id = glCreateProgram();
+    ProgramCache_PrepareForLink(program_id);
 
     // Definição dos dois shaders GLSL que devem ser executados pelo programa
     glAttachShader(program_id, vertex_shader_id);
@@ -2144,6 +2280,12 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
     // O cast para float é necessário pois números inteiros são arredondados ao
     // serem divididos!
     g_ScreenRatio = (float)width / height;
+
+    // O texto é posicionado em coordenadas de tela, que podem ser diferentes
+    // das do framebuffer (por exemplo em telas "Retina").
+    int window_width, window_height;
+    glfwGetWindowSize(window, &window_width, &window_height);
+    TextRendering_SetWindowSize(window_width, window_height);
 }
 
 // Variáveis globais que armazenam a última posição do cursor do mouse, para
@@ -2154,6 +2296,18 @@ double g_LastCursorPosX, g_LastCursorPosY;
 // Função callback chamada sempre que o usuário aperta algum dos botões do mouse
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
+    // A posição do cursor é gravada junto com o clique, e na reprodução vem
+    // do arquivo em vez da GLFW.
+    double cursor_x, cursor_y;
+    glfwGetCursorPos(window, &cursor_x, &cursor_y);
+    if (!AcceptInputEvent(INPUT_MOUSE_BUTTON, button, 0, action, mods, cursor_x, cursor_y))
+        return;
+    if (g_ReplayEvent != NULL)
+    {
+        cursor_x = g_ReplayEvent->x;
+        cursor_y = g_ReplayEvent->y;
+    }
+
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
     {
         // Se o usuário pressionou o botão esquerdo do mouse, guardamos a
@@ -2161,7 +2315,8 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
         // g_LastCursorPosY.  Também, setamos a variável
         // g_LeftMouseButtonPressed como true, para saber que o usuário está
         // com o botão esquerdo pressionado.
-        glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
+        g_LastCursorPosX = cursor_x;
+        g_LastCursorPosY = cursor_y;
         g_LeftMouseButtonPressed = true;
     }
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE)
@@ -2177,7 +2332,8 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
         // g_LastCursorPosY.  Também, setamos a variável
         // g_RightMouseButtonPressed como true, para saber que o usuário está
         // com o botão esquerdo pressionado.
-        glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
+        g_LastCursorPosX = cursor_x;
+        g_LastCursorPosY = cursor_y;
         g_RightMouseButtonPressed = true;
     }
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE)
@@ -2193,7 +2349,8 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
         // g_LastCursorPosY.  Também, setamos a variável
         // g_MiddleMouseButtonPressed como true, para saber que o usuário está
         // com o botão esquerdo pressionado.
-        glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
+        g_LastCursorPosX = cursor_x;
+        g_LastCursorPosY = cursor_y;
         g_MiddleMouseButtonPressed = true;
     }
     if (button == GLFW_MOUSE_BUTTON_MIDDLE && action == GLFW_RELEASE)
@@ -2208,12 +2365,20 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 // cima da janela OpenGL.
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos)
 {
+    // No modo de benchmark a câmera segue o roteiro e o cursor não é capturado.
+    if ( Bench_IsActive() )
+        return;
+    if (!AcceptInputEvent(INPUT_CURSOR_POS, 0, 0, 0, 0, xpos, ypos))
+        return;
+
     // Abaixo executamos o seguinte: caso o botão esquerdo do mouse esteja
     // pressionado, computamos quanto que o mouse se movimento desde o último
     // instante de tempo, e usamos esta movimentação para atualizar os
     // parâmetros que definem a posição da câmera dentro da cena virtual.
-    // Assim, temos que o usuário consegue controlar a câmera.
-    float dx, dy;
+    // Assim, temos que o usuário consegue controlar a câmera. Quando o cursor
+    // é recentralizado em um eixo, o deslocamento nesse eixo é zero.
+    float dx = 0.0f;
+    float dy = 0.0f;
     if(xpos >= 1099 || xpos <= 400)
     {
         if(ypos >= 899 || ypos <= 300)
@@ -2369,6 +2534,9 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
 
+    if (!AcceptInputEvent(INPUT_KEY, key, scancode, action, mod, 0.0, 0.0))
+        return;
+
     // O código abaixo implementa a seguinte lógica:
     //   Se apertar tecla X       então g_AngleX += delta;
     //   Se apertar tecla shift+X então g_AngleX -= delta;
@@ -2423,12 +2591,38 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
         g_ShowInfoText = !g_ShowInfoText;
     }
 
+    // Se o usuário apertar a tecla F3, mostramos/escondemos o profiler de quadros.
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+    {
+        g_ShowProfiler = !g_ShowProfiler;
+    }
+
+    // Se o usuário apertar a tecla F4, gravamos os próximos quadros em um
+    // arquivo JSON para chrome://tracing ou https://ui.perfetto.dev .
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        StartTraceCapture();
+    }
+
+    // Se o usuário apertar a tecla F5, mostramos/escondemos o uso de memória;
+    // com F6, imprimimos o uso de memória no terminal.
+    if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+    {
+        g_ShowMemory = !g_ShowMemory;
+    }
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+    {
+        MemTrack_Print();
+    }
+
     // Se o usuário apertar a tecla R, recarregamos os shaders dos arquivos "shader_fragment.glsl" e "shader_vertex.glsl".
     if (key == GLFW_KEY_R && action == GLFW_PRESS)
     {
-        LoadShadersFromFiles();
-        fprintf(stdout,"Shaders recarregados!\n");
-        fflush(stdout);
+        if (LoadShadersFromFiles())
+        {
+            fprintf(stdout,"Shaders recarregados!\n");
+            fflush(stdout);
+        }
     }
 
     if (key == GLFW_KEY_W && action == GLFW_PRESS)
@@ -2486,12 +2680,7 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
     }
     if (key == GLFW_KEY_E && action == GLFW_PRESS)
     {
-        if(isNear(camera_position_c, box_position))
-        {
-            isHolding = (isHolding == false) ? true : false;
-            if(!isHolding) dropped = true;
-        }
-
+        ToggleHoldBox();
     }
 
 }
@@ -2541,6 +2730,19 @@ void TextRendering_ShowModelViewProjection(
     TextRendering_PrintString(window, " Projection matrix        Camera                    In NDC", -1.0f, 1.0f-17*pad, 1.0f);
     TextRendering_PrintMatrixVectorProductDivW(window, projection, p_camera, -1.0f, 1.0f-18*pad, 1.0f);
 
+    glm::mat4 viewport_mapping = ViewportMappingMatrix(window);
+
+    TextRendering_PrintString(window, "                                                       |  ", -1.0f, 1.0f-22*pad, 1.0f);
+    TextRendering_PrintString(window, "                            .--------------------------'  ", -1.0f, 1.0f-23*pad, 1.0f);
+    TextRendering_PrintString(window, "                            V                           ", -1.0f, 1.0f-24*pad, 1.0f);
+
+    TextRendering_PrintString(window, " Viewport matrix           NDC      In Pixel Coords.", -1.0f, 1.0f-25*pad, 1.0f);
+    TextRendering_PrintMatrixVectorProductMoreDigits(window, viewport_mapping, p_ndc, -1.0f, 1.0f-26*pad, 1.0f);
+}
+
+// Mapeamento de NDC para coordenadas de pixels do framebuffer.
+glm::mat4 ViewportMappingMatrix(GLFWwindow* window)
+{
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
 
@@ -2549,19 +2751,65 @@ void TextRendering_ShowModelViewProjection(
     glm::vec2 p = glm::vec2( 0,  0);
     glm::vec2 q = glm::vec2(width, height);
 
-    glm::mat4 viewport_mapping = Matrix(
+    return Matrix(
         (q.x - p.x)/(b.x-a.x), 0.0f, 0.0f, (b.x*p.x - a.x*q.x)/(b.x-a.x),
         0.0f, (q.y - p.y)/(b.y-a.y), 0.0f, (b.y*p.y - a.y*q.y)/(b.y-a.y),
         0.0f , 0.0f , 1.0f , 0.0f ,
         0.0f , 0.0f , 0.0f , 1.0f
     );
+}
 
-    TextRendering_PrintString(window, "                                                       |  ", -1.0f, 1.0f-22*pad, 1.0f);
-    TextRendering_PrintString(window, "                            .--------------------------'  ", -1.0f, 1.0f-23*pad, 1.0f);
-    TextRendering_PrintString(window, "                            V                           ", -1.0f, 1.0f-24*pad, 1.0f);
+// Mesma informação de TextRendering_ShowModelViewProjection(), com o texto
+// guardado em objetos retidos: os rótulos e as setas são montados uma única
+// vez, e cada bloco de números só quando algum dos seus valores muda.
+void TextRendering_ShowModelViewProjectionRetained(
+    GLFWwindow* window,
+    glm::mat4 projection,
+    glm::mat4 view,
+    glm::mat4 model,
+    glm::vec4 p_model
+)
+{
+    if ( !g_ShowInfoText )
+        return;
 
-    TextRendering_PrintString(window, " Viewport matrix           NDC      In Pixel Coords.", -1.0f, 1.0f-25*pad, 1.0f);
-    TextRendering_PrintMatrixVectorProductMoreDigits(window, viewport_mapping, p_ndc, -1.0f, 1.0f-26*pad, 1.0f);
+    static TextObject labels;
+    static TextObject products[4];
+
+    glm::vec4 p_world = model*p_model;
+    glm::vec4 p_camera = view*p_world;
+    glm::vec4 p_clip = projection*p_camera;
+    glm::vec4 p_ndc = p_clip / p_clip.w;
+
+    float pad = TextRendering_LineHeight(window);
+
+    TextObject_Set(&labels,
+        " Model matrix             Model     In World Coords.\n"
+        "\n\n\n\n"
+        "                                        |  \n"
+        "                            .-----------'  \n"
+        "                            V              \n"
+        " View matrix              World     In Camera Coords.\n"
+        "\n\n\n\n"
+        "                                        |  \n"
+        "                            .-----------'  \n"
+        "                            V              \n"
+        " Projection matrix        Camera                    In NDC\n"
+        "\n\n\n\n"
+        "                                                       |  \n"
+        "                            .--------------------------'  \n"
+        "                            V                           \n"
+        " Viewport matrix           NDC      In Pixel Coords.",
+        -1.0f, 1.0f-pad, 1.0f);
+
+    TextObject_Set(&products[0], TextRendering_FormatMatrixVectorProduct(model, p_model), -1.0f, 1.0f-2*pad, 1.0f);
+    TextObject_Set(&products[1], TextRendering_FormatMatrixVectorProduct(view, p_world), -1.0f, 1.0f-10*pad, 1.0f);
+    TextObject_Set(&products[2], TextRendering_FormatMatrixVectorProductDivW(projection, p_camera), -1.0f, 1.0f-18*pad, 1.0f);
+    TextObject_Set(&products[3], TextRendering_FormatMatrixVectorProductMoreDigits(ViewportMappingMatrix(window), p_ndc), -1.0f, 1.0f-26*pad, 1.0f);
+
+    TextObject_Draw(&labels);
+    for (int i = 0; i < 4; ++i)
+        TextObject_Draw(&products[i]);
 }
 
 // Escrevemos na tela os ângulos de Euler definidos nas variáveis globais
@@ -2627,7 +2875,107 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window)
     float lineheight = TextRendering_LineHeight(window);
     float charwidth = TextRendering_CharWidth(window);
 
-    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-lineheight, 1.0f);
+    // O texto muda no máximo uma vez por segundo.
+    static TextObject text;
+    TextObject_Set(&text, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-lineheight, 1.0f);
+    TextObject_Draw(&text);
+}
+
+// Escrevemos na tela quantos bytes de textura foram enviados no último quadro e
+// quanto tempo a thread principal ficou bloqueada nisso.
+void TextRendering_ShowTextureStreaming(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText || TextureStreaming_IsIdle() )
+        return;
+
+    const TextureStreamingStats& stats = TextureStreaming_GetStats();
+
+    char buffer[80];
+    int numchars = snprintf(buffer, 80, "tex %.0f KB/frame %.2f ms",
+                            stats.bytes_this_frame / 1024.0, stats.stall_ms_this_frame);
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-2*lineheight, 1.0f);
+}
+
+// Escrevemos na tela o tempo médio de CPU e de GPU de cada etapa do quadro,
+// medido pelo profiler (veja "profiler.h").
+void TextRendering_ShowProfiler(GLFWwindow* window)
+{
+    if ( !g_ShowProfiler )
+        return;
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    const ProfilerResult* results;
+    size_t count = Profiler_GetResults(&results);
+
+    // O tempo em glfwSwapBuffers() é, em geral, espera pela GPU (ou pelo
+    // vsync), e não trabalho da CPU.
+    double cpu_ms = Profiler_GetCpuFrameMs();
+    double gpu_ms = Profiler_GetGpuFrameMs();
+    for (size_t i = 0; i < count; ++i)
+        if ( !results[i].gpu && results[i].depth == 0 && strcmp(results[i].name, "swap") == 0 )
+            cpu_ms -= results[i].ms;
+
+    char buffer[80];
+    snprintf(buffer, 80, "CPU %6.2f ms  GPU %6.2f ms  (%s)",
+             cpu_ms, gpu_ms, cpu_ms >= gpu_ms ? "CPU-bound" : "GPU-bound");
+    TextRendering_PrintString(window, buffer, -1.0f+charwidth, 1.0f-lineheight, 1.0f);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        snprintf(buffer, 80, "%s %*s%-*s %6.2f ms",
+                 results[i].gpu ? "gpu" : results[i].job ? "job" : "cpu",
+                 2*results[i].depth, "", 16 - 2*results[i].depth, results[i].name,
+                 results[i].ms);
+        TextRendering_PrintString(window, buffer, -1.0f+charwidth, 1.0f-(i+2)*lineheight, 1.0f);
+    }
+
+    // Chamadas OpenGL do quadro anterior (veja "glstats.h"); entre parênteses,
+    // quantas foram redundantes.
+#if GLSTATS_ENABLED
+    const GLStats& gl = GLStats_GetLastFrame();
+    snprintf(buffer, 80, "draws %4lu  tris %7lu  buffer %6.0f KB",
+             (unsigned long)gl.draw_calls, (unsigned long)gl.triangles, gl.buffer_bytes / 1024.0);
+    TextRendering_PrintString(window, buffer, -1.0f+charwidth, 1.0f-(count+2)*lineheight, 1.0f);
+    snprintf(buffer, 80, "vao %lu (%lu)  prog %lu (%lu)  tex %lu (%lu)",
+             (unsigned long)gl.vao_binds, (unsigned long)gl.redundant_vao_binds,
+             (unsigned long)gl.program_binds, (unsigned long)gl.redundant_program_binds,
+             (unsigned long)gl.texture_binds, (unsigned long)gl.redundant_texture_binds);
+    TextRendering_PrintString(window, buffer, -1.0f+charwidth, 1.0f-(count+3)*lineheight, 1.0f);
+    snprintf(buffer, 80, "uniforms %lu (%lu)  buffer binds %lu",
+             (unsigned long)gl.uniform_uploads, (unsigned long)gl.redundant_uniforms, (unsigned long)gl.buffer_binds);
+    TextRendering_PrintString(window, buffer, -1.0f+charwidth, 1.0f-(count+4)*lineheight, 1.0f);
+#endif
+}
+
+// Escrevemos na tela a memória de CPU e de GPU usada por cada subsistema, e o
+// máximo atingido desde o início (veja "memtrack.h").
+void TextRendering_ShowMemory(GLFWwindow* window)
+{
+    if ( !g_ShowMemory )
+        return;
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    const double MB = 1024.0 * 1024.0;
+    char buffer[80];
+    snprintf(buffer, 80, "MB           CPU   peak     GPU   peak");
+    TextRendering_PrintString(window, buffer, -1.0f+charwidth, -1.0f+(MEM_CATEGORY_COUNT+2)*lineheight, 1.0f);
+
+    for (int i = 0; i <= MEM_CATEGORY_COUNT; ++i)
+    {
+        MemTrackUsage u;
+        MemTrack_GetUsage((MemCategory)i, &u);
+        snprintf(buffer, 80, "%-9s %6.1f %6.1f  %6.1f %6.1f", MemTrack_CategoryName((MemCategory)i),
+                 u.cpu_bytes / MB, u.cpu_peak_bytes / MB, u.gpu_bytes / MB, u.gpu_peak_bytes / MB);
+        TextRendering_PrintString(window, buffer, -1.0f+charwidth, -1.0f+(MEM_CATEGORY_COUNT+1-i)*lineheight, 1.0f);
+    }
 }
 
 // Função para debugging: imprime no terminal todas informações de um modelo
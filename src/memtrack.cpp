@@ -0,0 +1,100 @@
+// Contabilidade de memória por subsistema. Veja os comentários em
+// "include/memtrack.h".
+#include <cstdio>
+#include <atomic>
+
+#include "memtrack.h"
+
+struct MemCounter
+{
+    std::atomic<size_t> bytes;
+    std::atomic<size_t> peak;
+};
+
+// Índice MEM_CATEGORY_COUNT guarda o total de todas as categorias.
+static MemCounter g_MemCpu[MEM_CATEGORY_COUNT + 1];
+static MemCounter g_MemGpu[MEM_CATEGORY_COUNT + 1];
+
+static const char* g_MemCategoryNames[MEM_CATEGORY_COUNT + 1] =
+{
+    "meshes", "textures", "text", "physics", "assets", "entities", "total"
+};
+
+static void MemCounterAdd(MemCounter& counter, size_t bytes)
+{
+    size_t now = counter.bytes.fetch_add(bytes) + bytes;
+    size_t peak = counter.peak.load();
+    while (now > peak && !counter.peak.compare_exchange_weak(peak, now))
+        ;
+}
+
+static void MemCounterSub(MemCounter& counter, size_t bytes)
+{
+    counter.bytes.fetch_sub(bytes);
+}
+
+void MemTrack_CpuAlloc(MemCategory category, size_t bytes)
+{
+    MemCounterAdd(g_MemCpu[category], bytes);
+    MemCounterAdd(g_MemCpu[MEM_CATEGORY_COUNT], bytes);
+}
+
+void MemTrack_CpuFree(MemCategory category, size_t bytes)
+{
+    MemCounterSub(g_MemCpu[category], bytes);
+    MemCounterSub(g_MemCpu[MEM_CATEGORY_COUNT], bytes);
+}
+
+void MemTrack_GpuAlloc(MemCategory category, size_t bytes)
+{
+    MemCounterAdd(g_MemGpu[category], bytes);
+    MemCounterAdd(g_MemGpu[MEM_CATEGORY_COUNT], bytes);
+}
+
+void MemTrack_GpuFree(MemCategory category, size_t bytes)
+{
+    MemCounterSub(g_MemGpu[category], bytes);
+    MemCounterSub(g_MemGpu[MEM_CATEGORY_COUNT], bytes);
+}
+
+size_t MemTrack_TextureBytes(int width, int height, int bytes_per_texel, bool mipmaps)
+{
+    // Cada nível tem metade da largura e da altura do anterior (arredondando
+    // para baixo, mínimo 1), até 1x1; no total, cerca de 4/3 do nível 0.
+    size_t bytes = 0;
+    for (;;)
+    {
+        bytes += (size_t)width * height * bytes_per_texel;
+        if (!mipmaps || (width == 1 && height == 1))
+            break;
+        width  = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return bytes;
+}
+
+const char* MemTrack_CategoryName(MemCategory category)
+{
+    return g_MemCategoryNames[category];
+}
+
+void MemTrack_GetUsage(MemCategory category, MemTrackUsage* usage)
+{
+    usage->cpu_bytes      = g_MemCpu[category].bytes.load();
+    usage->cpu_peak_bytes = g_MemCpu[category].peak.load();
+    usage->gpu_bytes      = g_MemGpu[category].bytes.load();
+    usage->gpu_peak_bytes = g_MemGpu[category].peak.load();
+}
+
+void MemTrack_Print()
+{
+    const double MB = 1024.0 * 1024.0;
+    printf("Memory (MB):   CPU     peak      GPU     peak\n");
+    for (int i = 0; i <= MEM_CATEGORY_COUNT; ++i)
+    {
+        MemTrackUsage u;
+        MemTrack_GetUsage((MemCategory)i, &u);
+        printf("  %-9s %8.2f %8.2f %8.2f %8.2f\n", g_MemCategoryNames[i],
+               u.cpu_bytes / MB, u.cpu_peak_bytes / MB, u.gpu_bytes / MB, u.gpu_peak_bytes / MB);
+    }
+}
@@ -0,0 +1,695 @@
+// Microbenchmarks dos núcleos de matemática, colisão e construção de malhas,
+// executados com "make bench". Cada benchmark roda sobre entradas sintéticas
+// de alguns tamanhos, geradas com semente fixa, e os resultados são escritos
+// na saída padrão em CSV (ou JSON, com "--json"), um benchmark por linha:
+//
+//     benchmark,size,iterations,ns_per_op,ns_per_item,min_ns_per_op
+//
+// onde "op" é uma passada completa sobre a entrada de tamanho "size" (por
+// exemplo, um ponto testado contra "size" caixas), "ns_per_op" é a mediana de
+// MICROBENCH_SAMPLES amostras e "min_ns_per_op" a menor delas.
+//
+// Opções: "--filter=texto" executa só os benchmarks cujo nome contém o texto,
+// e "--min-time-ms=N" define a duração mínima de cada amostra.
+//
+// "Jobs_AddParallel" usa uma thread auxiliar a menos que o número de núcleos.
+//
+// Nenhuma chamada OpenGL é feita: a construção de malhas é medida através de
+// BuildMeshData(), a parte de BuildTrianglesAndAddToVirtualScene() que não
+// envia dados para a GPU, e a busca de glifos através de TextGlyphs_Find() e
+// TextGlyphs_Lookup().
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "matrices.h"
+#include "affine.h"
+#include "collisions.h"
+#include "bezier.h"
+#include "objmodel.h"
+#include "dejavufont.h"
+#include "textglyphs.h"
+#include "sdfatlas.h"
+#include "assetpack.h"
+#include "level.h"
+#include "ecs.h"
+#include "jobs.h"
+
+#define MICROBENCH_SAMPLES 5
+
+struct MicroBenchResult
+{
+    std::string   name;
+    size_t        size;
+    unsigned long iterations;  // Por amostra
+    double        ns_per_op;
+    double        min_ns_per_op;
+};
+
+static std::vector<MicroBenchResult> g_MicroBenchResults;
+static const char*                   g_MicroBenchFilter = NULL;
+static double                        g_MicroBenchMinTimeMs = 50.0;
+
+// Impede que o compilador elimine o cálculo de "value" como código morto.
+template <typename T>
+inline void MicroBenchKeep(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+static double MicroBenchNowNs()
+{
+    typedef std::chrono::steady_clock clock;
+    return std::chrono::duration<double, std::nano>(clock::now().time_since_epoch()).count();
+}
+
+// Gerador congruencial com semente fixa, para que as entradas sejam as mesmas
+// em todas as execuções.
+static unsigned int g_MicroBenchSeed = 12345;
+
+static float MicroBenchRandom(float lo, float hi)
+{
+    g_MicroBenchSeed = g_MicroBenchSeed * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((g_MicroBenchSeed >> 8) / 16777216.0f);
+}
+
+// Mede "body(iterations)", que deve executar a operação "iterations" vezes.
+// O número de iterações é dobrado até uma amostra durar g_MicroBenchMinTimeMs.
+template <typename Body>
+static void MicroBench_Run(const char* name, size_t size, Body body)
+{
+    if (g_MicroBenchFilter != NULL && strstr(name, g_MicroBenchFilter) == NULL)
+        return;
+
+    unsigned long iterations = 1;
+    for (;;)
+    {
+        double start = MicroBenchNowNs();
+        body(iterations);
+        double elapsed = MicroBenchNowNs() - start;
+        if (elapsed >= g_MicroBenchMinTimeMs * 1.0e6 || iterations >= (1ul << 40))
+            break;
+        iterations *= 2;
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < MICROBENCH_SAMPLES; ++i)
+    {
+        double start = MicroBenchNowNs();
+        body(iterations);
+        samples.push_back((MicroBenchNowNs() - start) / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    MicroBenchResult result;
+    result.name          = name;
+    result.size          = size;
+    result.iterations    = iterations;
+    result.ns_per_op     = samples[MICROBENCH_SAMPLES / 2];
+    result.min_ns_per_op = samples[0];
+    g_MicroBenchResults.push_back(result);
+
+    fprintf(stderr, "%-24s %8lu %14.1f ns/op\n", name, (unsigned long)size, result.ns_per_op);
+}
+
+// Caixas alinhadas aos eixos espalhadas pela sala (mesma escala de main()).
+static void MicroBenchMakeBoxes(size_t count, std::vector<glm::vec4>* mins, std::vector<glm::vec4>* maxs)
+{
+    mins->clear();
+    maxs->clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec4 center = glm::vec4(MicroBenchRandom(-50, 50), MicroBenchRandom(0, 5), MicroBenchRandom(-50, 50), 0);
+        glm::vec4 half   = glm::vec4(MicroBenchRandom(0.5f, 5), MicroBenchRandom(0.5f, 5), MicroBenchRandom(0.5f, 5), 0);
+        mins->push_back(center - half);
+        maxs->push_back(center + half);
+    }
+}
+
+// Malha em grade de "n" x "n" quadrados (dois triângulos cada), com
+// coordenadas de textura e sem normais, como um ".obj" típico.
+static void MicroBenchMakeGrid(size_t n, ObjModel* model)
+{
+    model->attrib.vertices.clear();
+    model->attrib.texcoords.clear();
+    model->attrib.normals.clear();
+    model->shapes.assign(1, tinyobj::shape_t());
+    model->shapes[0].name = "grid";
+
+    for (size_t j = 0; j <= n; ++j)
+    {
+        for (size_t i = 0; i <= n; ++i)
+        {
+            model->attrib.vertices.push_back((float)i);
+            model->attrib.vertices.push_back(MicroBenchRandom(-0.5f, 0.5f));
+            model->attrib.vertices.push_back((float)j);
+            model->attrib.texcoords.push_back((float)i / n);
+            model->attrib.texcoords.push_back((float)j / n);
+        }
+    }
+
+    tinyobj::mesh_t& mesh = model->shapes[0].mesh;
+    for (size_t j = 0; j < n; ++j)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            int v00 = (int)(j * (n + 1) + i);
+            int v10 = v00 + 1;
+            int v01 = v00 + (int)(n + 1);
+            int v11 = v01 + 1;
+            int triangles[6] = { v00, v01, v10, v10, v01, v11 };
+            for (int k = 0; k < 6; ++k)
+            {
+                tinyobj::index_t idx;
+                idx.vertex_index   = triangles[k];
+                idx.normal_index   = -1;
+                idx.texcoord_index = triangles[k];
+                mesh.indices.push_back(idx);
+            }
+            mesh.num_face_vertices.push_back(3);
+            mesh.num_face_vertices.push_back(3);
+            mesh.material_ids.push_back(-1);
+            mesh.material_ids.push_back(-1);
+        }
+    }
+}
+
+static void MicroBenchCollisions()
+{
+    static const size_t sizes[] = { 16, 256, 4096 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t count = sizes[s];
+        std::vector<glm::vec4> mins, maxs;
+        MicroBenchMakeBoxes(count, &mins, &maxs);
+
+        std::vector<glm::vec4> points(64);
+        std::vector<glm::vec4> directions(64);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            points[i] = glm::vec4(MicroBenchRandom(-50, 50), MicroBenchRandom(0, 5), MicroBenchRandom(-50, 50), 1);
+            directions[i] = glm::vec4(MicroBenchRandom(-1, 1), MicroBenchRandom(-0.2f, 0.2f), MicroBenchRandom(-1, 1), 0);
+        }
+
+        // Um ponto contra todas as caixas, como o teste da câmera contra
+        // "collisionList" no laço principal.
+        MicroBench_Run("detectColision", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                const glm::vec4& p = points[it % points.size()];
+                int hits = 0;
+                for (size_t i = 0; i < count; ++i)
+                    hits += detectColision(p, mins[i], maxs[i]);
+                MicroBenchKeep(hits);
+            }
+        });
+
+        // Um raio contra todas as caixas, como o disparo de um portal.
+        MicroBench_Run("CheckLineBox", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                const glm::vec4& p = points[it % points.size()];
+                const glm::vec4& d = directions[it % directions.size()];
+                int hits = 0;
+                glm::vec4 hit;
+                for (size_t i = 0; i < count; ++i)
+                    hits += CheckLineBox(mins[i], maxs[i], p, d, hit);
+                MicroBenchKeep(hits);
+                MicroBenchKeep(hit);
+            }
+        });
+    }
+}
+
+static void MicroBenchBezier()
+{
+    // Número de pontos de controle; o grau é um a menos.
+    static const size_t sizes[] = { 4, 6, 10 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t count = sizes[s];
+        std::vector<glm::vec3> points;
+        for (size_t i = 0; i < count; ++i)
+            points.push_back(glm::vec3(MicroBenchRandom(-1, 1), MicroBenchRandom(0, 0.5f), 0.0f));
+
+        std::vector<float> times(256);
+        for (size_t i = 0; i < times.size(); ++i)
+            times[i] = MicroBenchRandom(0, 1);
+
+        MicroBench_Run("Bernstein", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                float t = times[it % times.size()];
+                float sum = 0.0f;
+                for (size_t k = 0; k < count; ++k)
+                    sum += Bernstein(k, count - 1, t);
+                MicroBenchKeep(sum);
+            }
+        });
+
+        MicroBench_Run("bezierCurve", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                glm::vec3 p = bezierCurve(points, times[it % times.size()]);
+                MicroBenchKeep(p);
+            }
+        });
+    }
+
+    // Curvas de grau fixo (veja "bezier.h"): uma curva, e um lote de
+    // curvas cúbicas como as plataformas da cena de estresse.
+    BezierCurve<5> quintic;
+    for (int i = 0; i <= 5; ++i)
+        quintic.points[i] = glm::vec3(MicroBenchRandom(-1, 1), MicroBenchRandom(0, 0.5f), 0.0f);
+
+    std::vector<float> times(256);
+    for (size_t i = 0; i < times.size(); ++i)
+        times[i] = MicroBenchRandom(0, 1);
+
+    MicroBench_Run("BezierCurve<5>::Evaluate", 6, [&](unsigned long iterations) {
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            glm::vec3 p = quintic.Evaluate(times[it % times.size()]);
+            MicroBenchKeep(p);
+        }
+    });
+
+    static const size_t counts[] = { 16, 256 };
+    for (size_t s = 0; s < sizeof(counts) / sizeof(counts[0]); ++s)
+    {
+        size_t count = counts[s];
+        std::vector<BezierCurve<3> >  curves(count);
+        std::vector<BezierArcLength>  arcs(count);
+        std::vector<glm::vec3>        out(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (int p = 0; p <= 3; ++p)
+                curves[i].points[p] = glm::vec3(MicroBenchRandom(-20, 20), MicroBenchRandom(0, 5), MicroBenchRandom(-20, 20));
+            Bezier_BakeArcLength(curves[i], &arcs[i]);
+        }
+
+        MicroBench_Run("Bezier_EvaluateBatch", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Bezier_EvaluateBatch(curves.data(), &times[it % (times.size() - count + 1)], out.data(), count);
+                MicroBenchKeep(out[0]);
+            }
+        });
+
+        MicroBench_Run("Bezier_EvaluateUniformBatch", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Bezier_EvaluateUniformBatch(curves.data(), arcs.data(), &times[it % (times.size() - count + 1)], out.data(), count);
+                MicroBenchKeep(out[0]);
+            }
+        });
+    }
+}
+
+static void MicroBenchMatrices()
+{
+    std::vector<glm::vec4> values(256);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = glm::vec4(MicroBenchRandom(-50, 50), MicroBenchRandom(0.1f, 5), MicroBenchRandom(-50, 50), MicroBenchRandom(0, 6.28f));
+
+    MicroBench_Run("Matrix_Translate", 1, [&](unsigned long iterations) {
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            const glm::vec4& v = values[it % values.size()];
+            glm::mat4 m = Matrix_Translate(v.x, v.y, v.z);
+            MicroBenchKeep(m);
+        }
+    });
+
+    MicroBench_Run("Matrix_Rotate", 1, [&](unsigned long iterations) {
+        glm::vec4 axis = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            glm::mat4 m = Matrix_Rotate(values[it % values.size()].w, axis);
+            MicroBenchKeep(m);
+        }
+    });
+
+    // Matriz de modelagem no formato usado em main(): T * S * R.
+    MicroBench_Run("Matrix_TSR", 1, [&](unsigned long iterations) {
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            const glm::vec4& v = values[it % values.size()];
+            glm::mat4 m = Matrix_Translate(v.x, v.y, v.z) * Matrix_Scale(v.y, v.y, 1.0f) * Matrix_Rotate_Y(v.w);
+            MicroBenchKeep(m);
+        }
+    });
+
+    // A mesma matriz construída diretamente (veja "affine.h").
+    MicroBench_Run("Affine_MakeTSR", 1, [&](unsigned long iterations) {
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            const glm::vec4& v = values[it % values.size()];
+            glm::quat r = glm::angleAxis(v.w, glm::vec3(0.0f, 1.0f, 0.0f));
+            Affine m = Affine_MakeTSR(glm::vec3(v.x, v.y, v.z), r, glm::vec3(v.y, v.y, 1.0f));
+            MicroBenchKeep(m);
+        }
+    });
+
+    MicroBench_Run("Matrix_Perspective", 1, [&](unsigned long iterations) {
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            glm::mat4 m = Matrix_Perspective(1.0f + values[it % values.size()].w * 0.1f, 4.0f / 3.0f, -0.1f, -200.0f);
+            MicroBenchKeep(m);
+        }
+    });
+
+    MicroBench_Run("Matrix_Camera_View", 1, [&](unsigned long iterations) {
+        glm::vec4 up = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            const glm::vec4& v = values[it % values.size()];
+            glm::vec4 position = glm::vec4(v.x, 0.0f, v.z, 1.0f);
+            glm::vec4 view = glm::vec4(cosf(v.w), 0.0f, sinf(v.w), 0.0f);
+            glm::mat4 m = Matrix_Camera_View(&position, view, up, true, false, (it & 1) != 0, false, 25.0f, false, 1.0f / 60.0f);
+            MicroBenchKeep(m);
+            MicroBenchKeep(position);
+        }
+    });
+}
+
+// Transformações de muitos objetos por vez: a matriz do pai vezes a de cada
+// filho, com glm::mat4 e com os núcleos em lote de "affine.h".
+static void MicroBenchAffine()
+{
+    static const size_t sizes[] = { 16, 256, 4096 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t count = sizes[s];
+        std::vector<Affine>    local(count), world(count);
+        std::vector<glm::mat4> local4(count), world4(count);
+        std::vector<glm::vec3> points(count), transformed(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::quat r = glm::angleAxis(MicroBenchRandom(0, 6.28f), glm::vec3(0.0f, 1.0f, 0.0f));
+            local[i] = Affine_MakeTRS(glm::vec3(MicroBenchRandom(-50, 50), 0.0f, MicroBenchRandom(-50, 50)), r,
+                                      glm::vec3(MicroBenchRandom(0.1f, 5), MicroBenchRandom(0.1f, 5), 1.0f));
+            local4[i] = Affine_ToMat4(local[i]);
+            points[i] = glm::vec3(MicroBenchRandom(-1, 1), MicroBenchRandom(-1, 1), MicroBenchRandom(-1, 1));
+        }
+        Affine parent = Affine_MakeTSR(glm::vec3(1.0f, 2.0f, 3.0f), glm::angleAxis(0.5f, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(2.0f));
+        glm::mat4 parent4 = Affine_ToMat4(parent);
+
+        MicroBench_Run("mat4_multiply", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                for (size_t i = 0; i < count; ++i)
+                    world4[i] = parent4 * local4[i];
+                MicroBenchKeep(world4[it % count]);
+            }
+        });
+
+        MicroBench_Run("Affine_ComposeBatch", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Affine_ComposeBatch(parent, local.data(), world.data(), count);
+                MicroBenchKeep(world[it % count]);
+            }
+        });
+
+        MicroBench_Run("Affine_ToMat4Batch", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Affine_ToMat4Batch(local.data(), world4.data(), count);
+                MicroBenchKeep(world4[it % count]);
+            }
+        });
+
+        MicroBench_Run("Affine_TransformPointsBatch", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Affine_TransformPointsBatch(parent, points.data(), transformed.data(), count);
+                MicroBenchKeep(transformed[it % count]);
+            }
+        });
+    }
+}
+
+static void MicroBenchMeshes()
+{
+    static const size_t sizes[] = { 16, 64, 256 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t n = sizes[s];
+        ObjModel model;
+        MicroBenchMakeGrid(n, &model);
+        size_t triangles = 2 * n * n;
+
+        MicroBench_Run("ComputeNormals", triangles, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                model.attrib.normals.clear();  // ComputeNormals() não faz nada se já existirem
+                ComputeNormals(&model);
+                MicroBenchKeep(model.attrib.normals[0]);
+            }
+        });
+
+        MicroBench_Run("BuildMeshData", triangles, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                MeshData mesh;
+                BuildMeshData(&model, &mesh);
+                MicroBenchKeep(mesh.indices.back());
+            }
+        });
+    }
+}
+
+// Conversão do atlas da fonte em SDF, feita por "mkpack" (SdfFont_Bake()).
+static void MicroBenchSdf()
+{
+    std::vector<unsigned char> sdf(dejavufont.tex_width * dejavufont.tex_height);
+    MicroBench_Run("SdfAtlas_Generate", sdf.size(), [&](unsigned long iterations) {
+        for (unsigned long it = 0; it < iterations; ++it)
+        {
+            SdfAtlas_Generate(dejavufont.tex_data, (int)dejavufont.tex_width, (int)dejavufont.tex_height, sdf.data());
+            MicroBenchKeep(sdf[it % sdf.size()]);
+        }
+    });
+}
+
+// Carregamento da fase: compilação do texto (sem pacote) e cópia do formato
+// binário (com pacote), por Level_Load().
+static void MicroBenchLevel()
+{
+    AssetBlob text;
+    if (!AssetPack_Load("data/level1.level", &text))
+        return;
+    std::vector<unsigned char> binary;
+    if (Level_Compile((const char*)text.data, text.size, "data/level1.level", &binary))
+    {
+        MicroBench_Run("Level_Compile", text.size, [&](unsigned long iterations) {
+            std::vector<unsigned char> out;
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Level_Compile((const char*)text.data, text.size, "data/level1.level", &out);
+                MicroBenchKeep(out[it % out.size()]);
+            }
+        });
+        MicroBench_Run("Level_LoadMemory", binary.size(), [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Level level;
+                Level_LoadMemory(binary.data(), binary.size(), &level);
+                MicroBenchKeep((unsigned char)level.placement_count);
+            }
+        });
+    }
+    AssetPack_Free(&text);
+}
+
+// Sistemas de "ecs.h" percorrendo os vetores densos: a colisão da câmera com
+// as caixas sólidas e a busca do cubo mais próximo, com muitos cubos na fase.
+static void MicroBenchEcs()
+{
+    static const size_t sizes[] = { 16, 500, 4096, 65536 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t count = sizes[s];
+        World world;
+        std::vector<glm::vec4> mins, maxs;
+        MicroBenchMakeBoxes(count, &mins, &maxs);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ColliderComponent collider;
+            collider.box.bbox_min = mins[i];
+            collider.box.bbox_max = maxs[i];
+            collider.box.angle = 0.0;
+            Component_Add(&world.colliders, World_CreateEntity(&world), collider);
+
+            Entity entity = World_CreateEntity(&world);
+            TransformComponent transform = { glm::vec3(MicroBenchRandom(-50, 50), -1.25f, MicroBenchRandom(-50, 50)), TRANSFORM_ROOT };
+            PickupComponent pickup = { glm::vec3(0.0f), false, false };
+            Component_Add(&world.transforms, entity, transform);
+            Component_Add(&world.pickups, entity, pickup);
+        }
+
+        // Ponto fora de todas as caixas, para percorrer a lista inteira.
+        glm::vec4 camera = glm::vec4(0.0f, 100.0f, 0.0f, 1.0f);
+        MicroBench_Run("Ecs_CameraBlocked", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+                MicroBenchKeep((float)Ecs_CameraBlocked(world, camera));
+        });
+        MicroBench_Run("Ecs_FindPickupNear", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+                MicroBenchKeep((float)Ecs_FindPickupNear(world, camera));
+        });
+    }
+}
+
+// Custo de dividir uma busca em tarefas de "jobs.h", com as partes da busca
+// de colisão do quadro (1024 caixas), para comparar com Ecs_CameraBlocked()
+// nos mesmos tamanhos.
+static void MicroBenchJobsCollision(void* data, size_t begin, size_t end)
+{
+    const World* world = (const World*)data;
+    MicroBenchKeep((float)Ecs_CameraBlockedRange(*world, glm::vec4(0.0f, 100.0f, 0.0f, 1.0f), begin, end));
+}
+
+static void MicroBenchJobs()
+{
+    Jobs_Init(-1);
+
+    static const size_t sizes[] = { 4096, 65536 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t count = sizes[s];
+        World world;
+        std::vector<glm::vec4> mins, maxs;
+        MicroBenchMakeBoxes(count, &mins, &maxs);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ColliderComponent collider;
+            collider.box.bbox_min = mins[i];
+            collider.box.bbox_max = maxs[i];
+            collider.box.angle = 0.0;
+            Component_Add(&world.colliders, World_CreateEntity(&world), collider);
+        }
+
+        MicroBench_Run("Jobs_AddParallel", count, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                Jobs_Wait(Jobs_AddParallel("collision", MicroBenchJobsCollision, &world, count, 1024));
+                Jobs_EndFrame();
+            }
+        });
+    }
+
+    Jobs_Shutdown();
+}
+
+static void MicroBenchGlyphs()
+{
+    TextGlyphTable table;
+    TextGlyphs_BuildTable(&table, dejavufont.glyphs, dejavufont.glyphs_count);
+
+    static const size_t sizes[] = { 16, 256, 4096 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t length = sizes[s];
+        std::string text;
+        for (size_t i = 0; i < length; ++i)
+            text += (char)(32 + (int)MicroBenchRandom(0, 95));
+
+        // A busca feita por TextRendering_PrintString() para cada caractere.
+        MicroBench_Run("TextGlyphs_Find", length, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                float advance = 0.0f;
+                for (size_t i = 0; i < text.size(); ++i)
+                {
+                    const texture_glyph_t* glyph = TextGlyphs_Find(dejavufont.glyphs, dejavufont.glyphs_count, (unsigned char)text[i]);
+                    if (glyph)
+                        advance += glyph->advance_x;
+                }
+                MicroBenchKeep(advance);
+            }
+        });
+
+        // A busca em tabela usada desde que o texto passou a ser desenhado
+        // em lote.
+        MicroBench_Run("TextGlyphs_Lookup", length, [&](unsigned long iterations) {
+            for (unsigned long it = 0; it < iterations; ++it)
+            {
+                float advance = 0.0f;
+                for (size_t i = 0; i < text.size(); ++i)
+                {
+                    const texture_glyph_t* glyph = TextGlyphs_Lookup(table, (unsigned char)text[i]);
+                    if (glyph)
+                        advance += glyph->advance_x;
+                }
+                MicroBenchKeep(advance);
+            }
+        });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool json = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (strncmp(argv[i], "--filter=", 9) == 0)
+            g_MicroBenchFilter = argv[i] + 9;
+        else if (strncmp(argv[i], "--min-time-ms=", 14) == 0)
+            g_MicroBenchMinTimeMs = atof(argv[i] + 14);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--json] [--filter=name] [--min-time-ms=N]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    MicroBenchCollisions();
+    MicroBenchBezier();
+    MicroBenchMatrices();
+    MicroBenchAffine();
+    MicroBenchMeshes();
+    MicroBenchGlyphs();
+    MicroBenchSdf();
+    MicroBenchLevel();
+    MicroBenchEcs();
+    MicroBenchJobs();
+
+    if (json)
+        printf("[\n");
+    else
+        printf("benchmark,size,iterations,ns_per_op,ns_per_item,min_ns_per_op\n");
+
+    for (size_t i = 0; i < g_MicroBenchResults.size(); ++i)
+    {
+        const MicroBenchResult& r = g_MicroBenchResults[i];
+        if (json)
+            printf("  {\"benchmark\": \"%s\", \"size\": %lu, \"iterations\": %lu, \"ns_per_op\": %.3f, \"ns_per_item\": %.3f, \"min_ns_per_op\": %.3f}%s\n",
+                   r.name.c_str(), (unsigned long)r.size, r.iterations, r.ns_per_op, r.ns_per_op / r.size, r.min_ns_per_op,
+                   i + 1 < g_MicroBenchResults.size() ? "," : "");
+        else
+            printf("%s,%lu,%lu,%.3f,%.3f,%.3f\n",
+                   r.name.c_str(), (unsigned long)r.size, r.iterations, r.ns_per_op, r.ns_per_op / r.size, r.min_ns_per_op);
+    }
+
+    if (json)
+        printf("]\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+// Ferramenta que cria o pacote com os arquivos do jogo (veja
+// "include/assetpack.h"): todos os arquivos de "data/" e os shaders
+// "src/*.glsl". As fases "data/*.level" também são compiladas para o formato
+// binário ("data/*.lvl", veja "include/level.h"), e o atlas SDF da fonte é
+// regravado em "data/dejavufont.sdf" (veja "include/sdfatlas.h") antes de ser
+// empacotado; esse arquivo também fica no repositório, para que o jogo rode
+// sem pacote. Uso:
+//
+//     mkpack [pacote]
+//
+// Por padrão o pacote é criado como "assets.pak" ao lado do executável.
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+#include "assetpack.h"
+#include "level.h"
+#include "sdfatlas.h"
+#include "dejavufont.h"
+
+// Adiciona a "names" os arquivos do diretório "directory" (relativo à raiz do
+// projeto) cujo nome termina com "suffix".
+static void ListFiles(const char* directory, const char* suffix, std::vector<std::string>* names)
+{
+    std::string path = AssetPack_LoosePath(directory);
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot open directory \"%s\".\n", path.c_str());
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::string end(suffix);
+    while (struct dirent* entry = readdir(dir))
+    {
+        std::string name(entry->d_name);
+        if (name[0] == '.')
+            continue;
+        if (name.size() < end.size() || name.compare(name.size() - end.size(), end.size(), end) != 0)
+            continue;
+        names->push_back(std::string(directory) + "/" + name);
+    }
+    closedir(dir);
+}
+
+// Gera o atlas SDF da fonte embutida e o grava no disco, em SDFFONT_FILE.
+static bool BakeFont()
+{
+    std::vector<unsigned char> binary;
+    SdfFont_Bake(&dejavufont, &binary);
+
+    std::string path = AssetPack_LoosePath(SDFFONT_FILE);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot create \"%s\".\n", path.c_str());
+        return false;
+    }
+    bool ok = fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        fprintf(stderr, "ERROR: Cannot write \"%s\".\n", path.c_str());
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filename = argc > 1 ? argv[1] : AssetPack_ExecutableDirectory() + "/assets.pak";
+
+    if (!BakeFont())
+        return EXIT_FAILURE;
+
+    std::vector<std::string> names;
+    ListFiles("data", "", &names);
+    ListFiles("src", ".glsl", &names);
+
+    std::vector<std::string> levels;
+    ListFiles("data", ".level", &levels);
+    AssetPackGenerated generated;
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        AssetBlob blob;
+        if (!AssetPack_Load(levels[i].c_str(), &blob))
+        {
+            fprintf(stderr, "ERROR: Cannot read \"%s\".\n", levels[i].c_str());
+            return EXIT_FAILURE;
+        }
+        std::string name = levels[i].substr(0, levels[i].size() - 6) + ".lvl";
+        bool ok = Level_Compile((const char*)blob.data, blob.size, levels[i].c_str(), &generated[name]);
+        AssetPack_Free(&blob);
+        if (!ok)
+            return EXIT_FAILURE;
+    }
+
+    printf("Criando \"%s\"...\n", filename.c_str());
+    return AssetPack_Write(filename.c_str(), names, generated) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,305 @@
+// Profiler de quadros. Veja os comentários em "include/profiler.h".
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "utils.h"
+#include "trace.h"
+#include "profiler.h"
+
+// Peso de um novo quadro na média móvel exponencial.
+static const double PROFILER_SMOOTHING = 0.05;
+
+struct ProfilerCpuRecord
+{
+    const char* name;
+    int         depth;
+    double      ms;
+};
+
+struct ProfilerGpuFrame
+{
+    GLuint      queries[PROFILER_MAX_GPU_SCOPES];
+    const char* names[PROFILER_MAX_GPU_SCOPES];
+    int         count;
+};
+
+static bool                            g_ProfilerInitialized = false;
+static unsigned long                   g_ProfilerFrame = 0;
+static double                          g_ProfilerFrameStart = 0.0;
+
+// Escopos de CPU do quadro atual: "g_ProfilerCpuRecords" guarda a duração
+// (acumulada, caso o mesmo escopo seja aberto mais de uma vez), e
+// "g_ProfilerStack" os índices dos escopos abertos com seus tempos iniciais.
+static std::vector<ProfilerCpuRecord>  g_ProfilerCpuRecords;
+static std::vector<int>                g_ProfilerStack;
+static std::vector<double>             g_ProfilerStackStart;
+
+// Tarefas do quadro atual, somadas por nome (veja Profiler_AddJobTime()).
+static std::vector<ProfilerCpuRecord>  g_ProfilerJobRecords;
+
+static ProfilerGpuFrame                g_ProfilerGpuFrames[PROFILER_GPU_FRAMES];
+static bool                            g_ProfilerGpuActive = false;
+
+static std::vector<ProfilerResult>     g_ProfilerCpuResults;
+static std::vector<ProfilerResult>     g_ProfilerJobResults;
+static std::vector<ProfilerResult>     g_ProfilerGpuResults;
+static std::vector<ProfilerResult>     g_ProfilerResults;
+static double                          g_ProfilerCpuFrameMs = 0.0;
+static double                          g_ProfilerGpuFrameMs = 0.0;
+static double                          g_ProfilerLastCpuFrameMs = 0.0;
+static double                          g_ProfilerLastGpuFrameMs = -1.0;  // Negativo se nenhum quadro foi lido
+
+static double ProfilerNowMs()
+{
+    typedef std::chrono::steady_clock clock;
+    return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+}
+
+static double ProfilerSmooth(double average, double sample)
+{
+    return average + (sample - average) * PROFILER_SMOOTHING;
+}
+
+// Atualiza as médias de "results" com as amostras de um quadro. Escopos que
+// não apareceram no quadro recebem amostra zero.
+static void ProfilerAccumulate(std::vector<ProfilerResult>* results, const std::vector<ProfilerCpuRecord>& samples, bool gpu, bool job)
+{
+    std::vector<bool> seen(results->size(), false);
+
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        size_t j = 0;
+        while (j < results->size() && !((*results)[j].depth == samples[i].depth && strcmp((*results)[j].name, samples[i].name) == 0))
+            ++j;
+
+        if (j == results->size())
+        {
+            ProfilerResult result;
+            result.name  = samples[i].name;
+            result.depth = samples[i].depth;
+            result.gpu   = gpu;
+            result.job   = job;
+            result.ms    = samples[i].ms;
+            results->push_back(result);
+            seen.push_back(true);
+        }
+        else
+        {
+            (*results)[j].ms = ProfilerSmooth((*results)[j].ms, samples[i].ms);
+            seen[j] = true;
+        }
+    }
+
+    for (size_t j = 0; j < results->size(); ++j)
+        if (!seen[j])
+            (*results)[j].ms = ProfilerSmooth((*results)[j].ms, 0.0);
+}
+
+// Lê os resultados das consultas de GPU de um quadro antigo, sem bloquear.
+static void ProfilerCollectGpu(ProfilerGpuFrame& frame)
+{
+    if (frame.count == 0)
+        return;
+
+    std::vector<ProfilerCpuRecord> samples;
+    double total = 0.0;
+    for (int i = 0; i < frame.count; ++i)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            // A GPU está mais de PROFILER_GPU_FRAMES quadros atrasada;
+            // descartamos o quadro em vez de esperar.
+            frame.count = 0;
+            return;
+        }
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &ns);
+
+        ProfilerCpuRecord sample;
+        sample.name  = frame.names[i];
+        sample.depth = 0;
+        sample.ms    = ns / 1.0e6;
+        samples.push_back(sample);
+        total += sample.ms;
+    }
+    frame.count = 0;
+
+    ProfilerAccumulate(&g_ProfilerGpuResults, samples, true, false);
+    g_ProfilerGpuFrameMs = ProfilerSmooth(g_ProfilerGpuFrameMs, total);
+    g_ProfilerLastGpuFrameMs = total;
+}
+
+void Profiler_Init()
+{
+    for (int f = 0; f < PROFILER_GPU_FRAMES; ++f)
+    {
+        glGenQueries(PROFILER_MAX_GPU_SCOPES, g_ProfilerGpuFrames[f].queries);
+        g_ProfilerGpuFrames[f].count = 0;
+    }
+    glCheckError();
+    g_ProfilerInitialized = true;
+}
+
+void Profiler_Shutdown()
+{
+    if (!g_ProfilerInitialized)
+        return;
+
+    for (int f = 0; f < PROFILER_GPU_FRAMES; ++f)
+        glDeleteQueries(PROFILER_MAX_GPU_SCOPES, g_ProfilerGpuFrames[f].queries);
+    g_ProfilerInitialized = false;
+}
+
+void Profiler_BeginFrame()
+{
+    if (!g_ProfilerInitialized)
+        return;
+
+    // O slot deste quadro foi usado PROFILER_GPU_FRAMES quadros atrás.
+    g_ProfilerLastGpuFrameMs = -1.0;
+    ProfilerCollectGpu(g_ProfilerGpuFrames[g_ProfilerFrame % PROFILER_GPU_FRAMES]);
+
+    g_ProfilerCpuRecords.clear();
+    g_ProfilerStack.clear();
+    g_ProfilerStackStart.clear();
+    g_ProfilerJobRecords.clear();
+    g_ProfilerFrameStart = ProfilerNowMs();
+    Trace_Begin("frame");
+}
+
+void Profiler_EndFrame()
+{
+    if (!g_ProfilerInitialized)
+        return;
+
+    while (!g_ProfilerStack.empty())
+        Profiler_EndScope();
+    if (g_ProfilerGpuActive)
+        Profiler_EndGpuScope();
+    Trace_End();
+
+    g_ProfilerLastCpuFrameMs = ProfilerNowMs() - g_ProfilerFrameStart;
+    g_ProfilerCpuFrameMs = ProfilerSmooth(g_ProfilerCpuFrameMs, g_ProfilerLastCpuFrameMs);
+    ProfilerAccumulate(&g_ProfilerCpuResults, g_ProfilerCpuRecords, false, false);
+    ProfilerAccumulate(&g_ProfilerJobResults, g_ProfilerJobRecords, false, true);
+
+    g_ProfilerResults = g_ProfilerCpuResults;
+    g_ProfilerResults.insert(g_ProfilerResults.end(), g_ProfilerJobResults.begin(), g_ProfilerJobResults.end());
+    g_ProfilerResults.insert(g_ProfilerResults.end(), g_ProfilerGpuResults.begin(), g_ProfilerGpuResults.end());
+
+    g_ProfilerFrame += 1;
+}
+
+void Profiler_BeginScope(const char* name)
+{
+    if (!g_ProfilerInitialized)
+        return;
+
+    int depth = (int)g_ProfilerStack.size();
+
+    size_t i = 0;
+    while (i < g_ProfilerCpuRecords.size() && !(g_ProfilerCpuRecords[i].depth == depth && strcmp(g_ProfilerCpuRecords[i].name, name) == 0))
+        ++i;
+    if (i == g_ProfilerCpuRecords.size())
+    {
+        ProfilerCpuRecord record;
+        record.name  = name;
+        record.depth = depth;
+        record.ms    = 0.0;
+        g_ProfilerCpuRecords.push_back(record);
+    }
+
+    g_ProfilerStack.push_back((int)i);
+    g_ProfilerStackStart.push_back(ProfilerNowMs());
+    Trace_Begin(name);
+}
+
+void Profiler_EndScope()
+{
+    if (g_ProfilerStack.empty())
+        return;
+
+    g_ProfilerCpuRecords[g_ProfilerStack.back()].ms += ProfilerNowMs() - g_ProfilerStackStart.back();
+    g_ProfilerStack.pop_back();
+    g_ProfilerStackStart.pop_back();
+    Trace_End();
+}
+
+void Profiler_AddJobTime(const char* name, double ms)
+{
+    if (!g_ProfilerInitialized)
+        return;
+
+    size_t i = 0;
+    while (i < g_ProfilerJobRecords.size() && strcmp(g_ProfilerJobRecords[i].name, name) != 0)
+        ++i;
+    if (i == g_ProfilerJobRecords.size())
+    {
+        ProfilerCpuRecord record;
+        record.name  = name;
+        record.depth = 0;
+        record.ms    = 0.0;
+        g_ProfilerJobRecords.push_back(record);
+    }
+    g_ProfilerJobRecords[i].ms += ms;
+}
+
+void Profiler_BeginGpuScope(const char* name)
+{
+    if (!g_ProfilerInitialized || g_ProfilerGpuActive)
+        return;
+
+    ProfilerGpuFrame& frame = g_ProfilerGpuFrames[g_ProfilerFrame % PROFILER_GPU_FRAMES];
+    if (frame.count == PROFILER_MAX_GPU_SCOPES)
+        return;
+
+    frame.names[frame.count] = name;
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.count]);
+    g_ProfilerGpuActive = true;
+}
+
+void Profiler_EndGpuScope()
+{
+    if (!g_ProfilerGpuActive)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    g_ProfilerGpuFrames[g_ProfilerFrame % PROFILER_GPU_FRAMES].count += 1;
+    g_ProfilerGpuActive = false;
+}
+
+size_t Profiler_GetResults(const ProfilerResult** results)
+{
+    *results = g_ProfilerResults.empty() ? NULL : &g_ProfilerResults[0];
+    return g_ProfilerResults.size();
+}
+
+double Profiler_GetCpuFrameMs()
+{
+    return g_ProfilerCpuFrameMs;
+}
+
+double Profiler_GetGpuFrameMs()
+{
+    return g_ProfilerGpuFrameMs;
+}
+
+double Profiler_GetLastCpuFrameMs()
+{
+    return g_ProfilerLastCpuFrameMs;
+}
+
+bool Profiler_GetLastGpuFrameMs(double* ms)
+{
+    if (g_ProfilerLastGpuFrameMs < 0.0)
+        return false;
+    *ms = g_ProfilerLastGpuFrameMs;
+    return true;
+}
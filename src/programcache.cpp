@@ -0,0 +1,244 @@
+// Cache de programas de GPU. Veja os comentários em "include/programcache.h".
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "utils.h"
+#include "programcache.h"
+
+// O carregador glad deste projeto só contém o OpenGL 3.3, então buscamos as
+// funções de GL_ARB_get_program_binary manualmente.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#endif
+
+typedef void (APIENTRYP PFNPROGRAMCACHEGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNPROGRAMCACHEPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNPROGRAMCACHEPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+static PFNPROGRAMCACHEGETPROGRAMBINARYPROC   g_glGetProgramBinary = NULL;
+static PFNPROGRAMCACHEPROGRAMBINARYPROC      g_glProgramBinary = NULL;
+static PFNPROGRAMCACHEPROGRAMPARAMETERIPROC  g_glProgramParameteri = NULL;
+
+static bool        g_ProgramCacheEnabled = false;
+static std::string g_ProgramCacheDirectory;
+static std::string g_ProgramCacheDriver; // Fabricante, renderizador e versão
+
+// Cabeçalho de cada arquivo do cache, seguido de "length" bytes do binário.
+struct ProgramCacheHeader
+{
+    char     magic[4];   // "PGBC"
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;     // "binaryFormat" de glGetProgramBinary()
+    uint32_t length;
+};
+
+static const uint32_t PROGRAMCACHE_VERSION = 1;
+
+static bool ProgramCacheHasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Hash FNV-1a de 64 bits.
+static uint64_t ProgramCacheHash(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t ProgramCacheKey(const std::vector<std::string>& sources)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash = ProgramCacheHash(hash, &PROGRAMCACHE_VERSION, sizeof(PROGRAMCACHE_VERSION));
+    hash = ProgramCacheHash(hash, g_ProgramCacheDriver.c_str(), g_ProgramCacheDriver.size() + 1);
+    for (size_t i = 0; i < sources.size(); ++i)
+        hash = ProgramCacheHash(hash, sources[i].c_str(), sources[i].size() + 1);
+    return hash;
+}
+
+static std::string ProgramCacheFilename(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return g_ProgramCacheDirectory + "/" + name;
+}
+
+void ProgramCache_Init(const char* directory)
+{
+    g_ProgramCacheEnabled = false;
+
+    bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1)
+                  || ProgramCacheHasExtension("GL_ARB_get_program_binary");
+    if (!supported)
+    {
+        printf("Cache de programas de GPU indisponível (sem GL_ARB_get_program_binary).\n");
+        return;
+    }
+
+    g_glGetProgramBinary   = (PFNPROGRAMCACHEGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+    g_glProgramBinary      = (PFNPROGRAMCACHEPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+    g_glProgramParameteri  = (PFNPROGRAMCACHEPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+
+    // Alguns drivers anunciam a extensão mas não suportam nenhum formato.
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    glCheckError();
+
+    if (!g_glGetProgramBinary || !g_glProgramBinary || !g_glProgramParameteri || formats == 0)
+    {
+        printf("Cache de programas de GPU indisponível (driver sem formatos de binário).\n");
+        return;
+    }
+
+    g_ProgramCacheDirectory = directory;
+    #ifdef _WIN32
+    _mkdir(directory);
+    #else
+    mkdir(directory, 0755);
+    #endif
+
+    g_ProgramCacheDriver  = (const char*)glGetString(GL_VENDOR);
+    g_ProgramCacheDriver += '\n';
+    g_ProgramCacheDriver += (const char*)glGetString(GL_RENDERER);
+    g_ProgramCacheDriver += '\n';
+    g_ProgramCacheDriver += (const char*)glGetString(GL_VERSION);
+
+    g_ProgramCacheEnabled = true;
+}
+
+GLuint ProgramCache_Load(const std::vector<std::string>& sources)
+{
+    if (!g_ProgramCacheEnabled)
+        return 0;
+
+    uint64_t key = ProgramCacheKey(sources);
+    std::string filename = ProgramCacheFilename(key);
+
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == NULL)
+        return 0;
+
+    ProgramCacheHeader header;
+    std::vector<char> binary;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+           && memcmp(header.magic, "PGBC", 4) == 0
+           && header.version == PROGRAMCACHE_VERSION
+           && header.key == key;
+    if (ok)
+    {
+        binary.resize(header.length);
+        ok = header.length > 0 && fread(binary.data(), 1, header.length, file) == header.length;
+    }
+    fclose(file);
+
+    GLuint program_id = 0;
+    if (ok)
+    {
+        program_id = glCreateProgram();
+        g_glProgramBinary(program_id, header.format, binary.data(), header.length);
+
+        // O driver pode rejeitar binários antigos (por exemplo, após uma
+        // atualização que não mudou a string de versão).
+        GLint linked_ok = GL_FALSE;
+        glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
+
+        // Erros de glProgramBinary() não devem aparecer em glCheckError()
+        // depois, e também contam como rejeição. O número de leituras é
+        // limitado: com o contexto perdido glGetError() pode nunca retornar
+        // GL_NO_ERROR.
+        for (int i = 0; i < 8 && glGetError() != GL_NO_ERROR; ++i)
+            linked_ok = GL_FALSE;
+
+        if (linked_ok == GL_FALSE)
+        {
+            glDeleteProgram(program_id);
+            program_id = 0;
+            ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        remove(filename.c_str());
+        return 0;
+    }
+
+    return program_id;
+}
+
+void ProgramCache_Store(GLuint program_id, const std::vector<std::string>& sources)
+{
+    if (!g_ProgramCacheEnabled)
+        return;
+
+    GLint linked_ok = GL_FALSE;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
+    GLint length = 0;
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (linked_ok == GL_FALSE || length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    g_glGetProgramBinary(program_id, length, &written, &format, binary.data());
+    glCheckError();
+    if (written <= 0)
+        return;
+
+    ProgramCacheHeader header;
+    memcpy(header.magic, "PGBC", 4);
+    header.version = PROGRAMCACHE_VERSION;
+    header.key     = ProgramCacheKey(sources);
+    header.format  = format;
+    header.length  = (uint32_t)written;
+
+    // Escrevemos em um arquivo temporário e renomeamos, para que uma execução
+    // interrompida nunca deixe um arquivo parcial no cache.
+    std::string filename = ProgramCacheFilename(header.key);
+    std::string temporary = filename + ".tmp";
+
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == NULL)
+        return;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+           && fwrite(binary.data(), 1, written, file) == (size_t)written;
+    ok = fclose(file) == 0 && ok;
+
+    remove(filename.c_str());
+    if (!ok || rename(temporary.c_str(), filename.c_str()) != 0)
+        remove(temporary.c_str());
+}
+
+void ProgramCache_PrepareForLink(GLuint program_id)
+{
+    if (g_ProgramCacheEnabled)
+        g_glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
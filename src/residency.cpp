@@ -0,0 +1,569 @@
+// Gerenciador de residência de assets. Veja os comentários em
+// "include/residency.h".
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+#include "utils.h"
+#include "objmodel.h"
+#include "trace.h"
+#include "residency.h"
+#include "texturestreaming.h"
+#include "startup.h"
+#include "memtrack.h"
+
+// Definidos em "main.cpp"
+extern std::map<std::string, SceneObject> g_VirtualScene;
+GpuMesh UploadMeshData(MeshData* mesh);
+
+enum ResidencyState
+{
+    RESIDENCY_UNLOADED,
+    RESIDENCY_LOADING,   // Na thread auxiliar (malhas) ou no envio assíncrono (texturas)
+    RESIDENCY_PARSED,    // Malha pronta em memória da CPU, aguardando envio
+    RESIDENCY_RESIDENT,
+    RESIDENCY_FAILED
+};
+
+struct ResidentTexture
+{
+    std::string    filename;
+    GLuint         textureunit;
+    int            object_id;
+    ResidencyState state;
+    int            request;      // Requisição em TextureStreaming_*
+    size_t         bytes;
+    unsigned long  last_used_frame;
+    bool           reload_pending; // Arquivo alterado no disco (Residency_Reload())
+    int            reload_request; // Nova versão sendo enviada, ou -1
+};
+
+struct ResidentMesh
+{
+    std::string                 filename;
+    std::vector<std::string>    object_names;
+    std::atomic<ResidencyState> state;
+    MeshData*                   cpu;  // Somente no estado RESIDENCY_PARSED
+    GpuMesh                     gpu;  // Somente no estado RESIDENCY_RESIDENT
+    size_t                      bytes;
+    unsigned long               last_used_frame;
+    bool                        reload_pending; // Arquivo alterado no disco (Residency_Reload())
+    bool                        reloading;      // Nova versão na thread auxiliar
+    MeshData*                   reload_cpu;     // Nova versão aguardando envio
+};
+
+static std::vector<ResidentTexture>  g_ResidentTextures;
+static std::vector<ResidentMesh*>    g_ResidentMeshes;
+static std::map<std::string, int>    g_ResidentObjectToMesh;
+static std::map<int, int>            g_ResidentObjectIdToTexture;
+
+static size_t         g_ResidencyVramBudget = 0;
+static size_t         g_ResidencyRamBudget = 0;
+static unsigned long  g_ResidencyFrame = 0;
+static ResidencyStats g_ResidencyStats;
+
+// Thread auxiliar que lê arquivos ".obj". O mutex protege "state", "cpu",
+// "bytes", "reloading" e "reload_cpu" das malhas, além da fila. "state" é
+// atômico para que Residency_UseObject(), chamada a cada desenho, possa lê-lo
+// sem o mutex: somente a thread principal leva uma malha a RESIDENCY_RESIDENT
+// ou RESIDENCY_UNLOADED, e a thread auxiliar só sai de RESIDENCY_LOADING.
+static std::mutex              g_ResidencyMutex;
+static std::condition_variable g_ResidencyCondition;
+static std::deque<int>         g_ResidencyQueue;
+static std::thread             g_ResidencyWorker;
+static bool                    g_ResidencyInitialized = false;
+
+// Libera uma cópia em memória da CPU criada pela thread auxiliar.
+static void ResidencyFreeMeshData(MeshData* data)
+{
+    if (data == NULL)
+        return;
+    MemTrack_CpuFree(MEM_MESHES, data->SizeInBytes());
+    delete data;
+}
+
+static void ResidencyWorkerLoop()
+{
+    Trace_SetThreadName("mesh loader");
+
+    for (;;)
+    {
+        int index;
+        ResidentMesh* mesh;
+        bool reload;
+        {
+            std::unique_lock<std::mutex> lock(g_ResidencyMutex);
+            while (g_ResidencyQueue.empty())
+                g_ResidencyCondition.wait(lock);
+            index = g_ResidencyQueue.front();
+            g_ResidencyQueue.pop_front();
+            if (index < 0)
+                return;
+            mesh = g_ResidentMeshes[index];
+            reload = mesh->state == RESIDENCY_RESIDENT;
+        }
+
+        Trace_Begin("parse OBJ");
+        Startup_BeginStep("parse", mesh->filename);
+        MeshData* data = new MeshData;
+        bool ok = true;
+        try
+        {
+            // O ObjModel (cópia completa de attrib/shapes) só existe neste escopo.
+            ObjModel model(mesh->filename.c_str());
+            ComputeNormals(&model);
+            BuildMeshData(&model, data);
+        }
+        catch (std::exception& e)
+        {
+            fprintf(stderr, "ERROR: Cannot load model \"%s\": %s\n", mesh->filename.c_str(), e.what());
+            ok = false;
+        }
+        Startup_EndStep();
+        Trace_End();
+        if (ok)
+            MemTrack_CpuAlloc(MEM_MESHES, data->SizeInBytes());
+
+        std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+        if (reload)
+        {
+            // Em caso de erro, a versão anterior continua residente.
+            if (!ok)
+                delete data;
+            else
+                mesh->reload_cpu = data;
+            mesh->reloading = false;
+            continue;
+        }
+        if (!ok)
+        {
+            delete data;
+            mesh->state = RESIDENCY_FAILED;
+            continue;
+        }
+        mesh->cpu   = data;
+        mesh->bytes = data->SizeInBytes();
+        mesh->state = RESIDENCY_PARSED;
+        g_ResidencyStats.ram_bytes += mesh->bytes;
+        if (g_ResidencyStats.ram_bytes > g_ResidencyStats.ram_peak_bytes)
+            g_ResidencyStats.ram_peak_bytes = g_ResidencyStats.ram_bytes;
+    }
+}
+
+void Residency_Init(size_t vram_budget_bytes, size_t ram_budget_bytes)
+{
+    if (g_ResidencyInitialized)
+        return;
+
+    g_ResidencyVramBudget = vram_budget_bytes;
+    g_ResidencyRamBudget  = ram_budget_bytes;
+    memset(&g_ResidencyStats, 0, sizeof(g_ResidencyStats));
+
+    g_ResidencyWorker = std::thread(ResidencyWorkerLoop);
+    g_ResidencyInitialized = true;
+}
+
+void Residency_Shutdown()
+{
+    if (!g_ResidencyInitialized)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+        g_ResidencyQueue.push_front(-1);
+    }
+    g_ResidencyCondition.notify_one();
+    g_ResidencyWorker.join();
+
+    for (size_t i = 0; i < g_ResidentMeshes.size(); ++i)
+    {
+        ResidencyFreeMeshData(g_ResidentMeshes[i]->cpu);
+        ResidencyFreeMeshData(g_ResidentMeshes[i]->reload_cpu);
+        delete g_ResidentMeshes[i];
+    }
+    g_ResidentMeshes.clear();
+    g_ResidentTextures.clear();
+    g_ResidentObjectToMesh.clear();
+    g_ResidentObjectIdToTexture.clear();
+
+    g_ResidencyInitialized = false;
+}
+
+void Residency_RegisterTexture(const char* filename, GLuint textureunit, int object_id)
+{
+    ResidentTexture texture;
+    texture.filename        = filename;
+    texture.textureunit     = textureunit;
+    texture.object_id       = object_id;
+    texture.state           = RESIDENCY_UNLOADED;
+    texture.request         = -1;
+    texture.bytes           = 0;
+    texture.last_used_frame = 0;
+    texture.reload_pending  = false;
+    texture.reload_request  = -1;
+
+    g_ResidentObjectIdToTexture[object_id] = (int)g_ResidentTextures.size();
+    g_ResidentTextures.push_back(texture);
+
+    TextureStreaming_BindPlaceholder(textureunit);
+}
+
+void Residency_RegisterMesh(const char* filename, const std::vector<std::string>& object_names)
+{
+    ResidentMesh* mesh = new ResidentMesh;
+    mesh->filename        = filename;
+    mesh->object_names    = object_names;
+    mesh->state           = RESIDENCY_UNLOADED;
+    mesh->cpu             = NULL;
+    mesh->bytes           = 0;
+    mesh->last_used_frame = 0;
+    mesh->reload_pending  = false;
+    mesh->reloading       = false;
+    mesh->reload_cpu      = NULL;
+    memset(&mesh->gpu, 0, sizeof(mesh->gpu));
+
+    std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+    int index = (int)g_ResidentMeshes.size();
+    g_ResidentMeshes.push_back(mesh);
+    for (size_t i = 0; i < object_names.size(); ++i)
+        g_ResidentObjectToMesh[object_names[i]] = index;
+}
+
+bool Residency_UseObject(const std::string& object_name)
+{
+    std::map<std::string, int>::iterator it = g_ResidentObjectToMesh.find(object_name);
+    if (it == g_ResidentObjectToMesh.end())
+        return g_VirtualScene.count(object_name) > 0;
+
+    ResidentMesh* mesh = g_ResidentMeshes[it->second];
+    mesh->last_used_frame = g_ResidencyFrame;
+
+    // Somente o pedido de carga precisa do mutex (veja g_ResidencyMutex).
+    ResidencyState state = mesh->state.load(std::memory_order_acquire);
+    if (state != RESIDENCY_UNLOADED)
+        return state == RESIDENCY_RESIDENT;
+
+    std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+    if (mesh->state == RESIDENCY_UNLOADED)
+    {
+        // O orçamento de RAM limita quantas cópias em CPU podem existir ao
+        // mesmo tempo; a malha será pedida de novo no próximo uso.
+        if (g_ResidencyStats.ram_bytes > 0 && g_ResidencyStats.ram_bytes >= g_ResidencyRamBudget)
+            return false;
+
+        mesh->state = RESIDENCY_LOADING;
+        g_ResidencyQueue.push_back(it->second);
+        g_ResidencyCondition.notify_one();
+    }
+    return mesh->state == RESIDENCY_RESIDENT;
+}
+
+void Residency_UseMaterial(int object_id)
+{
+    std::map<int, int>::iterator it = g_ResidentObjectIdToTexture.find(object_id);
+    if (it == g_ResidentObjectIdToTexture.end())
+        return;
+
+    ResidentTexture& texture = g_ResidentTextures[it->second];
+    texture.last_used_frame = g_ResidencyFrame;
+
+    if (texture.state == RESIDENCY_UNLOADED)
+    {
+        texture.request = TextureStreaming_Request(texture.filename.c_str(), texture.textureunit);
+        texture.state = RESIDENCY_LOADING;
+    }
+}
+
+static void ResidencyEvictTexture(ResidentTexture& texture)
+{
+    TextureStreaming_Release(texture.request);
+    g_ResidencyStats.vram_bytes -= texture.bytes;
+    g_ResidencyStats.evictions += 1;
+    texture.request = -1;
+    texture.bytes   = 0;
+    texture.state   = RESIDENCY_UNLOADED;
+    texture.reload_pending = false;
+}
+
+static void ResidencyEvictMesh(ResidentMesh* mesh)
+{
+    glDeleteVertexArrays(1, &mesh->gpu.vertex_array_object_id);
+    glDeleteBuffers(mesh->gpu.num_buffers, mesh->gpu.buffers);
+    MemTrack_GpuFree(MEM_MESHES, mesh->gpu.bytes);
+    for (size_t i = 0; i < mesh->object_names.size(); ++i)
+        g_VirtualScene.erase(mesh->object_names[i]);
+
+    g_ResidencyStats.vram_bytes -= mesh->bytes;
+    g_ResidencyStats.evictions += 1;
+    memset(&mesh->gpu, 0, sizeof(mesh->gpu));
+
+    std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+    mesh->bytes = 0;
+    mesh->state = RESIDENCY_UNLOADED;
+    mesh->reload_pending = false;
+}
+
+static size_t ResidencyTextureBytes(int request)
+{
+    int width, height;
+    TextureStreaming_GetSize(request, &width, &height);
+
+    // Drivers normalmente armazenam GL_SRGB8 com 4 bytes por texel; somamos
+    // a cadeia de mipmaps.
+    return MemTrack_TextureBytes(width, height, 4, true);
+}
+
+static void ResidencyUpdateTextureReload(ResidentTexture& texture)
+{
+    if (texture.reload_request < 0)
+    {
+        if (texture.reload_pending)
+        {
+            texture.reload_request = TextureStreaming_Reload(texture.request);
+            texture.reload_pending = false;
+        }
+        return;
+    }
+
+    TextureStreamState state = TextureStreaming_GetState(texture.reload_request);
+    if (state == TEXSTREAM_READY)
+    {
+        // TextureStreaming_Update() já trocou as texturas na unidade.
+        g_ResidencyStats.vram_bytes -= texture.bytes;
+        texture.request = texture.reload_request;
+        texture.bytes   = ResidencyTextureBytes(texture.request);
+        g_ResidencyStats.vram_bytes += texture.bytes;
+        g_ResidencyStats.reloads += 1;
+        texture.reload_request = -1;
+    }
+    else if (state == TEXSTREAM_FAILED)
+    {
+        TextureStreaming_Release(texture.reload_request);
+        texture.reload_request = -1;
+    }
+}
+
+// Troca a versão residente de uma malha pela versão recarregada. Retorna true
+// se houve envio para a GPU neste quadro.
+static bool ResidencyUpdateMeshReload(ResidentMesh* mesh, int index)
+{
+    MeshData* data = NULL;
+    {
+        std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+        if (mesh->reload_pending && !mesh->reloading && mesh->reload_cpu == NULL)
+        {
+            mesh->reload_pending = false;
+            mesh->reloading = true;
+            g_ResidencyQueue.push_back(index);
+            g_ResidencyCondition.notify_one();
+        }
+        data = mesh->reload_cpu;
+        mesh->reload_cpu = NULL;
+    }
+    if (data == NULL)
+        return false;
+
+    glDeleteVertexArrays(1, &mesh->gpu.vertex_array_object_id);
+    glDeleteBuffers(mesh->gpu.num_buffers, mesh->gpu.buffers);
+    MemTrack_GpuFree(MEM_MESHES, mesh->gpu.bytes);
+    for (size_t i = 0; i < mesh->object_names.size(); ++i)
+        g_VirtualScene.erase(mesh->object_names[i]);
+
+    g_ResidencyStats.vram_bytes -= mesh->bytes;
+    mesh->gpu = UploadMeshData(data);
+    g_ResidencyStats.vram_bytes += data->SizeInBytes();
+    g_ResidencyStats.reloads += 1;
+
+    std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+    mesh->bytes = data->SizeInBytes();
+    ResidencyFreeMeshData(data);
+    return true;
+}
+
+void Residency_Reload(const std::string& filename)
+{
+    for (size_t i = 0; i < g_ResidentTextures.size(); ++i)
+    {
+        ResidentTexture& texture = g_ResidentTextures[i];
+        if (texture.filename != filename)
+            continue;
+
+        if (texture.state == RESIDENCY_FAILED)
+        {
+            // Tentaremos de novo no próximo uso.
+            TextureStreaming_Release(texture.request);
+            texture.request = -1;
+            texture.state = RESIDENCY_UNLOADED;
+        }
+        else if (texture.state != RESIDENCY_UNLOADED)
+        {
+            texture.reload_pending = true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+    for (size_t i = 0; i < g_ResidentMeshes.size(); ++i)
+    {
+        ResidentMesh* mesh = g_ResidentMeshes[i];
+        if (mesh->filename != filename)
+            continue;
+
+        if (mesh->state == RESIDENCY_FAILED)
+            mesh->state = RESIDENCY_UNLOADED;
+        else if (mesh->state != RESIDENCY_UNLOADED)
+            mesh->reload_pending = true;
+    }
+}
+
+void Residency_Update()
+{
+    if (!g_ResidencyInitialized)
+        return;
+
+    g_ResidencyFrame += 1;
+
+    // Texturas: o envio é feito por TextureStreaming_Update(); aqui apenas
+    // contabilizamos as que terminaram.
+    for (size_t i = 0; i < g_ResidentTextures.size(); ++i)
+    {
+        ResidentTexture& texture = g_ResidentTextures[i];
+        if (texture.state == RESIDENCY_RESIDENT)
+        {
+            ResidencyUpdateTextureReload(texture);
+            continue;
+        }
+        if (texture.state != RESIDENCY_LOADING)
+            continue;
+
+        TextureStreamState state = TextureStreaming_GetState(texture.request);
+        if (state == TEXSTREAM_READY)
+        {
+            texture.bytes = ResidencyTextureBytes(texture.request);
+            texture.state = RESIDENCY_RESIDENT;
+            g_ResidencyStats.vram_bytes += texture.bytes;
+            g_ResidencyStats.loads += 1;
+        }
+        else if (state == TEXSTREAM_FAILED)
+        {
+            texture.state = RESIDENCY_FAILED;
+        }
+    }
+
+    // Malhas: enviamos no máximo uma por quadro, para distribuir o custo.
+    for (size_t i = 0; i < g_ResidentMeshes.size(); ++i)
+    {
+        ResidentMesh* mesh = g_ResidentMeshes[i];
+        MeshData* data = NULL;
+        {
+            std::unique_lock<std::mutex> lock(g_ResidencyMutex);
+            if (mesh->state == RESIDENCY_RESIDENT)
+            {
+                lock.unlock();
+                if (ResidencyUpdateMeshReload(mesh, (int)i))
+                    break;
+                continue;
+            }
+            if (mesh->state != RESIDENCY_PARSED)
+                continue;
+            data = mesh->cpu;
+            mesh->cpu = NULL;
+            g_ResidencyStats.ram_bytes -= mesh->bytes;
+        }
+
+        Startup_BeginStep("upload", mesh->filename);
+        mesh->gpu = UploadMeshData(data);
+        Startup_EndStep();
+        ResidencyFreeMeshData(data); // Liberamos a cópia em memória da CPU
+
+        {
+            std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+            mesh->state = RESIDENCY_RESIDENT;
+        }
+        g_ResidencyStats.vram_bytes += mesh->bytes;
+        g_ResidencyStats.loads += 1;
+        break;
+    }
+
+    if (g_ResidencyStats.vram_bytes > g_ResidencyStats.vram_peak_bytes)
+        g_ResidencyStats.vram_peak_bytes = g_ResidencyStats.vram_bytes;
+
+    // Liberamos os assets usados há mais tempo até voltar ao orçamento. Assets
+    // usados no último quadro nunca são liberados, para evitar que um mesmo
+    // asset seja carregado e liberado a cada quadro.
+    while (g_ResidencyStats.vram_bytes > g_ResidencyVramBudget)
+    {
+        unsigned long oldest = g_ResidencyFrame - 1;
+        ResidentTexture* texture = NULL;
+        ResidentMesh* mesh = NULL;
+
+        for (size_t i = 0; i < g_ResidentTextures.size(); ++i)
+        {
+            ResidentTexture& t = g_ResidentTextures[i];
+            if (t.state == RESIDENCY_RESIDENT && t.reload_request < 0 && t.last_used_frame < oldest)
+            {
+                oldest = t.last_used_frame;
+                texture = &t;
+            }
+        }
+        for (size_t i = 0; i < g_ResidentMeshes.size(); ++i)
+        {
+            ResidentMesh* m = g_ResidentMeshes[i];
+            if (m->state == RESIDENCY_RESIDENT && !m->reloading && m->reload_cpu == NULL && m->last_used_frame < oldest)
+            {
+                oldest = m->last_used_frame;
+                mesh = m;
+                texture = NULL;
+            }
+        }
+
+        if (mesh)
+            ResidencyEvictMesh(mesh);
+        else if (texture)
+            ResidencyEvictTexture(*texture);
+        else
+            break;
+    }
+}
+
+bool Residency_IsIdle()
+{
+    for (size_t i = 0; i < g_ResidentTextures.size(); ++i)
+        if (g_ResidentTextures[i].state == RESIDENCY_LOADING)
+            return false;
+
+    std::lock_guard<std::mutex> lock(g_ResidencyMutex);
+    for (size_t i = 0; i < g_ResidentMeshes.size(); ++i)
+    {
+        ResidencyState state = g_ResidentMeshes[i]->state;
+        if (state == RESIDENCY_LOADING || state == RESIDENCY_PARSED)
+            return false;
+    }
+    return true;
+}
+
+const ResidencyStats& Residency_GetStats()
+{
+    return g_ResidencyStats;
+}
+
+void Residency_PrintStats()
+{
+    const ResidencyStats& s = g_ResidencyStats;
+    printf("Residency: %.2f MB residentes (pico %.2f MB, orçamento %.2f MB), pico de %.2f MB em CPU\n",
+           s.vram_bytes / (1024.0*1024.0),
+           s.vram_peak_bytes / (1024.0*1024.0),
+           g_ResidencyVramBudget / (1024.0*1024.0),
+           s.ram_peak_bytes / (1024.0*1024.0));
+    printf("Residency: %lu carregamentos, %lu liberações, %lu recargas\n",
+           (unsigned long)s.loads, (unsigned long)s.evictions, (unsigned long)s.reloads);
+}
@@ -0,0 +1,228 @@
+// Geração de atlas SDF. Veja "include/sdfatlas.h".
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "sdfatlas.h"
+#include "assetpack.h"
+
+// Vetor até o ponto "marcado" mais próximo.
+struct SdfOffset
+{
+    int dx, dy, length2;
+};
+
+#define SDF_FAR 10000
+
+static inline void SdfCompare(SdfOffset* p, const SdfOffset* neighbour, int ox, int oy)
+{
+    int dx = neighbour->dx + ox;
+    int dy = neighbour->dy + oy;
+    int length2 = dx * dx + dy * dy;
+    if (length2 < p->length2)
+    {
+        p->dx = dx;
+        p->dy = dy;
+        p->length2 = length2;
+    }
+}
+
+// 8SSEDT (Danielsson): duas passadas em cada sentido propagam o vetor até o
+// ponto marcado mais próximo. "grid" começa com (0, 0) nos pontos marcados e
+// SDF_FAR nos demais.
+static void SdfPropagate(std::vector<SdfOffset>& grid, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        SdfOffset* row = &grid[y * width];
+        const SdfOffset* up = y > 0 ? row - width : NULL;
+        for (int x = 0; x < width; ++x)
+        {
+            if (x > 0)
+                SdfCompare(&row[x], &row[x - 1], -1, 0);
+            if (up)
+            {
+                SdfCompare(&row[x], &up[x], 0, -1);
+                if (x > 0)
+                    SdfCompare(&row[x], &up[x - 1], -1, -1);
+                if (x < width - 1)
+                    SdfCompare(&row[x], &up[x + 1], +1, -1);
+            }
+        }
+        for (int x = width - 2; x >= 0; --x)
+            SdfCompare(&row[x], &row[x + 1], +1, 0);
+    }
+    for (int y = height - 1; y >= 0; --y)
+    {
+        SdfOffset* row = &grid[y * width];
+        const SdfOffset* down = y < height - 1 ? row + width : NULL;
+        for (int x = width - 1; x >= 0; --x)
+        {
+            if (x < width - 1)
+                SdfCompare(&row[x], &row[x + 1], +1, 0);
+            if (down)
+            {
+                SdfCompare(&row[x], &down[x], 0, +1);
+                if (x > 0)
+                    SdfCompare(&row[x], &down[x - 1], -1, +1);
+                if (x < width - 1)
+                    SdfCompare(&row[x], &down[x + 1], +1, +1);
+            }
+        }
+        for (int x = 1; x < width; ++x)
+            SdfCompare(&row[x], &row[x - 1], -1, 0);
+    }
+}
+
+// Cobertura interpolada no ponto (u, v), em texels do atlas.
+static float SdfSample(const unsigned char* coverage, int width, int height, float u, float v)
+{
+    u = std::min(std::max(u - 0.5f, 0.0f), (float)(width - 1));
+    v = std::min(std::max(v - 0.5f, 0.0f), (float)(height - 1));
+    int x0 = (int)u, y0 = (int)v;
+    int x1 = std::min(x0 + 1, width - 1), y1 = std::min(y0 + 1, height - 1);
+    float fx = u - x0, fy = v - y0;
+    float a = coverage[y0 * width + x0] + (coverage[y0 * width + x1] - coverage[y0 * width + x0]) * fx;
+    float b = coverage[y1 * width + x0] + (coverage[y1 * width + x1] - coverage[y1 * width + x0]) * fx;
+    return (a + (b - a) * fy) / 255.0f;
+}
+
+void SdfAtlas_Generate(const unsigned char* coverage, int width, int height, unsigned char* sdf,
+                       float spread, int supersample)
+{
+    int hw = width * supersample;
+    int hh = height * supersample;
+    std::vector<unsigned char> inside(hw * hh);
+    for (int y = 0; y < hh; ++y)
+        for (int x = 0; x < hw; ++x)
+            inside[y * hw + x] = SdfSample(coverage, width, height,
+                                           (x + 0.5f) / supersample, (y + 0.5f) / supersample) >= 0.5f;
+
+    // Distância de cada ponto até o ponto mais próximo do lado oposto.
+    SdfOffset zero = { 0, 0, 0 };
+    SdfOffset far  = { SDF_FAR, SDF_FAR, 2 * SDF_FAR * SDF_FAR };
+    std::vector<SdfOffset> to_inside(hw * hh), to_outside(hw * hh);
+    for (int i = 0; i < hw * hh; ++i)
+    {
+        to_inside[i]  = inside[i] ? zero : far;
+        to_outside[i] = inside[i] ? far : zero;
+    }
+    SdfPropagate(to_inside, hw, hh);
+    SdfPropagate(to_outside, hw, hh);
+
+    // A borda fica a meio texel do centro do texel mais próximo do outro
+    // lado. Distâncias positivas dentro do glifo, em texels do atlas.
+    float scale = 1.0f / supersample;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            float sum = 0.0f;
+            for (int sy = 0; sy < supersample; ++sy)
+            {
+                for (int sx = 0; sx < supersample; ++sx)
+                {
+                    int i = (y * supersample + sy) * hw + (x * supersample + sx);
+                    float d = inside[i] ? std::sqrt((float)to_outside[i].length2) - 0.5f
+                                        : 0.5f - std::sqrt((float)to_inside[i].length2);
+                    sum += d * scale;
+                }
+            }
+            float distance = sum / (supersample * supersample);
+            float value = 0.5f + 0.5f * distance / spread;
+            sdf[y * width + x] = (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    }
+}
+
+void SdfFont_Bake(const texture_font_t* font, std::vector<unsigned char>* binary)
+{
+    SdfFontHeader header;
+    memcpy(header.magic, "SDFF", 4);
+    header.version     = SDFFONT_VERSION;
+    header.tex_width   = (uint32_t)font->tex_width;
+    header.tex_height  = (uint32_t)font->tex_height;
+    header.height      = font->height;
+    header.glyph_count = (uint32_t)font->glyphs_count;
+
+    size_t glyphs_offset = sizeof(header);
+    size_t sdf_offset    = glyphs_offset + font->glyphs_count * sizeof(SdfFontGlyph);
+    binary->assign(sdf_offset + font->tex_width * font->tex_height, 0);
+    memcpy(binary->data(), &header, sizeof(header));
+
+    for (size_t i = 0; i < font->glyphs_count; ++i)
+    {
+        const texture_glyph_t& in = font->glyphs[i];
+        SdfFontGlyph out;
+        out.codepoint = in.codepoint;
+        out.width     = in.width;
+        out.height    = in.height;
+        out.offset_x  = in.offset_x;
+        out.offset_y  = in.offset_y;
+        out.advance_x = in.advance_x;
+        out.advance_y = in.advance_y;
+        out.s0 = in.s0;
+        out.t0 = in.t0;
+        out.s1 = in.s1;
+        out.t1 = in.t1;
+        out.kerning_count     = in.kerning_count > 0 ? 1 : 0;
+        out.kerning_codepoint = in.kerning[0].codepoint;
+        out.kerning           = in.kerning[0].kerning;
+        memcpy(binary->data() + glyphs_offset + i * sizeof(out), &out, sizeof(out));
+    }
+
+    SdfAtlas_Generate(font->tex_data, (int)font->tex_width, (int)font->tex_height, binary->data() + sdf_offset);
+}
+
+bool SdfFont_LoadMemory(const unsigned char* binary, size_t size, SdfFont* font)
+{
+    SdfFontHeader header;
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, binary, sizeof(header));
+    if (memcmp(header.magic, "SDFF", 4) != 0 || header.version != SDFFONT_VERSION)
+        return false;
+
+    uint64_t glyphs_offset = sizeof(header);
+    uint64_t sdf_offset    = glyphs_offset + (uint64_t)header.glyph_count * sizeof(SdfFontGlyph);
+    if (sdf_offset + (uint64_t)header.tex_width * header.tex_height != size)
+        return false;
+
+    font->tex_width  = (int)header.tex_width;
+    font->tex_height = (int)header.tex_height;
+    font->height     = header.height;
+    font->glyphs.resize(header.glyph_count);
+    for (size_t i = 0; i < header.glyph_count; ++i)
+    {
+        SdfFontGlyph in;
+        memcpy(&in, binary + glyphs_offset + i * sizeof(in), sizeof(in));
+        texture_glyph_t& out = font->glyphs[i];
+        out.codepoint = in.codepoint;
+        out.width     = in.width;
+        out.height    = in.height;
+        out.offset_x  = in.offset_x;
+        out.offset_y  = in.offset_y;
+        out.advance_x = in.advance_x;
+        out.advance_y = in.advance_y;
+        out.s0 = in.s0;
+        out.t0 = in.t0;
+        out.s1 = in.s1;
+        out.t1 = in.t1;
+        out.kerning_count        = in.kerning_count;
+        out.kerning[0].codepoint = in.kerning_codepoint;
+        out.kerning[0].kerning   = in.kerning;
+    }
+    font->sdf.assign(binary + sdf_offset, binary + size);
+    return true;
+}
+
+bool SdfFont_Load(const char* name, SdfFont* font)
+{
+    AssetBlob blob;
+    if (!AssetPack_Load(name, &blob))
+        return false;
+    bool ok = SdfFont_LoadMemory(blob.data, blob.size, font);
+    AssetPack_Free(&blob);
+    return ok;
+}
@@ -0,0 +1,253 @@
+// Linha do tempo da inicialização. Veja os comentários em "include/startup.h".
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "startup.h"
+#include "assetpack.h"
+
+struct StartupStep
+{
+    const char* category;
+    std::string name;
+    std::string thread;
+    double      start_ms;   // Desde Startup_Init()
+    double      wall_ms;
+    double      cpu_ms;
+    size_t      bytes;      // Lidos pela própria thread (veja AssetPack_GetBytesRead())
+
+    // O mesmo, sem as etapas aninhadas nesta; são esses valores que entram
+    // nos totais por categoria, para que nada seja contado duas vezes.
+    double      self_wall_ms;
+    double      self_cpu_ms;
+    size_t      self_bytes;
+};
+
+// Etapa em andamento em uma thread (as etapas podem ser aninhadas).
+struct StartupOpenStep
+{
+    StartupStep step;
+    double      cpu_start_ms;
+    size_t      bytes_start;
+    double      child_wall_ms;  // Soma das etapas aninhadas já terminadas
+    double      child_cpu_ms;
+    size_t      child_bytes;
+};
+
+static std::mutex                    g_StartupMutex;
+static std::vector<StartupStep>      g_StartupSteps;
+static bool                          g_StartupActive = false;
+static double                        g_StartupOrigin = 0.0;
+static double                        g_StartupFirstFrameMs = -1.0;
+static int                           g_StartupThreadCount = 0;
+
+static thread_local std::vector<StartupOpenStep> t_StartupOpen;
+static thread_local int                          t_StartupThread = -1;
+
+static double StartupNowMs()
+{
+    typedef std::chrono::steady_clock clock;
+    return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+}
+
+// Tempo de CPU gasto pela thread atual.
+static double StartupThreadCpuMs()
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;   u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) / 10000.0; // Unidades de 100 ns
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0.0;
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+void Startup_Init()
+{
+    std::lock_guard<std::mutex> lock(g_StartupMutex);
+    g_StartupOrigin = StartupNowMs();
+    g_StartupSteps.clear();
+    g_StartupFirstFrameMs = -1.0;
+    g_StartupActive = true;
+}
+
+bool Startup_IsActive()
+{
+    std::lock_guard<std::mutex> lock(g_StartupMutex);
+    return g_StartupActive;
+}
+
+void Startup_BeginStep(const char* category, const std::string& name)
+{
+    // Registramos a etapa mesmo que a inicialização termine antes do seu fim;
+    // Startup_EndStep() a descarta nesse caso.
+    StartupOpenStep open;
+    open.step.category = category;
+    open.step.name     = name;
+    open.step.start_ms = StartupNowMs();
+    open.cpu_start_ms  = StartupThreadCpuMs();
+    open.bytes_start   = AssetPack_GetBytesRead();
+    open.child_wall_ms = 0.0;
+    open.child_cpu_ms  = 0.0;
+    open.child_bytes   = 0;
+    t_StartupOpen.push_back(open);
+}
+
+void Startup_EndStep()
+{
+    if (t_StartupOpen.empty())
+        return;
+
+    StartupOpenStep open = t_StartupOpen.back();
+    t_StartupOpen.pop_back();
+
+    StartupStep& step = open.step;
+    step.wall_ms = StartupNowMs() - step.start_ms;
+    step.cpu_ms  = StartupThreadCpuMs() - open.cpu_start_ms;
+    step.bytes   = AssetPack_GetBytesRead() - open.bytes_start;
+    step.self_wall_ms = step.wall_ms - open.child_wall_ms;
+    step.self_cpu_ms  = step.cpu_ms - open.child_cpu_ms;
+    step.self_bytes   = step.bytes - open.child_bytes;
+
+    if (!t_StartupOpen.empty())
+    {
+        StartupOpenStep& parent = t_StartupOpen.back();
+        parent.child_wall_ms += step.wall_ms;
+        parent.child_cpu_ms  += step.cpu_ms;
+        parent.child_bytes   += step.bytes;
+    }
+
+    std::lock_guard<std::mutex> lock(g_StartupMutex);
+    if (!g_StartupActive)
+        return;
+
+    // As threads são numeradas na ordem em que aparecem; a thread principal
+    // (que chama Startup_Init()) registra a primeira etapa.
+    if (t_StartupThread < 0)
+        t_StartupThread = g_StartupThreadCount++;
+    char thread[32];
+    snprintf(thread, sizeof(thread), t_StartupThread == 0 ? "main" : "worker %d", t_StartupThread);
+
+    step.thread   = thread;
+    step.start_ms -= g_StartupOrigin;
+    g_StartupSteps.push_back(step);
+}
+
+void Startup_FirstFrame()
+{
+    std::lock_guard<std::mutex> lock(g_StartupMutex);
+    if (g_StartupActive && g_StartupFirstFrameMs < 0.0)
+        g_StartupFirstFrameMs = StartupNowMs() - g_StartupOrigin;
+}
+
+static void StartupWriteJsonString(FILE* file, const std::string& s)
+{
+    fputc('"', file);
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        char c = s[i];
+        if (c == '"' || c == '\\')
+            fputc('\\', file);
+        if ((unsigned char)c >= 0x20)
+            fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+void Startup_Finish(const char* json_filename)
+{
+    std::vector<StartupStep> steps;
+    double first_frame_ms, total_ms;
+    {
+        std::lock_guard<std::mutex> lock(g_StartupMutex);
+        if (!g_StartupActive)
+            return;
+        g_StartupActive = false;
+        steps.swap(g_StartupSteps);
+        first_frame_ms = g_StartupFirstFrameMs;
+        total_ms = StartupNowMs() - g_StartupOrigin;
+    }
+
+    std::stable_sort(steps.begin(), steps.end(),
+                     [](const StartupStep& a, const StartupStep& b) { return a.wall_ms > b.wall_ms; });
+
+    // Totais por categoria, também ordenados pelo tempo real. Cada etapa
+    // contribui somente com o tempo fora das etapas aninhadas nela.
+    std::vector<StartupStep> categories;
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        size_t c = 0;
+        while (c < categories.size() && categories[c].name != steps[i].category)
+            ++c;
+        if (c == categories.size())
+        {
+            StartupStep total = StartupStep();
+            total.name = steps[i].category;
+            categories.push_back(total);
+        }
+        categories[c].wall_ms += steps[i].self_wall_ms;
+        categories[c].cpu_ms  += steps[i].self_cpu_ms;
+        categories[c].bytes   += steps[i].self_bytes;
+    }
+    std::stable_sort(categories.begin(), categories.end(),
+                     [](const StartupStep& a, const StartupStep& b) { return a.wall_ms > b.wall_ms; });
+
+    printf("Startup: first frame after %.1f ms, all assets resident after %.1f ms\n", first_frame_ms, total_ms);
+    printf("  category      wall ms    cpu ms      bytes\n");
+    for (size_t i = 0; i < categories.size(); ++i)
+        printf("  %-10s %10.2f %9.2f %10lu\n", categories[i].name.c_str(),
+               categories[i].wall_ms, categories[i].cpu_ms, (unsigned long)categories[i].bytes);
+    printf("  category   thread      start ms    wall ms    cpu ms      bytes  step\n");
+    for (size_t i = 0; i < steps.size(); ++i)
+        printf("  %-10s %-9s %10.2f %10.2f %9.2f %10lu  %s\n", steps[i].category, steps[i].thread.c_str(),
+               steps[i].start_ms, steps[i].wall_ms, steps[i].cpu_ms, (unsigned long)steps[i].bytes, steps[i].name.c_str());
+
+    if (json_filename == NULL)
+        return;
+
+    FILE* file = fopen(json_filename, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot create startup report \"%s\".\n", json_filename);
+        return;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"first_frame_ms\": %.3f,\n", first_frame_ms);
+    fprintf(file, "  \"assets_resident_ms\": %.3f,\n", total_ms);
+    fprintf(file, "  \"categories\": [");
+    for (size_t i = 0; i < categories.size(); ++i)
+    {
+        fprintf(file, "%s\n    {\"category\": ", i > 0 ? "," : "");
+        StartupWriteJsonString(file, categories[i].name);
+        fprintf(file, ", \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"bytes\": %lu}",
+                categories[i].wall_ms, categories[i].cpu_ms, (unsigned long)categories[i].bytes);
+    }
+    fprintf(file, "\n  ],\n");
+    fprintf(file, "  \"steps\": [");
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        fprintf(file, "%s\n    {\"category\": \"%s\", \"name\": ", i > 0 ? "," : "", steps[i].category);
+        StartupWriteJsonString(file, steps[i].name);
+        fprintf(file, ", \"thread\": \"%s\", \"start_ms\": %.3f, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"bytes\": %lu}",
+                steps[i].thread.c_str(), steps[i].start_ms, steps[i].wall_ms, steps[i].cpu_ms, (unsigned long)steps[i].bytes);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+}
@@ -0,0 +1,236 @@
+// Gerador de cenas de estresse. Veja "include/stressscene.h".
+#include <cmath>
+#include <algorithm>
+
+#include "stressscene.h"
+
+// Largura da porta no meio de cada parede do contorno de uma sala.
+#define STRESS_DOOR_WIDTH 6.0f
+// Espaço entre salas vizinhas.
+#define STRESS_ROOM_GAP   10.0f
+
+// Gerador pseudo-aleatório xorshift32; não usamos rand() para que a cena não
+// dependa da biblioteca C nem de outras chamadas a rand().
+struct StressRandom
+{
+    unsigned state;
+
+    explicit StressRandom(unsigned seed) : state(seed != 0 ? seed : 0x9E3779B9u) {}
+
+    unsigned Next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Entre "a" e "b".
+    float Range(float a, float b)
+    {
+        return a + (b - a) * ((Next() >> 8) / 16777216.0f);
+    }
+};
+
+static bbox StressBox(float x0, float z0, float x1, float z1, float height)
+{
+    bbox box;
+    box.bbox_min = glm::vec4(std::min(x0, x1), 0, std::min(z0, z1), 0);
+    box.bbox_max = glm::vec4(std::max(x0, x1), height, std::max(z0, z1), 0);
+    box.angle = boxAngle(box.bbox_min, box.bbox_max);
+    return box;
+}
+
+// Caixa de colisão de uma plataforma em "position": a mesma extensão do
+// objeto desenhado (escala 2 x 0.25 x 2), inclusive em y, já que ela se move
+// na altura e não vai até o chão.
+static bbox StressPlatformBox(const glm::vec3& position)
+{
+    bbox box;
+    box.bbox_min = glm::vec4(position.x - 2.0f, position.y - 0.25f, position.z - 2.0f, 0);
+    box.bbox_max = glm::vec4(position.x + 2.0f, position.y + 0.25f, position.z + 2.0f, 0);
+    box.angle = boxAngle(box.bbox_min, box.bbox_max);
+    return box;
+}
+
+// Parede de (x0, z0) a (x1, z1), paralela ao eixo X ou ao eixo Z, visível no
+// lado para onde aponta "yaw". Com "both_sides", uma segunda cópia virada
+// para o lado oposto também é desenhada.
+static void StressAddWall(const StressSceneParams& params, StressScene* scene,
+                          float x0, float z0, float x1, float z1, float yaw, bool both_sides)
+{
+    float half_length = 0.5f * (std::fabs(x1 - x0) + std::fabs(z1 - z0));
+
+    StressObject wall;
+    wall.kind     = STRESS_WALL;
+    wall.position = glm::vec3(0.5f * (x0 + x1), params.origin.y + params.wall_height, 0.5f * (z0 + z1));
+    wall.scale    = glm::vec3(half_length, params.wall_height, 0.0f);
+    wall.yaw      = yaw;
+    scene->objects.push_back(wall);
+    if (both_sides)
+    {
+        wall.yaw = yaw + 3.141592f;
+        scene->objects.push_back(wall);
+    }
+
+    bbox box = StressBox(x0, z0, x1, z1, params.wall_height);
+    scene->colliders.push_back(box);
+    scene->portal_surfaces.push_back(box);
+    scene->walls += 1;
+}
+
+// Contorno de uma sala: em cada lado, dois segmentos com uma porta no meio,
+// todos visíveis pelo lado de dentro.
+static void StressAddRoomWalls(const StressSceneParams& params, StressScene* scene, float cx, float cz)
+{
+    float h = 0.5f * params.room_size;
+    float d = 0.5f * STRESS_DOOR_WIDTH;
+    const float pi = 3.141592f;
+
+    StressAddWall(params, scene, cx - h, cz - h, cx - d, cz - h, 0.0f, false);
+    StressAddWall(params, scene, cx + d, cz - h, cx + h, cz - h, 0.0f, false);
+    StressAddWall(params, scene, cx - h, cz + h, cx - d, cz + h, pi, false);
+    StressAddWall(params, scene, cx + d, cz + h, cx + h, cz + h, pi, false);
+    StressAddWall(params, scene, cx - h, cz - h, cx - h, cz - d, pi / 2.0f, false);
+    StressAddWall(params, scene, cx - h, cz + d, cx - h, cz + h, pi / 2.0f, false);
+    StressAddWall(params, scene, cx + h, cz - h, cx + h, cz - d, -pi / 2.0f, false);
+    StressAddWall(params, scene, cx + h, cz + d, cx + h, cz + h, -pi / 2.0f, false);
+}
+
+void StressScene_Generate(const StressSceneParams& params, StressScene* scene)
+{
+    scene->objects.clear();
+    scene->platforms.clear();
+    scene->platform_curves.clear();
+    scene->platform_arcs.clear();
+    scene->colliders.clear();
+    scene->portal_surfaces.clear();
+    scene->walls = 0;
+    scene->props = 0;
+
+    if (params.rooms <= 0)
+        return;
+
+    StressRandom random(params.seed);
+
+    int   columns = (int)std::ceil(std::sqrt((double)params.rooms));
+    float spacing = params.room_size + STRESS_ROOM_GAP;
+    float h       = 0.5f * params.room_size;
+    float inner   = h - 2.0f;       // Margem para não encostar no contorno
+    float floor_y = params.origin.y;
+    const float pi = 3.141592f;
+
+    for (int room = 0; room < params.rooms; ++room)
+    {
+        float cx = params.origin.x + (room % columns) * spacing + h;
+        float cz = params.origin.z + (room / columns) * spacing + h;
+
+        StressObject floor;
+        floor.kind     = STRESS_FLOOR;
+        floor.position = glm::vec3(cx, floor_y, cz);
+        floor.scale    = glm::vec3(h, 0.5f * params.wall_height, h);
+        floor.yaw      = 0.0f;
+        scene->objects.push_back(floor);
+
+        StressAddRoomWalls(params, scene, cx, cz);
+
+        // Paredes internas, paralelas ao eixo X ou ao eixo Z, visíveis pelos
+        // dois lados.
+        for (int i = 0; i < params.walls_per_room; ++i)
+        {
+            float length = random.Range(4.0f, params.room_size / 3.0f);
+            float x = cx + random.Range(-inner + length / 2, inner - length / 2);
+            float z = cz + random.Range(-inner + length / 2, inner - length / 2);
+            if (random.Next() & 1)
+                StressAddWall(params, scene, x - length / 2, z, x + length / 2, z, 0.0f, true);
+            else
+                StressAddWall(params, scene, x, z - length / 2, x, z + length / 2, pi / 2.0f, true);
+        }
+
+        // Objetos no chão: cubos de tamanhos variados e cubos de companhia,
+        // com a mesma caixa de colisão do cubo da fase.
+        for (int i = 0; i < params.props_per_room; ++i)
+        {
+            StressObject prop;
+            float x = cx + random.Range(-inner, inner);
+            float z = cz + random.Range(-inner, inner);
+            if (random.Next() & 1)
+            {
+                float size = random.Range(0.5f, 1.5f);
+                prop.kind     = STRESS_PROP_CUBE;
+                prop.position = glm::vec3(x, floor_y + size, z);
+                prop.scale    = glm::vec3(size);
+            }
+            else
+            {
+                prop.kind     = STRESS_PROP_COMPANION;
+                prop.position = glm::vec3(x, floor_y + 1.25f, z);
+                prop.scale    = glm::vec3(1.0f);
+            }
+            prop.yaw = random.Range(0.0f, 2.0f * pi);
+            scene->objects.push_back(prop);
+            scene->colliders.push_back(StressBox(x - 1.2f, z - 1.2f, x + 1.2f, z + 1.2f, params.wall_height));
+            scene->props += 1;
+        }
+
+        // Plataformas: quatro pontos de controle sorteados dentro da sala,
+        // entre o piso e o topo das paredes.
+        for (int i = 0; i < params.platforms_per_room; ++i)
+        {
+            BezierCurve<3> curve;
+            for (int p = 0; p < 4; ++p)
+                curve.points[p] = glm::vec3(cx + random.Range(-inner, inner),
+                                            floor_y + random.Range(1.0f, params.wall_height),
+                                            cz + random.Range(-inner, inner));
+            BezierArcLength arc;
+            Bezier_BakeArcLength(curve, &arc);
+
+            StressPlatform platform;
+            platform.period = random.Range(3.0f, 8.0f);
+            platform.phase  = random.Range(0.0f, 2.0f);
+
+            StressObject object;
+            object.kind     = STRESS_PLATFORM;
+            object.position = curve.points[0];
+            object.scale    = glm::vec3(2.0f, 0.25f, 2.0f);
+            object.yaw      = 0.0f;
+
+            platform.object   = (int)scene->objects.size();
+            platform.collider = (int)scene->colliders.size();
+            scene->objects.push_back(object);
+            scene->colliders.push_back(StressPlatformBox(object.position));
+            scene->platforms.push_back(platform);
+            scene->platform_curves.push_back(curve);
+            scene->platform_arcs.push_back(arc);
+        }
+    }
+
+    StressScene_Update(scene, 0.0);
+}
+
+void StressScene_Update(StressScene* scene, double time)
+{
+    size_t count = scene->platforms.size();
+    scene->platform_fractions.resize(count);
+    scene->platform_positions.resize(count);
+
+    // Ida e volta ao longo da curva, como o cubo móvel da fase.
+    for (size_t i = 0; i < count; ++i)
+    {
+        const StressPlatform& platform = scene->platforms[i];
+        float f = (float)std::fmod(time / platform.period + platform.phase, 2.0);
+        scene->platform_fractions[i] = f > 1.0f ? 2.0f - f : f;
+    }
+
+    Bezier_EvaluateUniformBatch(scene->platform_curves.data(), scene->platform_arcs.data(),
+                                scene->platform_fractions.data(), scene->platform_positions.data(), count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const StressPlatform& platform = scene->platforms[i];
+        const glm::vec3& position = scene->platform_positions[i];
+        scene->objects[platform.object].position = position;
+
+        scene->colliders[platform.collider] = StressPlatformBox(position);
+    }
+}
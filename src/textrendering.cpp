@@ -1,6 +1,8 @@
 // Based on http://hamelot.io/visualization/opengl-text-without-any-external-libraries/
 //   and on https://github.com/rougier/freetype-gl
+#include <cstdlib>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -9,7 +11,11 @@
 #include <glm/vec4.hpp>
 
 #include "utils.h"
-#include "dejavufont.h"
+#include "textglyphs.h"
+#include "programcache.h"
+#include "memtrack.h"
+#include "textobject.h"
+#include "sdfatlas.h"
 
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Função definida em main.cpp
 
@@ -31,7 +37,11 @@ const GLchar* const textfragmentshader_source = ""
 "out vec4 fragColor;\n"
 "void main()\n"
 "{\n"
-    "fragColor = vec4(0, 0, 0, texture(tex, texCoords).r);\n"
+    // O atlas guarda distâncias com sinal, 0.5 na borda do glifo (veja
+    // "sdfatlas.h"); suavizamos a borda ao longo de cerca de um pixel.
+    "float d = texture(tex, texCoords).r;\n"
+    "float w = max(0.7 * fwidth(d), 1e-4);\n"
+    "fragColor = vec4(0, 0, 0, smoothstep(0.5 - w, 0.5 + w, d));\n"
 "}\n"
 "\0";
 
@@ -87,6 +97,23 @@ GLuint textVBO;
 GLuint textprogram_id;
 GLuint texttexture_id;
 
+// Vértices (x, y, s, t) de todos os glifos impressos no quadro, desenhados de
+// uma só vez por TextRendering_Flush(). "textVBO" é reespecificado a cada
+// envio (orphaning) e só cresce.
+typedef std::vector<float, MemTrackAllocator<float, MEM_TEXT> > TextVertexList;
+TextVertexList textvertices;
+size_t textbuffer_bytes = 0;
+
+// Fonte com o atlas SDF pré-gerado por "mkpack" (veja "sdfatlas.h").
+SdfFont textfont;
+TextGlyphTable textglyphs;
+
+// Tamanho da janela em coordenadas de tela, atualizado por
+// FramebufferSizeCallback() em "main.cpp" através de
+// TextRendering_SetWindowSize().
+int textwindow_width  = 800;
+int textwindow_height = 600;
+
 void TextRendering_Init()
 {
     GLuint sampler;
@@ -101,33 +128,51 @@ void TextRendering_Init()
     glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glCheckError();
 
-    GLuint textvertexshader_id = glCreateShader(GL_VERTEX_SHADER);
-    TextRendering_LoadShader(textvertexshader_source, textvertexshader_id);
-    glCheckError();
+    std::vector<std::string> sources;
+    sources.push_back(textvertexshader_source);
+    sources.push_back(textfragmentshader_source);
 
-    GLuint textfragmentshader_id = glCreateShader(GL_FRAGMENT_SHADER);
-    TextRendering_LoadShader(textfragmentshader_source, textfragmentshader_id);
-    glCheckError();
+    textprogram_id = ProgramCache_Load(sources);
+    if (textprogram_id == 0)
+    {
+        GLuint textvertexshader_id = glCreateShader(GL_VERTEX_SHADER);
+        TextRendering_LoadShader(textvertexshader_source, textvertexshader_id);
+        glCheckError();
 
-    textprogram_id = CreateGpuProgram(textvertexshader_id, textfragmentshader_id);
-    glLinkProgram(textprogram_id);
-    glCheckError();
+        GLuint textfragmentshader_id = glCreateShader(GL_FRAGMENT_SHADER);
+        TextRendering_LoadShader(textfragmentshader_source, textfragmentshader_id);
+        glCheckError();
+
+        textprogram_id = CreateGpuProgram(textvertexshader_id, textfragmentshader_id);
+        glLinkProgram(textprogram_id);
+        glCheckError();
+
+        ProgramCache_Store(textprogram_id, sources);
+    }
 
     GLuint texttex_uniform;
     texttex_uniform = glGetUniformLocation(textprogram_id, "tex");
     glCheckError();
 
+    // O atlas da fonte já vem convertido em campo de distâncias, que continua
+    // nítido quando o texto é ampliado por "textscale".
+    if (!SdfFont_Load(SDFFONT_FILE, &textfont))
+    {
+        fprintf(stderr, "ERROR: Cannot load font \"%s\" (run \"make pack\" to rebuild it).\n", SDFFONT_FILE);
+        std::exit(EXIT_FAILURE);
+    }
+
     GLuint textureunit = 31;
     glActiveTexture(GL_TEXTURE0 + textureunit);
     glBindTexture(GL_TEXTURE_2D, texttexture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, dejavufont.tex_width, dejavufont.tex_height, 0, GL_RED, GL_UNSIGNED_BYTE, dejavufont.tex_data);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, textfont.tex_width, textfont.tex_height, 0, GL_RED, GL_UNSIGNED_BYTE, textfont.sdf.data());
+    MemTrack_GpuAlloc(MEM_TEXT, MemTrack_TextureBytes(textfont.tex_width, textfont.tex_height, 1, false));
     glBindSampler(textureunit, sampler);
     glCheckError();
 
     glBindVertexArray(textVAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
     glCheckError();
@@ -140,30 +185,45 @@ void TextRendering_Init()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     glCheckError();
+
+    TextGlyphs_BuildTable(&textglyphs, textfont.glyphs.data(), textfont.glyphs.size());
+
+    // O SDF só era necessário para o envio acima.
+    std::vector<unsigned char>().swap(textfont.sdf);
+}
+
+void TextRendering_SetWindowSize(int width, int height)
+{
+    // Janela minimizada: mantemos o último tamanho válido.
+    if (width <= 0 || height <= 0)
+        return;
+
+    textwindow_width  = width;
+    textwindow_height = height;
 }
 
 float textscale = 1.5f;
 
-void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float x, float y, float scale = 1.0f)
+// Acrescenta a "vertices" os quadriláteros dos glifos de "str".
+static void TextRenderingLayout(TextVertexList* vertices, const std::string &str, float x, float y, float scale)
 {
     scale *= textscale;
-    int width, height;
-    glfwGetWindowSize(window, &width, &height);
-    float sx = scale / width;
-    float sy = scale / height;
+    float sx = scale / textwindow_width;
+    float sy = scale / textwindow_height;
+    float line_x = x;
 
+    vertices->reserve(vertices->size() + 24 * str.size());
     for (size_t i = 0; i < str.size(); i++)
     {
-        // Find the glyph for the character we are looking for
-        texture_glyph_t *glyph = 0;
-        for (size_t j = 0; j < dejavufont.glyphs_count; ++j)
+        if (str[i] == '\n')
         {
-            if (dejavufont.glyphs[j].codepoint == (uint32_t)str[i])
-            {
-                glyph = &dejavufont.glyphs[j];
-                break;
-            }
+            x = line_x;
+            y -= textfont.height * sy;
+            continue;
         }
+
+        // Find the glyph for the character we are looking for
+        const texture_glyph_t *glyph = TextGlyphs_Lookup(textglyphs, (unsigned char)str[i]);
         if (!glyph) {
             continue;
         }
@@ -173,56 +233,159 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
         float x1 = (float) (x0 + glyph->width * sx);
         float y1 = (float) (y0 - glyph->height * sy);
 
-        float s0 = glyph->s0 - 0.5f/dejavufont.tex_width;
-        float t0 = glyph->t0 - 0.5f/dejavufont.tex_height;
-        float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
-        float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
-
-        struct {float x, y, s, t;} data[6] = {
-            { x0, y0, s0, t0 },
-            { x0, y1, s0, t1 },
-            { x1, y1, s1, t1 },
-            { x0, y0, s0, t0 },
-            { x1, y1, s1, t1 },
-            { x1, y0, s1, t0 }
+        float s0 = glyph->s0 - 0.5f/textfont.tex_width;
+        float t0 = glyph->t0 - 0.5f/textfont.tex_height;
+        float s1 = glyph->s1 - 0.5f/textfont.tex_width;
+        float t1 = glyph->t1 - 0.5f/textfont.tex_height;
+
+        float data[24] = {
+            x0, y0, s0, t0,
+            x0, y1, s0, t1,
+            x1, y1, s1, t1,
+            x0, y0, s0, t0,
+            x1, y1, s1, t1,
+            x1, y0, s1, t0
         };
+        vertices->insert(vertices->end(), data, data + 24);
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        x += (glyph->advance_x * sx);
+    }
+}
 
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDepthFunc(GL_ALWAYS);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, 24 * sizeof(float), data);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+// Desenha "count" vértices do VAO com o programa e o estado usados pelo texto.
+static void TextRenderingDraw(GLuint vertex_array_object_id, GLsizei count)
+{
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        glUseProgram(textprogram_id);
-        glBindVertexArray(textVAO);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDepthFunc(GL_ALWAYS);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glUseProgram(textprogram_id);
+    glBindVertexArray(vertex_array_object_id);
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-        glDepthFunc(GL_LESS);
+    glDrawArrays(GL_TRIANGLES, 0, count);
 
-        glDisable(GL_BLEND);
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDepthFunc(GL_LESS);
 
-        x += (glyph->advance_x * sx);
+    glDisable(GL_BLEND);
+}
+
+void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float x, float y, float scale = 1.0f)
+{
+    TextRenderingLayout(&textvertices, str, x, y, scale);
+}
+
+// Desenha todo o texto impresso desde a última chamada. Chamada uma vez por
+// quadro, antes de glfwSwapBuffers().
+void TextRendering_Flush()
+{
+    if (textvertices.empty())
+        return;
+
+    size_t bytes = textvertices.size() * sizeof(float);
+
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    if (bytes > textbuffer_bytes)
+    {
+        size_t capacity = textbuffer_bytes > 0 ? textbuffer_bytes : 4096;
+        while (capacity < bytes)
+            capacity *= 2;
+        MemTrack_GpuFree(MEM_TEXT, textbuffer_bytes);
+        MemTrack_GpuAlloc(MEM_TEXT, capacity);
+        textbuffer_bytes = capacity;
+    }
+    glBufferData(GL_ARRAY_BUFFER, textbuffer_bytes, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, textvertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    TextRenderingDraw(textVAO, (GLsizei)(textvertices.size() / 4));
+
+    textvertices.clear();
+}
+
+void TextObject_Set(TextObject* object, const std::string& text, float x, float y, float scale)
+{
+    if (object->text == text && object->x == x && object->y == y && object->scale == scale)
+        return;
+
+    object->text  = text;
+    object->x     = x;
+    object->y     = y;
+    object->scale = scale;
+    object->dirty = true;
+}
+
+void TextObject_Draw(TextObject* object)
+{
+    if (object->window_width != textwindow_width || object->window_height != textwindow_height)
+        object->dirty = true;
+
+    if (object->dirty)
+    {
+        // Reaproveitado entre montagens, para não alocar memória a cada uma.
+        static TextVertexList vertices;
+        vertices.clear();
+        TextRenderingLayout(&vertices, object->text, object->x, object->y, object->scale);
+
+        if (object->vertex_array_object_id == 0)
+        {
+            glGenVertexArrays(1, &object->vertex_array_object_id);
+            glGenBuffers(1, &object->vertex_buffer_id);
+            glBindVertexArray(object->vertex_array_object_id);
+            glBindBuffer(GL_ARRAY_BUFFER, object->vertex_buffer_id);
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+            glEnableVertexAttribArray(0);
+            glBindVertexArray(0);
+        }
+
+        size_t bytes = vertices.size() * sizeof(float);
+        glBindBuffer(GL_ARRAY_BUFFER, object->vertex_buffer_id);
+        if (bytes > object->buffer_bytes)
+        {
+            glBufferData(GL_ARRAY_BUFFER, bytes, vertices.data(), GL_STATIC_DRAW);
+            MemTrack_GpuFree(MEM_TEXT, object->buffer_bytes);
+            MemTrack_GpuAlloc(MEM_TEXT, bytes);
+            object->buffer_bytes = bytes;
+        }
+        else if (bytes > 0)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glCheckError();
+
+        object->vertex_count  = (GLsizei)(vertices.size() / 4);
+        object->window_width  = textwindow_width;
+        object->window_height = textwindow_height;
+        object->dirty = false;
     }
+
+    if (object->vertex_count > 0)
+        TextRenderingDraw(object->vertex_array_object_id, object->vertex_count);
+}
+
+void TextObject_Destroy(TextObject* object)
+{
+    if (object->vertex_array_object_id != 0)
+    {
+        glDeleteBuffers(1, &object->vertex_buffer_id);
+        glDeleteVertexArrays(1, &object->vertex_array_object_id);
+        MemTrack_GpuFree(MEM_TEXT, object->buffer_bytes);
+    }
+    *object = TextObject();
 }
 
 float TextRendering_LineHeight(GLFWwindow* window)
 {
-    int width, height;
-    glfwGetWindowSize(window, &width, &height);
-    return dejavufont.height / height * textscale;
+    return textfont.height / textwindow_height * textscale;
 }
 
 float TextRendering_CharWidth(GLFWwindow* window)
 {
-    int width, height;
-    glfwGetWindowSize(window, &width, &height);
-    return dejavufont.glyphs[32].advance_x / width * textscale;
+    return textfont.glyphs[32].advance_x / textwindow_width * textscale;
 }
 
 void TextRendering_PrintMatrix(GLFWwindow* window, glm::mat4 M, float x, float y, float scale = 1.0f)
@@ -255,52 +418,73 @@ void TextRendering_PrintVector(GLFWwindow* window, glm::vec4 v, float x, float y
     TextRendering_PrintString(window, buffer, x, y - 3*lineheight, scale);
 }
 
-void TextRendering_PrintMatrixVectorProduct(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f)
+// As três funções abaixo retornam as quatro linhas de M*v separadas por "\n",
+// para serem impressas com TextRendering_PrintString() ou guardadas em um
+// TextObject.
+std::string TextRendering_FormatMatrixVectorProduct(glm::mat4 M, glm::vec4 v)
 {
     char buffer[70];
-    float lineheight = TextRendering_LineHeight(window) * scale;
+    std::string lines;
 
     auto r = M*v;
     snprintf(buffer, 70, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f]     [%+0.2f]\n", M[0][0], M[1][0], M[2][0], M[3][0], v[0], r[0]);
-    TextRendering_PrintString(window, buffer, x, y, scale);
+    lines += buffer;
     snprintf(buffer, 70, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f]     [%+0.2f]\n", M[0][1], M[1][1], M[2][1], M[3][1], v[1], r[1]);
-    TextRendering_PrintString(window, buffer, x, y - lineheight, scale);
+    lines += buffer;
     snprintf(buffer, 70, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f] --> [%+0.2f]\n", M[0][2], M[1][2], M[2][2], M[3][2], v[2], r[2]);
-    TextRendering_PrintString(window, buffer, x, y - 2*lineheight, scale);
+    lines += buffer;
     snprintf(buffer, 70, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f]     [%+0.2f]\n", M[0][3], M[1][3], M[2][3], M[3][3], v[3], r[3]);
-    TextRendering_PrintString(window, buffer, x, y - 3*lineheight, scale);
+    lines += buffer;
+    return lines;
 }
 
-void TextRendering_PrintMatrixVectorProductMoreDigits(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f)
+std::string TextRendering_FormatMatrixVectorProductMoreDigits(glm::mat4 M, glm::vec4 v)
 {
     char buffer[70];
-    float lineheight = TextRendering_LineHeight(window) * scale;
+    std::string lines;
 
     auto r = M*v;
     snprintf(buffer, 70, "[%5.1f %5.1f %5.1f %5.1f][%5.2f]     [%+6.1f]\n", M[0][0], M[1][0], M[2][0], M[3][0], v[0], r[0]);
-    TextRendering_PrintString(window, buffer, x, y, scale);
+    lines += buffer;
     snprintf(buffer, 70, "[%5.1f %5.1f %5.1f %5.1f][%5.2f]     [%+6.1f]\n", M[0][1], M[1][1], M[2][1], M[3][1], v[1], r[1]);
-    TextRendering_PrintString(window, buffer, x, y - lineheight, scale);
+    lines += buffer;
     snprintf(buffer, 70, "[%5.1f %5.1f %5.1f %5.1f][%5.2f] --> [%+6.1f]\n", M[0][2], M[1][2], M[2][2], M[3][2], v[2], r[2]);
-    TextRendering_PrintString(window, buffer, x, y - 2*lineheight, scale);
+    lines += buffer;
     snprintf(buffer, 70, "[%5.1f %5.1f %5.1f %5.1f][%5.2f]     [%+6.1f]\n", M[0][3], M[1][3], M[2][3], M[3][3], v[3], r[3]);
-    TextRendering_PrintString(window, buffer, x, y - 3*lineheight, scale);
+    lines += buffer;
+    return lines;
 }
 
-void TextRendering_PrintMatrixVectorProductDivW(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f)
+std::string TextRendering_FormatMatrixVectorProductDivW(glm::mat4 M, glm::vec4 v)
 {
     auto r = M*v;
     auto w = r[3];
 
     char buffer[90];
-    float lineheight = TextRendering_LineHeight(window) * scale;
+    std::string lines;
 
     snprintf(buffer, 90, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f]     [%+0.2f]        [%+0.2f]\n", M[0][0], M[1][0], M[2][0], M[3][0], v[0], r[0], r[0]/w);
-    TextRendering_PrintString(window, buffer, x, y, scale);
+    lines += buffer;
     snprintf(buffer, 90, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f]     [%+0.2f] div. w [%+0.2f]\n", M[0][1], M[1][1], M[2][1], M[3][1], v[1], r[1], r[1]/w);
-    TextRendering_PrintString(window, buffer, x, y - lineheight, scale);
+    lines += buffer;
     snprintf(buffer, 90, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f] --> [%+0.2f] -----> [%+0.2f]\n", M[0][2], M[1][2], M[2][2], M[3][2], v[2], r[2], r[2]/w);
-    TextRendering_PrintString(window, buffer, x, y - 2*lineheight, scale);
+    lines += buffer;
     snprintf(buffer, 90, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f]     [%+0.2f]        [%+0.2f]\n", M[0][3], M[1][3], M[2][3], M[3][3], v[3], r[3], r[3]/w);
-    TextRendering_PrintString(window, buffer, x, y - 3*lineheight, scale);
+    lines += buffer;
+    return lines;
+}
+
+void TextRendering_PrintMatrixVectorProduct(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f)
+{
+    TextRendering_PrintString(window, TextRendering_FormatMatrixVectorProduct(M, v), x, y, scale);
+}
+
+void TextRendering_PrintMatrixVectorProductMoreDigits(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f)
+{
+    TextRendering_PrintString(window, TextRendering_FormatMatrixVectorProductMoreDigits(M, v), x, y, scale);
+}
+
+void TextRendering_PrintMatrixVectorProductDivW(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f)
+{
+    TextRendering_PrintString(window, TextRendering_FormatMatrixVectorProductDivW(M, v), x, y, scale);
 }
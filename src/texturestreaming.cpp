@@ -0,0 +1,550 @@
+// Envio assíncrono de texturas através de Pixel Buffer Objects. Veja os
+// comentários em "include/texturestreaming.h".
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+#include <stb_image.h>
+
+#include "utils.h"
+#include "trace.h"
+#include "framestats.h"
+#include "assetpack.h"
+#include "startup.h"
+#include "memtrack.h"
+#include "texturestreaming.h"
+
+struct TextureStreamRequest
+{
+    std::string        filename;
+    GLuint             texture_id;
+    GLuint             sampler_id;
+    GLuint             textureunit;
+    TextureStreamState state;
+    int                replaces;  // Requisição substituída ao terminar (TextureStreaming_Reload()), ou -1
+
+    // Preenchidos pela thread auxiliar após a decodificação
+    int                width;
+    int                height;
+    unsigned char*     pixels;
+
+    // PBO em uso pela requisição (índice em g_StreamPbos) e ponteiro mapeado
+    int                pbo;
+    void*              mapped;
+    GLsync             fence;
+
+    size_t             gpu_bytes; // Estimativa para "memtrack.h", após o envio
+};
+
+struct StreamPbo
+{
+    GLuint id;
+    size_t capacity;
+    bool   in_use;
+};
+
+enum StreamTaskType { STREAMTASK_DECODE, STREAMTASK_COPY, STREAMTASK_QUIT };
+
+struct StreamTask
+{
+    StreamTaskType type;
+    int            request;
+};
+
+static std::vector<TextureStreamRequest*> g_StreamRequests;
+static std::vector<StreamPbo>             g_StreamPbos;
+static size_t                             g_StreamMaxBytesPerFrame = 0;
+static TextureStreamingStats              g_StreamStats;
+
+// Fila de tarefas da thread auxiliar. O mutex também protege o campo "state"
+// de todas as requisições.
+static std::mutex                         g_StreamMutex;
+static std::condition_variable            g_StreamCondition;
+static std::deque<StreamTask>             g_StreamTasks;
+static std::thread                        g_StreamWorker;
+static bool                               g_StreamInitialized = false;
+
+// Textura cinza de 1x1 pixel mostrada enquanto a imagem real não chega.
+static GLuint                             g_StreamPlaceholderTexture = 0;
+
+static double StreamNowMs()
+{
+    typedef std::chrono::steady_clock clock;
+    return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+}
+
+static void StreamPushTask(StreamTaskType type, int request)
+{
+    StreamTask task;
+    task.type = type;
+    task.request = request;
+    {
+        std::lock_guard<std::mutex> lock(g_StreamMutex);
+        g_StreamTasks.push_back(task);
+    }
+    g_StreamCondition.notify_one();
+}
+
+// Laço da thread auxiliar: decodifica imagens e copia pixels para PBOs já
+// mapeados pela thread do contexto OpenGL. Nenhuma chamada OpenGL é feita aqui.
+static void StreamWorkerLoop()
+{
+    Trace_SetThreadName("texture streaming");
+
+    for (;;)
+    {
+        StreamTask task;
+        TextureStreamRequest* req;
+        {
+            std::unique_lock<std::mutex> lock(g_StreamMutex);
+            while (g_StreamTasks.empty())
+                g_StreamCondition.wait(lock);
+            task = g_StreamTasks.front();
+            g_StreamTasks.pop_front();
+            if (task.type == STREAMTASK_QUIT)
+                return;
+            req = g_StreamRequests[task.request];
+        }
+
+        if (task.type == STREAMTASK_DECODE)
+        {
+            TRACE_SCOPE("decode");
+            StartupScope step("decode", req->filename);
+            int width, height, channels;
+            unsigned char* data = NULL;
+            AssetBlob blob;
+            if (AssetPack_Load(req->filename.c_str(), &blob))
+            {
+                data = stbi_load_from_memory(blob.data, (int)blob.size, &width, &height, &channels, 3);
+                AssetPack_Free(&blob);
+            }
+
+            std::lock_guard<std::mutex> lock(g_StreamMutex);
+            if (data == NULL)
+            {
+                fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", req->filename.c_str());
+                req->state = TEXSTREAM_FAILED;
+                continue;
+            }
+            req->width  = width;
+            req->height = height;
+            req->pixels = data;
+            req->state  = TEXSTREAM_DECODED;
+            MemTrack_CpuAlloc(MEM_TEXTURES, (size_t)width * height * 3);
+        }
+        else if (task.type == STREAMTASK_COPY)
+        {
+            TRACE_SCOPE("copy to PBO");
+            StartupScope step("upload", req->filename + " (PBO copy)");
+            memcpy(req->mapped, req->pixels, (size_t)req->width * req->height * 3);
+            stbi_image_free(req->pixels);
+            MemTrack_CpuFree(MEM_TEXTURES, (size_t)req->width * req->height * 3);
+
+            std::lock_guard<std::mutex> lock(g_StreamMutex);
+            req->pixels = NULL;
+            req->state  = TEXSTREAM_COPIED;
+        }
+    }
+}
+
+void TextureStreaming_Init(size_t num_pbos, size_t max_bytes_per_frame)
+{
+    if (g_StreamInitialized)
+        return;
+
+    // stbi_set_flip_vertically_on_load() altera uma variável global da
+    // stb_image; configuramos antes de criar a thread auxiliar.
+    stbi_set_flip_vertically_on_load(true);
+
+    g_StreamPbos.resize(num_pbos);
+    for (size_t i = 0; i < num_pbos; ++i)
+    {
+        glGenBuffers(1, &g_StreamPbos[i].id);
+        g_StreamPbos[i].capacity = 0;
+        g_StreamPbos[i].in_use = false;
+    }
+    glCheckError();
+
+    const unsigned char placeholder[3] = { 128, 128, 128 };
+    glGenTextures(1, &g_StreamPlaceholderTexture);
+    glBindTexture(GL_TEXTURE_2D, g_StreamPlaceholderTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholder);
+    MemTrack_GpuAlloc(MEM_TEXTURES, MemTrack_TextureBytes(1, 1, 4, false));
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glCheckError();
+
+    g_StreamMaxBytesPerFrame = max_bytes_per_frame;
+    memset(&g_StreamStats, 0, sizeof(g_StreamStats));
+
+    g_StreamWorker = std::thread(StreamWorkerLoop);
+    g_StreamInitialized = true;
+}
+
+void TextureStreaming_Shutdown()
+{
+    if (!g_StreamInitialized)
+        return;
+
+    StreamPushTask(STREAMTASK_QUIT, -1);
+    g_StreamWorker.join();
+
+    for (size_t i = 0; i < g_StreamRequests.size(); ++i)
+    {
+        TextureStreamRequest* req = g_StreamRequests[i];
+        if (req->pixels)
+        {
+            stbi_image_free(req->pixels);
+            MemTrack_CpuFree(MEM_TEXTURES, (size_t)req->width * req->height * 3);
+        }
+        MemTrack_GpuFree(MEM_TEXTURES, req->gpu_bytes);
+        if (req->fence)
+            glDeleteSync(req->fence);
+        delete req;
+    }
+    g_StreamRequests.clear();
+
+    for (size_t i = 0; i < g_StreamPbos.size(); ++i)
+    {
+        glDeleteBuffers(1, &g_StreamPbos[i].id);
+        MemTrack_GpuFree(MEM_TEXTURES, g_StreamPbos[i].capacity);
+    }
+    g_StreamPbos.clear();
+
+    glDeleteTextures(1, &g_StreamPlaceholderTexture);
+    MemTrack_GpuFree(MEM_TEXTURES, MemTrack_TextureBytes(1, 1, 4, false));
+    g_StreamPlaceholderTexture = 0;
+
+    g_StreamInitialized = false;
+}
+
+static int StreamCreateRequest(const char* filename, GLuint textureunit, int replaces, GLuint* texture_id)
+{
+    TextureStreamRequest* req = new TextureStreamRequest;
+    req->filename    = filename;
+    req->textureunit = textureunit;
+    req->state       = TEXSTREAM_DECODING;
+    req->replaces    = replaces;
+    req->width       = 0;
+    req->height      = 0;
+    req->pixels      = NULL;
+    req->pbo         = -1;
+    req->mapped      = NULL;
+    req->fence       = 0;
+    req->gpu_bytes   = 0;
+
+    // Veja slides 95-96 do documento Aula_20_Mapeamento_de_Texturas.pdf
+    glGenTextures(1, &req->texture_id);
+    glGenSamplers(1, &req->sampler_id);
+    glSamplerParameteri(req->sampler_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(req->sampler_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(req->sampler_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(req->sampler_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // A unidade de textura aponta para a textura provisória até que a imagem
+    // real chegue na GPU (veja TextureStreaming_Update()). Em uma recarga, a
+    // textura anterior continua ligada.
+    if (replaces < 0)
+    {
+        glActiveTexture(GL_TEXTURE0 + textureunit);
+        glBindTexture(GL_TEXTURE_2D, g_StreamPlaceholderTexture);
+        glBindSampler(textureunit, req->sampler_id);
+    }
+    glCheckError();
+
+    if (texture_id)
+        *texture_id = req->texture_id;
+
+    int index;
+    {
+        std::lock_guard<std::mutex> lock(g_StreamMutex);
+        index = (int)g_StreamRequests.size();
+        g_StreamRequests.push_back(req);
+    }
+    StreamPushTask(STREAMTASK_DECODE, index);
+
+    return index;
+}
+
+int TextureStreaming_Request(const char* filename, GLuint textureunit, GLuint* texture_id)
+{
+    return StreamCreateRequest(filename, textureunit, -1, texture_id);
+}
+
+int TextureStreaming_Reload(int request)
+{
+    TextureStreamRequest* old = g_StreamRequests[request];
+    return StreamCreateRequest(old->filename.c_str(), old->textureunit, request, NULL);
+}
+
+static int StreamAcquirePbo()
+{
+    for (size_t i = 0; i < g_StreamPbos.size(); ++i)
+        if (!g_StreamPbos[i].in_use)
+            return (int)i;
+    return -1;
+}
+
+void TextureStreaming_Update()
+{
+    if (!g_StreamInitialized)
+        return;
+
+    TRACE_SCOPE("TextureStreaming_Update");
+
+    size_t bytes = 0;
+    double stall_ms = 0.0;
+
+    // Copiamos os ponteiros para não segurar o mutex durante chamadas OpenGL.
+    // Somente esta thread adiciona requisições, então o vetor não muda aqui.
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(g_StreamMutex);
+        count = g_StreamRequests.size();
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        TextureStreamRequest* req = g_StreamRequests[i];
+
+        TextureStreamState state;
+        {
+            std::lock_guard<std::mutex> lock(g_StreamMutex);
+            state = req->state;
+        }
+
+        if (state == TEXSTREAM_UPLOADING)
+        {
+            // Teste não bloqueante do fence (timeout zero).
+            double t0 = StreamNowMs();
+            GLenum result = glClientWaitSync(req->fence, 0, 0);
+            stall_ms += StreamNowMs() - t0;
+
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            {
+                // Só agora trocamos a textura provisória (ou a versão
+                // anterior, em uma recarga) pela textura real.
+                glActiveTexture(GL_TEXTURE0 + req->textureunit);
+                glBindTexture(GL_TEXTURE_2D, req->texture_id);
+                glBindSampler(req->textureunit, req->sampler_id);
+
+                if (req->replaces >= 0)
+                {
+                    TextureStreamRequest* old = g_StreamRequests[req->replaces];
+                    glDeleteTextures(1, &old->texture_id);
+                    glDeleteSamplers(1, &old->sampler_id);
+                    old->texture_id = 0;
+                    old->sampler_id = 0;
+                    MemTrack_GpuFree(MEM_TEXTURES, old->gpu_bytes);
+                    old->gpu_bytes = 0;
+
+                    std::lock_guard<std::mutex> lock(g_StreamMutex);
+                    old->state = TEXSTREAM_RELEASED;
+                }
+
+                glDeleteSync(req->fence);
+                req->fence = 0;
+                g_StreamPbos[req->pbo].in_use = false;
+                req->pbo = -1;
+                g_StreamStats.textures_completed += 1;
+
+                std::lock_guard<std::mutex> lock(g_StreamMutex);
+                req->state = TEXSTREAM_READY;
+            }
+        }
+        else if (state == TEXSTREAM_COPIED)
+        {
+            StreamPbo& pbo = g_StreamPbos[req->pbo];
+            FrameStats_Annotate("texture upload");
+            StartupScope step("upload", req->filename);
+
+            double t0 = StreamNowMs();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.id);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            req->mapped = NULL;
+
+            // Com um GL_PIXEL_UNPACK_BUFFER ligado, o último argumento de
+            // glTexImage2D() é um deslocamento dentro do PBO e a cópia para a
+            // textura é feita de forma assíncrona pelo driver.
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+            glActiveTexture(GL_TEXTURE0 + req->textureunit);
+            glBindTexture(GL_TEXTURE_2D, req->texture_id);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, req->width, req->height, 0, GL_RGB, GL_UNSIGNED_BYTE, (void*)0);
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+            // Drivers normalmente armazenam GL_SRGB8 com 4 bytes por texel.
+            req->gpu_bytes = MemTrack_TextureBytes(req->width, req->height, 4, true);
+            MemTrack_GpuAlloc(MEM_TEXTURES, req->gpu_bytes);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            // Mantemos a textura anterior ligada até o fence ser sinalizado.
+            if (req->replaces >= 0)
+                glBindTexture(GL_TEXTURE_2D, g_StreamRequests[req->replaces]->texture_id);
+            else
+                glBindTexture(GL_TEXTURE_2D, g_StreamPlaceholderTexture);
+
+            req->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            stall_ms += StreamNowMs() - t0;
+            glCheckError();
+
+            std::lock_guard<std::mutex> lock(g_StreamMutex);
+            req->state = TEXSTREAM_UPLOADING;
+        }
+        else if (state == TEXSTREAM_DECODED)
+        {
+            size_t size = (size_t)req->width * req->height * 3;
+
+            // Respeitamos o orçamento de bytes por quadro, mas sempre deixamos
+            // ao menos uma textura começar, para não travar imagens grandes.
+            if (bytes > 0 && bytes + size > g_StreamMaxBytesPerFrame)
+                continue;
+
+            int p = StreamAcquirePbo();
+            if (p < 0)
+                continue;
+
+            StreamPbo& pbo = g_StreamPbos[p];
+
+            double t0 = StreamNowMs();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.id);
+            if (pbo.capacity < size)
+            {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+                MemTrack_GpuFree(MEM_TEXTURES, pbo.capacity);
+                MemTrack_GpuAlloc(MEM_TEXTURES, size);
+                pbo.capacity = size;
+            }
+            // GL_MAP_INVALIDATE_BUFFER_BIT permite ao driver entregar memória
+            // nova sem esperar o uso anterior deste PBO.
+            void* ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            stall_ms += StreamNowMs() - t0;
+
+            if (ptr == NULL)
+            {
+                glCheckError();
+                continue;
+            }
+
+            pbo.in_use  = true;
+            req->pbo    = p;
+            req->mapped = ptr;
+            bytes += size;
+
+            {
+                std::lock_guard<std::mutex> lock(g_StreamMutex);
+                req->state = TEXSTREAM_COPYING;
+            }
+            StreamPushTask(STREAMTASK_COPY, (int)i);
+        }
+    }
+
+    g_StreamStats.frames             += 1;
+    g_StreamStats.bytes_this_frame    = bytes;
+    g_StreamStats.bytes_total        += bytes;
+    g_StreamStats.stall_ms_this_frame = stall_ms;
+    g_StreamStats.stall_ms_total     += stall_ms;
+    if (bytes > g_StreamStats.bytes_peak_frame)
+        g_StreamStats.bytes_peak_frame = bytes;
+    if (stall_ms > g_StreamStats.stall_ms_peak_frame)
+        g_StreamStats.stall_ms_peak_frame = stall_ms;
+}
+
+void TextureStreaming_Finish()
+{
+    while (!TextureStreaming_IsIdle())
+    {
+        TextureStreaming_Update();
+        std::this_thread::yield();
+    }
+}
+
+TextureStreamState TextureStreaming_GetState(int request)
+{
+    std::lock_guard<std::mutex> lock(g_StreamMutex);
+    return g_StreamRequests[request]->state;
+}
+
+bool TextureStreaming_GetSize(int request, int* width, int* height)
+{
+    std::lock_guard<std::mutex> lock(g_StreamMutex);
+    TextureStreamRequest* req = g_StreamRequests[request];
+    if (req->width == 0)
+        return false;
+    *width  = req->width;
+    *height = req->height;
+    return true;
+}
+
+void TextureStreaming_Release(int request)
+{
+    TextureStreamRequest* req = g_StreamRequests[request];
+    bool failed_reload;
+    {
+        std::lock_guard<std::mutex> lock(g_StreamMutex);
+        if (req->state != TEXSTREAM_READY && req->state != TEXSTREAM_FAILED)
+            return;
+        failed_reload = req->state == TEXSTREAM_FAILED && req->replaces >= 0;
+        req->state = TEXSTREAM_RELEASED;
+    }
+
+    // Uma recarga que falhou nunca foi ligada: a unidade de textura continua
+    // com a versão anterior.
+    if (!failed_reload)
+    {
+        glActiveTexture(GL_TEXTURE0 + req->textureunit);
+        glBindTexture(GL_TEXTURE_2D, g_StreamPlaceholderTexture);
+    }
+    glDeleteTextures(1, &req->texture_id);
+    glDeleteSamplers(1, &req->sampler_id);
+    req->texture_id = 0;
+    req->sampler_id = 0;
+    MemTrack_GpuFree(MEM_TEXTURES, req->gpu_bytes);
+    req->gpu_bytes = 0;
+}
+
+void TextureStreaming_BindPlaceholder(GLuint textureunit)
+{
+    glActiveTexture(GL_TEXTURE0 + textureunit);
+    glBindTexture(GL_TEXTURE_2D, g_StreamPlaceholderTexture);
+}
+
+bool TextureStreaming_IsIdle()
+{
+    std::lock_guard<std::mutex> lock(g_StreamMutex);
+    for (size_t i = 0; i < g_StreamRequests.size(); ++i)
+    {
+        TextureStreamState state = g_StreamRequests[i]->state;
+        if (state != TEXSTREAM_READY && state != TEXSTREAM_FAILED && state != TEXSTREAM_RELEASED)
+            return false;
+    }
+    return true;
+}
+
+const TextureStreamingStats& TextureStreaming_GetStats()
+{
+    return g_StreamStats;
+}
+
+void TextureStreaming_PrintStats()
+{
+    const TextureStreamingStats& s = g_StreamStats;
+    printf("Texture streaming: %lu texturas, %.2f MB enviados, pico de %.2f MB/quadro\n",
+           (unsigned long)s.textures_completed,
+           s.bytes_total / (1024.0*1024.0),
+           s.bytes_peak_frame / (1024.0*1024.0));
+    printf("Texture streaming: tempo bloqueado total %.3f ms, pico de %.3f ms/quadro (%lu quadros)\n",
+           s.stall_ms_total, s.stall_ms_peak_frame, (unsigned long)s.frames);
+}
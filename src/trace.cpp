@@ -0,0 +1,239 @@
+// Gravação de linha do tempo. Veja os comentários em "include/trace.h".
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+// Número máximo de eventos por thread em uma gravação. Eventos além deste
+// limite são descartados (e contados).
+static const unsigned TRACE_CAPACITY = 1 << 16;
+
+struct TraceEvent
+{
+    const char* name;
+    double      ts_us;
+    char        phase;  // 'B' ou 'E'
+};
+
+// Somente a thread dona escreve no buffer, inclusive para esvaziá-lo: ao
+// gravar o primeiro evento de uma nova gravação (g_TraceEpoch diferente de
+// "epoch") ela zera os contadores antes de publicar a nova época.
+struct TraceThreadBuffer
+{
+    int                   tid;
+    const char*           name;
+    TraceEvent*           events;
+    std::atomic<unsigned> count;   // Publicado pela thread dona (release)
+    std::atomic<unsigned> dropped;
+    std::atomic<unsigned> epoch;   // Gravação à qual os eventos pertencem
+};
+
+// Lista de buffers de todas as threads que já gravaram algum evento. O mutex
+// só é usado na primeira gravação de cada thread e ao gerar o arquivo.
+static std::mutex                        g_TraceMutex;
+static std::vector<TraceThreadBuffer*>   g_TraceBuffers;
+static thread_local TraceThreadBuffer*   t_TraceBuffer = NULL;
+
+static std::atomic<bool>                 g_TraceRecording(false);
+static std::atomic<unsigned>             g_TraceEpoch(0);           // Incrementada a cada gravação
+static int                               g_TracePendingFrames = 0;  // Gravação pedida, ainda não iniciada
+static int                               g_TraceRemainingFrames = 0;
+static std::string                       g_TraceFilename;
+static double                            g_TraceStartUs = 0.0;
+
+static double TraceNowUs()
+{
+    typedef std::chrono::steady_clock clock;
+    return std::chrono::duration<double, std::micro>(clock::now().time_since_epoch()).count();
+}
+
+static TraceThreadBuffer* TraceGetBuffer()
+{
+    if (t_TraceBuffer == NULL)
+    {
+        TraceThreadBuffer* buffer = new TraceThreadBuffer;
+        buffer->name   = NULL;
+        buffer->events = new TraceEvent[TRACE_CAPACITY];
+        buffer->count.store(0);
+        buffer->dropped.store(0);
+        buffer->epoch.store(0);
+
+        std::lock_guard<std::mutex> lock(g_TraceMutex);
+        buffer->tid = (int)g_TraceBuffers.size() + 1;
+        g_TraceBuffers.push_back(buffer);
+        t_TraceBuffer = buffer;
+    }
+    return t_TraceBuffer;
+}
+
+static void TracePush(const char* name, char phase)
+{
+    TraceThreadBuffer* buffer = TraceGetBuffer();
+    unsigned epoch = g_TraceEpoch.load(std::memory_order_acquire);
+    if (buffer->epoch.load(std::memory_order_relaxed) != epoch)
+    {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->epoch.store(epoch, std::memory_order_release);
+    }
+
+    unsigned index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= TRACE_CAPACITY)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent& event = buffer->events[index];
+    event.name  = name;
+    event.ts_us = TraceNowUs();
+    event.phase = phase;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+// "acquire" garante que quem vê a gravação ligada também vê a sua época.
+void Trace_Begin(const char* name)
+{
+    if (g_TraceRecording.load(std::memory_order_acquire))
+        TracePush(name, 'B');
+}
+
+void Trace_End()
+{
+    if (g_TraceRecording.load(std::memory_order_acquire))
+        TracePush(NULL, 'E');
+}
+
+void Trace_SetThreadName(const char* name)
+{
+    TraceGetBuffer()->name = name;
+}
+
+void Trace_StartCapture(int frames, const char* filename)
+{
+    if (frames <= 0 || Trace_IsCapturing())
+        return;
+
+    g_TracePendingFrames = frames;
+    g_TraceFilename = filename;
+}
+
+bool Trace_IsCapturing()
+{
+    return g_TracePendingFrames > 0 || g_TraceRecording.load();
+}
+
+// Escreve uma string JSON (os nomes dos escopos são literais simples, mas
+// escapamos aspas e barras por segurança).
+static void TraceWriteString(FILE* file, const char* str)
+{
+    fputc('"', file);
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', file);
+        fputc(*str, file);
+    }
+    fputc('"', file);
+}
+
+static void TraceWriteFile()
+{
+    FILE* file = fopen(g_TraceFilename.c_str(), "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Cannot create trace file \"%s\".\n", g_TraceFilename.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(g_TraceMutex);
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    size_t total = 0;
+    size_t dropped = 0;
+    unsigned epoch = g_TraceEpoch.load();
+    for (size_t b = 0; b < g_TraceBuffers.size(); ++b)
+    {
+        TraceThreadBuffer* buffer = g_TraceBuffers[b];
+
+        // Threads que não gravaram nada nesta gravação ainda guardam eventos
+        // de uma anterior.
+        if (buffer->epoch.load(std::memory_order_acquire) != epoch)
+            continue;
+
+        if (buffer->name)
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                    first ? "" : ",\n", buffer->tid);
+            TraceWriteString(file, buffer->name);
+            fprintf(file, "}}");
+            first = false;
+        }
+
+        // Pilha de nomes abertos, para repetir o nome nos eventos "E".
+        std::vector<const char*> stack;
+        unsigned count = buffer->count.load(std::memory_order_acquire);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            const TraceEvent& event = buffer->events[i];
+            const char* name = event.name;
+            if (event.phase == 'B')
+            {
+                stack.push_back(name);
+            }
+            else
+            {
+                // Um "E" sem "B" correspondente começou antes da gravação.
+                if (stack.empty())
+                    continue;
+                name = stack.back();
+                stack.pop_back();
+            }
+
+            fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+            TraceWriteString(file, name);
+            fprintf(file, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                    event.phase, event.ts_us - g_TraceStartUs, buffer->tid);
+            first = false;
+        }
+        total   += count;
+        dropped += buffer->dropped.load();
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("Trace: %lu eventos gravados em \"%s\"", (unsigned long)total, g_TraceFilename.c_str());
+    if (dropped > 0)
+        printf(" (%lu descartados)", (unsigned long)dropped);
+    printf(".\n");
+}
+
+void Trace_BeginFrame()
+{
+    if (g_TraceRecording.load(std::memory_order_relaxed))
+    {
+        if (--g_TraceRemainingFrames > 0)
+            return;
+
+        g_TraceRecording.store(false);
+        TraceWriteFile();
+    }
+
+    if (g_TracePendingFrames > 0)
+    {
+        // Novos eventos sobrescrevem a gravação anterior. Os buffers não são
+        // esvaziados aqui, pois as outras threads podem estar gravando neles
+        // (veja TracePush()): basta mudar a época.
+        g_TraceEpoch.fetch_add(1);
+
+        g_TraceRemainingFrames = g_TracePendingFrames;
+        g_TracePendingFrames = 0;
+        g_TraceStartUs = TraceNowUs();
+        g_TraceRecording.store(true);
+    }
+}
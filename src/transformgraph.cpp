@@ -0,0 +1,75 @@
+// Hierarquia de transformações. Veja "include/transformgraph.h".
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "transformgraph.h"
+
+int TransformGraph_AddNode(TransformGraph* graph, int parent, const Affine& local)
+{
+    int node = (int)graph->parent.size();
+    assert(parent == TRANSFORM_ROOT || (parent >= 0 && parent < node));
+
+    graph->parent.push_back(parent);
+    graph->local.push_back(local);
+    graph->world.push_back(local);
+    graph->world_matrix.push_back(glm::mat4(1.0f));
+    graph->dirty.push_back(1);
+    graph->first_dirty = std::min(graph->first_dirty, (size_t)node);
+    return node;
+}
+
+void TransformGraph_SetLocal(TransformGraph* graph, int node, const Affine& local)
+{
+    if (memcmp(&graph->local[node], &local, sizeof(Affine)) == 0)
+        return;
+
+    graph->local[node] = local;
+    graph->dirty[node] = 1;
+    graph->first_dirty = std::min(graph->first_dirty, (size_t)node);
+}
+
+// Um nó precisa ser recalculado se mudou ou se o seu pai foi recalculado.
+static bool TransformGraphMark(TransformGraph* graph, size_t node)
+{
+    int parent = graph->parent[node];
+    if (parent != TRANSFORM_ROOT && graph->dirty[parent])
+        graph->dirty[node] = 1;
+    return graph->dirty[node] != 0;
+}
+
+void TransformGraph_Update(TransformGraph* graph)
+{
+    size_t count = graph->parent.size();
+    graph->updated = 0;
+    if (graph->first_dirty >= count)
+        return;
+
+    // Irmãos consecutivos sujos são recalculados em lote.
+    size_t i = graph->first_dirty;
+    while (i < count)
+    {
+        if (!TransformGraphMark(graph, i))
+        {
+            ++i;
+            continue;
+        }
+
+        int parent = graph->parent[i];
+        size_t end = i + 1;
+        while (end < count && graph->parent[end] == parent && TransformGraphMark(graph, end))
+            ++end;
+
+        if (parent == TRANSFORM_ROOT)
+            std::copy(&graph->local[i], &graph->local[0] + end, &graph->world[i]);
+        else
+            Affine_ComposeBatch(graph->world[parent], &graph->local[i], &graph->world[i], end - i);
+        Affine_ToMat4Batch(&graph->world[i], &graph->world_matrix[i], end - i);
+
+        graph->updated += end - i;
+        i = end;
+    }
+
+    std::fill(graph->dirty.begin() + graph->first_dirty, graph->dirty.end(), 0);
+    graph->first_dirty = count;
+}